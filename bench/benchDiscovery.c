@@ -0,0 +1,739 @@
+// -------------------------------------------------------------------------------------------------
+//  File benchDiscovery.c
+//
+//  Copyright (c) 2016, 2017 DexLogic, Dirk Apitz
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+// -------------------------------------------------------------------------------------------------
+//  End-to-end discovery benchmark (Linux). A responder thread emulates a fleet of servers on
+//  the loopback interface: A single wildcard socket receives all requests, the destination
+//  address (IP_PKTINFO) selects the emulated server address (127.0.x.y) which is also used as
+//  the source address of the response. A session scan of the loopback interface is timed for
+//  growing fleets. The module is included to count the heap allocations of the scan engine.
+// -------------------------------------------------------------------------------------------------
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/plt-posix.h"
+
+
+// -------------------------------------------------------------------------------------------------
+//  Allocation counter (scan engine only, single thread)
+// -------------------------------------------------------------------------------------------------
+
+static unsigned long allocCount;
+static unsigned long long allocBytes;
+
+static void *countMalloc(size_t size) { allocCount++; allocBytes += size; return malloc(size); }
+static void *countCalloc(size_t count, size_t size) { allocCount++; allocBytes += count * size; return calloc(count, size); }
+static void *countRealloc(void *ptr, size_t size) { allocCount++; allocBytes += size; return realloc(ptr, size); }
+
+#define malloc(s) countMalloc(s)
+#define calloc(c, s) countCalloc(c, s)
+#define realloc(p, s) countRealloc(p, s)
+
+#include "../src/idnServerList.c"
+
+#undef malloc
+#undef calloc
+#undef realloc
+
+
+// -------------------------------------------------------------------------------------------------
+//  Defines / Typedefs
+// -------------------------------------------------------------------------------------------------
+
+#define FLEET_NET_BASE                  0x7F000002      // Address of the first emulated server (127.0.0.2)
+#define FLEET_MAX_ADDRESSES             60000           // Address range limit (stays within 127.0.0.0/16)
+
+typedef struct
+{
+    unsigned serverCount;                               // Number of emulated servers
+    unsigned addressCount;                              // Addresses per server
+    unsigned serviceCount;                              // Services per server
+    unsigned relayCount;                                // Relays per server (services distributed round robin)
+    uint32_t unitIDBase;                                // UnitID of the first server (counted up)
+    unsigned lossPercent;                               // Responses dropped
+    unsigned usJitter;                                  // Random extra delay of each response
+    unsigned usSpread;                                  // Broadcast responses spread over this period
+
+} FLEET_CONFIG;
+
+
+typedef struct
+{
+    uint64_t nsDue;                                     // Send time
+    uint32_t addrIndex;                                 // Responding address (server * addressCount + n)
+    struct sockaddr_in remoteAddr;                      // The requester
+    uint8_t command;                                    // The request command
+    uint8_t flags;                                      // Echoed flags/client group
+    uint16_t sequence;                                  // Echoed sequence number (network order)
+    uint8_t payload[8];                                 // Ping: Echoed payload; Parameters: Request payload
+    uint8_t payloadLength;
+
+} PENDING_RESPONSE;
+
+
+typedef struct
+{
+    FLEET_CONFIG config;
+    int fdSocket;                                       // Wildcard socket
+    uint32_t randState;                                 // xorshift32 state
+
+    PENDING_RESPONSE *heapTable;                        // Min-heap on nsDue
+    unsigned heapCount;
+    unsigned heapSize;
+
+    PLT_THREAD thread;
+    volatile uint32_t stopFlag;
+
+    unsigned long requestCount;                         // Statistics (read after the thread stopped)
+    unsigned long responseCount;
+    unsigned long lossCount;                            // Responses dropped by the loss emulation
+    unsigned long dropCount;                            // Harness drops: Send failures, response heap full
+    unsigned long recvDropCount;                        // Harness drops: Requests dropped by the kernel
+    uint32_t recvDropCounter;                           // Last SO_RXQ_OVFL value (cumulative)
+
+} FLEET;
+
+
+// -------------------------------------------------------------------------------------------------
+//  Responder fleet
+// -------------------------------------------------------------------------------------------------
+
+static uint32_t fleetRandom(FLEET *fleet)
+{
+    uint32_t x = fleet->randState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    fleet->randState = x;
+
+    return x;
+}
+
+
+static int pushResponse(FLEET *fleet, const PENDING_RESPONSE *response)
+{
+    if(fleet->heapCount >= fleet->heapSize)
+    {
+        unsigned heapSize = fleet->heapSize ? (fleet->heapSize * 2) : 1024;
+        PENDING_RESPONSE *heapTable = (PENDING_RESPONSE *)realloc(fleet->heapTable, heapSize * sizeof(PENDING_RESPONSE));
+        if(heapTable == (PENDING_RESPONSE *)0) return -1;
+
+        fleet->heapTable = heapTable;
+        fleet->heapSize = heapSize;
+    }
+
+    // Sift up
+    unsigned i = fleet->heapCount++;
+    while(i > 0)
+    {
+        unsigned parent = (i - 1) / 2;
+        if(fleet->heapTable[parent].nsDue <= response->nsDue) break;
+
+        fleet->heapTable[i] = fleet->heapTable[parent];
+        i = parent;
+    }
+    fleet->heapTable[i] = *response;
+
+    return 0;
+}
+
+
+static void popResponse(FLEET *fleet, PENDING_RESPONSE *response)
+{
+    *response = fleet->heapTable[0];
+
+    // Sift down (last element)
+    PENDING_RESPONSE last = fleet->heapTable[--fleet->heapCount];
+    unsigned i = 0;
+    while(1)
+    {
+        unsigned child = 2 * i + 1;
+        if(child >= fleet->heapCount) break;
+        if((child + 1 < fleet->heapCount) && (fleet->heapTable[child + 1].nsDue < fleet->heapTable[child].nsDue)) child++;
+        if(last.nsDue <= fleet->heapTable[child].nsDue) break;
+
+        fleet->heapTable[i] = fleet->heapTable[child];
+        i = child;
+    }
+    if(fleet->heapCount) fleet->heapTable[i] = last;
+}
+
+
+static unsigned buildResponse(FLEET *fleet, const PENDING_RESPONSE *response, uint8_t *buffer)
+{
+    const FLEET_CONFIG *config = &fleet->config;
+    unsigned serverIndex = response->addrIndex / config->addressCount;
+
+    IDNHDR_PACKET *packetHdr = (IDNHDR_PACKET *)buffer;
+    packetHdr->command = response->command + 1;
+    packetHdr->flags = response->flags;
+    packetHdr->sequence = response->sequence;
+
+    if(response->command == IDNCMD_SCAN_REQUEST)
+    {
+        IDNHDR_SCAN_RESPONSE *scanRspHdr = (IDNHDR_SCAN_RESPONSE *)&packetHdr[1];
+        memset(scanRspHdr, 0, sizeof(IDNHDR_SCAN_RESPONSE));
+        scanRspHdr->structSize = sizeof(IDNHDR_SCAN_RESPONSE);
+        scanRspHdr->protocolVersion = 0x10;
+        scanRspHdr->status = IDNFLG_SCAN_STATUS_REALTIME;
+
+        // Each server excludes one client group (server number modulo 16)
+        if((serverIndex % 16) == (response->flags & IDNMSK_PKTFLAGS_GROUP)) scanRspHdr->status |= IDNFLG_SCAN_STATUS_EXCLUDED;
+
+        uint32_t unitNum = config->unitIDBase + serverIndex;
+        scanRspHdr->unitID[0] = 7;
+        scanRspHdr->unitID[1] = 1;
+        scanRspHdr->unitID[2] = (uint8_t)(unitNum >> 24);
+        scanRspHdr->unitID[3] = (uint8_t)(unitNum >> 16);
+        scanRspHdr->unitID[4] = (uint8_t)(unitNum >> 8);
+        scanRspHdr->unitID[5] = (uint8_t)unitNum;
+        snprintf((char *)scanRspHdr->hostName, sizeof(scanRspHdr->hostName), "unit%u", serverIndex);
+
+        return sizeof(IDNHDR_PACKET) + sizeof(IDNHDR_SCAN_RESPONSE);
+    }
+    else if(response->command == IDNCMD_SERVICEMAP_REQUEST)
+    {
+        IDNHDR_SERVICEMAP_RESPONSE *mapRspHdr = (IDNHDR_SERVICEMAP_RESPONSE *)&packetHdr[1];
+        mapRspHdr->structSize = sizeof(IDNHDR_SERVICEMAP_RESPONSE);
+        mapRspHdr->entrySize = sizeof(IDNHDR_SERVICEMAP_ENTRY);
+        mapRspHdr->relayEntryCount = (uint8_t)config->relayCount;
+        mapRspHdr->serviceEntryCount = (uint8_t)config->serviceCount;
+
+        // Relay table, followed by the service table
+        IDNHDR_SERVICEMAP_ENTRY *mapEntry = (IDNHDR_SERVICEMAP_ENTRY *)&mapRspHdr[1];
+        for(unsigned i = 0; i < config->relayCount; i++, mapEntry++)
+        {
+            memset(mapEntry, 0, sizeof(IDNHDR_SERVICEMAP_ENTRY));
+            mapEntry->relayNumber = (uint8_t)(i + 1);
+            snprintf((char *)mapEntry->name, sizeof(mapEntry->name), "relay%u", i + 1);
+        }
+        for(unsigned i = 0; i < config->serviceCount; i++, mapEntry++)
+        {
+            memset(mapEntry, 0, sizeof(IDNHDR_SERVICEMAP_ENTRY));
+            mapEntry->serviceID = (uint8_t)(i + 1);
+            mapEntry->serviceType = 0x80;
+            mapEntry->relayNumber = config->relayCount ? (uint8_t)(i % (config->relayCount + 1)) : 0;
+            snprintf((char *)mapEntry->name, sizeof(mapEntry->name), "laser%u", i + 1);
+        }
+
+        return (unsigned)((uint8_t *)mapEntry - buffer);
+    }
+
+    else if(response->command != IDNCMD_PING_REQUEST)
+    {
+        // Parameters: The request payload (service ID), followed by the unit number
+        uint8_t *payloadPtr = (uint8_t *)&packetHdr[1];
+        uint32_t unitNum = htonl(config->unitIDBase + serverIndex);
+        memset(payloadPtr, 0, 4);
+        memcpy(payloadPtr, response->payload, (response->payloadLength < 4) ? response->payloadLength : 4);
+        memcpy(&payloadPtr[4], &unitNum, sizeof(unitNum));
+
+        return sizeof(IDNHDR_PACKET) + 8;
+    }
+
+    // Ping: Payload echoed
+    memcpy(&packetHdr[1], response->payload, response->payloadLength);
+    return sizeof(IDNHDR_PACKET) + response->payloadLength;
+}
+
+
+static int sendResponse(FLEET *fleet, const PENDING_RESPONSE *response)
+{
+    uint8_t buffer[sizeof(IDNHDR_PACKET) + sizeof(IDNHDR_SERVICEMAP_RESPONSE) + 510 * sizeof(IDNHDR_SERVICEMAP_ENTRY)];
+    struct iovec iov;
+    iov.iov_base = buffer;
+    iov.iov_len = buildResponse(fleet, response, buffer);
+
+    // The source address of the response is the emulated server address
+    union { struct cmsghdr align; uint8_t buffer[CMSG_SPACE(sizeof(struct in_pktinfo))]; } control;
+    memset(&control, 0, sizeof(control));
+
+    struct msghdr msgHdr;
+    memset(&msgHdr, 0, sizeof(msgHdr));
+    msgHdr.msg_name = (void *)&response->remoteAddr;
+    msgHdr.msg_namelen = sizeof(response->remoteAddr);
+    msgHdr.msg_iov = &iov;
+    msgHdr.msg_iovlen = 1;
+    msgHdr.msg_control = control.buffer;
+    msgHdr.msg_controllen = sizeof(control.buffer);
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msgHdr);
+    cmsg->cmsg_level = IPPROTO_IP;
+    cmsg->cmsg_type = IP_PKTINFO;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(struct in_pktinfo));
+    struct in_pktinfo *pktInfo = (struct in_pktinfo *)CMSG_DATA(cmsg);
+    pktInfo->ipi_spec_dst.s_addr = htonl(FLEET_NET_BASE + response->addrIndex);
+
+    // Note: Full socket buffer counts as a drop (a real server would lose it as well)
+    if(sendmsg(fleet->fdSocket, &msgHdr, 0) < 0) { fleet->dropCount++; return -1; }
+
+    fleet->responseCount++;
+    return 0;
+}
+
+
+static void queueResponse(FLEET *fleet, PENDING_RESPONSE *response, uint64_t nsNow, unsigned usSpread)
+{
+    // Loss emulation: The response is never sent
+    if((fleetRandom(fleet) % 100) < fleet->config.lossPercent) { fleet->lossCount++; return; }
+
+    uint64_t usDelay = 0;
+    if(usSpread) usDelay += fleetRandom(fleet) % usSpread;
+    if(fleet->config.usJitter) usDelay += fleetRandom(fleet) % fleet->config.usJitter;
+    response->nsDue = nsNow + usDelay * 1000;
+
+    if(pushResponse(fleet, response)) fleet->dropCount++;
+}
+
+
+static void handleRequest(FLEET *fleet, const uint8_t *buffer, unsigned length, struct sockaddr_in *remoteAddr, uint32_t dstAddr)
+{
+    const FLEET_CONFIG *config = &fleet->config;
+    if(length < sizeof(IDNHDR_PACKET)) return;
+
+    const IDNHDR_PACKET *packetHdr = (const IDNHDR_PACKET *)buffer;
+    if((packetHdr->command != IDNCMD_SCAN_REQUEST) && (packetHdr->command != IDNCMD_SERVICEMAP_REQUEST) &&
+       (packetHdr->command != IDNCMD_PING_REQUEST) && (packetHdr->command != IDNCMD_UNIT_PARAMETERS_REQUEST) &&
+       (packetHdr->command != IDNCMD_LINK_PARAMETERS_REQUEST) && (packetHdr->command != IDNCMD_SERVICE_PARAMETERS_REQUEST)) return;
+
+    PENDING_RESPONSE response;
+    memset(&response, 0, sizeof(response));
+    response.remoteAddr = *remoteAddr;
+    response.command = packetHdr->command;
+    response.flags = packetHdr->flags;
+    response.sequence = packetHdr->sequence;
+    if((packetHdr->command == IDNCMD_PING_REQUEST) || (packetHdr->command == IDNCMD_SERVICE_PARAMETERS_REQUEST))
+    {
+        unsigned payloadLength = length - sizeof(IDNHDR_PACKET);
+        if(payloadLength > sizeof(response.payload)) payloadLength = sizeof(response.payload);
+        memcpy(response.payload, &packetHdr[1], payloadLength);
+        response.payloadLength = (uint8_t)payloadLength;
+    }
+
+    fleet->requestCount++;
+    uint64_t nsNow = plt_getMonoTimeNS();
+    unsigned addrTotal = config->serverCount * config->addressCount;
+
+    // Broadcast (limited or loopback net directed): All addresses of all servers respond
+    if((dstAddr == 0xFFFFFFFF) || (dstAddr == 0x7FFFFFFF))
+    {
+        if(packetHdr->command != IDNCMD_SCAN_REQUEST) return;
+
+        for(unsigned i = 0; i < addrTotal; i++)
+        {
+            response.addrIndex = i;
+            queueResponse(fleet, &response, nsNow, config->usSpread);
+        }
+        return;
+    }
+
+    // Unicast: Emulated servers only
+    if((dstAddr < FLEET_NET_BASE) || ((dstAddr - FLEET_NET_BASE) >= addrTotal)) return;
+    response.addrIndex = dstAddr - FLEET_NET_BASE;
+    queueResponse(fleet, &response, nsNow, 0);
+}
+
+
+static void fleetThreadFunc(void *threadArg)
+{
+    FLEET *fleet = (FLEET *)threadArg;
+    uint8_t buffer[0x800];
+
+    while(!fleet->stopFlag)
+    {
+        // Send all due responses
+        uint64_t nsNow = plt_getMonoTimeNS();
+        while(fleet->heapCount && (fleet->heapTable[0].nsDue <= nsNow))
+        {
+            PENDING_RESPONSE response;
+            popResponse(fleet, &response);
+            sendResponse(fleet, &response);
+        }
+
+        // Wait for the next request or the next due response (10ms max. to check the stop flag)
+        uint64_t nsWait = 10000000;
+        if(fleet->heapCount && ((fleet->heapTable[0].nsDue - nsNow) < nsWait)) nsWait = fleet->heapTable[0].nsDue - nsNow;
+
+        struct pollfd pollFD;
+        pollFD.fd = fleet->fdSocket;
+        pollFD.events = POLLIN;
+        pollFD.revents = 0;
+
+        struct timespec tsWait;
+        tsWait.tv_sec = 0;
+        tsWait.tv_nsec = (long)nsWait;
+        if(ppoll(&pollFD, 1, &tsWait, (const sigset_t *)0) <= 0) continue;
+
+        // Receive all pending requests
+        while(1)
+        {
+            struct sockaddr_in remoteAddr;
+            struct iovec iov;
+            iov.iov_base = buffer;
+            iov.iov_len = sizeof(buffer);
+
+            union { struct cmsghdr align; uint8_t buffer[CMSG_SPACE(sizeof(struct in_pktinfo)) + CMSG_SPACE(sizeof(uint32_t))]; } control;
+            struct msghdr msgHdr;
+            memset(&msgHdr, 0, sizeof(msgHdr));
+            msgHdr.msg_name = &remoteAddr;
+            msgHdr.msg_namelen = sizeof(remoteAddr);
+            msgHdr.msg_iov = &iov;
+            msgHdr.msg_iovlen = 1;
+            msgHdr.msg_control = control.buffer;
+            msgHdr.msg_controllen = sizeof(control.buffer);
+
+            ssize_t length = recvmsg(fleet->fdSocket, &msgHdr, MSG_DONTWAIT);
+            if(length < 0) break;
+
+            // Destination address and the kernel drop counter of the socket (cumulative)
+            uint32_t dstAddr = 0;
+            for(struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msgHdr); cmsg; cmsg = CMSG_NXTHDR(&msgHdr, cmsg))
+            {
+                if((cmsg->cmsg_level == IPPROTO_IP) && (cmsg->cmsg_type == IP_PKTINFO))
+                {
+                    dstAddr = ntohl(((struct in_pktinfo *)CMSG_DATA(cmsg))->ipi_addr.s_addr);
+                }
+                else if((cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SO_RXQ_OVFL))
+                {
+                    uint32_t dropCounter;
+                    memcpy(&dropCounter, CMSG_DATA(cmsg), sizeof(dropCounter));
+                    fleet->recvDropCount += (uint32_t)(dropCounter - fleet->recvDropCounter);
+                    fleet->recvDropCounter = dropCounter;
+                }
+            }
+
+            handleRequest(fleet, buffer, (unsigned)length, &remoteAddr, dstAddr);
+        }
+    }
+}
+
+
+static int startFleet(FLEET *fleet, const FLEET_CONFIG *config)
+{
+    memset(fleet, 0, sizeof(FLEET));
+    fleet->config = *config;
+    fleet->randState = 0x2545F491;
+    fleet->fdSocket = -1;
+
+    do
+    {
+        fleet->fdSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if(fleet->fdSocket < 0)
+        {
+            logError("socket() failed (error: %d)", plt_sockGetLastError());
+            break;
+        }
+
+        int optVal = 1;
+        setsockopt(fleet->fdSocket, SOL_SOCKET, SO_REUSEADDR, &optVal, sizeof(optVal));
+        if(setsockopt(fleet->fdSocket, IPPROTO_IP, IP_PKTINFO, &optVal, sizeof(optVal)) < 0)
+        {
+            logError("setsockopt(IP_PKTINFO) failed (error: %d)", plt_sockGetLastError());
+            break;
+        }
+
+        // Large buffers: Broadcast responses of the whole fleet are sent back to back, the checks
+        // and info requests of all servers arrive in bursts. Beyond the system limit where allowed
+        // (CAP_NET_ADMIN). Kernel drops of requests are counted (harness drops, no emulated loss).
+        optVal = 16 * 1024 * 1024;
+        if(setsockopt(fleet->fdSocket, SOL_SOCKET, SO_SNDBUFFORCE, &optVal, sizeof(optVal)) < 0)
+        {
+            setsockopt(fleet->fdSocket, SOL_SOCKET, SO_SNDBUF, &optVal, sizeof(optVal));
+        }
+        if(setsockopt(fleet->fdSocket, SOL_SOCKET, SO_RCVBUFFORCE, &optVal, sizeof(optVal)) < 0)
+        {
+            setsockopt(fleet->fdSocket, SOL_SOCKET, SO_RCVBUF, &optVal, sizeof(optVal));
+        }
+
+        optVal = 1;
+        if(setsockopt(fleet->fdSocket, SOL_SOCKET, SO_RXQ_OVFL, &optVal, sizeof(optVal)) < 0)
+        {
+            logError("setsockopt(SO_RXQ_OVFL) failed (error: %d)", plt_sockGetLastError());
+            break;
+        }
+
+        struct sockaddr_in bindAddr;
+        memset(&bindAddr, 0, sizeof(bindAddr));
+        bindAddr.sin_family = AF_INET;
+        bindAddr.sin_port = htons(IDNVAL_HELLO_UDP_PORT);
+        bindAddr.sin_addr.s_addr = htonl(INADDR_ANY);
+        if(bind(fleet->fdSocket, (struct sockaddr *)&bindAddr, sizeof(bindAddr)) < 0)
+        {
+            logError("bind() failed (error: %d)", plt_sockGetLastError());
+            break;
+        }
+
+        if(plt_threadStart(&fleet->thread, fleetThreadFunc, fleet))
+        {
+            logError("plt_threadStart() failed (error: %d)", plt_sockGetLastError());
+            break;
+        }
+
+        return 0;
+    }
+    while(0);
+
+    if(fleet->fdSocket >= 0) close(fleet->fdSocket);
+    return -1;
+}
+
+
+static void stopFleet(FLEET *fleet)
+{
+    fleet->stopFlag = 1;
+    plt_threadJoin(&fleet->thread);
+
+    close(fleet->fdSocket);
+    free(fleet->heapTable);
+}
+
+
+// -------------------------------------------------------------------------------------------------
+//  Benchmark
+// -------------------------------------------------------------------------------------------------
+
+static uint64_t getThreadCPUTimeNS(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+
+static int timeScan(IDNSL_SESSION *session, const FLEET_CONFIG *fleetConfig, const IDNSL_SCAN_OPTIONS *scanOptions, const char *label)
+{
+    allocCount = 0;
+    allocBytes = 0;
+
+    uint64_t nsCPU = getThreadCPUTimeNS();
+    uint64_t nsStart = plt_getMonoTimeNS();
+    if(rescanIDNSession(session)) { logError("rescanIDNSession() failed"); return -1; }
+    uint64_t nsComplete = plt_getMonoTimeNS() - nsStart;
+    nsCPU = getThreadCPUTimeNS() - nsCPU;
+
+    unsigned long scanAllocCount = allocCount;
+    unsigned long long scanAllocBytes = allocBytes;
+
+    // Result check: Servers with full address and service tables (and all parameters, if requested),
+    // responded to all client groups, the excluded group reported
+    IDNSL_SERVER_INFO *firstServerInfo = (IDNSL_SERVER_INFO *)0;
+    if(getIDNSessionServerList(session, &firstServerInfo)) { logError("getIDNSessionServerList() failed"); return -1; }
+
+    uint16_t groupMask = (uint16_t)(scanOptions->groupMask | (1 << scanOptions->clientGroup));
+    unsigned serverCount = 0, completeCount = 0;
+    for(IDNSL_SERVER_INFO *serverInfo = firstServerInfo; serverInfo; serverInfo = serverInfo->next)
+    {
+        const uint8_t *unitID = serverInfo->unitID;
+        uint32_t unitNum = ((uint32_t)unitID[2] << 24) | ((uint32_t)unitID[3] << 16) | ((uint32_t)unitID[4] << 8) | unitID[5];
+        uint16_t excludedMask = (uint16_t)(groupMask & (1 << ((unitNum - fleetConfig->unitIDBase) % 16)));
+
+        serverCount++;
+        if((serverInfo->groupMask != groupMask) || (serverInfo->excludedMask != excludedMask)) continue;
+        if((serverInfo->addressCount == fleetConfig->addressCount) &&
+           (serverInfo->serviceCount == fleetConfig->serviceCount) &&
+           (serverInfo->relayCount == fleetConfig->relayCount))
+        {
+            unsigned validCount = 0;
+            for(unsigned i = 0; i < serverInfo->paramCount; i++) validCount += serverInfo->paramTable[i].validFlag;
+            if(!scanOptions->paramRequests || (validCount == fleetConfig->serviceCount + 2)) completeCount++;
+        }
+    }
+    freeIDNServerList(firstServerInfo);
+
+    // Time to the first server: First broadcast response (the scan statistics)
+    IDNSL_SCAN_STATS scanStats;
+    if(getIDNSessionStats(session, &scanStats)) { logError("getIDNSessionStats() failed"); return -1; }
+
+    unsigned rejectCount = 0;
+    for(unsigned i = 0; i < IDNSL_REJECT_REASONS; i++) rejectCount += scanStats.rejectCount[i];
+
+    unsigned followUpCount = 0;
+    for(unsigned i = 0; (i < scanStats.ifCount) && (i < IDNSL_STATS_IF_LIMIT); i++) followUpCount += scanStats.ifStats[i].followUpCount;
+
+    printf("%6u servers %-5s: found %6u (complete %6u), first %9.3f ms, complete %9.3f ms, cpu %9.3f ms, allocs %7lu (%llu kB), rejects %u, drops %u (follow-ups %u)\n",
+           fleetConfig->serverCount, label, serverCount, completeCount, (double)scanStats.usFirstResponse / 1000.0,
+           (double)nsComplete / 1000000.0, (double)nsCPU / 1000000.0, scanAllocCount, scanAllocBytes / 1024, rejectCount,
+           scanStats.packetsDropped, followUpCount);
+
+    return 0;
+}
+
+
+static int runBenchmark(const FLEET_CONFIG *fleetConfig, const IDNSL_SCAN_OPTIONS *scanOptions)
+{
+    // Replay: The trace stands in for the fleet
+    FLEET fleet;
+    memset(&fleet, 0, sizeof(fleet));
+    if(!scanOptions->traceReplay && startFleet(&fleet, fleetConfig)) return -1;
+
+    int result = -1;
+    IDNSL_SESSION *session = (IDNSL_SESSION *)0;
+    do
+    {
+        if(openIDNSession(&session, scanOptions, (const IDNSL_SESSION_CALLBACKS *)0)) { logError("openIDNSession() failed"); break; }
+
+        // First scan: All servers new. Second scan: Known servers updated in place
+        if(timeScan(session, fleetConfig, scanOptions, "cold")) break;
+        if(timeScan(session, fleetConfig, scanOptions, "warm")) break;
+
+        result = 0;
+    }
+    while(0);
+
+    if(session) closeIDNSession(session);
+    if(scanOptions->traceReplay) return result;
+    stopFleet(&fleet);
+
+    printf("%6u servers fleet: requests %lu, responses %lu, lost %lu (emulated), harness drops %lu (recv %lu)\n",
+           fleetConfig->serverCount, fleet.requestCount, fleet.responseCount, fleet.lossCount,
+           fleet.dropCount + fleet.recvDropCount, fleet.recvDropCount);
+
+    // The configured loss shall be the only loss (the results are meaningless otherwise)
+    if(fleet.dropCount || fleet.recvDropCount)
+    {
+        logError("Fleet of %u servers dropped packets itself, run invalid", fleetConfig->serverCount);
+        result = -1;
+    }
+
+    return result;
+}
+
+
+static void printUsage(const char *progName)
+{
+    printf("Usage: %s [options]\n", progName);
+    printf("  -n <count>       Fleet size (default: 10, 100, 1000, 10000)\n");
+    printf("  -addr <count>    Addresses per server (default: 1)\n");
+    printf("  -services <n>    Services per server (default: 1)\n");
+    printf("  -relays <n>      Relays per server (default: 0)\n");
+    printf("  -uid <hex>       UnitID of the first server (default: a0000000)\n");
+    printf("  -loss <percent>  Responses dropped (default: 0)\n");
+    printf("  -jitter <us>     Random extra response delay (default: 0)\n");
+    printf("  -spread <us>     Broadcast responses spread per server (default: 10)\n");
+    printf("  -timeout <ms>    Scan timeout (default: 5000)\n");
+    printf("  -quiet <factor>  Adaptive completion, quiet period in RTTs (default: 4)\n");
+    printf("  -workers <n>     Parallel scan worker threads (default: 0)\n");
+    printf("  -shared <0|1>    Single broadcast socket for the IPv4 interfaces (default: 0)\n");
+    printf("  -expect <n>      Receive buffers sized for n servers (default: 0, as found)\n");
+    printf("  -followups <n>   Follow-up broadcasts on kernel drops (default: 2)\n");
+    printf("  -stagger <ms>    Broadcasts spread across the window (default: 0, at once)\n");
+    printf("  -groups <mask>   Multi-group scan, client groups besides group 0 (default: 0)\n");
+    printf("  -params <window> Retrieve unit/link/service parameters, requests in flight per server (default: 0, off)\n");
+    printf("  -record <file>   Record the scans into a trace file (single fleet size)\n");
+    printf("  -replay <file>   Replay the scans of a trace file instead of the fleet (fleet options as recorded)\n");
+}
+
+
+int main(int argc, char **argv)
+{
+    if(plt_validateMonoTime() != 0)
+    {
+        logError("Monotonic time init failed");
+        return 1;
+    }
+
+    FLEET_CONFIG fleetConfig;
+    memset(&fleetConfig, 0, sizeof(fleetConfig));
+    fleetConfig.addressCount = 1;
+    fleetConfig.serviceCount = 1;
+    fleetConfig.unitIDBase = 0xA0000000;
+
+    IDNSL_SCAN_OPTIONS scanOptions;
+    initIDNScanOptions(&scanOptions);
+    scanOptions.msTimeout = 5000;
+    scanOptions.quietRTTFactor = 4;
+    scanOptions.ifInclude = "lo";
+
+    unsigned fleetSize = 0, usSpreadPerServer = 10;
+    for(int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *val = (i + 1 < argc) ? argv[i + 1] : (const char *)0;
+
+        if(!strcmp(arg, "-h") || !strcmp(arg, "--help")) { printUsage(argv[0]); return 0; }
+        if(val == (const char *)0) { printUsage(argv[0]); return 1; }
+
+        if(!strcmp(arg, "-n")) fleetSize = (unsigned)strtoul(val, (char **)0, 0);
+        else if(!strcmp(arg, "-addr")) fleetConfig.addressCount = (unsigned)strtoul(val, (char **)0, 0);
+        else if(!strcmp(arg, "-services")) fleetConfig.serviceCount = (unsigned)strtoul(val, (char **)0, 0);
+        else if(!strcmp(arg, "-relays")) fleetConfig.relayCount = (unsigned)strtoul(val, (char **)0, 0);
+        else if(!strcmp(arg, "-uid")) fleetConfig.unitIDBase = (uint32_t)strtoul(val, (char **)0, 16);
+        else if(!strcmp(arg, "-loss")) fleetConfig.lossPercent = (unsigned)strtoul(val, (char **)0, 0);
+        else if(!strcmp(arg, "-jitter")) fleetConfig.usJitter = (unsigned)strtoul(val, (char **)0, 0);
+        else if(!strcmp(arg, "-spread")) usSpreadPerServer = (unsigned)strtoul(val, (char **)0, 0);
+        else if(!strcmp(arg, "-timeout")) scanOptions.msTimeout = (unsigned)strtoul(val, (char **)0, 0);
+        else if(!strcmp(arg, "-quiet")) scanOptions.quietRTTFactor = (unsigned)strtoul(val, (char **)0, 0);
+        else if(!strcmp(arg, "-workers")) scanOptions.workerCount = (unsigned)strtoul(val, (char **)0, 0);
+        else if(!strcmp(arg, "-shared")) scanOptions.sharedSocket = (uint8_t)strtoul(val, (char **)0, 0);
+        else if(!strcmp(arg, "-expect")) scanOptions.expectedServers = (unsigned)strtoul(val, (char **)0, 0);
+        else if(!strcmp(arg, "-followups")) scanOptions.followUpLimit = (unsigned)strtoul(val, (char **)0, 0);
+        else if(!strcmp(arg, "-stagger")) scanOptions.msBroadcastWindow = (unsigned)strtoul(val, (char **)0, 0);
+        else if(!strcmp(arg, "-groups")) scanOptions.groupMask = (uint16_t)strtoul(val, (char **)0, 0);
+        else if(!strcmp(arg, "-params"))
+        {
+            scanOptions.paramWindow = (unsigned)strtoul(val, (char **)0, 0);
+            scanOptions.paramRequests = scanOptions.paramWindow ? (IDNSL_PARAMREQ_UNIT | IDNSL_PARAMREQ_LINK | IDNSL_PARAMREQ_SERVICE) : 0;
+        }
+        else if(!strcmp(arg, "-record")) scanOptions.traceRecord = val;
+        else if(!strcmp(arg, "-replay")) scanOptions.traceReplay = val;
+        else { printUsage(argv[0]); return 1; }
+        i++;
+    }
+
+    // Validate the fleet layout (service map entry counts are 8 bit, address range is 127.0.0.0/16)
+    if((fleetConfig.addressCount == 0) || (fleetConfig.serviceCount > 255) || (fleetConfig.relayCount > 255))
+    {
+        logError("Invalid fleet layout");
+        return 1;
+    }
+
+    // Trace: One file per session, a single fleet size
+    if((scanOptions.traceRecord || scanOptions.traceReplay) && !fleetSize)
+    {
+        logError("Trace record/replay requires a fleet size (-n)");
+        return 1;
+    }
+
+    unsigned serverCounts[] = { 10, 100, 1000, 10000 };
+    unsigned countCount = sizeof(serverCounts) / sizeof(serverCounts[0]);
+    if(fleetSize) { serverCounts[0] = fleetSize; countCount = 1; }
+
+    for(unsigned i = 0; i < countCount; i++)
+    {
+        fleetConfig.serverCount = serverCounts[i];
+        fleetConfig.usSpread = usSpreadPerServer * serverCounts[i];
+        if((fleetConfig.serverCount * fleetConfig.addressCount) > FLEET_MAX_ADDRESSES)
+        {
+            logError("Fleet of %u servers exceeds the address range", fleetConfig.serverCount);
+            return 1;
+        }
+
+        if(runBenchmark(&fleetConfig, &scanOptions)) return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,286 @@
+// -------------------------------------------------------------------------------------------------
+//  File benchIndex.c
+//
+//  Copyright (c) 2016, 2017 DexLogic, Dirk Apitz
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+// -------------------------------------------------------------------------------------------------
+//  Micro-benchmark for the response/server lookup in the scan engine. The module is included
+//  to get access to the (static) engine functions. Scan responses of simulated servers are
+//  fed directly into the response handler (no sockets). Lookup time of the hash index is
+//  compared to a linear walk of the same lists (the lookup used before the index). Service
+//  queries of the query index are compared to a walk of all service tables.
+// -------------------------------------------------------------------------------------------------
+
+#include "../src/idnServerList.c"
+#include "../src/idn-stream.h"
+
+
+// -------------------------------------------------------------------------------------------------
+//  Tools
+// -------------------------------------------------------------------------------------------------
+
+static void buildScanResponse(PLT_RECV_SLOT *recvSlot, unsigned serverIndex, uint16_t sequenceNum)
+{
+    // Server address 10.x.y.z (one address per server)
+    memset(&recvSlot->remoteAddr, 0, sizeof(recvSlot->remoteAddr));
+    recvSlot->remoteAddr.sin.sin_family = AF_INET;
+    recvSlot->remoteAddr.sin.sin_port = htons(IDNVAL_HELLO_UDP_PORT);
+    recvSlot->remoteAddr.sin.sin_addr.s_addr = htonl(0x0A000000 + serverIndex + 1);
+
+    // Packet header
+    IDNHDR_PACKET *packetHdr = (IDNHDR_PACKET *)recvSlot->bufferPtr;
+    packetHdr->command = IDNCMD_SCAN_RESPONSE;
+    packetHdr->flags = 0;
+    packetHdr->sequence = htons(sequenceNum);
+
+    // Scan response, unitID derived from the server index
+    IDNHDR_SCAN_RESPONSE *scanRspHdr = (IDNHDR_SCAN_RESPONSE *)&packetHdr[1];
+    memset(scanRspHdr, 0, sizeof(IDNHDR_SCAN_RESPONSE));
+    scanRspHdr->structSize = sizeof(IDNHDR_SCAN_RESPONSE);
+    scanRspHdr->protocolVersion = 0x10;
+    scanRspHdr->unitID[0] = 7;
+    scanRspHdr->unitID[1] = 1;
+    scanRspHdr->unitID[2] = (uint8_t)(serverIndex >> 24);
+    scanRspHdr->unitID[3] = (uint8_t)(serverIndex >> 16);
+    scanRspHdr->unitID[4] = (uint8_t)(serverIndex >> 8);
+    scanRspHdr->unitID[5] = (uint8_t)serverIndex;
+    snprintf((char *)scanRspHdr->hostName, sizeof(scanRspHdr->hostName), "unit%u", serverIndex);
+
+    recvSlot->dataLength = sizeof(IDNHDR_PACKET) + sizeof(IDNHDR_SCAN_RESPONSE);
+    recvSlot->recvFlags = 0;
+}
+
+
+static RESPONSE_INFO *linearResponseInfo(SCAN_CONTEXT *scanCtx, IDNSL_NET_ADDRESS *addr)
+{
+    for(RESPONSE_INFO *responseInfo = scanCtx->firstResponseInfo; responseInfo; responseInfo = responseInfo->next) 
+    {
+        if(matchNetAddress(&responseInfo->addr, addr)) return responseInfo;
+    }
+
+    return (RESPONSE_INFO *)0;
+}
+
+
+static IDNSL_SERVER_INFO *linearServerInfo(SCAN_CONTEXT *scanCtx, uint8_t *unitID)
+{
+    for(IDNSL_SERVER_INFO *serverInfo = scanCtx->firstServerInfo; serverInfo; serverInfo = serverInfo->next) 
+    {
+        if(serverInfo->unitID[0] != unitID[0]) continue;
+        if(!memcmp(&serverInfo->unitID[1], &unitID[1], unitID[0])) return serverInfo;
+    }
+
+    return (IDNSL_SERVER_INFO *)0;
+}
+
+
+static unsigned linearQuery(IDNSL_SERVER_INFO *firstServerInfo, uint8_t serviceType, const char *serviceName)
+{
+    unsigned matchCount = 0;
+    for(IDNSL_SERVER_INFO *serverInfo = firstServerInfo; serverInfo; serverInfo = serverInfo->next)
+    {
+        for(unsigned i = 0; i < serverInfo->serviceCount; i++)
+        {
+            IDNSL_SERVICE_INFO *serviceInfo = &serverInfo->serviceTable[i];
+            if(serviceInfo->serviceType != serviceType) continue;
+            if(serviceName && strcmp(serviceInfo->serviceName, serviceName)) continue;
+            matchCount++;
+        }
+    }
+
+    return matchCount;
+}
+
+
+// -------------------------------------------------------------------------------------------------
+//  Benchmark
+// -------------------------------------------------------------------------------------------------
+
+static int runQueryBenchmark(IDNSL_SERVER_INFO *firstServerInfo, unsigned serverCount)
+{
+    // Services: Four per server, one laser projector of a unique name, DMX on every 16th server
+    IDNSL_SERVICE_INFO *serviceTable = (IDNSL_SERVICE_INFO *)calloc(serverCount * 4, sizeof(IDNSL_SERVICE_INFO));
+    if(!serviceTable) { logError("calloc() failed"); return -1; }
+
+    unsigned serverIndex = 0;
+    for(IDNSL_SERVER_INFO *serverInfo = firstServerInfo; serverInfo; serverInfo = serverInfo->next, serverIndex++)
+    {
+        IDNSL_SERVICE_INFO *serviceInfo = &serviceTable[serverIndex * 4];
+        uint8_t serviceTypes[4] = { IDNVAL_STYPE_LAPRO, IDNVAL_STYPE_AUDIO, IDNVAL_STYPE_AUDIO, IDNVAL_STYPE_MIDI };
+        if((serverIndex % 16) == 0) serviceTypes[3] = IDNVAL_STYPE_DMX512;
+        for(unsigned i = 0; i < 4; i++)
+        {
+            serviceInfo[i].serviceID = (uint8_t)(i + 1);
+            serviceInfo[i].serviceType = serviceTypes[i];
+            snprintf(serviceInfo[i].serviceName, sizeof(serviceInfo[i].serviceName), "svc%u", i);
+        }
+        snprintf(serviceInfo[0].serviceName, sizeof(serviceInfo[0].serviceName), "laser%u", serverIndex);
+        serverInfo->serviceCount = 4;
+        serverInfo->serviceTable = serviceInfo;
+    }
+
+    uint32_t usStart = plt_getMonoTimeUS();
+    IDNSL_QUERY_INDEX *queryIndex;
+    if(createIDNQueryIndex(firstServerInfo, &queryIndex)) return -1;
+    uint32_t usCreate = plt_getMonoTimeUS() - usStart;
+
+    // Queries: DMX servers (by type) and a single projector (by type and name)
+    IDNSL_QUERY_RESULT resultTable[16];
+    unsigned queryCount = (serverCount < 2000) ? 20000 : 2000, indexCount = 0, linearCount = 0;
+    char serviceName[IDNSL_SERVICE_NAME_LENGTH];
+    IDNSL_QUERY query;
+    memset(&query, 0, sizeof(query));
+
+    usStart = plt_getMonoTimeUS();
+    for(unsigned i = 0; i < queryCount; i++)
+    {
+        snprintf(serviceName, sizeof(serviceName), "laser%u", (i * 7919u) % serverCount);
+        query.queryFlags = IDNSL_QUERY_SERVICE_TYPE;
+        query.serviceType = IDNVAL_STYPE_DMX512;
+        int rc = queryIDNServices(queryIndex, &query, resultTable, 16);
+        indexCount += (rc > 0) ? rc : 0;
+
+        query.queryFlags = IDNSL_QUERY_SERVICE_TYPE | IDNSL_QUERY_SERVICE_NAME;
+        query.serviceType = IDNVAL_STYPE_LAPRO;
+        query.serviceName = serviceName;
+        rc = queryIDNServices(queryIndex, &query, resultTable, 16);
+        indexCount += (rc > 0) ? rc : 0;
+    }
+    uint32_t usQuery = plt_getMonoTimeUS() - usStart;
+
+    usStart = plt_getMonoTimeUS();
+    for(unsigned i = 0; i < queryCount; i++)
+    {
+        snprintf(serviceName, sizeof(serviceName), "laser%u", (i * 7919u) % serverCount);
+        unsigned matchCount = linearQuery(firstServerInfo, IDNVAL_STYPE_DMX512, (const char *)0);
+        linearCount += (matchCount < 16) ? matchCount : 16;
+        linearCount += linearQuery(firstServerInfo, IDNVAL_STYPE_LAPRO, serviceName);
+    }
+    uint32_t usLinear = plt_getMonoTimeUS() - usStart;
+
+    if(indexCount != linearCount) logError("Query mismatch (%u vs. %u)", indexCount, linearCount);
+
+    printf("%6u servers: create index %8.3f us/server, query %8.3f us, linear %8.3f us (x%.1f)\n",
+           serverCount, (double)usCreate / serverCount, (double)usQuery / (queryCount * 2),
+           (double)usLinear / (queryCount * 2), usQuery ? ((double)usLinear / usQuery) : 0.0);
+
+    // Cleanup (service tables are not owned by the server table)
+    freeIDNQueryIndex(queryIndex);
+    for(IDNSL_SERVER_INFO *serverInfo = firstServerInfo; serverInfo; serverInfo = serverInfo->next)
+    {
+        serverInfo->serviceCount = 0;
+        serverInfo->serviceTable = (IDNSL_SERVICE_INFO *)0;
+    }
+    free(serviceTable);
+
+    return 0;
+}
+
+
+
+static int runBenchmark(unsigned serverCount)
+{
+    SCAN_CONTEXT *scanCtx = (SCAN_CONTEXT *)calloc(1, sizeof(SCAN_CONTEXT));
+    INTERFACE_NODE *ifNode = (INTERFACE_NODE *)calloc(1, sizeof(INTERFACE_NODE));
+    if(!scanCtx || !ifNode) { logError("calloc() failed"); return -1; }
+
+    initIDNScanOptions(&scanCtx->scanOptions);
+    initPacketRing(&scanCtx->scanRing, &scanCtx->scanSlotBuffer[0][0], SCAN_SLOT_SIZE, SCAN_SLOT_COUNT);
+    initTokenBucket(&scanCtx->defaultPacer, 0, 1, plt_getMonoTimeNS());
+    initHashIndex(&scanCtx->responseIndex, &scanCtx->scanArena);
+    initHashIndex(&scanCtx->serverIndex, (MEM_ARENA *)0);
+    scanCtx->scanCount = 1;
+    scanCtx->groupTable[scanCtx->groupCount++] = scanCtx->clientGroup;
+    scanCtx->checkRequestQueue.queueStats = &scanCtx->scanStats.checkQueue;
+    scanCtx->infoRequestQueue.queueStats = &scanCtx->scanStats.infoQueue;
+    initTokenBucket(&ifNode->requestPacer, 0, 1, plt_getMonoTimeNS());
+    ifNode->scanSequenceNum = 0x1234;
+
+    PLT_RECV_SLOT *recvSlot = &scanCtx->scanRing.slotTable[0];
+
+    // Full response handling: Every server responds to the broadcast
+    uint32_t usStart = plt_getMonoTimeUS();
+    for(unsigned i = 0; i < serverCount; i++)
+    {
+        buildScanResponse(recvSlot, i, ifNode->scanSequenceNum);
+        if(handleScanResponse(scanCtx, ifNode, recvSlot)) return -1;
+    }
+    uint32_t usHandle = plt_getMonoTimeUS() - usStart;
+
+    // Lookup only: Hash index vs. linear list walk (for all servers)
+    unsigned lookupCount = (serverCount < 2000) ? 20000 : 2000, hitCount = 0;
+    IDNSL_NET_ADDRESS remoteAddr;
+    usStart = plt_getMonoTimeUS();
+    for(unsigned i = 0; i < lookupCount; i++)
+    {
+        buildScanResponse(recvSlot, (i * 7919u) % serverCount, 0);
+        IDNHDR_SCAN_RESPONSE *scanRspHdr = (IDNHDR_SCAN_RESPONSE *)&((IDNHDR_PACKET *)recvSlot->bufferPtr)[1];
+        getSockAddress(&remoteAddr, &recvSlot->remoteAddr);
+        hitCount += (getResponseInfo(scanCtx, &remoteAddr) != (RESPONSE_INFO *)0);
+        hitCount += (getServerInfo(scanCtx, scanRspHdr, scanCtx->clientGroup) != (IDNSL_SERVER_INFO *)0);
+    }
+    uint32_t usIndex = plt_getMonoTimeUS() - usStart;
+
+    usStart = plt_getMonoTimeUS();
+    for(unsigned i = 0; i < lookupCount; i++)
+    {
+        buildScanResponse(recvSlot, (i * 7919u) % serverCount, 0);
+        IDNHDR_SCAN_RESPONSE *scanRspHdr = (IDNHDR_SCAN_RESPONSE *)&((IDNHDR_PACKET *)recvSlot->bufferPtr)[1];
+        getSockAddress(&remoteAddr, &recvSlot->remoteAddr);
+        hitCount += (linearResponseInfo(scanCtx, &remoteAddr) != (RESPONSE_INFO *)0);
+        hitCount += (linearServerInfo(scanCtx, scanRspHdr->unitID) != (IDNSL_SERVER_INFO *)0);
+    }
+    uint32_t usLinear = plt_getMonoTimeUS() - usStart;
+
+    if(hitCount != lookupCount * 4) logError("Lookup mismatch (%u of %u)", hitCount, lookupCount * 4);
+
+    printf("%6u servers: handle %8.3f us/packet, lookup index %8.3f us, linear %8.3f us (x%.1f)\n",
+           serverCount, (double)usHandle / serverCount, (double)usIndex / lookupCount,
+           (double)usLinear / lookupCount, usIndex ? ((double)usLinear / usIndex) : 0.0);
+
+    if(runQueryBenchmark(scanCtx->firstServerInfo, serverCount)) return -1;
+
+    // Cleanup (server table on heap, response records are scan arena memory)
+    freeServerTable(scanCtx);
+    arenaFree(&scanCtx->scanArena);
+    free(ifNode);
+    free(scanCtx);
+
+    return 0;
+}
+
+
+int main(int argc, char **argv)
+{
+    if(plt_validateMonoTime() != 0)
+    {
+        logError("Monotonic time init failed");
+        return 1;
+    }
+
+    unsigned serverCounts[] = { 10, 100, 1000, 10000 };
+    for(unsigned i = 0; i < sizeof(serverCounts) / sizeof(serverCounts[0]); i++)
+    {
+        if(runBenchmark(serverCounts[i])) return 1;
+    }
+
+    return 0;
+}
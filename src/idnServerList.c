@@ -91,39 +91,405 @@
                                                                                             \
         unsigned i = 0;                                                                     \
         char *dst = dstField;                                                               \
-        uint8_t *src = srcField;                                                            \
+        const uint8_t *src = srcField;                                                      \
         for(; (i < cpyCount) && (*src != 0); i++) *dst++ = *src++;                          \
-        for(; i < sizeof(dstField); i++) *dst = 0;                                          \
+        for(; i < sizeof(dstField); i++) *dst++ = 0;                                        \
     }
 
+#define EVENT_TABLE_SIZE                    64          // Max. number of events per wait
+
+#define SCAN_SLOT_COUNT                     32          // Receive ring slots for scan responses
+#define SCAN_SLOT_SIZE                      0x800       // MTU sized slot (scan responses are small)
+#define INFO_SLOT_COUNT                     8           // Receive ring slots for info responses
+#define INFO_SLOT_SIZE                      0x3000      // Fits the largest service map (2 * 255 entries)
+#define RECV_BATCH_LIMIT                    8           // Max. number of batches per socket and wakeup
+#define SEND_BATCH_LIMIT                    8           // Max. number of batches per socket and wakeup
+#define PACING_LOOKAHEAD                    64          // Max. number of jobs inspected for pacing
+#define TOKEN_SCALE                         1000000     // Token bucket credit per token (us per s)
+#define QUIET_PERIOD_MAX                    1000000     // Adaptive completion: Upper limit (us) of the quiet period
+#define WHEEL_SLOT_COUNT                    256         // Retransmission timer wheel slots (power of 2)
+#define WHEEL_TICK                          1000        // Timer wheel slot granularity (us)
+#define HASH_INDEX_MIN_SIZE                 64          // Initial number of hash index slots
+#define RECV_BUFFER_MIN                     0x40000     // Min. receive buffer size of the sockets (256 kB)
+#define RECV_BUFFER_MAX                     0x1000000   // Max. receive buffer size of the sockets (16 MB)
+#define RECV_BUFFER_PER_SERVER              0x400       // Kernel memory of a queued response datagram (incl. overhead)
+#define FOLLOWUP_DELAY_MIN                  5000        // Min. delay (us) of a follow-up broadcast after kernel drops
+#define ARENA_CHUNK_SIZE                    0x10000     // Initial arena chunk size
+#define ARENA_ALIGN                         16          // Alignment of arena allocations
+
+#define ALIGN_SIZE(size, align)             (((size) + ((align) - 1)) & ~(size_t)((align) - 1))
+
+#define EVSRC_INTERFACE                     1           // Interface broadcast socket
+#define EVSRC_REQUEST_QUEUE                 2           // Unicast request queue socket
+#define EVSRC_SHARED_SOCKET                 3           // Shared IPv4 broadcast socket (interfaces: indexed)
+
+#define SCANSTATE_IDLE                      0           // No scan running (or blocking scan)
+#define SCANSTATE_ASYNC                     1           // Async scan running (external event loop)
+#define SCANSTATE_DONE                      2           // Async scan complete, result not polled yet
+
+#define SHM_MAGIC                           0x4D485349  // Shared memory segment: 'ISHM' (host byte order)
+#define SHM_READ_RETRIES                    1000        // Reader: Max. retries in case of concurrent updates
+
+#define CACHE_MAGIC                         0x48434349  // Discovery cache file: 'ICCH' (host byte order)
+#define CACHE_VERSION                       2           // Discovery cache file: Layout version
+
+#define TRACE_MAGIC                         0x52544449  // Trace file: 'IDTR' (host byte order)
+#define TRACE_VERSION                       1           // Trace file: Layout version
+#define TRACE_ALIGN                         4           // Alignment of the trace records
+
+#define TRACEREC_SCAN                       1           // Trace record: Start of a scan (TRACE_SCAN payload)
+#define TRACEREC_INTERFACE                  2           // Trace record: Interface of the scan (name payload)
+#define TRACEREC_SENT                       3           // Trace record: Datagram sent
+#define TRACEREC_RECEIVED                   4           // Trace record: Datagram received
+#define TRACEREC_SCAN_END                   5           // Trace record: End of the scan
+
+#define TRACEROLE_INTERFACE                 1           // Trace socket role: Interface broadcast socket
+#define TRACEROLE_SHARED                    2           // Trace socket role: Shared IPv4 broadcast socket
+#define TRACEROLE_CHECK                     3           // Trace socket role: Reachability check socket
+#define TRACEROLE_INFO                      4           // Trace socket role: Device info socket
+
+#define NET_ADDR_STRLEN                     64          // IPv4/IPv6 address string (including the scope)
+#define IP6_SCAN_GROUP                      "ff02::1"   // Default IPv6 scan group (link-local all nodes)
+
+#define PING_PAYLOAD_SIZE                   4           // Ping request payload: Send time (us, echoed)
+#define PARAM_PAYLOAD_SIZE                  4           // Service parameter request payload: Service ID, reserved
+
+#define TARGET_RANGE_LIMIT                  0x10000     // Max. number of addresses of a scan target (/16)
+#define TARGET_SPEC_LENGTH                  40          // Max. length of a scan target specification
+#define SWEEP_QUEUE_LIMIT                   64          // Max. number of queued check requests fed by sweeps
+
+#ifndef IDNSL_PACKET_LOG_RATE
+#define IDNSL_PACKET_LOG_RATE               10          // Rejected datagrams logged per second (build option, 0: not logged)
+#endif
+
+#define JOBSTATE_NONE                       0           // Sent/dropped (memory released with the arena)
+#define JOBSTATE_QUEUED                     1           // Pending in the request queue
+#define JOBSTATE_INFLIGHT                   2           // Sent, waiting for the response in the timer wheel
+
 
 // -------------------------------------------------------------------------------------------------
 //  Typedefs
 // -------------------------------------------------------------------------------------------------
 
+typedef struct
+{
+    unsigned sourceType;                        // The kind of socket owner (EVSRC_*)
+    void *sourceRecord;                         // The owner (INTERFACE_NODE, REQUEST_QUEUE or SCAN_CONTEXT)
+    unsigned evFlags;                           // Registered event interest (PLT_EVFLG_*)
+
+} EVENT_SOURCE;
+
+
+typedef struct
+{
+    PLT_RECV_SLOT slotTable[SCAN_SLOT_COUNT];   // Slot descriptors (buffers assigned once)
+    unsigned slotCount;                         // Number of slots (up to SCAN_SLOT_COUNT)
+
+} PACKET_RING;
+
+
+typedef struct _ARENA_CHUNK
+{
+    struct _ARENA_CHUNK *next;                  // Singly linked list of chunks (current first)
+    size_t chunkSize;                           // Usable size of the chunk
+    size_t usedSize;                            // Bytes allocated from the chunk
+
+    // Followed by chunk data (aligned)
+
+} ARENA_CHUNK;
+
+
+typedef struct
+{
+    ARENA_CHUNK *firstChunk;                    // Chunk list, allocations are made from the first
+
+} MEM_ARENA;
+
+
+typedef struct
+{
+    uint32_t hashValue;                         // Full hash value of the entry key
+    void *entryPtr;                             // The entry (0: empty slot)
+
+} HASH_SLOT;
+
+
+typedef struct
+{
+    HASH_SLOT *slotTable;                       // Open addressing table (linear probing)
+    unsigned slotMask;                          // Number of slots - 1 (power of 2)
+    unsigned entryCount;                        // Number of entries in the table
+    MEM_ARENA *memArena;                        // Memory for the table (0: heap)
+
+} HASH_INDEX;
+
+
+typedef int (* HASH_MATCH_PFN)(const void *entryPtr, const void *keyPtr);
+
+
+typedef struct
+{
+    unsigned tokenRate;                         // Tokens per second (0: unlimited)
+    unsigned tokenBurst;                        // Bucket depth (max. number of tokens)
+    uint64_t tokenCredit;                       // Available tokens (scaled by TOKEN_SCALE)
+    uint64_t nsRefill;                          // Time of the last refill (64 bit, buckets live as long as the session)
+
+} TOKEN_BUCKET;
+
+
 typedef struct _INTERFACE_NODE
 {
     struct _INTERFACE_NODE *prev, *next;        // Doubly linked list of interface records
 
     char ifName[40];
+    IDNSL_NET_ADDRESS ifAddr;                   // Interface address (IPv4 or link-local IPv6)
+    uint8_t visitFlag;                          // Interface list update: Set in case still present
 
-    int fdSocket;                               // Broadcast socket file descriptor
-    uint16_t scanSequenceNum;                   // Broadcast scan sequence number
+    int fdSocket;                               // Broadcast socket file descriptor (-1: shared socket)
+    unsigned ifIndex;                           // Shared socket: Interface to send on (0: by source address)
+    uint8_t sendPendingFlag;                    // Shared socket: Scan request not sent yet
+    uint16_t scanSequenceNum;                   // Broadcast scan sequence number (multi-group: of the first group)
+    uint8_t groupSentCount;                     // Multi-group scan: Group broadcasts of the request sent so far
+    uint32_t usScanSent;                        // Time the broadcast scan request was sent
+
+    uint8_t bcastDueFlag;                       // Broadcast scheduled at usBcastDue (staggered or follow-up)
+    uint32_t usBcastDue;                        // Time the scheduled broadcast is due
+    uint32_t lastYield;                         // Datagrams received in the last scan (broadcast order)
+
+    uint32_t dropCounter;                       // Kernel drops of the socket reported so far
+    uint8_t followUpFlag;                       // The scheduled broadcast is a follow-up (kernel drops)
+    unsigned followUpCount;                     // Follow-up broadcasts sent in the current scan
+
+    TOKEN_BUCKET requestPacer;                  // Unicast request pacing (servers found on interface)
+    IDNSL_IF_STATS ifStats;                     // Counters of the current scan
+
+    EVENT_SOURCE eventSource;                   // Event loop registration (user data)
 
 } INTERFACE_NODE;
 
 
+typedef struct
+{
+    uint32_t firstAddr;                         // First (or broadcast) address (host byte order)
+    uint32_t addrCount;                         // Number of addresses (1 for a host or broadcast)
+    uint8_t broadcastFlag;                      // Set for a (subnet-directed) broadcast address
+    uint16_t scanSequenceNum;                   // Broadcast scan sequence number
+    uint32_t usScanSent;                        // Time the broadcast scan request was scheduled
+    uint32_t sweepIndex;                        // Ranges: Next address of the sweep (resumed by the next scan)
+    uint32_t sweepCount;                        // Ranges: Number of sweeps started
+
+} SCAN_TARGET;
+
+
+typedef struct _SERVER_NODE
+{
+    IDNSL_SERVER_INFO serverInfo;               // Public server info (first member, tables on heap)
+
+    uint32_t *addressScanTable;                 // Scan number of the last response per address
+    unsigned addressLimit;                      // Allocated number of address table entries
+
+    uint8_t scanStatus;                         // Unit status reported by the last scan response
+    uint8_t otherGroupFlag;                     // Multi-group scan: scanStatus from another group (new server)
+    uint8_t serviceMapFlag;                     // Set in case the service map is up to date
+    uint8_t paramFlag;                          // Set in case all parameter responses were received
+    uint8_t foundFlag;                          // Set once the server was reported (onServerFound)
+    uint8_t changedFlag;                        // Set in case a change is to be reported (onServerChanged)
+    uint32_t seenScanCount;                     // Scan number of the last response of the server
+    unsigned missedScanCount;                   // Number of consecutive scans without response
+    uint64_t lastSeenTime;                      // Wall clock time (seconds) of the last response
+
+    struct _SERVER_NODE *mergeNext;             // Parallel scan: Next record in the merge bucket
+    struct _SERVER_NODE *mergeDup;              // Parallel scan: Records of the server found by other workers
+    uint8_t mergePrimary;                       // Parallel scan: Set for the first record of a server
+
+} SERVER_NODE;
+
+
+typedef struct
+{
+    SERVER_NODE **bucketTable;                  // Bucket lists by unitID hash (lock-free insertion)
+    unsigned bucketMask;                        // Number of buckets - 1 (power of 2)
+
+} MERGE_INDEX;
+
+
+typedef struct
+{
+    volatile uint32_t magic;                    // SHM_MAGIC once initialized
+    uint32_t segmentSize;                       // Size of the segment (header and snapshot area)
+    volatile uint32_t sequenceNum;              // Seqlock: Odd while the snapshot is written
+    volatile uint32_t publishCount;             // Number of snapshots published
+    volatile uint32_t snapshotSize;             // Size of the current snapshot (0: none yet)
+    uint32_t reserved;
+
+    // Followed by the snapshot area (aligned, see SHM_HEADER_SIZE)
+
+} SHM_HEADER;
+
+#define SHM_HEADER_SIZE                     ALIGN_SIZE(sizeof(SHM_HEADER), 16)
+
+
+typedef struct
+{
+    uint32_t magic;                             // CACHE_MAGIC
+    uint16_t version;                           // CACHE_VERSION
+    uint16_t headerSize;                        // sizeof(CACHE_HEADER)
+    uint32_t serverCount;                       // Number of servers (and CACHE_SERVER records)
+    uint32_t snapshotOffset;                    // Offset of the snapshot (aligned)
+
+    // Followed by the server records (CACHE_SERVER[serverCount], snapshot order), then the snapshot
+
+} CACHE_HEADER;
+
+
+typedef struct
+{
+    uint64_t lastSeenTime;                      // Wall clock time (seconds) of the last response
+    uint8_t scanStatus;                         // Status reported in the scan response
+    uint8_t serviceMapFlag;                     // Set in case the snapshot has the service map
+    uint8_t reserved[6];
+
+} CACHE_SERVER;
+
+
+typedef struct
+{
+    uint32_t magic;                             // TRACE_MAGIC
+    uint16_t version;                           // TRACE_VERSION
+    uint16_t headerSize;                        // sizeof(TRACE_HEADER)
+    uint32_t traceLength;                       // Length of the valid data (header and records)
+    uint32_t recordCount;                       // Number of records
+
+    // Followed by the records (TRACE_RECORD, each followed by its payload, TRACE_ALIGN aligned)
+
+} TRACE_HEADER;
+
+
+typedef struct
+{
+    uint32_t usTime;                            // Time since the start of the recording
+    uint8_t recordType;                         // The kind of record (TRACEREC_*)
+    uint8_t traceRole;                          // The socket (TRACEROLE_*)
+    uint16_t dataLength;                        // Length of the payload (datagram, name)
+    uint16_t peerPort;                          // Port of the remote address
+    uint8_t recvFlags;                          // Receive condition flags (PLT_RECVFLG_*)
+    uint8_t reserved;
+    uint32_t dropCounter;                       // Kernel drops of the socket so far (as received)
+    IDNSL_NET_ADDRESS localAddr;                // Interface address (interface/shared socket)
+    IDNSL_NET_ADDRESS peerAddr;                 // Sender/destination address
+
+} TRACE_RECORD;
+
+
+typedef struct
+{
+    uint16_t sequenceNum;                       // Next sequence number at the start of the scan
+    uint16_t reserved;
+    uint32_t randomState;                       // Jitter state at the start of the scan
+
+} TRACE_SCAN;
+
+
+struct _IDNSL_PUBLISHER
+{
+    PLT_SHARED_MEM sharedMem;                   // The segment (read/write)
+    char memName[128];                          // Name of the segment (removed on close)
+};
+
+
+struct _IDNSL_READER
+{
+    PLT_SHARED_MEM sharedMem;                   // The segment (read-only)
+};
+
+
+typedef struct
+{
+    const IDNSL_SERVER_INFO *serverInfo;        // The server (of the indexed list)
+    IDNSL_SERVICE_INFO serviceInfo;             // Copy of the service entry (lazy service maps decoded)
+
+} QUERY_ENTRY;
+
+
+typedef struct
+{
+    const IDNSL_SERVER_INFO *serverInfo;        // The server (of the indexed list)
+    unsigned entryStart;                        // First service entry (entryTable index)
+    unsigned entryCount;                        // Number of service entries
+
+} QUERY_SERVER;
+
+
+struct _IDNSL_QUERY_INDEX
+{
+    unsigned serverCount;                       // Number of servers
+    unsigned entryCount;                        // Number of services (all servers)
+
+    QUERY_SERVER *serverTable;                  // Servers (list order)
+    QUERY_SERVER **unitIDTable;                 // Servers by unitID (length, then bytes)
+    QUERY_SERVER **hostTable;                   // Servers by host name
+    QUERY_ENTRY *entryTable;                    // Services (list order, servers in sequence)
+    QUERY_ENTRY **typeTable;                    // Services by type (then list order)
+    QUERY_ENTRY **nameTable;                    // Services by name (then list order)
+
+    // Followed by the tables (single memory block)
+};
+
+
+struct _IDNSL_SERVICE_MAP
+{
+    uint32_t mapSize;                           // Size of the map including all tables (no pointers)
+    uint8_t relayCount;                         // Number of relay entries
+    uint8_t serviceCount;                       // Number of service entries
+
+    // Followed by the (validated) entry table as received: Relay entries, then service entries
+    // Followed by the relay index of each service (relayCount: root service)
+    // Followed by the service indices grouped by relay (root services last, service order kept)
+    // Followed by the group start of each relay (relayCount + 2 entries, last is serviceCount)
+};
+
+
+typedef struct
+{
+    uint8_t pendingFlag;                        // Set while the response is outstanding
+    uint8_t cmd;                                // Request command (response: cmd + 1)
+    uint16_t sequenceNum;                       // Request sequence number (matched with the response)
+    unsigned paramIndex;                        // Parameter requests: Index into the server parameter table
+    struct _REQUEST_JOB *reqJob;                // Request job (retransmission), 0: none
+
+} INFO_REQUEST;
+
+
 typedef struct _RESPONSE_INFO
 {
     struct _RESPONSE_INFO *prev, *next;         // Doubly linked list of response info records
 
-    struct in_addr addr;                        // Remote address the response was received from
+    IDNSL_NET_ADDRESS addr;                     // Remote address the response was received from
     IDNSL_SERVER_INFO *serverInfo;              // Associated server info record
+    TOKEN_BUCKET *requestPacer;                 // Pacing of requests to the address
 
     uint16_t ambiguousErrorFlag;                // Set in case multiple servers responded on the address
     uint16_t infoRequestFlag;                   // Set for default address in case info was requested
     uint16_t checkSequenceNum;                  // Reachability check sequence number
-    uint16_t serviceMapSequenceNum;             // Service map info request sequence number
+    uint16_t checkPendingFlag;                  // Set while the check awaits its first response
+    uint16_t targetRequestFlag;                 // Set in case a scan target request was scheduled
+    uint16_t pingSequenceNum;                   // Sequence number of the current ping request
+    uint16_t pingPendingFlag;                   // Set while the current ping awaits its response
+    uint16_t pingRequestFlag;                   // Set in case the address is pinged in this scan
+    uint16_t scanSentFlag;                      // Set in case the address responded to a broadcast
+    uint32_t usScanSent;                        // Send time of that broadcast (latency statistics)
+
+    unsigned rttSampleCount;                    // Ping responses received (this scan)
+    uint32_t usRTTSum;                          // Sum of the round trip times
+    uint32_t usRTTLast;                         // Round trip time of the previous ping
+    uint32_t usJitterSum;                       // Sum of the differences of consecutive round trip times
+
+    struct _REQUEST_JOB *checkJob;              // Check request waiting for the response (0: none)
+    struct _REQUEST_JOB *pingJob;               // Ping request waiting for the response (0: none)
+
+    INFO_REQUEST *infoTable;                    // Info requests in flight (IDNSL_PARAM_WINDOW_MAX, 0: none)
+    unsigned paramNext;                         // Next parameter table entry to be requested
+    uint8_t paramActiveFlag;                    // Set while the parameters are retrieved
 
 } RESPONSE_INFO;
 
@@ -132,41 +498,137 @@ typedef struct _REQUEST_JOB
 {
     struct _REQUEST_JOB *prev, *next;           // Doubly linked list of request jobs
 
-    struct in_addr addr;                        // Remote address the request shall be sent to
+    IDNSL_NET_ADDRESS addr;                     // Remote address the request shall be sent to
+    TOKEN_BUCKET *requestPacer;                 // Pacing of the request (interface or default)
     uint16_t packetLength;                      // Length of the data
 
+    struct _REQUEST_QUEUE *requestQueue;        // The queue the request is (re-)sent by
+    struct _REQUEST_JOB **ownerRef;             // Owner reference, reset on completion (0: no retransmission)
+    struct _RESPONSE_INFO *infoOwner;           // Info requests: The address record tracking the request
+    uint8_t infoIndex;                          // Info requests: Index into the info table of infoOwner
+    uint64_t usDue;                             // Retransmission time (in flight, 64-bit time base)
+    uint16_t wheelIndex;                        // Timer wheel slot (in flight)
+    uint8_t retryCount;                         // Number of retransmissions
+    uint8_t jobState;                           // JOBSTATE_*
+
     // Followed by packet data bytes
 
 } REQUEST_JOB;
 
 
 typedef struct
+{
+    REQUEST_JOB *firstJob;                      // Head of in-flight request list
+    REQUEST_JOB *lastJob;                       // Tail of in-flight request list
+
+} WHEEL_SLOT;
+
+
+typedef struct
+{
+    WHEEL_SLOT slotTable[WHEEL_SLOT_COUNT];     // Slots by due tick (hashed, multiple rounds per slot)
+    uint64_t tickDone;                          // Last tick processed (64-bit time base, no wrap)
+    unsigned jobCount;                          // Number of requests in flight
+
+} TIMER_WHEEL;
+
+
+typedef struct _REQUEST_QUEUE
 {
     REQUEST_JOB *firstRequest;                  // Head of request job list
     REQUEST_JOB *lastRequest;                   // Tail of request job list
 
     int fdSocket;                               // Unicast socket file descriptor
+    int addrFamily;                             // Socket address family (AF_INET6: dual-stack)
+
+    unsigned queuedCount;                       // Number of requests waiting to be sent
+    IDNSL_QUEUE_STATS *queueStats;              // Counters of the queue (in the scan statistics)
+    uint32_t dropCounter;                       // Kernel drops of the socket reported so far
+
+    EVENT_SOURCE eventSource;                   // Event loop registration (user data)
 
 } REQUEST_QUEUE;
 
 
-typedef struct
+typedef struct _IDNSL_SESSION
 {
+    IDNSL_SCAN_OPTIONS scanOptions;             // The options the session was opened with
+    IDNSL_SESSION_CALLBACKS callbacks;          // Event notification (all callbacks optional)
     uint8_t clientGroup;                        // The client group to run on
+    uint8_t groupCount;                         // Multi-group scan: Number of groups broadcast (1: clientGroup only)
+    uint8_t groupTable[16];                     // Multi-group scan: The groups (groupTable[0]: clientGroup)
 
-    IDNSL_SERVER_INFO *firstServerInfo;         // The resulting server info list
+    IDNSL_SERVER_INFO *firstServerInfo;         // The server table (SERVER_NODE records, session lifetime)
 
     INTERFACE_NODE *firstIfNode;                // Head of interface record list
     INTERFACE_NODE *lastIfNode;                 // Tail of interface record list
 
     RESPONSE_INFO *firstResponseInfo;           // Head of response info record list
     RESPONSE_INFO *lastResponseInfo;            // Tail of response info record list
+    IDNSL_SERVER_INFO *lastServerInfo;          // Tail of the server table
+
+    HASH_INDEX responseIndex;                   // Response info records by address (per scan)
+    HASH_INDEX serverIndex;                     // Server records by (length-prefixed) unitID (heap)
 
     REQUEST_QUEUE checkRequestQueue;            // Check request jobs
     REQUEST_QUEUE infoRequestQueue;             // Info request jobs
+    int fdShared;                               // Shared IPv4 broadcast socket (-1: per interface sockets)
+    EVENT_SOURCE sharedSource;                  // Shared socket event loop registration
+    uint32_t sharedDropCounter;                 // Kernel drops of the shared socket reported so far
+    unsigned recvBufferSize;                    // Receive buffer size set on the sockets (0: system default)
+    HASH_INDEX ifAddrIndex;                     // Shared socket: Interface records by IPv4 address (heap)
+    TOKEN_BUCKET defaultPacer;                  // Pacing for addresses not related to an interface
+    TOKEN_BUCKET targetPacer;                   // Pacing of scan target requests (sweeps)
+    TIMER_WHEEL retryWheel;                     // Requests waiting for a response (retransmission)
+    uint32_t randomState;                       // Retransmission jitter (xorshift state)
+
+    PLT_EVENTLOOP eventLoop;                    // Socket readiness notification
+
+    PACKET_RING scanRing;                       // Receive ring for broadcast/check sockets
+    PACKET_RING infoRing;                       // Receive ring for the info socket
 
     uint16_t sequenceNum;                       // Next sequence number to be used
-    uint8_t packetBuffer[0x10000];              // Receive packet buffer
+    uint32_t scanCount;                         // Number of the current scan (starting at 1)
+
+    uint32_t usLastActivity;                    // Time of the last datagram sent or received
+    uint32_t usMaxRTT;                          // Max. response time to a broadcast (current scan)
+    uint32_t usScanStart;                       // Start time of the current scan
+    uint32_t usScanTimeout;                     // Max. duration of the current scan
+    unsigned scanState;                         // Async scan state (SCANSTATE_*)
+    uint8_t verifyScanFlag;                     // Unicast checks of known addresses only (no broadcast)
+
+    uint64_t nsIfRefresh;                       // Time of the last interface list update
+    struct in6_addr ip6Group;                   // IPv6 multicast group of the scan request
+
+    SCAN_TARGET *targetTable;                   // Scan targets (hosts, ranges, directed broadcasts)
+    unsigned targetCount;                       // Number of scan targets
+
+    struct _IDNSL_SESSION **workerTable;        // Parallel scan: Worker contexts (own interfaces/sockets)
+    unsigned workerCount;                       // Parallel scan: Number of workers (0: single thread)
+    MERGE_INDEX mergeIndex;                     // Parallel scan: Worker server records by unitID
+    IDNSL_SERVER_INFO *mergedServerInfo;        // Parallel scan: Merged server list (scan arena)
+
+    struct _IDNSL_SESSION *parentCtx;           // Worker: The session context
+    PLT_THREAD workerThread;                    // Worker: The thread running the scan
+    int workerResult;                           // Worker: Result of the scan
+
+    IDNSL_SCAN_STATS scanStats;                 // Counters of the current scan
+    IDNSL_SCAN_STATS lastScanStats;             // Statistics of the last completed scan (workers: merged)
+    TOKEN_BUCKET logPacer;                      // Rate limit of the messages about rejected datagrams
+
+    MEM_ARENA scanArena;                        // Scratch memory, reset at the start of each scan
+
+    PLT_SHARED_MEM traceMem;                    // Trace file mapping (record: read/write, replay: read-only)
+    char *traceFileName;                        // Record: The trace file (truncated on close)
+    uint32_t traceOffset;                       // Record: End of the records; Replay: The next record
+    uint32_t usTraceStart;                      // Record: Time reference of the records
+    uint32_t usTraceScan;                       // Replay: Record time of the current scan
+    uint32_t usReplayStart;                     // Replay: Start time of the replay of the current scan
+    uint8_t traceRecordFlag;                    // Datagrams are recorded (until the file is full)
+    uint8_t traceReplayFlag;                    // Sockets are replaced by the trace (virtual sockets)
+
+    uint8_t scanSlotBuffer[SCAN_SLOT_COUNT][SCAN_SLOT_SIZE];
+    uint8_t infoSlotBuffer[INFO_SLOT_COUNT][INFO_SLOT_SIZE];
 
 } SCAN_CONTEXT;
 
@@ -201,1059 +663,5911 @@ static void logInfo(const char *fmt, ...)
 }
 
 
-// -------------------------------------------------------------------------------------------------
-//  Interface list management
-// -------------------------------------------------------------------------------------------------
-
-static void createInterfaceNode(void *callbackArg, const char *ifName, uint32_t ifIP4Addr)
+static void notifyServer(SCAN_CONTEXT *scanCtx, IDNSL_SERVER_PFN pfnCallback, IDNSL_SERVER_INFO *serverInfo)
 {
-    SCAN_CONTEXT *scanCtx = (SCAN_CONTEXT *)callbackArg;
+    if(pfnCallback) pfnCallback(scanCtx->callbacks.callbackArg, serverInfo);
+}
 
-    // Allocate node memory
-    INTERFACE_NODE *ifNode = (INTERFACE_NODE *)calloc(1, sizeof(INTERFACE_NODE));
-    if(ifNode == (INTERFACE_NODE *)0)
+
+static int parseSubnet(const char *subnetSpec, uint32_t *netAddr, uint32_t *hostMask)
+{
+    // Syntax: a.b.c.d[/prefixLength] - address and host mask in host byte order (not masked)
+    char addrString[TARGET_SPEC_LENGTH];
+    if(strlen(subnetSpec) >= sizeof(addrString)) return -1;
+    strcpy(addrString, subnetSpec);
+
+    unsigned prefixLength = 32;
+    char *prefixString = strchr(addrString, '/');
+    if(prefixString)
     {
-        logError("calloc(INTERFACE_NODE) failed");
-        return;
+        *prefixString++ = '\0';
+        char *endPtr;
+        unsigned long param = strtoul(prefixString, &endPtr, 10);
+        if((*prefixString == '\0') || (*endPtr != '\0') || (param > 32)) return -1;
+        prefixLength = (unsigned)param;
     }
 
-    do
-    {
-        // Create socket
-        ifNode->fdSocket = plt_sockOpen(AF_INET, SOCK_DGRAM, 0);
-        if(ifNode->fdSocket < 0)
-        {
-            logError("socket() failed (error: %d)", plt_sockGetLastError());
-            break;
-        }
+    struct in_addr addr;
+    if(inet_pton(AF_INET, addrString, &addr) != 1) return -1;
 
-        // Remember interface name
-        snprintf(ifNode->ifName, sizeof(ifNode->ifName), ifName ? ifName : "<?>");
+    *netAddr = ntohl(addr.s_addr);
+    *hostMask = (prefixLength < 32) ? (0xFFFFFFFF >> prefixLength) : 0;
+    return 0;
+}
 
-        // Allow broadcast on socket
-        if(plt_sockSetBroadcast(ifNode->fdSocket) < 0)
-        {
-            logError("setsockopt(broadcast) failed (error: %d)", plt_sockGetLastError());
-            break;
-        }
 
-        // Bind to local interface (any! port)
-        // Note: This bind is needed to send the broadcast on the specific (virtual) interface,
-        struct sockaddr_in bindSockAddr = { 0 };
-        bindSockAddr.sin_family = AF_INET;
-        bindSockAddr.sin_port = 0;
-        bindSockAddr.sin_addr.s_addr = ifIP4Addr;
+static int getListItem(const char **cursor, char *itemBuffer, size_t bufferSize)
+{
+    // Next item of a comma (or blank) separated list. Returns 0 at the end of the list, -1 in
+    // case the item exceeds the buffer (the item is skipped).
+    const char *delimiters = ", \t";
+    *cursor += strspn(*cursor, delimiters);
+    if(**cursor == '\0') return 0;
+
+    size_t itemLength = strcspn(*cursor, delimiters);
+    const char *itemPtr = *cursor;
+    *cursor += itemLength;
+    if(itemLength >= bufferSize) return -1;
+
+    memcpy(itemBuffer, itemPtr, itemLength);
+    itemBuffer[itemLength] = '\0';
+    return 1;
+}
+
 
-        if(bind(ifNode->fdSocket, (struct sockaddr *)&bindSockAddr, sizeof(bindSockAddr)) < 0)
+static int matchNameGlob(const char *pattern, const char *name)
+{
+    // Wildcards: '*' (any sequence), '?' (any character)
+    for(; *pattern; pattern++, name++)
+    {
+        if(*pattern == '*')
         {
-            logError("bind() failed (error: %d)", plt_sockGetLastError());
-            break;
+            while(pattern[1] == '*') pattern++;
+            for(; ; name++)
+            {
+                if(matchNameGlob(&pattern[1], name)) return 1;
+                if(*name == '\0') return 0;
+            }
         }
 
-        //struct sockaddr_in *ifSockAddr = (struct sockaddr_in *)ifa->ifa_addr;
-        //logInfo("Interface %s(%s)", ifa->ifa_name, inet_ntoa(*(in_addr *)&(ifSockAddr->sin_addr.s_addr)));
-
-        // Node successfully created, append to list and return.
-        APPEND_NODE(scanCtx->firstIfNode, scanCtx->lastIfNode, ifNode);
-        return;
-    }
-    while(0);
-
-    // Error: Close socket
-    if(ifNode->fdSocket >= 0)
-    {
-        if(plt_sockClose(ifNode->fdSocket)) logError("close() failed (error: %d)", plt_sockGetLastError());
+        if(*name == '\0') return 0;
+        if((*pattern != '?') && (*pattern != *name)) return 0;
     }
 
-    // Error: Free node memory
-    free(ifNode);
+    return (*name == '\0');
 }
 
 
-static void deleteInterfaceNode(INTERFACE_NODE *ifNode)
+static char *copyOptionString(const char *optionString)
 {
-    if(!ifNode) return;
+    // Note: Option strings are copied (may be released by the caller after opening the session)
+    if(optionString == (const char *)0) return (char *)0;
 
-    // Close socket
-    if(ifNode->fdSocket >= 0)
+    size_t stringSize = strlen(optionString) + 1;
+    char *stringCopy = (char *)malloc(stringSize);
+    if(stringCopy == (char *)0)
     {
-        if(plt_sockClose(ifNode->fdSocket)) logError("close() failed (error: %d)", plt_sockGetLastError());
+        logError("malloc(optionString) failed");
+        return (char *)0;
     }
 
-    // Free node memory
-    free(ifNode);
+    memcpy(stringCopy, optionString, stringSize);
+    return stringCopy;
 }
 
 
-// -------------------------------------------------------------------------------------------------
-//  Request jobs and response mapping
-// -------------------------------------------------------------------------------------------------
-
-static int sendNextRequest(REQUEST_QUEUE *requestQueue)
+static void initPacketRing(PACKET_RING *packetRing, uint8_t *slotBuffer, unsigned slotSize, unsigned slotCount)
 {
-    // Get next request
-    REQUEST_JOB *reqJob = requestQueue->firstRequest;
-    if(reqJob == (REQUEST_JOB *)0) return 0;
-
-    // Populate remote socket address struct
-    struct sockaddr_in remoteSockAddr;
-    remoteSockAddr.sin_family = AF_INET;
-    remoteSockAddr.sin_port   = htons(IDNVAL_HELLO_UDP_PORT);
-    remoteSockAddr.sin_addr   = reqJob->addr;
-
-    // Send the check request
-    if(sendto(requestQueue->fdSocket, (char *)&reqJob[1], reqJob->packetLength, 0, (struct sockaddr *)&remoteSockAddr, sizeof(remoteSockAddr)) < 0)
+    packetRing->slotCount = slotCount;
+    for(unsigned i = 0; i < slotCount; i++)
     {
-        logError("sendto() failed (error: %d)", plt_sockGetLastError());
-        return -1;
+        packetRing->slotTable[i].bufferPtr = &slotBuffer[i * slotSize];
+        packetRing->slotTable[i].bufferSize = slotSize;
     }
+}
 
-    // Remove from pending request list and free memory
-    LINKOUT_NODE(requestQueue->firstRequest, requestQueue->lastRequest, reqJob);
-    free(reqJob);
 
-    return 0;
+static void initTokenBucket(TOKEN_BUCKET *tokenBucket, unsigned tokenRate, unsigned tokenBurst, uint64_t nsNow)
+{
+    // Note: A bucket starts full (a burst may be sent right away)
+    if(tokenBurst == 0) tokenBurst = 1;
+    tokenBucket->tokenRate = tokenRate;
+    tokenBucket->tokenBurst = tokenBurst;
+    tokenBucket->tokenCredit = (uint64_t)tokenBurst * TOKEN_SCALE;
+    tokenBucket->nsRefill = nsNow;
 }
 
 
-static int scheduleQueryRequest(REQUEST_QUEUE *requestQueue, uint8_t cmd, uint8_t clientGroup, uint16_t sequenceNum, struct in_addr *addr)
+static void refillTokenBucket(TOKEN_BUCKET *tokenBucket, uint64_t nsNow)
 {
-    // Allocate request job memory
-    size_t memSize = sizeof(REQUEST_JOB) + sizeof(IDNHDR_PACKET);
-    REQUEST_JOB *reqJob = (REQUEST_JOB *)calloc(1, memSize);
-    if(reqJob == (REQUEST_JOB *)0) 
-    { 
-        logError("calloc(REQUEST_JOB) failed"); 
-        return -1; 
-    }
+    if(tokenBucket->tokenRate == 0) return;
 
-    // Populate request job fields
-    reqJob->addr = *addr;
-    reqJob->packetLength = (uint16_t)(memSize - sizeof(REQUEST_JOB));
+    // Add credit for the elapsed time (full microseconds, the remainder is kept for the next
+    // refill), limited to the bucket depth. Note: An idle bucket is full (no overflow)
+    uint64_t usElapsed = (nsNow - tokenBucket->nsRefill) / 1000;
+    tokenBucket->nsRefill += usElapsed * 1000;
 
-    // Populate packet fields
-    IDNHDR_PACKET *reqPacketHdr = (IDNHDR_PACKET *)&reqJob[1];
-    reqPacketHdr->command = cmd;
-    reqPacketHdr->flags = clientGroup & IDNMSK_PKTFLAGS_GROUP;
-    reqPacketHdr->sequence = htons(sequenceNum);
+    uint64_t creditLimit = (uint64_t)tokenBucket->tokenBurst * TOKEN_SCALE;
+    uint64_t usFill = (creditLimit / tokenBucket->tokenRate) + 1;
+    if(usElapsed > usFill) usElapsed = usFill;
 
-    // Schedule for transmission
-    APPEND_NODE(requestQueue->firstRequest, requestQueue->lastRequest, reqJob);
+    uint64_t tokenCredit = tokenBucket->tokenCredit + (usElapsed * tokenBucket->tokenRate);
+    tokenBucket->tokenCredit = (tokenCredit > creditLimit) ? creditLimit : tokenCredit;
+}
 
-    return 0;
+
+static int takeToken(TOKEN_BUCKET *tokenBucket)
+{
+    if(tokenBucket->tokenRate == 0) return 1;
+    if(tokenBucket->tokenCredit < TOKEN_SCALE) return 0;
+
+    tokenBucket->tokenCredit -= TOKEN_SCALE;
+    return 1;
 }
 
 
-static RESPONSE_INFO *getResponseInfo(SCAN_CONTEXT *scanCtx, struct in_addr *addr)
+static void returnToken(TOKEN_BUCKET *tokenBucket)
 {
-    // In case the address is already known: Return response info
-    RESPONSE_INFO *responseInfo;
-    for(responseInfo = scanCtx->firstResponseInfo; responseInfo; responseInfo = responseInfo->next) 
-    {
-        // Check address. On match, return info record
-        if(memcmp(&responseInfo->addr, addr, sizeof(responseInfo->addr)) == 0) return responseInfo;
-    }
+    if(tokenBucket->tokenRate == 0) return;
+    tokenBucket->tokenCredit += TOKEN_SCALE;
+}
 
-    // New response address - allocate info record
-    responseInfo = (RESPONSE_INFO *)calloc(1, sizeof(RESPONSE_INFO));
-    if(responseInfo == (RESPONSE_INFO *)0) 
-    { 
-        logError("calloc(RESPONSE_INFO) failed"); 
-        return (RESPONSE_INFO *)0; 
-    }
 
-    // Populate fields - server address
-    responseInfo->addr = *addr;
+static uint32_t getTokenDelay(TOKEN_BUCKET *tokenBucket)
+{
+    // Time (in microseconds) until the next token is available
+    if((tokenBucket->tokenRate == 0) || (tokenBucket->tokenCredit >= TOKEN_SCALE)) return 0;
 
-    // Append to response info list and return info record
-    APPEND_NODE(scanCtx->firstResponseInfo, scanCtx->lastResponseInfo, responseInfo);
-    return responseInfo;
+    uint64_t creditMissing = TOKEN_SCALE - tokenBucket->tokenCredit;
+    return (uint32_t)((creditMissing + tokenBucket->tokenRate - 1) / tokenBucket->tokenRate);
 }
 
 
 // -------------------------------------------------------------------------------------------------
-//  Device info handling
+//  Network addresses (tagged IPv4/IPv6, zero-padded - compared and hashed as a whole)
 // -------------------------------------------------------------------------------------------------
 
-static int scheduleInfoRequests(SCAN_CONTEXT *scanCtx, RESPONSE_INFO *responseInfo)
+static void setIP4Address(IDNSL_NET_ADDRESS *netAddr, uint32_t ip4Addr)
 {
-    uint8_t cmd = IDNCMD_SERVICEMAP_REQUEST;
-    uint16_t sequenceNum = responseInfo->serviceMapSequenceNum = scanCtx->sequenceNum++;
-    int rc = scheduleQueryRequest(&(scanCtx->infoRequestQueue), cmd, scanCtx->clientGroup, sequenceNum, &(responseInfo->addr));
-    if(rc < 0) return rc;
-
-    // Additional requests (properies, ...) could go here.
-
-    return 0;
+    // Note: Address in network byte order
+    memset(netAddr, 0, sizeof(IDNSL_NET_ADDRESS));
+    netAddr->family = AF_INET;
+    netAddr->u.ip4.s_addr = ip4Addr;
 }
 
 
-static int serviceMapResponse(SCAN_CONTEXT *scanCtx, RESPONSE_INFO *responseInfo, void *payloadPtr, size_t payloadLen)
+static void setIP6Address(IDNSL_NET_ADDRESS *netAddr, const struct in6_addr *ip6Addr, uint32_t scopeID)
 {
-    // Convert IP address to string
-    char strRemoteAddr[20];
-    if(inet_ntop(AF_INET, &responseInfo->addr, strRemoteAddr, sizeof(strRemoteAddr)) == (char *)0)
+    // IPv4-mapped addresses (received on dual-stack sockets) are IPv4 addresses
+    if(IN6_IS_ADDR_V4MAPPED(ip6Addr))
     {
-        logError("inet_ntop() failed (error: %d)", plt_sockGetLastError());
-        return -1;
+        uint32_t ip4Addr;
+        memcpy(&ip4Addr, &ip6Addr->s6_addr[12], sizeof(ip4Addr));
+        setIP4Address(netAddr, ip4Addr);
+        return;
     }
 
-    // -------------------------------------------------------------------------
-    //  Check response
-    // -------------------------------------------------------------------------
+    // The scope is significant for link-local addresses only
+    memset(netAddr, 0, sizeof(IDNSL_NET_ADDRESS));
+    netAddr->family = AF_INET6;
+    netAddr->u.ip6 = *ip6Addr;
+    if(IN6_IS_ADDR_LINKLOCAL(ip6Addr) || IN6_IS_ADDR_MC_LINKLOCAL(ip6Addr)) netAddr->scopeID = scopeID;
+}
 
-    if(payloadLen < sizeof(IDNHDR_SERVICEMAP_RESPONSE))
-    {
-        logError("ServiceMapRsp(%s): Invalid response length %u", strRemoteAddr, payloadLen); 
-        return 0;
-    }
 
-    IDNHDR_SERVICEMAP_RESPONSE *serviceMapHdr = (IDNHDR_SERVICEMAP_RESPONSE *)payloadPtr;
-    if(serviceMapHdr->structSize != sizeof(IDNHDR_SERVICEMAP_RESPONSE))
-    {
-        logError("ServiceMapRsp(%s): Invalid header size %u", strRemoteAddr, serviceMapHdr->structSize);
-        return 0;
-    }
+static int matchNetAddress(const IDNSL_NET_ADDRESS *netAddr1, const IDNSL_NET_ADDRESS *netAddr2)
+{
+    return memcmp(netAddr1, netAddr2, sizeof(IDNSL_NET_ADDRESS)) == 0;
+}
 
-    // Check entry table
-    payloadPtr = &serviceMapHdr[1];
-    payloadLen -= sizeof(IDNHDR_SERVICEMAP_RESPONSE);
-    if(serviceMapHdr->entrySize != sizeof(IDNHDR_SERVICEMAP_ENTRY))
-    {
-        logError("ServiceMapRsp(%s): Invalid entry struct size %u", strRemoteAddr, serviceMapHdr->entrySize);
-        return 0;
-    }
 
-    unsigned entryCount = serviceMapHdr->relayEntryCount + serviceMapHdr->serviceEntryCount;
-    if(payloadLen != entryCount * serviceMapHdr->entrySize)
+static uint16_t getSockAddress(IDNSL_NET_ADDRESS *netAddr, const PLT_SOCKADDR *sockAddr)
+{
+    // Note: Returns the port (host byte order)
+    if(sockAddr->sa.sa_family == AF_INET6)
     {
-        logError("ServiceMapRsp(%s): Invalid entry table %u != %u * %u", strRemoteAddr, payloadLen, entryCount, serviceMapHdr->entrySize);
-        return 0;
+        setIP6Address(netAddr, &sockAddr->sin6.sin6_addr, (uint32_t)sockAddr->sin6.sin6_scope_id);
+        return ntohs(sockAddr->sin6.sin6_port);
     }
 
+    setIP4Address(netAddr, (uint32_t)sockAddr->sin.sin_addr.s_addr);
+    return ntohs(sockAddr->sin.sin_port);
+}
 
-    // -------------------------------------------------------------------------
-    //  Read relay table and service table
-    // -------------------------------------------------------------------------
 
-    IDNHDR_SERVICEMAP_ENTRY *serviceMapEntry = (IDNHDR_SERVICEMAP_ENTRY *)payloadPtr;
-    IDNSL_RELAY_INFO *relayTable = (IDNSL_RELAY_INFO *)0;
-    IDNSL_SERVICE_INFO *serviceTable = (IDNSL_SERVICE_INFO *)0;
-    do
+static void putSockAddress(PLT_SOCKADDR *sockAddr, const IDNSL_NET_ADDRESS *netAddr, int sockFamily, uint16_t port)
+{
+    // Note: IPv4 addresses are mapped for IPv6 (dual-stack) sockets
+    memset(sockAddr, 0, sizeof(PLT_SOCKADDR));
+    if(sockFamily == AF_INET6)
     {
-        // Read relay entries
-        if(serviceMapHdr->relayEntryCount > 0)
+        sockAddr->sin6.sin6_family = AF_INET6;
+        sockAddr->sin6.sin6_port = htons(port);
+        if(netAddr->family == AF_INET6)
         {
-            // Allocate memory
-            relayTable = (IDNSL_RELAY_INFO *)calloc(serviceMapHdr->relayEntryCount, sizeof(IDNSL_RELAY_INFO));
-            if(relayTable == (IDNSL_RELAY_INFO *)0)
-            {
-                logError("calloc(IDNSL_RELAY_INFO) failed");
-                break;
-            }
+            sockAddr->sin6.sin6_addr = netAddr->u.ip6;
+            sockAddr->sin6.sin6_scope_id = netAddr->scopeID;
+        }
+        else
+        {
+            sockAddr->sin6.sin6_addr.s6_addr[10] = 0xFF;
+            sockAddr->sin6.sin6_addr.s6_addr[11] = 0xFF;
+            memcpy(&sockAddr->sin6.sin6_addr.s6_addr[12], &netAddr->u.ip4, sizeof(netAddr->u.ip4));
+        }
+        return;
+    }
 
-            // Copy entries
-            unsigned relayIndex;
-            for(relayIndex = 0; relayIndex < serviceMapHdr->relayEntryCount; relayIndex++)
-            {
-                // Validate input fields
-                if(serviceMapEntry->serviceID != 0)
-                {
-                    logError("ServiceMapRsp(%s, relay): Invalid serviceID %u", strRemoteAddr, serviceMapEntry->serviceID);
-                    break;
-                }
-                else if(serviceMapEntry->serviceType != 0)
-                {
-                    logError("ServiceMapRsp(%s, relay): Invalid serviceType %u", strRemoteAddr, serviceMapEntry->serviceType);
-                    break;
-                }
-                else if(serviceMapEntry->relayNumber == 0)
-                {
-                    logError("ServiceMapRsp(%s, relay): Invalid relayNumber %u", strRemoteAddr, serviceMapEntry->relayNumber);
-                    break;
-                }
+    sockAddr->sin.sin_family = AF_INET;
+    sockAddr->sin.sin_port = htons(port);
+    sockAddr->sin.sin_addr = netAddr->u.ip4;
+}
 
-                // Copy fields
-                IDNSL_RELAY_INFO *relayEntry = &relayTable[relayIndex];
-                relayEntry->relayNumber = serviceMapEntry->relayNumber;
-                relayEntry->flags = serviceMapEntry->flags;
-                COPY_NAME_NULLTERM(relayEntry->relayName, serviceMapEntry->name);
 
-                // Next entry
-                serviceMapEntry = &serviceMapEntry[1];
-            }
-            if(relayIndex < serviceMapHdr->relayEntryCount) break;
-        }
+static int formatNetAddress(const IDNSL_NET_ADDRESS *netAddr, char *strBuffer, size_t bufferSize)
+{
+    // Convert IP address to string (link-local IPv6 addresses with scope)
+    if(netAddr->family == AF_INET)
+    {
+        return (inet_ntop(AF_INET, (void *)&netAddr->u.ip4, strBuffer, bufferSize) == (char *)0) ? -1 : 0;
+    }
 
-        // Read service entries
-        if(serviceMapHdr->serviceEntryCount > 0)
-        {
-            // Allocate memory
-            serviceTable = (IDNSL_SERVICE_INFO *)calloc(serviceMapHdr->serviceEntryCount, sizeof(IDNSL_SERVICE_INFO));
-            if(serviceTable == (IDNSL_SERVICE_INFO *)0)
-            {
-                logError("calloc(IDNSL_SERVICE_INFO) failed");
-                break;
-            }
+    if(inet_ntop(AF_INET6, (void *)&netAddr->u.ip6, strBuffer, bufferSize) == (char *)0) return -1;
 
-            // Copy entries
-            unsigned serviceIndex;
-            for(serviceIndex = 0; serviceIndex < serviceMapHdr->serviceEntryCount; serviceIndex++)
-            {
-                // Validate input fields
-                if(serviceMapEntry->serviceID == 0)
-                {
-                    logError("ServiceMapRsp(%s, service): Invalid serviceID %u", strRemoteAddr, serviceMapEntry->serviceID);
-                    break;
-                }
+    size_t strLength = strlen(strBuffer);
+    if(netAddr->scopeID) snprintf(&strBuffer[strLength], bufferSize - strLength, "%%%u", (unsigned)netAddr->scopeID);
+    return 0;
+}
 
-                // Copy fields
-                IDNSL_SERVICE_INFO *serviceEntry = &serviceTable[serviceIndex];
-                serviceEntry->serviceID = serviceMapEntry->serviceID;
-                serviceEntry->serviceType = serviceMapEntry->serviceType;
-                serviceEntry->flags = serviceMapEntry->flags;
-                COPY_NAME_NULLTERM(serviceEntry->serviceName, serviceMapEntry->name);
 
-                // In case associated with a relay: Link into relay service list
-                if(serviceMapEntry->relayNumber != 0) 
-                {
-                    unsigned relayIndex;
-                    for(relayIndex = 0; relayIndex < serviceMapHdr->relayEntryCount; relayIndex++)
-                    {
-                        IDNSL_RELAY_INFO *relayEntry = &relayTable[relayIndex];
-                        if(relayEntry->relayNumber != serviceMapEntry->relayNumber) continue;
+// -------------------------------------------------------------------------------------------------
+//  Scan statistics
+// -------------------------------------------------------------------------------------------------
 
-                        // First in list - or append to end of list
-                        if(relayEntry->firstRelayService == (IDNSL_SERVICE_INFO *)0) 
-                        {
-                            relayEntry->firstRelayService = serviceEntry;
-                        }
-                        else
-                        {
-                            IDNSL_SERVICE_INFO *cursor = relayEntry->firstRelayService;
-                            while(cursor->nextRelayService != (IDNSL_SERVICE_INFO *)0) cursor = cursor->nextRelayService;
-                            cursor->nextRelayService = serviceEntry;
-                        }
+static void rejectPacket(SCAN_CONTEXT *scanCtx, unsigned rejectReason, const char *rspName, const IDNSL_NET_ADDRESS *remoteAddr, const char *fmt, ...)
+{
+    // Count the rejected datagram. The message is formatted only in case it is logged (rate limit)
+    scanCtx->scanStats.rejectCount[rejectReason]++;
 
-                        // Found / done
-                        serviceEntry->parentRelay = relayEntry;
-                        break;
-                    }
-                    if(relayIndex == serviceMapHdr->relayEntryCount)
-                    {
-                        logError("ServiceMapRsp(%s, service): Invalid relayNumber %u", strRemoteAddr, serviceMapEntry->relayNumber);
-                        break;
-                    }
-                }
+#if (IDNSL_PACKET_LOG_RATE > 0)
+    refillTokenBucket(&scanCtx->logPacer, plt_getMonoTimeNS());
+    if(!takeToken(&scanCtx->logPacer))
+    {
+        scanCtx->scanStats.logSuppressCount++;
+        return;
+    }
 
-                // Next entry
-                serviceMapEntry = &serviceMapEntry[1];
-            }
-            if(serviceIndex < serviceMapHdr->serviceEntryCount) break;
-        }
+    char strRemoteAddr[NET_ADDR_STRLEN];
+    if(formatNetAddress(remoteAddr, strRemoteAddr, sizeof(strRemoteAddr))) strcpy(strRemoteAddr, "?");
+
+    char strMessage[128];
+    va_list arg_ptr;
+    va_start(arg_ptr, fmt);
+    vsnprintf(strMessage, sizeof(strMessage), fmt, arg_ptr);
+    va_end(arg_ptr);
 
-        // Assign relay table
-        responseInfo->serverInfo->relayCount = serviceMapHdr->relayEntryCount;
-        responseInfo->serverInfo->relayTable = relayTable;
-        relayTable = (IDNSL_RELAY_INFO *)0;
+    logError("%s(%s): %s", rspName, strRemoteAddr, strMessage);
+#endif
+}
 
-        // Assign service table
-        responseInfo->serverInfo->serviceCount = serviceMapHdr->serviceEntryCount;
-        responseInfo->serverInfo->serviceTable = serviceTable;
-        serviceTable = (IDNSL_SERVICE_INFO *)0;
 
-        // No error
-        return 1;
+static uint32_t countDrops(SCAN_CONTEXT *scanCtx, uint32_t *dropCounter, const PLT_RECV_SLOT *slotTable, int slotCount)
+{
+    // Datagrams dropped by the kernel since the last receive from the socket. Note: The counter
+    // of the socket is attached to datagrams received after a drop only (0 otherwise).
+    uint32_t lastCounter = *dropCounter;
+    for(int i = 0; i < slotCount; i++)
+    {
+        if((int32_t)(slotTable[i].dropCounter - *dropCounter) > 0) *dropCounter = slotTable[i].dropCounter;
     }
-    while(0);
 
-    // Free memory in case of errors (service map not available)
-    if(relayTable) free(relayTable);
-    if(serviceTable) free(serviceTable);
+    uint32_t dropCount = *dropCounter - lastCounter;
+    scanCtx->scanStats.packetsDropped += dropCount;
+    return dropCount;
+}
+
 
-    return 0;
+static void addLatencySample(IDNSL_LATENCY_HISTOGRAM *histogram, uint32_t usLatency)
+{
+    // Bucket n: Below (IDNSL_STATS_HIST_BASE << n), last bucket: All others
+    unsigned bucketIndex = 0;
+    while((bucketIndex < IDNSL_STATS_HIST_BUCKETS - 1) && (usLatency >= ((uint32_t)IDNSL_STATS_HIST_BASE << bucketIndex))) bucketIndex++;
+
+    histogram->bucketCount[bucketIndex]++;
+    histogram->sampleCount++;
+    histogram->usSum += usLatency;
+    if(usLatency > histogram->usMax) histogram->usMax = usLatency;
 }
 
 
-static int recvInfoResponse(SCAN_CONTEXT *scanCtx)
+static void mergeLatencyHistogram(IDNSL_LATENCY_HISTOGRAM *dstHistogram, const IDNSL_LATENCY_HISTOGRAM *srcHistogram)
 {
-    struct sockaddr_in recvSockAddr;
-    struct sockaddr *recvAddr = (struct sockaddr *)&recvSockAddr;
-    socklen_t recvAddrSize = sizeof(recvSockAddr);
-    int fdSocket = scanCtx->infoRequestQueue.fdSocket;
+    for(unsigned i = 0; i < IDNSL_STATS_HIST_BUCKETS; i++) dstHistogram->bucketCount[i] += srcHistogram->bucketCount[i];
+    dstHistogram->sampleCount += srcHistogram->sampleCount;
+    dstHistogram->usSum += srcHistogram->usSum;
+    if(srcHistogram->usMax > dstHistogram->usMax) dstHistogram->usMax = srcHistogram->usMax;
+}
 
-    // Receive reply from scan request
-    int nBytes = recvfrom(fdSocket, scanCtx->packetBuffer, sizeof(scanCtx->packetBuffer), 0, recvAddr, &recvAddrSize);
-    if(nBytes < 0)
-    {
-        logError("recvfrom() failed (error: %d)", plt_sockGetLastError());
-        return -1;
-    }
 
-    // Convert IP address to string
-    char strRemoteAddr[20];
-    if(inet_ntop(AF_INET, &recvSockAddr.sin_addr, strRemoteAddr, sizeof(strRemoteAddr)) == (char *)0)
+static void mergeQueueStats(IDNSL_QUEUE_STATS *dstStats, const IDNSL_QUEUE_STATS *srcStats)
+{
+    dstStats->packetsSent += srcStats->packetsSent;
+    dstStats->packetsReceived += srcStats->packetsReceived;
+    dstStats->packetsDropped += srcStats->packetsDropped;
+    dstStats->retryCount += srcStats->retryCount;
+    dstStats->timeoutCount += srcStats->timeoutCount;
+    if(srcStats->queueHighWater > dstStats->queueHighWater) dstStats->queueHighWater = srcStats->queueHighWater;
+}
+
+
+static void mergeScanStats(IDNSL_SCAN_STATS *dstStats, const IDNSL_SCAN_STATS *srcStats)
+{
+    // Parallel scan: Workers run at the same time (phase times are the earliest/latest, high-water
+    // marks the max. of a worker), the interfaces are appended
+    if(srcStats->usDuration > dstStats->usDuration) dstStats->usDuration = srcStats->usDuration;
+    if(srcStats->usFirstResponse && (!dstStats->usFirstResponse || (srcStats->usFirstResponse < dstStats->usFirstResponse)))
     {
-        logError("inet_ntop() failed (error: %d)", plt_sockGetLastError());
-        return -1;
+        dstStats->usFirstResponse = srcStats->usFirstResponse;
     }
+    if(srcStats->usLastResponse > dstStats->usLastResponse) dstStats->usLastResponse = srcStats->usLastResponse;
+    if(srcStats->usLastCheck > dstStats->usLastCheck) dstStats->usLastCheck = srcStats->usLastCheck;
+    if(srcStats->usLastServiceMap > dstStats->usLastServiceMap) dstStats->usLastServiceMap = srcStats->usLastServiceMap;
 
-    // Check sender port
-    if(ntohs(recvSockAddr.sin_port) != IDNVAL_HELLO_UDP_PORT)
+    for(unsigned i = 0; (i < srcStats->ifCount) && (i < IDNSL_STATS_IF_LIMIT); i++)
     {
-        logError("InfoRsp(%s): Invalid sender port %u", strRemoteAddr, ntohs(recvSockAddr.sin_port));
-        return 0;
+        if(dstStats->ifCount + i < IDNSL_STATS_IF_LIMIT) dstStats->ifStats[dstStats->ifCount + i] = srcStats->ifStats[i];
     }
+    dstStats->ifCount += srcStats->ifCount;
 
-    // Get info record for address from which the datagram was received
-    RESPONSE_INFO *responseInfo = getResponseInfo(scanCtx, &(recvSockAddr.sin_addr));
-    if(responseInfo == (RESPONSE_INFO *)0) return -1;
+    mergeQueueStats(&dstStats->checkQueue, &srcStats->checkQueue);
+    mergeQueueStats(&dstStats->infoQueue, &srcStats->infoQueue);
+    if(srcStats->inflightHighWater > dstStats->inflightHighWater) dstStats->inflightHighWater = srcStats->inflightHighWater;
 
+    if(srcStats->recvBufferSize > dstStats->recvBufferSize) dstStats->recvBufferSize = srcStats->recvBufferSize;
+    dstStats->packetsDropped += srcStats->packetsDropped;
 
-    // -------------------------------------------------------------------------
-    //  Check IDN-Hello packet header
-    // -------------------------------------------------------------------------
+    for(unsigned i = 0; i < IDNSL_REJECT_REASONS; i++) dstStats->rejectCount[i] += srcStats->rejectCount[i];
+    dstStats->logSuppressCount += srcStats->logSuppressCount;
 
-    if((size_t)nBytes < sizeof(IDNHDR_PACKET))
-    {
-        logError("InfoRsp(%s): Invalid packet size %u", strRemoteAddr, nBytes);
-        return 0;
-    }
+    mergeLatencyHistogram(&dstStats->scanLatency, &srcStats->scanLatency);
+    mergeLatencyHistogram(&dstStats->checkLatency, &srcStats->checkLatency);
+    mergeLatencyHistogram(&dstStats->serviceMapLatency, &srcStats->serviceMapLatency);
+}
 
-    // Calculate pointers
-    IDNHDR_PACKET *recvPacketHdr = (IDNHDR_PACKET *)scanCtx->packetBuffer;
-    void *payloadPtr = &recvPacketHdr[1];
-    size_t payloadLen = (size_t)nBytes - sizeof(IDNHDR_PACKET);
 
-    // Dispatch based response
-    if(recvPacketHdr->command == IDNCMD_SERVICEMAP_RESPONSE)
+// -------------------------------------------------------------------------------------------------
+//  Memory arena
+// -------------------------------------------------------------------------------------------------
+
+static void *arenaAlloc(MEM_ARENA *memArena, size_t size)
+{
+    size_t allocSize = ALIGN_SIZE(size, ARENA_ALIGN);
+    size_t hdrSize = ALIGN_SIZE(sizeof(ARENA_CHUNK), ARENA_ALIGN);
+
+    // In case of insufficient space: Add new chunk (at least double the size of the current)
+    ARENA_CHUNK *chunk = memArena->firstChunk;
+    if((chunk == (ARENA_CHUNK *)0) || ((chunk->chunkSize - chunk->usedSize) < allocSize))
     {
-        uint16_t sequenceNum = responseInfo->serviceMapSequenceNum;
-        if(ntohs(recvPacketHdr->sequence) != sequenceNum)
+        size_t chunkSize = chunk ? (chunk->chunkSize * 2) : ARENA_CHUNK_SIZE;
+        if(chunkSize < allocSize) chunkSize = allocSize;
+
+        ARENA_CHUNK *newChunk = (ARENA_CHUNK *)malloc(hdrSize + chunkSize);
+        if(newChunk == (ARENA_CHUNK *)0)
         {
-            logError("ServiceMapRsp(%s): Invalid sequence %04X %04X", strRemoteAddr, recvPacketHdr->sequence, sequenceNum);
-            return 0;
+            logError("malloc(ARENA_CHUNK) failed");
+            return (void *)0;
         }
 
-        // Process service map response
-        int rcRsp = serviceMapResponse(scanCtx, responseInfo, payloadPtr, payloadLen);
-        if(rcRsp <= 0) return rcRsp;
+        newChunk->next = chunk;
+        newChunk->chunkSize = chunkSize;
+        newChunk->usedSize = 0;
+        memArena->firstChunk = chunk = newChunk;
     }
-    else
+
+    // Allocate from the current chunk - zero-initialized (like calloc)
+    uint8_t *ptr = &((uint8_t *)chunk)[hdrSize + chunk->usedSize];
+    chunk->usedSize += allocSize;
+    memset(ptr, 0, size);
+
+    return ptr;
+}
+
+
+static void arenaFree(MEM_ARENA *memArena)
+{
+    while(memArena->firstChunk)
     {
-        logError("%s: Invalid command 0x%02X", strRemoteAddr, recvPacketHdr->command);
-        return 0;
+        ARENA_CHUNK *chunk = memArena->firstChunk;
+        memArena->firstChunk = chunk->next;
+        free(chunk);
     }
+}
 
-    return 0;
+
+static void arenaReset(MEM_ARENA *memArena)
+{
+    ARENA_CHUNK *chunk = memArena->firstChunk;
+    if(chunk == (ARENA_CHUNK *)0) return;
+
+    // Single chunk: Just reuse. Multiple chunks: Replace by one chunk of the total size
+    // (next use of the arena will not need any further chunk allocation)
+    if(chunk->next != (ARENA_CHUNK *)0)
+    {
+        size_t totalSize = 0;
+        for(; chunk; chunk = chunk->next) totalSize += chunk->chunkSize;
+        arenaFree(memArena);
+
+        size_t hdrSize = ALIGN_SIZE(sizeof(ARENA_CHUNK), ARENA_ALIGN);
+        chunk = (ARENA_CHUNK *)malloc(hdrSize + totalSize);
+        if(chunk == (ARENA_CHUNK *)0) return;
+
+        chunk->next = (ARENA_CHUNK *)0;
+        chunk->chunkSize = totalSize;
+        memArena->firstChunk = chunk;
+    }
+
+    chunk->usedSize = 0;
 }
 
 
 // -------------------------------------------------------------------------------------------------
-//  Discovery broadcast and reachability handling
+//  Hash index
 // -------------------------------------------------------------------------------------------------
 
-static int sendBroadcastRequest(SCAN_CONTEXT *scanCtx, INTERFACE_NODE *ifNode)
+static uint32_t hashAddress(const IDNSL_NET_ADDRESS *addr)
 {
-    // Remember request packet sequence number
-    ifNode->scanSequenceNum = scanCtx->sequenceNum++;
+    // Note: Finalizer of MurmurHash3 - last address bytes differ most, mix into all bits.
+    // IPv6: All address words (and the scope) are folded first.
+    uint32_t hashValue = (uint32_t)addr->u.ip4.s_addr;
+    if(addr->family == AF_INET6)
+    {
+        uint32_t wordTable[4];
+        memcpy(wordTable, &addr->u.ip6, sizeof(wordTable));
+        hashValue = wordTable[0] ^ (wordTable[1] * 31) ^ (wordTable[2] * 961) ^ wordTable[3] ^ addr->scopeID;
+    }
+    hashValue ^= hashValue >> 16;
+    hashValue *= 0x85EBCA6B;
+    hashValue ^= hashValue >> 13;
+    hashValue *= 0xC2B2AE35;
+    hashValue ^= hashValue >> 16;
 
-    // Use network broadcast address (to find all servers)
-    struct sockaddr_in remoteSockAddr;
-    remoteSockAddr.sin_family      = AF_INET;
-    remoteSockAddr.sin_port        = htons(IDNVAL_HELLO_UDP_PORT);
-    remoteSockAddr.sin_addr.s_addr = INADDR_BROADCAST;
+    return hashValue;
+}
 
-    // Populate IDN-Hello request packet
-    IDNHDR_PACKET reqPacketHdr;
-    reqPacketHdr.command = IDNCMD_SCAN_REQUEST;
-    reqPacketHdr.flags = scanCtx->clientGroup & IDNMSK_PKTFLAGS_GROUP;
-    reqPacketHdr.sequence = htons(ifNode->scanSequenceNum);
 
-    // Broadcast the scan request
-    if(sendto(ifNode->fdSocket, (char *)&reqPacketHdr, sizeof(reqPacketHdr), 0, (struct sockaddr *)&remoteSockAddr, sizeof(remoteSockAddr)) < 0)
+static uint32_t hashUnitID(const uint8_t *unitID)
+{
+    // FNV-1a over the length byte and the ID bytes
+    uint32_t hashValue = 0x811C9DC5;
+    unsigned unitIDLen = unitID[0];
+    for(unsigned i = 0; i <= unitIDLen; i++)
     {
-        logError("sendto() failed (error: %d)", plt_sockGetLastError());
-        return -1;
+        hashValue ^= unitID[i];
+        hashValue *= 0x01000193;
     }
 
-    return 0;
+    return hashValue;
 }
 
 
-static int scheduleCheckRequest(SCAN_CONTEXT *scanCtx, RESPONSE_INFO *responseInfo)
+static void *findHashEntry(HASH_INDEX *hashIndex, uint32_t hashValue, HASH_MATCH_PFN pfnMatch, const void *keyPtr)
 {
-    uint8_t cmd = IDNCMD_SCAN_REQUEST;
-    uint16_t sequenceNum = responseInfo->checkSequenceNum = scanCtx->sequenceNum++;
-    return scheduleQueryRequest(&(scanCtx->checkRequestQueue), cmd, scanCtx->clientGroup, sequenceNum, &(responseInfo->addr));
+    if(hashIndex->slotTable == (HASH_SLOT *)0) return (void *)0;
+
+    // Probe until the entry or an empty slot is found
+    for(unsigned slotIndex = hashValue & hashIndex->slotMask; ; slotIndex = (slotIndex + 1) & hashIndex->slotMask)
+    {
+        HASH_SLOT *hashSlot = &hashIndex->slotTable[slotIndex];
+        if(hashSlot->entryPtr == (void *)0) return (void *)0;
+
+        if((hashSlot->hashValue == hashValue) && pfnMatch(hashSlot->entryPtr, keyPtr)) return hashSlot->entryPtr;
+    }
 }
 
 
-static IDNSL_SERVER_INFO *getServerInfo(SCAN_CONTEXT *scanCtx, IDNHDR_SCAN_RESPONSE *scanRspHdr)
+static void putHashSlot(HASH_SLOT *slotTable, unsigned slotMask, uint32_t hashValue, void *entryPtr)
 {
-    // In case the server is already known: Return server info
-    IDNSL_SERVER_INFO **ppServerInfo = &scanCtx->firstServerInfo;
-    for(; *ppServerInfo; ppServerInfo = &((*ppServerInfo)->next)) 
-    {
-        IDNSL_SERVER_INFO *serverInfo = *ppServerInfo;
+    unsigned slotIndex = hashValue & slotMask;
+    while(slotTable[slotIndex].entryPtr != (void *)0) slotIndex = (slotIndex + 1) & slotMask;
 
-        // Check UnitID length (stored in first byte)
-        if(serverInfo->unitID[0] != scanRspHdr->unitID[0]) continue;
+    slotTable[slotIndex].hashValue = hashValue;
+    slotTable[slotIndex].entryPtr = entryPtr;
+}
 
-        // Check UnitID. On match, return info record
-        if(!memcmp(&serverInfo->unitID[1], &scanRspHdr->unitID[1], scanRspHdr->unitID[0])) return serverInfo;
-    }
 
-    // Check unit ID length
-    uint8_t unitIDLen = scanRspHdr->unitID[0];
-    if((unitIDLen >= sizeof(scanRspHdr->unitID)) || (unitIDLen >= sizeof(((IDNSL_SERVER_INFO *)0)->unitID)))
-    { 
-        logError("serverInfo: Invalid unitID length %u", unitIDLen); 
-        return (IDNSL_SERVER_INFO *)0; 
-    }
+static int insertHashEntry(HASH_INDEX *hashIndex, uint32_t hashValue, void *entryPtr)
+{
+    // Grow the table in case of a load factor above 1/2 (also initially)
+    unsigned slotCount = hashIndex->slotTable ? (hashIndex->slotMask + 1) : 0;
+    if((hashIndex->entryCount + 1) * 2 > slotCount)
+    {
+        unsigned newCount = slotCount ? (slotCount * 2) : HASH_INDEX_MIN_SIZE;
+        HASH_SLOT *newTable;
+        if(hashIndex->memArena) newTable = (HASH_SLOT *)arenaAlloc(hashIndex->memArena, newCount * sizeof(HASH_SLOT));
+        else newTable = (HASH_SLOT *)calloc(newCount, sizeof(HASH_SLOT));
+        if(newTable == (HASH_SLOT *)0)
+        {
+            logError("calloc(HASH_SLOT) failed");
+            return -1;
+        }
+
+        // Rehash existing entries (slot index is based on the stored hash value)
+        for(unsigned i = 0; i < slotCount; i++)
+        {
+            HASH_SLOT *hashSlot = &hashIndex->slotTable[i];
+            if(hashSlot->entryPtr) putHashSlot(newTable, newCount - 1, hashSlot->hashValue, hashSlot->entryPtr);
+        }
 
-    // New server - allocate info record and append to list
-    *ppServerInfo = (IDNSL_SERVER_INFO *)calloc(1, sizeof(IDNSL_SERVER_INFO));
-    if(*ppServerInfo == (IDNSL_SERVER_INFO *)0) 
-    { 
-        logError("calloc(IDN_SERVER_INFO) failed"); 
-        return (IDNSL_SERVER_INFO *)0; 
+        if(hashIndex->memArena == (MEM_ARENA *)0) free(hashIndex->slotTable);
+        hashIndex->slotTable = newTable;
+        hashIndex->slotMask = newCount - 1;
     }
 
-    // Populate unitID (Note: Field 0-initialized - calloc) and host name.
-    IDNSL_SERVER_INFO *serverInfo = *ppServerInfo;
-    serverInfo->unitID[0] = unitIDLen;
-    memcpy(&serverInfo->unitID[1], &scanRspHdr->unitID[1], unitIDLen);
-    COPY_NAME_NULLTERM(serverInfo->hostName, scanRspHdr->hostName);
+    putHashSlot(hashIndex->slotTable, hashIndex->slotMask, hashValue, entryPtr);
+    hashIndex->entryCount++;
 
-    // Return new server info record
-    return serverInfo;
+    return 0;
 }
 
 
-static int getServerAddressIndex(IDNSL_SERVER_INFO *serverInfo, struct in_addr *addr)
+static void removeHashEntry(HASH_INDEX *hashIndex, uint32_t hashValue, void *entryPtr)
 {
-    // In case the address is already known: return the index
-    for(unsigned i = 0; i < serverInfo->addressCount; i++)
+    if(hashIndex->slotTable == (HASH_SLOT *)0) return;
+
+    // Find the slot of the entry
+    unsigned slotMask = hashIndex->slotMask;
+    unsigned slotIndex = hashValue & slotMask;
+    for(; hashIndex->slotTable[slotIndex].entryPtr != entryPtr; slotIndex = (slotIndex + 1) & slotMask)
     {
-        IDNSL_SERVER_ADDRESS *serverAddr = &serverInfo->addressTable[i];
-        if(memcmp(&serverAddr->addr, addr, sizeof(struct in_addr)) == 0) return i;
+        if(hashIndex->slotTable[slotIndex].entryPtr == (void *)0) return;
     }
 
-    // New address - reallocate address table
-    size_t newSize = (serverInfo->addressCount + 1) * sizeof(IDNSL_SERVER_ADDRESS);
-    serverInfo->addressTable = (IDNSL_SERVER_ADDRESS *)realloc(serverInfo->addressTable, newSize);
-    if(serverInfo->addressTable == (IDNSL_SERVER_ADDRESS *)0) { serverInfo->addressCount = 0; return -1; }
+    // Close the gap: Move back following entries of the probe sequence (no tombstones needed).
+    // An entry may move to the gap in case its home slot is not cyclically in (gap, entry].
+    for(unsigned nextIndex = (slotIndex + 1) & slotMask; ; nextIndex = (nextIndex + 1) & slotMask)
+    {
+        HASH_SLOT *hashSlot = &hashIndex->slotTable[nextIndex];
+        if(hashSlot->entryPtr == (void *)0) break;
 
-    // Populate info entry fields, assume unreachable
-    unsigned addrIndex = serverInfo->addressCount++;
-    IDNSL_SERVER_ADDRESS *serverAddr = &serverInfo->addressTable[addrIndex];
-    memset(serverAddr, 0, sizeof(IDNSL_SERVER_ADDRESS));
-    serverAddr->errorFlags = IDNSL_ADDR_ERRORFLAG_UNREACHABLE;
-    serverAddr->addr = *addr;
+        unsigned homeIndex = hashSlot->hashValue & slotMask;
+        if(((nextIndex - homeIndex) & slotMask) < ((nextIndex - slotIndex) & slotMask)) continue;
 
-    return addrIndex;
+        hashIndex->slotTable[slotIndex] = *hashSlot;
+        slotIndex = nextIndex;
+    }
+
+    hashIndex->slotTable[slotIndex].entryPtr = (void *)0;
+    hashIndex->entryCount--;
 }
 
 
-static int putScannedAddress(IDNSL_SERVER_INFO *serverInfo, struct in_addr *addr)
+static void initHashIndex(HASH_INDEX *hashIndex, MEM_ARENA *memArena)
 {
-    return getServerAddressIndex(serverInfo, addr);
+    memset(hashIndex, 0, sizeof(HASH_INDEX));
+    hashIndex->memArena = memArena;
 }
 
 
-static int putCheckedAddress(IDNSL_SERVER_INFO *serverInfo, struct in_addr *addr)
+static void freeHashIndex(HASH_INDEX *hashIndex)
 {
-    int addrIndex = getServerAddressIndex(serverInfo, addr);
-    if(addrIndex < 0) return addrIndex;
+    if(hashIndex->memArena == (MEM_ARENA *)0) free(hashIndex->slotTable);
+    initHashIndex(hashIndex, hashIndex->memArena);
+}
 
-    // Reachability has been checked - remove error flag.
-    serverInfo->addressTable[addrIndex].errorFlags &= ~IDNSL_ADDR_ERRORFLAG_UNREACHABLE;
-    if(serverInfo->addressTable[addrIndex].errorFlags != 0) return addrIndex;
 
-    // Maintain address info list order (reachable first, erroneous last)
-    for(; addrIndex > 0; addrIndex--) 
-    {
-        IDNSL_SERVER_ADDRESS checkInfo = serverInfo->addressTable[addrIndex - 1];
-        if(checkInfo.errorFlags == 0) break;
+// -------------------------------------------------------------------------------------------------
+//  Retransmission timer wheel
+// -------------------------------------------------------------------------------------------------
 
-        // Swap in case entry is preceeded by an erroneous entry
-        serverInfo->addressTable[addrIndex - 1] = serverInfo->addressTable[addrIndex];
-        serverInfo->addressTable[addrIndex] = checkInfo;
-    }
+static void initTimerWheel(TIMER_WHEEL *timerWheel, uint64_t usNow)
+{
+    // Note: Ticks of the 64-bit time (plt_getMonoTimeNS() / 1000), the 32-bit time does not
+    // wrap on a tick boundary
+    memset(timerWheel, 0, sizeof(TIMER_WHEEL));
+    timerWheel->tickDone = usNow / WHEEL_TICK;
+}
 
-    return addrIndex;
+
+static void insertTimerJob(TIMER_WHEEL *timerWheel, REQUEST_JOB *reqJob, uint64_t usDue)
+{
+    // Round up to the next tick, never into a tick that has been processed already
+    uint64_t dueTick = (usDue + WHEEL_TICK - 1) / WHEEL_TICK;
+    if(dueTick <= timerWheel->tickDone) dueTick = timerWheel->tickDone + 1;
+
+    reqJob->usDue = usDue;
+    reqJob->wheelIndex = (uint16_t)(dueTick & (WHEEL_SLOT_COUNT - 1));
+    reqJob->jobState = JOBSTATE_INFLIGHT;
+
+    WHEEL_SLOT *wheelSlot = &timerWheel->slotTable[reqJob->wheelIndex];
+    APPEND_NODE(wheelSlot->firstJob, wheelSlot->lastJob, reqJob);
+    timerWheel->jobCount++;
 }
 
 
-static int putAmbiguousAddress(IDNSL_SERVER_INFO *serverInfo, struct in_addr *addr)
+static void removeTimerJob(TIMER_WHEEL *timerWheel, REQUEST_JOB *reqJob)
 {
-    int addrIndex = getServerAddressIndex(serverInfo, addr);
-    if(addrIndex < 0) return addrIndex;
+    WHEEL_SLOT *wheelSlot = &timerWheel->slotTable[reqJob->wheelIndex];
+    LINKOUT_NODE(wheelSlot->firstJob, wheelSlot->lastJob, reqJob);
+    timerWheel->jobCount--;
+    reqJob->jobState = JOBSTATE_NONE;
+}
 
-    // Set error flag
-    serverInfo->addressTable[addrIndex].errorFlags |= IDNSL_ADDR_ERRORFLAG_AMBIGUOUS;
 
-    // Maintain address info list order (reachable first, erroneous last)
-    int addrLimit = (int)(serverInfo->addressCount) - 1;
-    for(; addrIndex < addrLimit; addrIndex++) 
+static uint32_t getTimerDelay(TIMER_WHEEL *timerWheel, uint64_t usNow)
+{
+    // Time (in microseconds) until the next non-empty slot is due (UINT32_MAX: none)
+    if(timerWheel->jobCount == 0) return UINT32_MAX;
+
+    for(uint64_t tick = timerWheel->tickDone + 1; tick != timerWheel->tickDone + WHEEL_SLOT_COUNT + 1; tick++)
     {
-        IDNSL_SERVER_ADDRESS checkInfo = serverInfo->addressTable[addrIndex + 1];
-        if(checkInfo.errorFlags != 0) break;
+        if(timerWheel->slotTable[tick & (WHEEL_SLOT_COUNT - 1)].firstJob == (REQUEST_JOB *)0) continue;
 
-        // Swap in case entry is followed by a reachable entry
-        serverInfo->addressTable[addrIndex + 1] = serverInfo->addressTable[addrIndex];
-        serverInfo->addressTable[addrIndex] = checkInfo;
+        // Computed in 64 bits, clamped to the event loop timeout
+        uint64_t usSlotDue = tick * WHEEL_TICK;
+        if(usSlotDue <= usNow) return 0;
+        return ((usSlotDue - usNow) >= UINT32_MAX) ? (UINT32_MAX - 1) : (uint32_t)(usSlotDue - usNow);
     }
 
-    return addrIndex;
+    return UINT32_MAX;
 }
 
 
-static int recvScanResponse(SCAN_CONTEXT *scanCtx, INTERFACE_NODE *ifNode)
-{
-    struct sockaddr_in recvSockAddr;
-    struct sockaddr *recvAddr = (struct sockaddr *)&recvSockAddr;
-    socklen_t recvAddrSize = sizeof(recvSockAddr);
-    int fdSocket = ifNode ? ifNode->fdSocket : scanCtx->checkRequestQueue.fdSocket;
+// -------------------------------------------------------------------------------------------------
+//  Interface list management
+// -------------------------------------------------------------------------------------------------
 
-    // Receive reply from scan request
-    int nBytes = recvfrom(fdSocket, scanCtx->packetBuffer, sizeof(scanCtx->packetBuffer), 0, recvAddr, &recvAddrSize);
-    if(nBytes < 0)
+static int matchInterface(SCAN_CONTEXT *scanCtx, const char *ifName, const IDNSL_NET_ADDRESS *ifAddr, unsigned ifFlags)
+{
+    IDNSL_SCAN_OPTIONS *scanOptions = &scanCtx->scanOptions;
+    char itemBuffer[TARGET_SPEC_LENGTH];
+    const char *cursor;
+    int rcItem;
+
+    // Interface flags (platform flags mapped to the API)
+    unsigned matchFlags = 0;
+    if(ifFlags & PLT_IFFLG_UP) matchFlags |= IDNSL_IFFLAG_UP;
+    if(ifFlags & PLT_IFFLG_BROADCAST) matchFlags |= IDNSL_IFFLAG_BROADCAST;
+    if(ifFlags & PLT_IFFLG_LOOPBACK) matchFlags |= IDNSL_IFFLAG_LOOPBACK;
+    if(ifFlags & PLT_IFFLG_MULTICAST) matchFlags |= IDNSL_IFFLAG_MULTICAST;
+    if((matchFlags & scanOptions->ifFlagsRequired) != scanOptions->ifFlagsRequired) return 0;
+    if(matchFlags & scanOptions->ifFlagsExcluded) return 0;
+
+    // Name: Any of the include globs (if given), none of the exclude globs
+    if(scanOptions->ifInclude)
     {
-        logError("recvfrom() failed (error: %d)", plt_sockGetLastError());
-        return -1;
+        int includeFlag = 0;
+        cursor = scanOptions->ifInclude;
+        while(!includeFlag && (rcItem = getListItem(&cursor, itemBuffer, sizeof(itemBuffer))) != 0)
+        {
+            if(rcItem > 0) includeFlag = matchNameGlob(itemBuffer, ifName);
+        }
+        if(!includeFlag) return 0;
     }
 
-    // Convert IP address to string
-    char strRemoteAddr[20];
-    if(inet_ntop(AF_INET, &recvSockAddr.sin_addr, strRemoteAddr, sizeof(strRemoteAddr)) == (char *)0)
+    cursor = scanOptions->ifExclude ? scanOptions->ifExclude : "";
+    while((rcItem = getListItem(&cursor, itemBuffer, sizeof(itemBuffer))) != 0)
     {
-        logError("inet_ntop() failed (error: %d)", plt_sockGetLastError());
-        return -1;
+        if((rcItem > 0) && matchNameGlob(itemBuffer, ifName)) return 0;
     }
 
-    // Check sender port
-    if(ntohs(recvSockAddr.sin_port) != IDNVAL_HELLO_UDP_PORT)
+    // Address: Within any of the subnets (if given, IPv4 interfaces only)
+    if(scanOptions->ifSubnets && (ifAddr->family == AF_INET))
     {
-        logError("ScanRsp(%s): Invalid sender port %u", strRemoteAddr, ntohs(recvSockAddr.sin_port));
+        uint32_t hostAddr = ntohl(ifAddr->u.ip4.s_addr);
+        cursor = scanOptions->ifSubnets;
+        while((rcItem = getListItem(&cursor, itemBuffer, sizeof(itemBuffer))) != 0)
+        {
+            uint32_t netAddr, hostMask;
+            if((rcItem < 0) || parseSubnet(itemBuffer, &netAddr, &hostMask)) continue;
+            if((hostAddr & ~hostMask) == (netAddr & ~hostMask)) return 1;
+        }
         return 0;
     }
 
-    // Get info record for address from which the datagram was received
-    RESPONSE_INFO *responseInfo = getResponseInfo(scanCtx, &(recvSockAddr.sin_addr));
-    if(responseInfo == (RESPONSE_INFO *)0) return -1;
-
+    return 1;
+}
 
-    // -------------------------------------------------------------------------
-    //  Check IDN-Hello packet header
-    // -------------------------------------------------------------------------
 
-    if((size_t)nBytes < sizeof(IDNHDR_PACKET))
-    {
-        logError("ScanRsp(%s): Invalid packet size %u", strRemoteAddr, nBytes);
-        return 0;
-    }
+static void addInterfaceNode(SCAN_CONTEXT *scanCtx, const char *ifName, const IDNSL_NET_ADDRESS *ifAddr, unsigned ifFlags)
+{
+    if(ifName == (const char *)0) ifName = "<?>";
 
-    // Calculate pointers
-    IDNHDR_PACKET *recvPacketHdr = (IDNHDR_PACKET *)scanCtx->packetBuffer;
-    void *payloadPtr = &recvPacketHdr[1];
-    size_t payloadLen = (size_t)nBytes - sizeof(IDNHDR_PACKET);
+    // Filter before any socket is opened
+    if(!matchInterface(scanCtx, ifName, ifAddr, ifFlags)) return;
 
-    // Check packet command
-    if(recvPacketHdr->command != IDNCMD_SCAN_RESPONSE) 
+    // Interface list update: Known interfaces keep their socket
+    for(INTERFACE_NODE *ifNode = scanCtx->firstIfNode; ifNode; ifNode = ifNode->next)
     {
-        logError("scanRsp(%s): Invalid command 0x%02X", strRemoteAddr, recvPacketHdr->command);
-        return 0;
+        if(!matchNetAddress(&ifNode->ifAddr, ifAddr) || strncmp(ifNode->ifName, ifName, sizeof(ifNode->ifName) - 1)) continue;
+
+        ifNode->visitFlag = 1;
+        return;
     }
 
-    // Check sequence number (distinguish broadcast discovery and unicast check)
-    uint16_t sequenceNum = ifNode ? ifNode->scanSequenceNum : responseInfo->checkSequenceNum;
-    if(ntohs(recvPacketHdr->sequence) != sequenceNum)
+    // Allocate node memory (kept for the lifetime of the session)
+    INTERFACE_NODE *ifNode = (INTERFACE_NODE *)calloc(1, sizeof(INTERFACE_NODE));
+    if(ifNode == (INTERFACE_NODE *)0)
+    {
+        logError("calloc(INTERFACE_NODE) failed");
+        return;
+    }
+
+    do
+    {
+        // Remember interface name and address
+        snprintf(ifNode->ifName, sizeof(ifNode->ifName), "%s", ifName);
+        ifNode->ifAddr = *ifAddr;
+        ifNode->visitFlag = 1;
+
+        // Unicast requests to servers found on the interface are paced per interface
+        IDNSL_SCAN_OPTIONS *scanOptions = &scanCtx->scanOptions;
+        initTokenBucket(&ifNode->requestPacer, scanOptions->requestRate, scanOptions->requestBurst, plt_getMonoTimeNS());
+
+        // Shared socket: No socket of the interface (IPv4), the broadcast is sent on the interface
+        if(scanOptions->sharedSocket && (ifAddr->family == AF_INET))
+        {
+            ifNode->fdSocket = -1;
+            ifNode->ifIndex = plt_ifNameToIndex(ifNode->ifName);
+
+            APPEND_NODE(scanCtx->firstIfNode, scanCtx->lastIfNode, ifNode);
+            return;
+        }
+
+        // Create socket
+        ifNode->fdSocket = plt_sockOpen(ifAddr->family, SOCK_DGRAM, 0);
+        if(ifNode->fdSocket < 0)
+        {
+            logError("socket() failed (error: %d)", plt_sockGetLastError());
+            break;
+        }
+
+        // Allow broadcast on socket (IPv6: Multicast on the interface)
+        if(ifAddr->family == AF_INET6)
+        {
+            if(plt_sockSetMulticast6(ifNode->fdSocket, ifAddr->scopeID) < 0)
+            {
+                logError("setsockopt(multicast) failed (error: %d)", plt_sockGetLastError());
+                break;
+            }
+        }
+        else if(plt_sockSetBroadcast(ifNode->fdSocket) < 0)
+        {
+            logError("setsockopt(broadcast) failed (error: %d)", plt_sockGetLastError());
+            break;
+        }
+
+        // Responses are received in batches until the socket would block
+        if(plt_sockSetNonBlocking(ifNode->fdSocket) < 0)
+        {
+            logError("setNonBlocking() failed (error: %d)", plt_sockGetLastError());
+            break;
+        }
+
+        // Responses lost in the kernel (receive buffer overflow) are reported with the next one
+        if(plt_sockSetDropCounter(ifNode->fdSocket) < 0)
+        {
+            logError("setsockopt(drop counter) failed (error: %d)", plt_sockGetLastError());
+            break;
+        }
+
+        // Bind to local interface (any! port)
+        // Note: This bind is needed to send the broadcast on the specific (virtual) interface,
+        PLT_SOCKADDR bindSockAddr;
+        putSockAddress(&bindSockAddr, ifAddr, ifAddr->family, 0);
+
+        if(bind(ifNode->fdSocket, &bindSockAddr.sa, plt_sockAddrSize(&bindSockAddr)) < 0)
+        {
+            logError("bind() failed (error: %d)", plt_sockGetLastError());
+            break;
+        }
+
+        //struct sockaddr_in *ifSockAddr = (struct sockaddr_in *)ifa->ifa_addr;
+        //logInfo("Interface %s(%s)", ifa->ifa_name, inet_ntoa(*(in_addr *)&(ifSockAddr->sin_addr.s_addr)));
+
+        // Node successfully created, append to list and return.
+        APPEND_NODE(scanCtx->firstIfNode, scanCtx->lastIfNode, ifNode);
+        return;
+    }
+    while(0);
+
+    // Error: Close socket and free memory
+    if(ifNode->fdSocket >= 0)
+    {
+        if(plt_sockClose(ifNode->fdSocket)) logError("close() failed (error: %d)", plt_sockGetLastError());
+    }
+    free(ifNode);
+}
+
+
+static void createInterfaceNode(void *callbackArg, const char *ifName, uint32_t ifIP4Addr, uint32_t ifIP4Mask, unsigned ifFlags)
+{
+    IDNSL_NET_ADDRESS ifAddr;
+    setIP4Address(&ifAddr, ifIP4Addr);
+
+    addInterfaceNode((SCAN_CONTEXT *)callbackArg, ifName, &ifAddr, ifFlags);
+}
+
+
+static void createInterfaceNode6(void *callbackArg, const char *ifName, const struct in6_addr *ifIP6Addr, uint32_t scopeID, unsigned ifFlags)
+{
+    // Note: The scan request is multicast on the link - one socket per link-local address
+    if(!IN6_IS_ADDR_LINKLOCAL(ifIP6Addr) || !(ifFlags & PLT_IFFLG_MULTICAST)) return;
+
+    IDNSL_NET_ADDRESS ifAddr;
+    setIP6Address(&ifAddr, ifIP6Addr, scopeID);
+
+    addInterfaceNode((SCAN_CONTEXT *)callbackArg, ifName, &ifAddr, ifFlags);
+}
+
+
+static void deleteInterfaceNode(INTERFACE_NODE *ifNode)
+{
+    if(!ifNode) return;
+
+    // Close socket
+    if(ifNode->fdSocket >= 0)
+    {
+        if(plt_sockClose(ifNode->fdSocket)) logError("close() failed (error: %d)", plt_sockGetLastError());
+    }
+
+    // Free memory
+    free(ifNode);
+}
+
+
+// -------------------------------------------------------------------------------------------------
+//  Trace record/replay (datagrams of a session in a memory-mapped file)
+// -------------------------------------------------------------------------------------------------
+
+static int openTraceRecord(SCAN_CONTEXT *scanCtx, const char *fileName, unsigned traceLimit)
+{
+    // The file is mapped at full size, truncated to the records on close
+    size_t mapSize = traceLimit;
+    if(mapSize < sizeof(TRACE_HEADER) + sizeof(TRACE_RECORD)) mapSize = sizeof(TRACE_HEADER) + sizeof(TRACE_RECORD);
+
+    if(plt_fileMapCreate(&scanCtx->traceMem, fileName, mapSize))
+    {
+        logError("fileMapCreate(%s) failed (error: %d)", fileName, plt_sockGetLastError());
+        return -1;
+    }
+
+    // Note: Released by closeTrace() (along with the mapping)
+    scanCtx->traceFileName = copyOptionString(fileName);
+    if(scanCtx->traceFileName == (char *)0) return -1;
+
+    TRACE_HEADER *traceHdr = (TRACE_HEADER *)scanCtx->traceMem.mapPtr;
+    traceHdr->magic = TRACE_MAGIC;
+    traceHdr->version = TRACE_VERSION;
+    traceHdr->headerSize = sizeof(TRACE_HEADER);
+    traceHdr->traceLength = sizeof(TRACE_HEADER);
+    traceHdr->recordCount = 0;
+
+    scanCtx->traceOffset = sizeof(TRACE_HEADER);
+    scanCtx->usTraceStart = plt_getMonoTimeUS();
+    scanCtx->traceRecordFlag = 1;
+    return 0;
+}
+
+
+static int openTraceReplay(SCAN_CONTEXT *scanCtx, const char *fileName)
+{
+    if(plt_fileMapOpen(&scanCtx->traceMem, fileName))
+    {
+        logError("fileMapOpen(%s) failed (error: %d)", fileName, plt_sockGetLastError());
+        return -1;
+    }
+
+    const TRACE_HEADER *traceHdr = (const TRACE_HEADER *)scanCtx->traceMem.mapPtr;
+    if((scanCtx->traceMem.mapSize < sizeof(TRACE_HEADER)) || (traceHdr->magic != TRACE_MAGIC) ||
+       (traceHdr->version != TRACE_VERSION) || (traceHdr->headerSize != sizeof(TRACE_HEADER)) ||
+       (traceHdr->traceLength > scanCtx->traceMem.mapSize))
+    {
+        logError("Invalid trace file %s", fileName);
+        return -1;
+    }
+
+    // Virtual sockets: The event sources are not registered with the event loop
+    REQUEST_QUEUE *checkQueue = &scanCtx->checkRequestQueue, *infoQueue = &scanCtx->infoRequestQueue;
+    checkQueue->addrFamily = infoQueue->addrFamily = scanCtx->scanOptions.ip6Scan ? AF_INET6 : AF_INET;
+    checkQueue->eventSource.sourceType = infoQueue->eventSource.sourceType = EVSRC_REQUEST_QUEUE;
+    checkQueue->eventSource.sourceRecord = checkQueue;
+    infoQueue->eventSource.sourceRecord = infoQueue;
+    scanCtx->sharedSource.sourceType = EVSRC_SHARED_SOCKET;
+    scanCtx->sharedSource.sourceRecord = scanCtx;
+
+    scanCtx->traceOffset = sizeof(TRACE_HEADER);
+    scanCtx->traceReplayFlag = 1;
+    return 0;
+}
+
+
+static void closeTrace(SCAN_CONTEXT *scanCtx)
+{
+    if(scanCtx->traceMem.mapPtr == (void *)0) return;
+
+    // Recording: Unmap, then truncate the file to the records
+    size_t traceLength = ((const TRACE_HEADER *)scanCtx->traceMem.mapPtr)->traceLength;
+    if(plt_sharedMemClose(&scanCtx->traceMem)) logError("sharedMemClose() failed (error: %d)", plt_sockGetLastError());
+    if(scanCtx->traceFileName)
+    {
+        if(plt_fileTruncate(scanCtx->traceFileName, traceLength)) logError("fileTruncate(%s) failed (error: %d)", scanCtx->traceFileName, plt_sockGetLastError());
+    }
+
+    free(scanCtx->traceFileName);
+    scanCtx->traceFileName = (char *)0;
+    scanCtx->traceRecordFlag = scanCtx->traceReplayFlag = 0;
+}
+
+
+static TRACE_RECORD *appendTraceRecord(SCAN_CONTEXT *scanCtx, uint8_t recordType, uint8_t traceRole, const void *dataPtr, unsigned dataLength)
+{
+    // Note: Returns a zeroed record (payload copied), null in case not recording (or full)
+    if(!scanCtx->traceRecordFlag) return (TRACE_RECORD *)0;
+
+    TRACE_HEADER *traceHdr = (TRACE_HEADER *)scanCtx->traceMem.mapPtr;
+    size_t recordSize = ALIGN_SIZE(sizeof(TRACE_RECORD) + dataLength, TRACE_ALIGN);
+    if((size_t)scanCtx->traceOffset + recordSize > scanCtx->traceMem.mapSize)
+    {
+        logError("Trace file full (%u records), recording stopped", traceHdr->recordCount);
+        scanCtx->traceRecordFlag = 0;
+        return (TRACE_RECORD *)0;
+    }
+
+    uint8_t *recordPtr = (uint8_t *)scanCtx->traceMem.mapPtr + scanCtx->traceOffset;
+    memset(recordPtr, 0, recordSize);
+    if(dataLength) memcpy(recordPtr + sizeof(TRACE_RECORD), dataPtr, dataLength);
+
+    TRACE_RECORD *traceRec = (TRACE_RECORD *)recordPtr;
+    traceRec->usTime = plt_getMonoTimeUS() - scanCtx->usTraceStart;
+    traceRec->recordType = recordType;
+    traceRec->traceRole = traceRole;
+    traceRec->dataLength = (uint16_t)dataLength;
+
+    // The header is kept valid (the records so far can be replayed in any case)
+    scanCtx->traceOffset += (uint32_t)recordSize;
+    traceHdr->traceLength = scanCtx->traceOffset;
+    traceHdr->recordCount++;
+
+    return traceRec;
+}
+
+
+static void traceScanBegin(SCAN_CONTEXT *scanCtx)
+{
+    // Start of a scan: Sequence/jitter state and the interfaces (restored by the replay)
+    TRACE_SCAN traceScan;
+    memset(&traceScan, 0, sizeof(traceScan));
+    traceScan.sequenceNum = scanCtx->sequenceNum;
+    traceScan.randomState = scanCtx->randomState;
+    if(appendTraceRecord(scanCtx, TRACEREC_SCAN, 0, &traceScan, sizeof(traceScan)) == (TRACE_RECORD *)0) return;
+
+    for(INTERFACE_NODE *ifNode = scanCtx->firstIfNode; ifNode; ifNode = ifNode->next)
+    {
+        uint8_t traceRole = (ifNode->fdSocket >= 0) ? TRACEROLE_INTERFACE : TRACEROLE_SHARED;
+        TRACE_RECORD *traceRec = appendTraceRecord(scanCtx, TRACEREC_INTERFACE, traceRole, ifNode->ifName, (unsigned)strlen(ifNode->ifName));
+        if(traceRec) traceRec->localAddr = ifNode->ifAddr;
+    }
+}
+
+
+static void traceSent(SCAN_CONTEXT *scanCtx, uint8_t traceRole, const IDNSL_NET_ADDRESS *localAddr, const PLT_SOCKADDR *remoteAddr, const void *dataPtr, unsigned dataLength)
+{
+    TRACE_RECORD *traceRec = appendTraceRecord(scanCtx, TRACEREC_SENT, traceRole, dataPtr, dataLength);
+    if(traceRec == (TRACE_RECORD *)0) return;
+
+    if(localAddr) traceRec->localAddr = *localAddr;
+    traceRec->peerPort = getSockAddress(&traceRec->peerAddr, remoteAddr);
+}
+
+
+static void traceReceived(SCAN_CONTEXT *scanCtx, uint8_t traceRole, const IDNSL_NET_ADDRESS *localAddr, const PLT_RECV_SLOT *slotTable, int slotCount)
+{
+    for(int i = 0; i < slotCount && scanCtx->traceRecordFlag; i++)
+    {
+        // Truncated datagrams: The slot content
+        const PLT_RECV_SLOT *recvSlot = &slotTable[i];
+        unsigned dataLength = (recvSlot->dataLength < recvSlot->bufferSize) ? recvSlot->dataLength : recvSlot->bufferSize;
+        TRACE_RECORD *traceRec = appendTraceRecord(scanCtx, TRACEREC_RECEIVED, traceRole, recvSlot->bufferPtr, dataLength);
+        if(traceRec == (TRACE_RECORD *)0) return;
+
+        traceRec->recvFlags = (uint8_t)recvSlot->recvFlags;
+        traceRec->dropCounter = recvSlot->dropCounter;
+        traceRec->peerPort = getSockAddress(&traceRec->peerAddr, &recvSlot->remoteAddr);
+        if(localAddr) traceRec->localAddr = *localAddr;
+        else if(traceRole == TRACEROLE_SHARED) setIP4Address(&traceRec->localAddr, (uint32_t)recvSlot->localAddr.s_addr);
+    }
+}
+
+
+static void traceScanEnd(SCAN_CONTEXT *scanCtx)
+{
+    appendTraceRecord(scanCtx, TRACEREC_SCAN_END, 0, (const void *)0, 0);
+}
+
+
+static const TRACE_RECORD *peekTraceRecord(SCAN_CONTEXT *scanCtx)
+{
+    // Replay: The next record, null at the end of the trace (or in case of a damaged record)
+    const TRACE_HEADER *traceHdr = (const TRACE_HEADER *)scanCtx->traceMem.mapPtr;
+    if((size_t)scanCtx->traceOffset + sizeof(TRACE_RECORD) > traceHdr->traceLength) return (const TRACE_RECORD *)0;
+
+    const TRACE_RECORD *traceRec = (const TRACE_RECORD *)((const uint8_t *)traceHdr + scanCtx->traceOffset);
+    if((size_t)scanCtx->traceOffset + sizeof(TRACE_RECORD) + traceRec->dataLength > traceHdr->traceLength)
+    {
+        logError("Damaged trace record at offset %u", scanCtx->traceOffset);
+        scanCtx->traceOffset = traceHdr->traceLength;
+        return (const TRACE_RECORD *)0;
+    }
+
+    return traceRec;
+}
+
+
+static void skipTraceRecord(SCAN_CONTEXT *scanCtx, const TRACE_RECORD *traceRec)
+{
+    scanCtx->traceOffset += (uint32_t)ALIGN_SIZE(sizeof(TRACE_RECORD) + traceRec->dataLength, TRACE_ALIGN);
+}
+
+
+static int isTraceRecordDue(SCAN_CONTEXT *scanCtx, const TRACE_RECORD *traceRec, uint32_t usNow)
+{
+    // As fast as possible: Always. Real time: Relative to the start of the scan
+    if(!scanCtx->scanOptions.traceRealTime) return 1;
+
+    uint32_t usDue = scanCtx->usReplayStart + (traceRec->usTime - scanCtx->usTraceScan);
+    return (int32_t)(usNow - usDue) >= 0;
+}
+
+
+static uint8_t getTraceRole(SCAN_CONTEXT *scanCtx, const EVENT_SOURCE *eventSource)
+{
+    if(eventSource->sourceType == EVSRC_INTERFACE) return TRACEROLE_INTERFACE;
+    if(eventSource->sourceType == EVSRC_SHARED_SOCKET) return TRACEROLE_SHARED;
+
+    return (eventSource->sourceRecord == &scanCtx->checkRequestQueue) ? TRACEROLE_CHECK : TRACEROLE_INFO;
+}
+
+
+static int replayDatagrams(SCAN_CONTEXT *scanCtx, const EVENT_SOURCE *eventSource, PLT_RECV_SLOT *slotTable, unsigned slotCount)
+{
+    // The consecutive received datagrams of the socket (that are due)
+    uint8_t traceRole = getTraceRole(scanCtx, eventSource);
+    const INTERFACE_NODE *ifNode = (traceRole == TRACEROLE_INTERFACE) ? (const INTERFACE_NODE *)eventSource->sourceRecord : (const INTERFACE_NODE *)0;
+    uint32_t usNow = plt_getMonoTimeUS();
+
+    unsigned fillCount = 0;
+    while(fillCount < slotCount)
+    {
+        const TRACE_RECORD *traceRec = peekTraceRecord(scanCtx);
+        if(traceRec == (const TRACE_RECORD *)0) break;
+        if((traceRec->recordType != TRACEREC_RECEIVED) || (traceRec->traceRole != traceRole)) break;
+        if(ifNode && !matchNetAddress(&traceRec->localAddr, &ifNode->ifAddr)) break;
+        if(!isTraceRecordDue(scanCtx, traceRec, usNow)) break;
+
+        PLT_RECV_SLOT *recvSlot = &slotTable[fillCount++];
+        unsigned dataLength = (traceRec->dataLength < recvSlot->bufferSize) ? traceRec->dataLength : recvSlot->bufferSize;
+        memcpy(recvSlot->bufferPtr, &traceRec[1], dataLength);
+        recvSlot->dataLength = dataLength;
+        recvSlot->recvFlags = traceRec->recvFlags;
+        if(traceRec->dataLength > recvSlot->bufferSize) recvSlot->recvFlags |= PLT_RECVFLG_TRUNCATED;
+        putSockAddress(&recvSlot->remoteAddr, &traceRec->peerAddr, traceRec->peerAddr.family, traceRec->peerPort);
+        recvSlot->localAddr.s_addr = (traceRec->localAddr.family == AF_INET) ? traceRec->localAddr.u.ip4.s_addr : 0;
+        recvSlot->dropCounter = traceRec->dropCounter;
+
+        skipTraceRecord(scanCtx, traceRec);
+    }
+
+    return (int)fillCount;
+}
+
+
+static int recvDatagrams(SCAN_CONTEXT *scanCtx, EVENT_SOURCE *eventSource, int fdSocket, PACKET_RING *packetRing)
+{
+    // Replay: Datagrams taken from the trace (virtual socket)
+    if(scanCtx->traceReplayFlag) return replayDatagrams(scanCtx, eventSource, packetRing->slotTable, packetRing->slotCount);
+
+    int slotCount = plt_sockRecvBatch(fdSocket, packetRing->slotTable, packetRing->slotCount);
+    if(slotCount > 0 && scanCtx->traceRecordFlag)
+    {
+        uint8_t traceRole = getTraceRole(scanCtx, eventSource);
+        const IDNSL_NET_ADDRESS *localAddr = (const IDNSL_NET_ADDRESS *)0;
+        if(traceRole == TRACEROLE_INTERFACE) localAddr = &((const INTERFACE_NODE *)eventSource->sourceRecord)->ifAddr;
+
+        traceReceived(scanCtx, traceRole, localAddr, packetRing->slotTable, slotCount);
+    }
+
+    return slotCount;
+}
+
+
+// -------------------------------------------------------------------------------------------------
+//  Request jobs and response mapping
+// -------------------------------------------------------------------------------------------------
+
+// Info request window (see device info handling): Called once a request is given up
+static int releaseInfoRequest(SCAN_CONTEXT *scanCtx, RESPONSE_INFO *responseInfo, unsigned infoIndex);
+
+
+static uint32_t getJitter(SCAN_CONTEXT *scanCtx, uint32_t usRange)
+{
+    // Uniform in [0, usRange] (xorshift)
+    uint32_t x = scanCtx->randomState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    scanCtx->randomState = x;
+
+    return x % (usRange + 1);
+}
+
+
+static uint32_t getRetryTimeout(SCAN_CONTEXT *scanCtx, unsigned retryCount)
+{
+    // Initial timeout (at least twice the max. round trip time), doubled per retransmission
+    uint32_t usTimeout = scanCtx->scanOptions.msRetryTimeout * 1000;
+    if(usTimeout < scanCtx->usMaxRTT * 2) usTimeout = scanCtx->usMaxRTT * 2;
+    if(usTimeout < WHEEL_TICK) usTimeout = WHEEL_TICK;
+    usTimeout <<= (retryCount < 8) ? retryCount : 8;
+
+    // Add up to 25% jitter (avoid retransmission bursts of requests sent in one batch)
+    return usTimeout + getJitter(scanCtx, usTimeout / 4);
+}
+
+
+static void queueRequestJob(REQUEST_QUEUE *requestQueue, REQUEST_JOB *reqJob)
+{
+    // Append to the pending request list (new request or retransmission), track the high-water mark
+    reqJob->jobState = JOBSTATE_QUEUED;
+    APPEND_NODE(requestQueue->firstRequest, requestQueue->lastRequest, reqJob);
+
+    requestQueue->queuedCount++;
+    if(requestQueue->queuedCount > requestQueue->queueStats->queueHighWater) requestQueue->queueStats->queueHighWater = requestQueue->queuedCount;
+}
+
+
+static void completeRequest(SCAN_CONTEXT *scanCtx, REQUEST_JOB *reqJob)
+{
+    // Response received (or no more retransmissions): Stop tracking the request
+    if(reqJob == (REQUEST_JOB *)0) return;
+
+    if(reqJob->jobState == JOBSTATE_INFLIGHT)
+    {
+        removeTimerJob(&scanCtx->retryWheel, reqJob);
+    }
+    else if(reqJob->jobState == JOBSTATE_QUEUED)
+    {
+        REQUEST_QUEUE *requestQueue = reqJob->requestQueue;
+        LINKOUT_NODE(requestQueue->firstRequest, requestQueue->lastRequest, reqJob);
+        requestQueue->queuedCount--;
+        reqJob->jobState = JOBSTATE_NONE;
+    }
+
+    if(reqJob->ownerRef) *reqJob->ownerRef = (REQUEST_JOB *)0;
+    reqJob->ownerRef = (REQUEST_JOB **)0;
+}
+
+
+static int expireRequests(SCAN_CONTEXT *scanCtx, uint64_t usNow)
+{
+    TIMER_WHEEL *timerWheel = &scanCtx->retryWheel;
+    uint64_t tickNow = usNow / WHEEL_TICK;
+    uint64_t tickCount = (tickNow > timerWheel->tickDone) ? (tickNow - timerWheel->tickDone) : 0;
+    if(tickCount > WHEEL_SLOT_COUNT) tickCount = WHEEL_SLOT_COUNT;
+    if(timerWheel->jobCount == 0) tickCount = 0;
+
+    // Visit the slots of all elapsed ticks (each slot once at most)
+    for(uint64_t tick = timerWheel->tickDone + 1; tickCount > 0; tick++, tickCount--)
+    {
+        WHEEL_SLOT *wheelSlot = &timerWheel->slotTable[tick & (WHEEL_SLOT_COUNT - 1)];
+        REQUEST_JOB *reqJob = wheelSlot->firstJob;
+        while(reqJob)
+        {
+            REQUEST_JOB *nextJob = reqJob->next;
+
+            // Jobs of a later round stay in the slot
+            if(reqJob->usDue <= usNow)
+            {
+                removeTimerJob(timerWheel, reqJob);
+
+                // Retransmit (same sequence number, a late response is accepted) - or give up
+                if(reqJob->retryCount < scanCtx->scanOptions.retryLimit)
+                {
+                    reqJob->retryCount++;
+                    reqJob->requestQueue->queueStats->retryCount++;
+                    queueRequestJob(reqJob->requestQueue, reqJob);
+                }
+                else
+                {
+                    reqJob->requestQueue->queueStats->timeoutCount++;
+                    completeRequest(scanCtx, reqJob);
+
+                    // Info requests: The window slot is free for the next request
+                    if(reqJob->infoOwner && releaseInfoRequest(scanCtx, reqJob->infoOwner, reqJob->infoIndex)) return -1;
+                }
+            }
+
+            reqJob = nextJob;
+        }
+    }
+
+    if(tickNow > timerWheel->tickDone) timerWheel->tickDone = tickNow;
+    return 0;
+}
+
+
+static int sendRequests(SCAN_CONTEXT *scanCtx, REQUEST_QUEUE *requestQueue)
+{
+    uint64_t nsNow = plt_getMonoTimeNS();
+    uint32_t usNow = (uint32_t)(nsNow / 1000);
+
+    for(unsigned batchCount = 0; batchCount < SEND_BATCH_LIMIT; batchCount++)
+    {
+        // Collect the requests that may be sent now (skip requests held back by pacing)
+        REQUEST_JOB *jobTable[PLT_SEND_BATCH_MAX];
+        PLT_SEND_SLOT slotTable[PLT_SEND_BATCH_MAX];
+        unsigned slotCount = 0, inspectCount = 0;
+
+        REQUEST_JOB *reqJob = requestQueue->firstRequest;
+        for(; reqJob && (slotCount < PLT_SEND_BATCH_MAX) && (inspectCount < PACING_LOOKAHEAD); reqJob = reqJob->next)
+        {
+            inspectCount++;
+            refillTokenBucket(reqJob->requestPacer, nsNow);
+            if(!takeToken(reqJob->requestPacer)) continue;
+
+            // Populate remote socket address struct
+            PLT_SEND_SLOT *sendSlot = &slotTable[slotCount];
+            putSockAddress(&sendSlot->remoteAddr, &reqJob->addr, requestQueue->addrFamily, IDNVAL_HELLO_UDP_PORT);
+            sendSlot->dataPtr = (uint8_t *)&reqJob[1];
+            sendSlot->dataLength = reqJob->packetLength;
+
+            // Ping requests carry the send time (echoed, a retransmission is measured on its own)
+            IDNHDR_PACKET *reqPacketHdr = (IDNHDR_PACKET *)&reqJob[1];
+            if(reqPacketHdr->command == IDNCMD_PING_REQUEST)
+            {
+                uint32_t usSent = htonl(usNow);
+                memcpy(&reqPacketHdr[1], &usSent, sizeof(usSent));
+            }
+
+            jobTable[slotCount++] = reqJob;
+        }
+        if(slotCount == 0) break;
+
+        // Send the requests (all or until the socket would block). Replay: Sent at once
+        int sentCount = scanCtx->traceReplayFlag ? (int)slotCount : plt_sockSendBatch(requestQueue->fdSocket, slotTable, slotCount);
+        if(sentCount < 0)
+        {
+            logError("sendBatch() failed (error: %d)", plt_sockGetLastError());
+            return -1;
+        }
+
+        uint8_t traceRole = (requestQueue == &scanCtx->checkRequestQueue) ? TRACEROLE_CHECK : TRACEROLE_INFO;
+        for(int i = 0; i < sentCount && scanCtx->traceRecordFlag; i++)
+        {
+            traceSent(scanCtx, traceRole, (const IDNSL_NET_ADDRESS *)0, &slotTable[i].remoteAddr, slotTable[i].dataPtr, slotTable[i].dataLength);
+        }
+
+        // Remove sent requests from pending request list, keep others
+        for(unsigned i = 0; i < slotCount; i++)
+        {
+            reqJob = jobTable[i];
+            if(i >= (unsigned)sentCount) { returnToken(reqJob->requestPacer); continue; }
+
+            // Requests with an owner wait for the response (retransmission timeout). Info requests
+            // without retransmission as well (the window slot is released on the timeout).
+            // Note: Job memory is released with the arena
+            LINKOUT_NODE(requestQueue->firstRequest, requestQueue->lastRequest, reqJob);
+            requestQueue->queuedCount--;
+            requestQueue->queueStats->packetsSent++;
+            reqJob->jobState = JOBSTATE_NONE;
+            if(reqJob->ownerRef && (scanCtx->scanOptions.retryLimit || reqJob->infoOwner))
+            {
+                insertTimerJob(&scanCtx->retryWheel, reqJob, (nsNow / 1000) + getRetryTimeout(scanCtx, reqJob->retryCount));
+                if(scanCtx->retryWheel.jobCount > scanCtx->scanStats.inflightHighWater) scanCtx->scanStats.inflightHighWater = scanCtx->retryWheel.jobCount;
+            }
+            else if(reqJob->ownerRef)
+            {
+                completeRequest(scanCtx, reqJob);
+            }
+        }
+
+        // Socket would block
+        if((unsigned)sentCount < slotCount) break;
+    }
+
+    return 0;
+}
+
+
+static REQUEST_JOB *scheduleRequestJob(SCAN_CONTEXT *scanCtx, REQUEST_QUEUE *requestQueue, TOKEN_BUCKET *requestPacer, uint8_t cmd, uint16_t sequenceNum, const IDNSL_NET_ADDRESS *addr, REQUEST_JOB **ownerRef, size_t payloadLength)
+{
+    // Allocate request job memory (from scan arena). Note: Payload populated by the caller
+    size_t memSize = sizeof(REQUEST_JOB) + sizeof(IDNHDR_PACKET) + payloadLength;
+    REQUEST_JOB *reqJob = (REQUEST_JOB *)arenaAlloc(&scanCtx->scanArena, memSize);
+    if(reqJob == (REQUEST_JOB *)0) return (REQUEST_JOB *)0;
+
+    // Populate request job fields
+    reqJob->addr = *addr;
+    reqJob->requestPacer = requestPacer;
+    reqJob->packetLength = (uint16_t)(memSize - sizeof(REQUEST_JOB));
+    reqJob->requestQueue = requestQueue;
+
+    // Track the request until the response is received (replaces a previous request)
+    if(ownerRef)
+    {
+        completeRequest(scanCtx, *ownerRef);
+        reqJob->ownerRef = ownerRef;
+        *ownerRef = reqJob;
+    }
+
+    // Populate packet fields
+    IDNHDR_PACKET *reqPacketHdr = (IDNHDR_PACKET *)&reqJob[1];
+    reqPacketHdr->command = cmd;
+    reqPacketHdr->flags = scanCtx->clientGroup & IDNMSK_PKTFLAGS_GROUP;
+    reqPacketHdr->sequence = htons(sequenceNum);
+
+    // Schedule for transmission
+    queueRequestJob(requestQueue, reqJob);
+
+    return reqJob;
+}
+
+
+static int scheduleQueryRequest(SCAN_CONTEXT *scanCtx, REQUEST_QUEUE *requestQueue, TOKEN_BUCKET *requestPacer, uint8_t cmd, uint16_t sequenceNum, const IDNSL_NET_ADDRESS *addr, REQUEST_JOB **ownerRef)
+{
+    // Requests without payload
+    REQUEST_JOB *reqJob = scheduleRequestJob(scanCtx, requestQueue, requestPacer, cmd, sequenceNum, addr, ownerRef, 0);
+    return (reqJob == (REQUEST_JOB *)0) ? -1 : 0;
+}
+
+
+static int matchResponseAddress(const void *entryPtr, const void *keyPtr)
+{
+    const RESPONSE_INFO *responseInfo = (const RESPONSE_INFO *)entryPtr;
+    return matchNetAddress(&responseInfo->addr, (const IDNSL_NET_ADDRESS *)keyPtr);
+}
+
+
+static RESPONSE_INFO *getResponseInfo(SCAN_CONTEXT *scanCtx, const IDNSL_NET_ADDRESS *addr)
+{
+    // In case the address is already known: Return response info
+    uint32_t hashValue = hashAddress(addr);
+    RESPONSE_INFO *responseInfo = (RESPONSE_INFO *)findHashEntry(&scanCtx->responseIndex, hashValue, matchResponseAddress, addr);
+    if(responseInfo != (RESPONSE_INFO *)0) return responseInfo;
+
+    // New response address - allocate info record (from scan arena)
+    responseInfo = (RESPONSE_INFO *)arenaAlloc(&scanCtx->scanArena, sizeof(RESPONSE_INFO));
+    if(responseInfo == (RESPONSE_INFO *)0) return (RESPONSE_INFO *)0;
+
+    // Populate fields - server address, interface not known yet
+    responseInfo->addr = *addr;
+    responseInfo->requestPacer = &scanCtx->defaultPacer;
+
+    // Add to index
+    if(insertHashEntry(&scanCtx->responseIndex, hashValue, responseInfo)) return (RESPONSE_INFO *)0;
+
+    // Append to response info list and return info record
+    APPEND_NODE(scanCtx->firstResponseInfo, scanCtx->lastResponseInfo, responseInfo);
+    return responseInfo;
+}
+
+
+// -------------------------------------------------------------------------------------------------
+//  Service maps
+// -------------------------------------------------------------------------------------------------
+
+static size_t getServiceMapSize(unsigned relayCount, unsigned serviceCount)
+{
+    size_t mapSize = sizeof(IDNSL_SERVICE_MAP);
+    mapSize += (relayCount + serviceCount) * sizeof(IDNHDR_SERVICEMAP_ENTRY);
+    mapSize += serviceCount + serviceCount + (relayCount + 2);
+
+    return mapSize;
+}
+
+
+static const IDNHDR_SERVICEMAP_ENTRY *getServiceMapEntries(const IDNSL_SERVICE_MAP *serviceMap)
+{
+    return (const IDNHDR_SERVICEMAP_ENTRY *)&serviceMap[1];
+}
+
+
+static const uint8_t *getServiceRelayTable(const IDNSL_SERVICE_MAP *serviceMap)
+{
+    return (const uint8_t *)&getServiceMapEntries(serviceMap)[serviceMap->relayCount + serviceMap->serviceCount];
+}
+
+
+static const uint8_t *getRelayServiceTable(const IDNSL_SERVICE_MAP *serviceMap)
+{
+    return &getServiceRelayTable(serviceMap)[serviceMap->serviceCount];
+}
+
+
+static const uint8_t *getRelayStartTable(const IDNSL_SERVICE_MAP *serviceMap)
+{
+    return &getRelayServiceTable(serviceMap)[serviceMap->serviceCount];
+}
+
+
+static IDNSL_SERVICE_MAP *createServiceMap(SCAN_CONTEXT *scanCtx, const IDNHDR_SERVICEMAP_RESPONSE *serviceMapHdr, const IDNSL_NET_ADDRESS *remoteAddr)
+{
+    // Note: The entry table (following the header) has the size checked already
+    unsigned relayCount = serviceMapHdr->relayEntryCount;
+    unsigned serviceCount = serviceMapHdr->serviceEntryCount;
+    const IDNHDR_SERVICEMAP_ENTRY *entryTable = (const IDNHDR_SERVICEMAP_ENTRY *)&serviceMapHdr[1];
+
+    // Allocate memory (single block, copied as is into the server list)
+    size_t mapSize = getServiceMapSize(relayCount, serviceCount);
+    IDNSL_SERVICE_MAP *serviceMap = (IDNSL_SERVICE_MAP *)malloc(mapSize);
+    if(serviceMap == (IDNSL_SERVICE_MAP *)0)
+    {
+        logError("malloc(IDNSL_SERVICE_MAP) failed");
+        return (IDNSL_SERVICE_MAP *)0;
+    }
+
+    serviceMap->mapSize = (uint32_t)mapSize;
+    serviceMap->relayCount = (uint8_t)relayCount;
+    serviceMap->serviceCount = (uint8_t)serviceCount;
+    memcpy((void *)getServiceMapEntries(serviceMap), entryTable, (relayCount + serviceCount) * sizeof(IDNHDR_SERVICEMAP_ENTRY));
+
+    uint8_t *serviceRelayTable = (uint8_t *)getServiceRelayTable(serviceMap);
+    uint8_t *relayServiceTable = (uint8_t *)getRelayServiceTable(serviceMap);
+    uint8_t *relayStartTable = (uint8_t *)getRelayStartTable(serviceMap);
+
+    do
+    {
+        // Validate relay entries, index by relay number (the first entry of a number is used)
+        uint8_t relayIndexTable[256];
+        memset(relayIndexTable, 0xFF, sizeof(relayIndexTable));
+
+        unsigned relayIndex;
+        for(relayIndex = 0; relayIndex < relayCount; relayIndex++)
+        {
+            const IDNHDR_SERVICEMAP_ENTRY *serviceMapEntry = &entryTable[relayIndex];
+            if(serviceMapEntry->serviceID != 0)
+            {
+                rejectPacket(scanCtx, IDNSL_REJECT_CONTENT, "ServiceMapRsp", remoteAddr, "Relay entry: Invalid serviceID %u", serviceMapEntry->serviceID);
+                break;
+            }
+            else if(serviceMapEntry->serviceType != 0)
+            {
+                rejectPacket(scanCtx, IDNSL_REJECT_CONTENT, "ServiceMapRsp", remoteAddr, "Relay entry: Invalid serviceType %u", serviceMapEntry->serviceType);
+                break;
+            }
+            else if(serviceMapEntry->relayNumber == 0)
+            {
+                rejectPacket(scanCtx, IDNSL_REJECT_CONTENT, "ServiceMapRsp", remoteAddr, "Relay entry: Invalid relayNumber %u", serviceMapEntry->relayNumber);
+                break;
+            }
+
+            if(relayIndexTable[serviceMapEntry->relayNumber] == 0xFF) relayIndexTable[serviceMapEntry->relayNumber] = (uint8_t)relayIndex;
+        }
+        if(relayIndex < relayCount) break;
+
+        // Validate service entries, resolve the relay of each service, count services per relay
+        unsigned groupCount[256 + 1];
+        memset(groupCount, 0, (relayCount + 1) * sizeof(unsigned));
+
+        unsigned serviceIndex;
+        for(serviceIndex = 0; serviceIndex < serviceCount; serviceIndex++)
+        {
+            const IDNHDR_SERVICEMAP_ENTRY *serviceMapEntry = &entryTable[relayCount + serviceIndex];
+            if(serviceMapEntry->serviceID == 0)
+            {
+                rejectPacket(scanCtx, IDNSL_REJECT_CONTENT, "ServiceMapRsp", remoteAddr, "Service entry: Invalid serviceID %u", serviceMapEntry->serviceID);
+                break;
+            }
+
+            unsigned groupIndex = relayCount;
+            if(serviceMapEntry->relayNumber != 0)
+            {
+                groupIndex = relayIndexTable[serviceMapEntry->relayNumber];
+                if(groupIndex == 0xFF)
+                {
+                    rejectPacket(scanCtx, IDNSL_REJECT_CONTENT, "ServiceMapRsp", remoteAddr, "Service entry: Invalid relayNumber %u", serviceMapEntry->relayNumber);
+                    break;
+                }
+            }
+
+            serviceRelayTable[serviceIndex] = (uint8_t)groupIndex;
+            groupCount[groupIndex]++;
+        }
+        if(serviceIndex < serviceCount) break;
+
+        // Group the services by relay (counting sort, stable)
+        unsigned groupStart = 0;
+        for(unsigned i = 0; i <= relayCount; i++)
+        {
+            relayStartTable[i] = (uint8_t)groupStart;
+            groupStart += groupCount[i];
+            groupCount[i] = relayStartTable[i];
+        }
+        relayStartTable[relayCount + 1] = (uint8_t)serviceCount;
+
+        for(unsigned i = 0; i < serviceCount; i++)
+        {
+            relayServiceTable[groupCount[serviceRelayTable[i]]++] = (uint8_t)i;
+        }
+
+        return serviceMap;
+    }
+    while(0);
+
+    free(serviceMap);
+    return (IDNSL_SERVICE_MAP *)0;
+}
+
+
+static void decodeRelayEntry(const IDNSL_SERVICE_MAP *serviceMap, unsigned relayIndex, IDNSL_RELAY_INFO *relayInfo)
+{
+    const IDNHDR_SERVICEMAP_ENTRY *serviceMapEntry = &getServiceMapEntries(serviceMap)[relayIndex];
+
+    relayInfo->relayNumber = serviceMapEntry->relayNumber;
+    relayInfo->flags = serviceMapEntry->flags;
+    COPY_NAME_NULLTERM(relayInfo->relayName, serviceMapEntry->name);
+    relayInfo->firstRelayService = (IDNSL_SERVICE_INFO *)0;
+}
+
+
+static void decodeServiceEntry(const IDNSL_SERVICE_MAP *serviceMap, unsigned serviceIndex, IDNSL_SERVICE_INFO *serviceInfo)
+{
+    const IDNHDR_SERVICEMAP_ENTRY *serviceMapEntry = &getServiceMapEntries(serviceMap)[serviceMap->relayCount + serviceIndex];
+
+    serviceInfo->serviceID = serviceMapEntry->serviceID;
+    serviceInfo->serviceType = serviceMapEntry->serviceType;
+    serviceInfo->flags = serviceMapEntry->flags;
+    COPY_NAME_NULLTERM(serviceInfo->serviceName, serviceMapEntry->name);
+    serviceInfo->parentRelay = (IDNSL_RELAY_INFO *)0;
+    serviceInfo->nextRelayService = (IDNSL_SERVICE_INFO *)0;
+}
+
+
+static int decodeServiceMap(const IDNSL_SERVICE_MAP *serviceMap, IDNSL_RELAY_INFO **pRelayTable, IDNSL_SERVICE_INFO **pServiceTable)
+{
+    IDNSL_RELAY_INFO *relayTable = (IDNSL_RELAY_INFO *)0;
+    IDNSL_SERVICE_INFO *serviceTable = (IDNSL_SERVICE_INFO *)0;
+    do
+    {
+        // Allocate memory
+        if(serviceMap->relayCount > 0)
+        {
+            relayTable = (IDNSL_RELAY_INFO *)calloc(serviceMap->relayCount, sizeof(IDNSL_RELAY_INFO));
+            if(relayTable == (IDNSL_RELAY_INFO *)0)
+            {
+                logError("calloc(IDNSL_RELAY_INFO) failed");
+                break;
+            }
+        }
+
+        if(serviceMap->serviceCount > 0)
+        {
+            serviceTable = (IDNSL_SERVICE_INFO *)calloc(serviceMap->serviceCount, sizeof(IDNSL_SERVICE_INFO));
+            if(serviceTable == (IDNSL_SERVICE_INFO *)0)
+            {
+                logError("calloc(IDNSL_SERVICE_INFO) failed");
+                break;
+            }
+        }
+
+        // Decode entries
+        for(unsigned i = 0; i < serviceMap->relayCount; i++) decodeRelayEntry(serviceMap, i, &relayTable[i]);
+        for(unsigned i = 0; i < serviceMap->serviceCount; i++) decodeServiceEntry(serviceMap, i, &serviceTable[i]);
+
+        // Link the services of each relay (group order is service order)
+        const uint8_t *relayServiceTable = getRelayServiceTable(serviceMap);
+        const uint8_t *relayStartTable = getRelayStartTable(serviceMap);
+        for(unsigned relayIndex = 0; relayIndex < serviceMap->relayCount; relayIndex++)
+        {
+            IDNSL_SERVICE_INFO **linkRef = &relayTable[relayIndex].firstRelayService;
+            for(unsigned i = relayStartTable[relayIndex]; i < relayStartTable[relayIndex + 1]; i++)
+            {
+                IDNSL_SERVICE_INFO *serviceEntry = &serviceTable[relayServiceTable[i]];
+                serviceEntry->parentRelay = &relayTable[relayIndex];
+                *linkRef = serviceEntry;
+                linkRef = &serviceEntry->nextRelayService;
+            }
+        }
+
+        *pRelayTable = relayTable;
+        *pServiceTable = serviceTable;
+        return 0;
+    }
+    while(0);
+
+    free(relayTable);
+    free(serviceTable);
+    return -1;
+}
+
+
+static int serviceMapResponse(SCAN_CONTEXT *scanCtx, RESPONSE_INFO *responseInfo, void *payloadPtr, size_t payloadLen)
+{
+    const IDNSL_NET_ADDRESS *remoteAddr = &responseInfo->addr;
+
+    // -------------------------------------------------------------------------
+    //  Check response
+    // -------------------------------------------------------------------------
+
+    if(payloadLen < sizeof(IDNHDR_SERVICEMAP_RESPONSE))
+    {
+        rejectPacket(scanCtx, IDNSL_REJECT_LENGTH, "ServiceMapRsp", remoteAddr, "Invalid response length %u", (unsigned)payloadLen);
+        return 0;
+    }
+
+    IDNHDR_SERVICEMAP_RESPONSE *serviceMapHdr = (IDNHDR_SERVICEMAP_RESPONSE *)payloadPtr;
+    if(serviceMapHdr->structSize != sizeof(IDNHDR_SERVICEMAP_RESPONSE))
+    {
+        rejectPacket(scanCtx, IDNSL_REJECT_STRUCTSIZE, "ServiceMapRsp", remoteAddr, "Invalid header size %u", serviceMapHdr->structSize);
+        return 0;
+    }
+
+    // Check entry table
+    payloadPtr = &serviceMapHdr[1];
+    payloadLen -= sizeof(IDNHDR_SERVICEMAP_RESPONSE);
+    if(serviceMapHdr->entrySize != sizeof(IDNHDR_SERVICEMAP_ENTRY))
+    {
+        rejectPacket(scanCtx, IDNSL_REJECT_STRUCTSIZE, "ServiceMapRsp", remoteAddr, "Invalid entry struct size %u", serviceMapHdr->entrySize);
+        return 0;
+    }
+
+    unsigned entryCount = serviceMapHdr->relayEntryCount + serviceMapHdr->serviceEntryCount;
+    if(payloadLen != entryCount * serviceMapHdr->entrySize)
+    {
+        rejectPacket(scanCtx, IDNSL_REJECT_LENGTH, "ServiceMapRsp", remoteAddr, "Invalid entry table %u != %u * %u", (unsigned)payloadLen, entryCount, serviceMapHdr->entrySize);
+        return 0;
+    }
+
+
+    // -------------------------------------------------------------------------
+    //  Validate entries, decode relay table and service table
+    // -------------------------------------------------------------------------
+
+    IDNSL_SERVICE_MAP *serviceMap = createServiceMap(scanCtx, serviceMapHdr, remoteAddr);
+    if(serviceMap == (IDNSL_SERVICE_MAP *)0) return 0;
+
+    // Lazy service maps: Entries are decoded on demand (see accessors), no tables
+    IDNSL_RELAY_INFO *relayTable = (IDNSL_RELAY_INFO *)0;
+    IDNSL_SERVICE_INFO *serviceTable = (IDNSL_SERVICE_INFO *)0;
+    if(!scanCtx->scanOptions.lazyServiceMap && decodeServiceMap(serviceMap, &relayTable, &serviceTable))
+    {
+        // Service map not available (keep the tables of a previous scan)
+        free(serviceMap);
+        return 0;
+    }
+
+    // Replace the tables of a previous scan
+    IDNSL_SERVER_INFO *serverInfo = responseInfo->serverInfo;
+    free(serverInfo->relayTable);
+    free(serverInfo->serviceTable);
+    free((void *)serverInfo->serviceMap);
+
+    serverInfo->relayCount = serviceMap->relayCount;
+    serverInfo->relayTable = relayTable;
+    serverInfo->serviceCount = serviceMap->serviceCount;
+    serverInfo->serviceTable = serviceTable;
+    serverInfo->serviceMap = serviceMap;
+
+    // Not requested again unless the server changes
+    ((SERVER_NODE *)serverInfo)->serviceMapFlag = 1;
+    notifyServer(scanCtx, scanCtx->callbacks.onServiceMapReady, serverInfo);
+
+    // No error
+    return 1;
+}
+
+
+// -------------------------------------------------------------------------------------------------
+//  Device info handling
+// -------------------------------------------------------------------------------------------------
+
+static void freeParamTable(IDNSL_SERVER_INFO *serverInfo)
+{
+    for(unsigned i = 0; i < serverInfo->paramCount; i++) free((void *)serverInfo->paramTable[i].dataPtr);
+    free(serverInfo->paramTable);
+
+    serverInfo->paramCount = 0;
+    serverInfo->paramTable = (IDNSL_PARAMETER_INFO *)0;
+}
+
+
+static int appendParamEntries(IDNSL_SERVER_INFO *serverInfo, unsigned paramRequests, const IDNSL_SERVICE_MAP *serviceMap)
+{
+    // Entries in request order: Unit, link, then the services (service map order)
+    unsigned serviceCount = ((paramRequests & IDNSL_PARAMREQ_SERVICE) && serviceMap) ? serviceMap->serviceCount : 0;
+    unsigned addCount = ((paramRequests & IDNSL_PARAMREQ_UNIT) ? 1 : 0) + ((paramRequests & IDNSL_PARAMREQ_LINK) ? 1 : 0) + serviceCount;
+    if(addCount == 0) return 0;
+
+    size_t tableSize = (serverInfo->paramCount + addCount) * sizeof(IDNSL_PARAMETER_INFO);
+    IDNSL_PARAMETER_INFO *paramTable = (IDNSL_PARAMETER_INFO *)realloc(serverInfo->paramTable, tableSize);
+    if(paramTable == (IDNSL_PARAMETER_INFO *)0)
+    {
+        logError("realloc(IDNSL_PARAMETER_INFO) failed");
+        return -1;
+    }
+
+    IDNSL_PARAMETER_INFO *paramInfo = &paramTable[serverInfo->paramCount];
+    memset(paramInfo, 0, addCount * sizeof(IDNSL_PARAMETER_INFO));
+    serverInfo->paramTable = paramTable;
+    serverInfo->paramCount += addCount;
+
+    if(paramRequests & IDNSL_PARAMREQ_UNIT) (paramInfo++)->paramType = IDNSL_PARAMREQ_UNIT;
+    if(paramRequests & IDNSL_PARAMREQ_LINK) (paramInfo++)->paramType = IDNSL_PARAMREQ_LINK;
+    for(unsigned i = 0; i < serviceCount; i++, paramInfo++)
+    {
+        paramInfo->paramType = IDNSL_PARAMREQ_SERVICE;
+        paramInfo->serviceID = getServiceMapEntries(serviceMap)[serviceMap->relayCount + i].serviceID;
+    }
+
+    return 0;
+}
+
+
+static INFO_REQUEST *findInfoRequest(RESPONSE_INFO *responseInfo, uint16_t sequenceNum)
+{
+    for(unsigned i = 0; responseInfo->infoTable && (i < IDNSL_PARAM_WINDOW_MAX); i++)
+    {
+        INFO_REQUEST *infoRequest = &responseInfo->infoTable[i];
+        if(infoRequest->pendingFlag && (infoRequest->sequenceNum == sequenceNum)) return infoRequest;
+    }
+
+    return (INFO_REQUEST *)0;
+}
+
+
+static int scheduleInfoRequest(SCAN_CONTEXT *scanCtx, RESPONSE_INFO *responseInfo, uint8_t cmd, unsigned paramIndex)
+{
+    // Take a free slot (the window is limited by the caller). Note: A request without response
+    // keeps its slot until it is given up (timeout, end of the scan).
+    unsigned infoIndex = 0;
+    while((infoIndex < IDNSL_PARAM_WINDOW_MAX) && responseInfo->infoTable[infoIndex].pendingFlag) infoIndex++;
+    if(infoIndex >= IDNSL_PARAM_WINDOW_MAX) return 0;
+
+    // Service parameter requests carry the service ID (reserved bytes zero-padded)
+    size_t payloadLength = (cmd == IDNCMD_SERVICE_PARAMETERS_REQUEST) ? PARAM_PAYLOAD_SIZE : 0;
+
+    INFO_REQUEST *infoRequest = &responseInfo->infoTable[infoIndex];
+    uint16_t sequenceNum = scanCtx->sequenceNum++;
+    REQUEST_JOB *reqJob = scheduleRequestJob(scanCtx, &(scanCtx->infoRequestQueue), responseInfo->requestPacer, cmd, sequenceNum, &(responseInfo->addr), &(infoRequest->reqJob), payloadLength);
+    if(reqJob == (REQUEST_JOB *)0) return -1;
+
+    reqJob->infoOwner = responseInfo;
+    reqJob->infoIndex = (uint8_t)infoIndex;
+    if(payloadLength)
+    {
+        uint8_t *payloadPtr = (uint8_t *)&reqJob[1] + sizeof(IDNHDR_PACKET);
+        payloadPtr[0] = responseInfo->serverInfo->paramTable[paramIndex].serviceID;
+    }
+
+    // Track the request (matched by sequence number)
+    infoRequest->pendingFlag = 1;
+    infoRequest->cmd = cmd;
+    infoRequest->sequenceNum = sequenceNum;
+    infoRequest->paramIndex = paramIndex;
+
+    return 0;
+}
+
+
+static int fillInfoWindow(SCAN_CONTEXT *scanCtx, RESPONSE_INFO *responseInfo)
+{
+    IDNSL_SERVER_INFO *serverInfo = responseInfo->serverInfo;
+    SERVER_NODE *serverNode = (SERVER_NODE *)serverInfo;
+    if(!responseInfo->paramActiveFlag) return 0;
+
+    unsigned windowSize = scanCtx->scanOptions.paramWindow;
+    if(windowSize < 1) windowSize = 1;
+    if(windowSize > IDNSL_PARAM_WINDOW_MAX) windowSize = IDNSL_PARAM_WINDOW_MAX;
+
+    unsigned pendingCount = 0;
+    for(unsigned i = 0; i < IDNSL_PARAM_WINDOW_MAX; i++) pendingCount += responseInfo->infoTable[i].pendingFlag;
+
+    // Keep the window filled with the next parameter requests (service map included)
+    for(; (responseInfo->paramNext < serverInfo->paramCount) && (pendingCount < windowSize); pendingCount++)
+    {
+        uint8_t paramType = serverInfo->paramTable[responseInfo->paramNext].paramType;
+        uint8_t cmd = IDNCMD_SERVICE_PARAMETERS_REQUEST;
+        if(paramType == IDNSL_PARAMREQ_UNIT) cmd = IDNCMD_UNIT_PARAMETERS_REQUEST;
+        else if(paramType == IDNSL_PARAMREQ_LINK) cmd = IDNCMD_LINK_PARAMETERS_REQUEST;
+
+        if(scheduleInfoRequest(scanCtx, responseInfo, cmd, responseInfo->paramNext)) return -1;
+        responseInfo->paramNext++;
+    }
+
+    // Done once all requests are answered or given up (the service map adds the service entries)
+    if(pendingCount || (responseInfo->paramNext < serverInfo->paramCount)) return 0;
+    responseInfo->paramActiveFlag = 0;
+
+    unsigned validCount = 0;
+    for(unsigned i = 0; i < serverInfo->paramCount; i++) validCount += serverInfo->paramTable[i].validFlag;
+    int serviceMissing = (scanCtx->scanOptions.paramRequests & IDNSL_PARAMREQ_SERVICE) && !serverNode->serviceMapFlag;
+    serverNode->paramFlag = (validCount == serverInfo->paramCount) && !serviceMissing;
+
+    notifyServer(scanCtx, scanCtx->callbacks.onParametersReady, serverInfo);
+    return 0;
+}
+
+
+static int releaseInfoRequest(SCAN_CONTEXT *scanCtx, RESPONSE_INFO *responseInfo, unsigned infoIndex)
+{
+    // Response received or request given up: Next request of the window
+    responseInfo->infoTable[infoIndex].pendingFlag = 0;
+    return fillInfoWindow(scanCtx, responseInfo);
+}
+
+
+static void closeInfoRequests(SCAN_CONTEXT *scanCtx)
+{
+    // Scan complete (quiet period, timeout): Requests without response are given up, parameters
+    // not requested yet are failed as well - the servers still retrieving parameters are done
+    REQUEST_QUEUE *infoQueue = &scanCtx->infoRequestQueue;
+    for(RESPONSE_INFO *responseInfo = scanCtx->firstResponseInfo; responseInfo; responseInfo = responseInfo->next)
+    {
+        if(!responseInfo->paramActiveFlag) continue;
+
+        for(unsigned i = 0; i < IDNSL_PARAM_WINDOW_MAX; i++)
+        {
+            INFO_REQUEST *infoRequest = &responseInfo->infoTable[i];
+            if(!infoRequest->pendingFlag) continue;
+
+            completeRequest(scanCtx, infoRequest->reqJob);
+            infoRequest->pendingFlag = 0;
+            infoQueue->queueStats->timeoutCount++;
+        }
+
+        // Note: Nothing is scheduled (all requested), the window is closed
+        responseInfo->paramNext = responseInfo->serverInfo->paramCount;
+        fillInfoWindow(scanCtx, responseInfo);
+    }
+}
+
+
+static int scheduleInfoRequests(SCAN_CONTEXT *scanCtx, RESPONSE_INFO *responseInfo)
+{
+    SERVER_NODE *serverNode = (SERVER_NODE *)responseInfo->serverInfo;
+
+    // Request window slots (from scan arena)
+    if(responseInfo->infoTable == (INFO_REQUEST *)0)
+    {
+        responseInfo->infoTable = (INFO_REQUEST *)arenaAlloc(&scanCtx->scanArena, IDNSL_PARAM_WINDOW_MAX * sizeof(INFO_REQUEST));
+        if(responseInfo->infoTable == (INFO_REQUEST *)0) return -1;
+    }
+
+    // Service map (unless up to date)
+    if(!serverNode->serviceMapFlag)
+    {
+        if(scheduleInfoRequest(scanCtx, responseInfo, IDNCMD_SERVICEMAP_REQUEST, 0)) return -1;
+    }
+
+    // Parameters (unless complete): Unit/link parameters and the services of a current service
+    // map right away, the services of a requested service map once received
+    unsigned paramRequests = scanCtx->scanOptions.paramRequests;
+    if(!paramRequests || serverNode->paramFlag) return 0;
+
+    freeParamTable(&serverNode->serverInfo);
+    unsigned paramMask = paramRequests & (IDNSL_PARAMREQ_UNIT | IDNSL_PARAMREQ_LINK);
+    if(serverNode->serviceMapFlag) paramMask |= paramRequests & IDNSL_PARAMREQ_SERVICE;
+    if(appendParamEntries(&serverNode->serverInfo, paramMask, serverNode->serverInfo.serviceMap)) return -1;
+
+    responseInfo->paramNext = 0;
+    responseInfo->paramActiveFlag = 1;
+    return fillInfoWindow(scanCtx, responseInfo);
+}
+
+
+static int parameterResponse(SCAN_CONTEXT *scanCtx, RESPONSE_INFO *responseInfo, unsigned paramIndex, void *payloadPtr, size_t payloadLen)
+{
+    // Note: The index belongs to the table of this scan (replaced when the retrieval starts)
+    IDNSL_SERVER_INFO *serverInfo = responseInfo->serverInfo;
+    if(!responseInfo->paramActiveFlag || (paramIndex >= serverInfo->paramCount)) return 0;
+
+    // Keep the payload as received (replaces a previous response)
+    uint8_t *dataPtr = (uint8_t *)malloc(payloadLen ? payloadLen : 1);
+    if(dataPtr == (uint8_t *)0)
+    {
+        logError("malloc(parameters) failed");
+        return -1;
+    }
+    memcpy(dataPtr, payloadPtr, payloadLen);
+
+    IDNSL_PARAMETER_INFO *paramInfo = &serverInfo->paramTable[paramIndex];
+    free((void *)paramInfo->dataPtr);
+    paramInfo->dataPtr = dataPtr;
+    paramInfo->dataLength = (uint32_t)payloadLen;
+    paramInfo->validFlag = 1;
+
+    return 0;
+}
+
+
+static int handleInfoResponse(SCAN_CONTEXT *scanCtx, PLT_RECV_SLOT *recvSlot)
+{
+    IDNSL_NET_ADDRESS remoteAddr;
+    uint16_t remotePort = getSockAddress(&remoteAddr, &recvSlot->remoteAddr);
+    unsigned nBytes = recvSlot->dataLength;
+
+    // Check sender port
+    if(remotePort != IDNVAL_HELLO_UDP_PORT)
+    {
+        rejectPacket(scanCtx, IDNSL_REJECT_PORT, "InfoRsp", &remoteAddr, "Invalid sender port %u", remotePort);
+        return 0;
+    }
+
+    // Get info record for address from which the datagram was received
+    RESPONSE_INFO *responseInfo = getResponseInfo(scanCtx, &remoteAddr);
+    if(responseInfo == (RESPONSE_INFO *)0) return -1;
+
+
+    // -------------------------------------------------------------------------
+    //  Check IDN-Hello packet header
+    // -------------------------------------------------------------------------
+
+    if(recvSlot->recvFlags & PLT_RECVFLG_TRUNCATED)
+    {
+        rejectPacket(scanCtx, IDNSL_REJECT_TRUNCATED, "InfoRsp", &remoteAddr, "Truncated packet (exceeds %u)", recvSlot->bufferSize);
+        return 0;
+    }
+
+    if((size_t)nBytes < sizeof(IDNHDR_PACKET))
+    {
+        rejectPacket(scanCtx, IDNSL_REJECT_LENGTH, "InfoRsp", &remoteAddr, "Invalid packet size %u", nBytes);
+        return 0;
+    }
+
+    // Calculate pointers
+    IDNHDR_PACKET *recvPacketHdr = (IDNHDR_PACKET *)recvSlot->bufferPtr;
+    void *payloadPtr = &recvPacketHdr[1];
+    size_t payloadLen = (size_t)nBytes - sizeof(IDNHDR_PACKET);
+
+    // Match the response with its request (per request sequence number)
+    uint16_t sequenceNum = ntohs(recvPacketHdr->sequence);
+    INFO_REQUEST *infoRequest = findInfoRequest(responseInfo, sequenceNum);
+    if(infoRequest == (INFO_REQUEST *)0)
+    {
+        rejectPacket(scanCtx, IDNSL_REJECT_SEQUENCE, "InfoRsp", &remoteAddr, "Invalid sequence %04X", sequenceNum);
+        return 0;
+    }
+
+    if(recvPacketHdr->command != (uint8_t)(infoRequest->cmd + 1))
+    {
+        rejectPacket(scanCtx, IDNSL_REJECT_COMMAND, "InfoRsp", &remoteAddr, "Invalid command 0x%02X (request 0x%02X)", recvPacketHdr->command, infoRequest->cmd);
+        return 0;
+    }
+
+    // Latency of the first response to the request (broadcast -> service map). Note: The
+    // request is released below, duplicates do not match
+    if(infoRequest->cmd == IDNCMD_SERVICEMAP_REQUEST)
+    {
+        IDNSL_SCAN_STATS *scanStats = &scanCtx->scanStats;
+        scanStats->usLastServiceMap = scanCtx->usLastActivity - scanCtx->usScanStart;
+        if(responseInfo->scanSentFlag) addLatencySample(&scanStats->serviceMapLatency, scanCtx->usLastActivity - responseInfo->usScanSent);
+    }
+
+    // Response received - no retransmission
+    completeRequest(scanCtx, infoRequest->reqJob);
+
+    // Dispatch based response
+    if(infoRequest->cmd == IDNCMD_SERVICEMAP_REQUEST)
+    {
+        // Process service map response
+        int rcRsp = serviceMapResponse(scanCtx, responseInfo, payloadPtr, payloadLen);
+        if(rcRsp < 0) return rcRsp;
+
+        // Parameter retrieval: The service parameters are requested once the services are known
+        unsigned paramRequests = scanCtx->scanOptions.paramRequests;
+        if(rcRsp && responseInfo->paramActiveFlag && (paramRequests & IDNSL_PARAMREQ_SERVICE))
+        {
+            if(appendParamEntries(responseInfo->serverInfo, IDNSL_PARAMREQ_SERVICE, responseInfo->serverInfo->serviceMap)) return -1;
+        }
+    }
+    else
+    {
+        if(parameterResponse(scanCtx, responseInfo, infoRequest->paramIndex, payloadPtr, payloadLen)) return -1;
+    }
+
+    // Next request of the window
+    return releaseInfoRequest(scanCtx, responseInfo, (unsigned)(infoRequest - responseInfo->infoTable));
+}
+
+
+static int recvInfoResponse(SCAN_CONTEXT *scanCtx)
+{
+    PACKET_RING *packetRing = &scanCtx->infoRing;
+    int fdSocket = scanCtx->infoRequestQueue.fdSocket;
+
+    // Drain the socket in batches, then process all datagrams of the batch
+    for(unsigned batchCount = 0; batchCount < RECV_BATCH_LIMIT; batchCount++)
+    {
+        int slotCount = recvDatagrams(scanCtx, &scanCtx->infoRequestQueue.eventSource, fdSocket, packetRing);
+        if(slotCount < 0)
+        {
+            logError("recvBatch() failed (error: %d)", plt_sockGetLastError());
+            return -1;
+        }
+
+        if(slotCount > 0) scanCtx->usLastActivity = plt_getMonoTimeUS();
+        REQUEST_QUEUE *infoQueue = &scanCtx->infoRequestQueue;
+        infoQueue->queueStats->packetsReceived += (unsigned)slotCount;
+        infoQueue->queueStats->packetsDropped += countDrops(scanCtx, &infoQueue->dropCounter, packetRing->slotTable, slotCount);
+        for(int i = 0; i < slotCount; i++)
+        {
+            if(handleInfoResponse(scanCtx, &packetRing->slotTable[i])) return -1;
+        }
+
+        // Socket drained in case the batch was not filled
+        if((unsigned)slotCount < packetRing->slotCount) break;
+    }
+
+    return 0;
+}
+
+
+// -------------------------------------------------------------------------------------------------
+//  Scan targets (hosts, subnet sweeps, directed broadcasts)
+// -------------------------------------------------------------------------------------------------
+
+static int parseScanTarget(const char *targetSpec, SCAN_TARGET *scanTarget)
+{
+    // Syntax: [bcast:]a.b.c.d[/prefixLength]
+    memset(scanTarget, 0, sizeof(SCAN_TARGET));
+    if(!strncmp(targetSpec, "bcast:", 6))
+    {
+        scanTarget->broadcastFlag = 1;
+        targetSpec += 6;
+    }
+
+    uint32_t netAddr, hostMask;
+    if(parseSubnet(targetSpec, &netAddr, &hostMask)) return -1;
+
+    netAddr &= ~hostMask;
+    if(scanTarget->broadcastFlag)
+    {
+        // Single request to the broadcast address of the subnet
+        scanTarget->firstAddr = netAddr | hostMask;
+        scanTarget->addrCount = 1;
+    }
+    else if(hostMask <= 1)
+    {
+        // Host (or point-to-point pair, RFC 3021)
+        scanTarget->firstAddr = netAddr;
+        scanTarget->addrCount = hostMask + 1;
+    }
+    else
+    {
+        // Subnet sweep: All hosts (neither network nor broadcast address). Note: The host mask
+        // is compared (the subnet size overflows for /0)
+        if(hostMask >= TARGET_RANGE_LIMIT) return -1;
+        scanTarget->firstAddr = netAddr + 1;
+        scanTarget->addrCount = hostMask - 1;
+    }
+
+    return 0;
+}
+
+
+static int addScanTargets(SCAN_CONTEXT *scanCtx, const char *targetList)
+{
+    // Comma (or blank) separated list of target specifications
+    unsigned broadcastCount = 0;
+    const char *cursor = targetList;
+    char targetSpec[TARGET_SPEC_LENGTH + 8];
+    for(int rcItem; (rcItem = getListItem(&cursor, targetSpec, sizeof(targetSpec))) != 0; )
+    {
+        if(rcItem < 0)
+        {
+            logError("Scan target too long");
+            return -1;
+        }
+
+        SCAN_TARGET *targetTable = (SCAN_TARGET *)realloc(scanCtx->targetTable, (scanCtx->targetCount + 1) * sizeof(SCAN_TARGET));
+        if(targetTable == (SCAN_TARGET *)0)
+        {
+            logError("realloc(targetTable) failed");
+            return -1;
+        }
+        scanCtx->targetTable = targetTable;
+
+        SCAN_TARGET *scanTarget = &targetTable[scanCtx->targetCount];
+        if(parseScanTarget(targetSpec, scanTarget))
+        {
+            logError("Invalid scan target '%s'", targetSpec);
+            return -1;
+        }
+
+        if(scanTarget->broadcastFlag) broadcastCount++;
+        scanCtx->targetCount++;
+    }
+
+    // Subnet-directed broadcasts are sent on the check socket
+    if(broadcastCount && (plt_sockSetBroadcast(scanCtx->checkRequestQueue.fdSocket) < 0))
+    {
+        logError("setsockopt(broadcast) failed (error: %d)", plt_sockGetLastError());
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static SCAN_TARGET *findBroadcastTarget(SCAN_CONTEXT *scanCtx, uint16_t sequenceNum)
+{
+    for(unsigned i = 0; i < scanCtx->targetCount; i++)
+    {
+        SCAN_TARGET *scanTarget = &scanCtx->targetTable[i];
+        if(scanTarget->broadcastFlag && (scanTarget->scanSequenceNum == sequenceNum)) return scanTarget;
+    }
+
+    return (SCAN_TARGET *)0;
+}
+
+
+static int scheduleTargetHost(SCAN_CONTEXT *scanCtx, SCAN_TARGET *scanTarget, uint32_t addrIndex)
+{
+    // Check request to an address of the target. Responses are checks - the host is reachable.
+    // Note: Single hosts are retransmitted, ranges are swept once per sweep.
+    IDNSL_NET_ADDRESS addr;
+    setIP4Address(&addr, htonl(scanTarget->firstAddr + addrIndex));
+    RESPONSE_INFO *responseInfo = getResponseInfo(scanCtx, &addr);
+    if(responseInfo == (RESPONSE_INFO *)0) return -1;
+    if(responseInfo->checkPendingFlag || responseInfo->targetRequestFlag) return 0;
+
+    responseInfo->targetRequestFlag = 1;
+    responseInfo->checkPendingFlag = 1;
+    responseInfo->requestPacer = &scanCtx->targetPacer;
+    responseInfo->checkSequenceNum = scanCtx->sequenceNum++;
+
+    REQUEST_JOB **ownerRef = (scanTarget->addrCount == 1) ? &responseInfo->checkJob : (REQUEST_JOB **)0;
+    return scheduleQueryRequest(scanCtx, &scanCtx->checkRequestQueue, responseInfo->requestPacer, IDNCMD_SCAN_REQUEST, responseInfo->checkSequenceNum, &addr, ownerRef);
+}
+
+
+static int scheduleTargetRequests(SCAN_CONTEXT *scanCtx, unsigned msTimeout)
+{
+    REQUEST_QUEUE *checkQueue = &scanCtx->checkRequestQueue;
+    uint8_t cmd = IDNCMD_SCAN_REQUEST;
+
+    // Broadcasts first (the response time is measured from here)
+    for(unsigned i = 0; i < scanCtx->targetCount; i++)
+    {
+        SCAN_TARGET *scanTarget = &scanCtx->targetTable[i];
+        if(!scanTarget->broadcastFlag) continue;
+
+        IDNSL_NET_ADDRESS addr;
+        setIP4Address(&addr, htonl(scanTarget->firstAddr));
+        scanTarget->scanSequenceNum = scanCtx->sequenceNum++;
+        scanTarget->usScanSent = plt_getMonoTimeUS();
+        if(scheduleQueryRequest(scanCtx, checkQueue, &scanCtx->targetPacer, cmd, scanTarget->scanSequenceNum, &addr, (REQUEST_JOB **)0)) return -1;
+    }
+
+    // Then the hosts. Ranges are fed by the pacer (see feedTargetSweeps), a sweep not complete
+    // at the end of the scan is continued by the next scan.
+    for(unsigned i = 0; i < scanCtx->targetCount; i++)
+    {
+        SCAN_TARGET *scanTarget = &scanCtx->targetTable[i];
+        if(scanTarget->broadcastFlag) continue;
+
+        if(scanTarget->addrCount > 1)
+        {
+            if(scanTarget->sweepIndex >= scanTarget->addrCount) scanTarget->sweepIndex = 0;
+            if(scanTarget->sweepIndex == 0) scanTarget->sweepCount++;
+
+            // First sweep: Note in case the timeout does not cover it
+            unsigned targetRate = scanCtx->scanOptions.targetRate;
+            if((scanTarget->sweepCount == 1) && (scanTarget->sweepIndex == 0) && targetRate)
+            {
+                uint64_t msSweep = ((uint64_t)scanTarget->addrCount * 1000) / targetRate;
+                if(msSweep > msTimeout) logError("Sweep of %u addresses takes %u ms (timeout %u ms), continued by the next scan", scanTarget->addrCount, (unsigned)msSweep, msTimeout);
+            }
+            continue;
+        }
+
+        if(scheduleTargetHost(scanCtx, scanTarget, 0)) return -1;
+    }
+
+    return 0;
+}
+
+
+static int isSweepPending(SCAN_CONTEXT *scanCtx)
+{
+    for(unsigned i = 0; i < scanCtx->targetCount; i++)
+    {
+        SCAN_TARGET *scanTarget = &scanCtx->targetTable[i];
+        if(!scanTarget->broadcastFlag && (scanTarget->sweepIndex < scanTarget->addrCount)) return 1;
+    }
+
+    return 0;
+}
+
+
+static int feedTargetSweeps(SCAN_CONTEXT *scanCtx, uint32_t *usWait)
+{
+    // Queue the next addresses of the sweeps as far as the pacer allows (no more than a few
+    // batches queued). Shortens the wait time to the next token otherwise.
+    if(scanCtx->verifyScanFlag || !isSweepPending(scanCtx)) return 0;
+
+    REQUEST_QUEUE *checkQueue = &scanCtx->checkRequestQueue;
+    if(checkQueue->queuedCount >= SWEEP_QUEUE_LIMIT) return 0;
+    unsigned feedCount = SWEEP_QUEUE_LIMIT - checkQueue->queuedCount;
+
+    TOKEN_BUCKET *targetPacer = &scanCtx->targetPacer;
+    refillTokenBucket(targetPacer, plt_getMonoTimeNS());
+    if(targetPacer->tokenRate)
+    {
+        uint64_t tokenCount = targetPacer->tokenCredit / TOKEN_SCALE;
+        if(tokenCount < feedCount) feedCount = (unsigned)tokenCount;
+    }
+    if(feedCount == 0)
+    {
+        uint32_t usDelay = getTokenDelay(targetPacer);
+        if(usDelay < *usWait) *usWait = usDelay;
+        return 0;
+    }
+
+    for(unsigned i = 0; (i < scanCtx->targetCount) && feedCount; i++)
+    {
+        SCAN_TARGET *scanTarget = &scanCtx->targetTable[i];
+        if(scanTarget->broadcastFlag) continue;
+
+        for(; (scanTarget->sweepIndex < scanTarget->addrCount) && feedCount; feedCount--)
+        {
+            if(scheduleTargetHost(scanCtx, scanTarget, scanTarget->sweepIndex++)) return -1;
+        }
+    }
+
+    return 0;
+}
+
+
+// -------------------------------------------------------------------------------------------------
+//  Discovery broadcast and reachability handling
+// -------------------------------------------------------------------------------------------------
+
+static int sendBroadcastRequest(SCAN_CONTEXT *scanCtx, INTERFACE_NODE *ifNode)
+{
+    // Remember request packet sequence number. A follow-up is a retransmission (responses to the
+    // first broadcast may still be queued). Multi-group scan: One broadcast per group, consecutive
+    // sequence numbers (the group of a response is given by its sequence number)
+    if(!ifNode->followUpFlag && (ifNode->groupSentCount == 0))
+    {
+        ifNode->scanSequenceNum = scanCtx->sequenceNum;
+        scanCtx->sequenceNum += scanCtx->groupCount;
+    }
+
+    // Use network broadcast address (to find all servers). IPv6: Multicast group on the link
+    IDNSL_NET_ADDRESS remoteAddr;
+    if(ifNode->ifAddr.family == AF_INET6) setIP6Address(&remoteAddr, &scanCtx->ip6Group, ifNode->ifAddr.scopeID);
+    else setIP4Address(&remoteAddr, INADDR_BROADCAST);
+
+    PLT_SOCKADDR remoteSockAddr;
+    putSockAddress(&remoteSockAddr, &remoteAddr, ifNode->ifAddr.family, IDNVAL_HELLO_UDP_PORT);
+
+    for(; ifNode->groupSentCount < scanCtx->groupCount; ifNode->groupSentCount++)
+    {
+        // Populate IDN-Hello request packet
+        IDNHDR_PACKET reqPacketHdr;
+        reqPacketHdr.command = IDNCMD_SCAN_REQUEST;
+        reqPacketHdr.flags = scanCtx->groupTable[ifNode->groupSentCount] & IDNMSK_PKTFLAGS_GROUP;
+        reqPacketHdr.sequence = htons((uint16_t)(ifNode->scanSequenceNum + ifNode->groupSentCount));
+
+        // Broadcast the scan request (shared socket: from the interface address, on the interface).
+        // Return 1 in case the socket would block (try again, continued with the next group).
+        // Replay: Sent at once (virtual socket)
+        int rcSend;
+        if(scanCtx->traceReplayFlag)
+        {
+            rcSend = (int)sizeof(reqPacketHdr);
+        }
+        else if(ifNode->fdSocket >= 0)
+        {
+            rcSend = sendto(ifNode->fdSocket, (char *)&reqPacketHdr, sizeof(reqPacketHdr), 0, &remoteSockAddr.sa, plt_sockAddrSize(&remoteSockAddr));
+        }
+        else
+        {
+            const uint8_t *dataPtr = (const uint8_t *)&reqPacketHdr;
+            rcSend = plt_sockSendFrom(scanCtx->fdShared, dataPtr, sizeof(reqPacketHdr), &remoteSockAddr, ifNode->ifAddr.u.ip4, ifNode->ifIndex);
+        }
+
+        if(rcSend < 0)
+        {
+            int errorCode = plt_sockGetLastError();
+            if(plt_sockIsWouldBlock(errorCode)) return 1;
+
+            logError("%s() failed (error: %d)", (ifNode->fdSocket >= 0) ? "sendto" : "sendFrom", errorCode);
+            return -1;
+        }
+
+        uint8_t traceRole = (ifNode->fdSocket >= 0) ? TRACEROLE_INTERFACE : TRACEROLE_SHARED;
+        traceSent(scanCtx, traceRole, &ifNode->ifAddr, &remoteSockAddr, &reqPacketHdr, sizeof(reqPacketHdr));
+
+        // Latencies are measured from the first broadcast of the request
+        scanCtx->usLastActivity = plt_getMonoTimeUS();
+        if(ifNode->groupSentCount == 0) ifNode->usScanSent = scanCtx->usLastActivity;
+        ifNode->ifStats.packetsSent++;
+    }
+
+    ifNode->groupSentCount = 0;
+    ifNode->bcastDueFlag = 0;
+    if(ifNode->followUpFlag)
+    {
+        ifNode->followUpFlag = 0;
+        ifNode->followUpCount++;
+        ifNode->ifStats.followUpCount++;
+    }
+    return 0;
+}
+
+
+static int setRecvBuffer(SCAN_CONTEXT *scanCtx, int fdSocket)
+{
+    if((scanCtx->recvBufferSize == 0) || (fdSocket < 0)) return 0;
+
+    if(plt_sockSetRecvBuffer(fdSocket, scanCtx->recvBufferSize) < 0)
+    {
+        logError("setsockopt(receive buffer) failed (error: %d)", plt_sockGetLastError());
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int sizeRecvBuffers(SCAN_CONTEXT *scanCtx, unsigned serverCount)
+{
+    // Broadcast responses arrive at once: Room for a response of each server. Buffers are grown only.
+    uint64_t bufferSize = (uint64_t)serverCount * RECV_BUFFER_PER_SERVER;
+    if(bufferSize < RECV_BUFFER_MIN) bufferSize = RECV_BUFFER_MIN;
+    if(bufferSize > RECV_BUFFER_MAX) bufferSize = RECV_BUFFER_MAX;
+    if((unsigned)bufferSize <= scanCtx->recvBufferSize) return 0;
+    scanCtx->recvBufferSize = (unsigned)bufferSize;
+    scanCtx->scanStats.recvBufferSize = scanCtx->recvBufferSize;
+
+    for(INTERFACE_NODE *ifNode = scanCtx->firstIfNode; ifNode; ifNode = ifNode->next)
+    {
+        if(setRecvBuffer(scanCtx, ifNode->fdSocket)) return -1;
+    }
+    if(setRecvBuffer(scanCtx, scanCtx->fdShared)) return -1;
+    if(setRecvBuffer(scanCtx, scanCtx->checkRequestQueue.fdSocket)) return -1;
+    if(setRecvBuffer(scanCtx, scanCtx->infoRequestQueue.fdSocket)) return -1;
+
+    return 0;
+}
+
+
+static void scheduleFollowUp(SCAN_CONTEXT *scanCtx, INTERFACE_NODE *ifNode, uint32_t usNow)
+{
+    // Kernel drops on the broadcast socket: Broadcast again once the burst had the time to drain
+    // (as long as it took so far, with jitter - interfaces are not followed up at once). Not in
+    // case a broadcast is scheduled already.
+    if(ifNode->bcastDueFlag || (ifNode->followUpCount >= scanCtx->scanOptions.followUpLimit)) return;
+    if(scanCtx->verifyScanFlag || scanCtx->scanOptions.noBroadcast) return;
+
+    uint32_t usDelay = (usNow - ifNode->usScanSent) + FOLLOWUP_DELAY_MIN;
+    ifNode->usBcastDue = usNow + usDelay + getJitter(scanCtx, usDelay / 2);
+    ifNode->bcastDueFlag = 1;
+    ifNode->followUpFlag = 1;
+}
+
+
+static int scheduleCheckRequest(SCAN_CONTEXT *scanCtx, RESPONSE_INFO *responseInfo)
+{
+    uint8_t cmd = IDNCMD_SCAN_REQUEST;
+    uint16_t sequenceNum = responseInfo->checkSequenceNum = scanCtx->sequenceNum++;
+    responseInfo->checkPendingFlag = 1;
+    return scheduleQueryRequest(scanCtx, &(scanCtx->checkRequestQueue), responseInfo->requestPacer, cmd, sequenceNum, &(responseInfo->addr), &(responseInfo->checkJob));
+}
+
+
+static int schedulePingRequest(SCAN_CONTEXT *scanCtx, RESPONSE_INFO *responseInfo)
+{
+    // One ping at a time (the next one is sent on the response), retransmitted like checks
+    uint8_t cmd = IDNCMD_PING_REQUEST;
+    uint16_t sequenceNum = responseInfo->pingSequenceNum = scanCtx->sequenceNum++;
+    REQUEST_JOB *reqJob = scheduleRequestJob(scanCtx, &(scanCtx->checkRequestQueue), responseInfo->requestPacer, cmd, sequenceNum, &(responseInfo->addr), &(responseInfo->pingJob), PING_PAYLOAD_SIZE);
+    if(reqJob == (REQUEST_JOB *)0) return -1;
+
+    responseInfo->pingRequestFlag = 1;
+    responseInfo->pingPendingFlag = 1;
+    return 0;
+}
+
+
+static int matchServerUnitID(const void *entryPtr, const void *keyPtr)
+{
+    const IDNSL_SERVER_INFO *serverInfo = (const IDNSL_SERVER_INFO *)entryPtr;
+    const uint8_t *unitID = (const uint8_t *)keyPtr;
+
+    // Check UnitID length (stored in first byte), then the UnitID
+    if(serverInfo->unitID[0] != unitID[0]) return 0;
+    return memcmp(&serverInfo->unitID[1], &unitID[1], unitID[0]) == 0;
+}
+
+
+static SERVER_NODE *addServerNode(SCAN_CONTEXT *scanCtx, const uint8_t *unitID, uint32_t hashValue)
+{
+    // Allocate server record (kept across scans, the result list is a copy)
+    // Note: The unitID length is checked by the caller
+    SERVER_NODE *serverNode = (SERVER_NODE *)calloc(1, sizeof(SERVER_NODE));
+    if(serverNode == (SERVER_NODE *)0)
+    {
+        logError("calloc(SERVER_NODE) failed");
+        return (SERVER_NODE *)0;
+    }
+
+    // Populate unitID (Note: Field 0-initialized - calloc)
+    IDNSL_SERVER_INFO *serverInfo = &serverNode->serverInfo;
+    serverInfo->unitID[0] = unitID[0];
+    memcpy(&serverInfo->unitID[1], &unitID[1], unitID[0]);
+    serverNode->seenScanCount = scanCtx->scanCount;
+
+    // Add to index
+    if(insertHashEntry(&scanCtx->serverIndex, hashValue, serverNode))
+    {
+        free(serverNode);
+        return (SERVER_NODE *)0;
+    }
+
+    // Append to list (in order of discovery)
+    if(scanCtx->lastServerInfo) scanCtx->lastServerInfo->next = serverInfo;
+    else scanCtx->firstServerInfo = serverInfo;
+    scanCtx->lastServerInfo = serverInfo;
+
+    return serverNode;
+}
+
+
+static IDNSL_SERVER_INFO *getServerInfo(SCAN_CONTEXT *scanCtx, IDNHDR_SCAN_RESPONSE *scanRspHdr, uint8_t clientGroup)
+{
+    // Note: The unitID length is validated with the scan response header. Multi-group scan: The
+    // status is tracked for the client group of the session - the responses to the other groups
+    // add to the group masks only (the excluded flag differs by group)
+    int otherGroupFlag = (clientGroup != scanCtx->clientGroup);
+
+    // In case the server is already known (this or a previous scan): Return server info
+    uint32_t hashValue = hashUnitID(scanRspHdr->unitID);
+    SERVER_NODE *serverNode = (SERVER_NODE *)findHashEntry(&scanCtx->serverIndex, hashValue, matchServerUnitID, scanRspHdr->unitID);
+    if(serverNode != (SERVER_NODE *)0)
+    {
+        // The status of a new server found with another group is replaced silently
+        if(serverNode->otherGroupFlag && !otherGroupFlag)
+        {
+            serverNode->scanStatus = scanRspHdr->status;
+            serverNode->otherGroupFlag = 0;
+        }
+
+        // Changed host name or status: The service map is requested again
+        char hostName[IDNSL_HOST_NAME_LENGTH];
+        COPY_NAME_NULLTERM(hostName, scanRspHdr->hostName);
+        int statusFlag = !otherGroupFlag && (serverNode->scanStatus != scanRspHdr->status);
+        if(statusFlag || memcmp(hostName, serverNode->serverInfo.hostName, sizeof(hostName)))
+        {
+            memcpy(serverNode->serverInfo.hostName, hostName, sizeof(hostName));
+            if(!otherGroupFlag) serverNode->scanStatus = scanRspHdr->status;
+            serverNode->serviceMapFlag = 0;
+            serverNode->paramFlag = 0;
+            serverNode->changedFlag = 1;
+        }
+
+        serverNode->seenScanCount = scanCtx->scanCount;
+        return &serverNode->serverInfo;
+    }
+
+    // New server - populate host name
+    serverNode = addServerNode(scanCtx, scanRspHdr->unitID, hashValue);
+    if(serverNode == (SERVER_NODE *)0) return (IDNSL_SERVER_INFO *)0;
+
+    IDNSL_SERVER_INFO *serverInfo = &serverNode->serverInfo;
+    COPY_NAME_NULLTERM(serverInfo->hostName, scanRspHdr->hostName);
+    serverNode->scanStatus = scanRspHdr->status;
+    serverNode->otherGroupFlag = (uint8_t)otherGroupFlag;
+
+    return serverInfo;
+}
+
+
+static int findServerAddress(IDNSL_SERVER_INFO *serverInfo, const IDNSL_NET_ADDRESS *addr)
+{
+    for(unsigned i = 0; i < serverInfo->addressCount; i++)
+    {
+        IDNSL_SERVER_ADDRESS *serverAddr = &serverInfo->addressTable[i];
+        if(matchNetAddress(&serverAddr->netAddr, addr)) return i;
+    }
+
+    return -1;
+}
+
+
+static void swapServerAddress(IDNSL_SERVER_INFO *serverInfo, unsigned addrIndex1, unsigned addrIndex2)
+{
+    SERVER_NODE *serverNode = (SERVER_NODE *)serverInfo;
+
+    IDNSL_SERVER_ADDRESS serverAddr = serverInfo->addressTable[addrIndex1];
+    serverInfo->addressTable[addrIndex1] = serverInfo->addressTable[addrIndex2];
+    serverInfo->addressTable[addrIndex2] = serverAddr;
+
+    uint32_t scanCount = serverNode->addressScanTable[addrIndex1];
+    serverNode->addressScanTable[addrIndex1] = serverNode->addressScanTable[addrIndex2];
+    serverNode->addressScanTable[addrIndex2] = scanCount;
+}
+
+
+static int getServerAddressIndex(SCAN_CONTEXT *scanCtx, IDNSL_SERVER_INFO *serverInfo, const IDNSL_NET_ADDRESS *addr)
+{
+    SERVER_NODE *serverNode = (SERVER_NODE *)serverInfo;
+
+    // In case the address is already known: Mark as seen in this scan, return the index
+    int knownIndex = findServerAddress(serverInfo, addr);
+    if(knownIndex >= 0)
+    {
+        serverNode->addressScanTable[knownIndex] = scanCtx->scanCount;
+        return knownIndex;
+    }
+
+    // New address - grow address tables in case they are full (double the size)
+    unsigned addrCount = serverInfo->addressCount;
+    if(addrCount == serverNode->addressLimit)
+    {
+        unsigned newLimit = addrCount ? (addrCount * 2) : 2;
+        IDNSL_SERVER_ADDRESS *addrTable = (IDNSL_SERVER_ADDRESS *)realloc(serverInfo->addressTable, newLimit * sizeof(IDNSL_SERVER_ADDRESS));
+        if(addrTable == (IDNSL_SERVER_ADDRESS *)0)
+        {
+            logError("realloc(IDNSL_SERVER_ADDRESS) failed");
+            return -1;
+        }
+        serverInfo->addressTable = addrTable;
+
+        uint32_t *scanTable = (uint32_t *)realloc(serverNode->addressScanTable, newLimit * sizeof(uint32_t));
+        if(scanTable == (uint32_t *)0)
+        {
+            logError("realloc(addressScanTable) failed");
+            return -1;
+        }
+        serverNode->addressScanTable = scanTable;
+        serverNode->addressLimit = newLimit;
+    }
+
+    // Populate info entry fields, assume unreachable
+    unsigned addrIndex = serverInfo->addressCount++;
+    IDNSL_SERVER_ADDRESS *serverAddr = &serverInfo->addressTable[addrIndex];
+    memset(serverAddr, 0, sizeof(IDNSL_SERVER_ADDRESS));
+    serverAddr->errorFlags = IDNSL_ADDR_ERRORFLAG_UNREACHABLE;
+    serverAddr->netAddr = *addr;
+    if(addr->family == AF_INET) serverAddr->addr = addr->u.ip4;
+    serverNode->addressScanTable[addrIndex] = scanCtx->scanCount;
+
+    return addrIndex;
+}
+
+
+static int isLowerLatency(const IDNSL_SERVER_ADDRESS *serverAddr1, const IDNSL_SERVER_ADDRESS *serverAddr2)
+{
+    // Measured addresses first (by average round trip time), unmeasured addresses keep their order
+    if(serverAddr1->rttSampleCount == 0) return 0;
+    if(serverAddr2->rttSampleCount == 0) return 1;
+    return serverAddr1->usRTTAvg < serverAddr2->usRTTAvg;
+}
+
+
+static int rankServerAddress(IDNSL_SERVER_INFO *serverInfo, int addrIndex)
+{
+    // Move a reachable address within the reachable group (ordered by latency)
+    IDNSL_SERVER_ADDRESS *addressTable = serverInfo->addressTable;
+    if(addressTable[addrIndex].errorFlags != 0) return addrIndex;
+
+    for(; addrIndex > 0; addrIndex--)
+    {
+        if(addressTable[addrIndex - 1].errorFlags != 0) break;
+        if(!isLowerLatency(&addressTable[addrIndex], &addressTable[addrIndex - 1])) break;
+        swapServerAddress(serverInfo, addrIndex - 1, addrIndex);
+    }
+
+    int addrLimit = (int)(serverInfo->addressCount) - 1;
+    for(; addrIndex < addrLimit; addrIndex++)
+    {
+        if(addressTable[addrIndex + 1].errorFlags != 0) break;
+        if(!isLowerLatency(&addressTable[addrIndex + 1], &addressTable[addrIndex])) break;
+        swapServerAddress(serverInfo, addrIndex + 1, addrIndex);
+    }
+
+    return addrIndex;
+}
+
+
+static int putScannedAddress(SCAN_CONTEXT *scanCtx, IDNSL_SERVER_INFO *serverInfo, const IDNSL_NET_ADDRESS *addr)
+{
+    return getServerAddressIndex(scanCtx, serverInfo, addr);
+}
+
+
+static int putCheckedAddress(SCAN_CONTEXT *scanCtx, IDNSL_SERVER_INFO *serverInfo, const IDNSL_NET_ADDRESS *addr)
+{
+    int addrIndex = getServerAddressIndex(scanCtx, serverInfo, addr);
+    if(addrIndex < 0) return addrIndex;
+
+    // Reachability has been checked - remove error flags.
+    unsigned errorFlags = serverInfo->addressTable[addrIndex].errorFlags;
+    serverInfo->addressTable[addrIndex].errorFlags &= ~(IDNSL_ADDR_ERRORFLAG_UNREACHABLE | IDNSL_ADDR_ERRORFLAG_UNVERIFIED);
+    if(serverInfo->addressTable[addrIndex].errorFlags != 0) return addrIndex;
+
+    // Maintain address info list order (reachable first, erroneous last)
+    for(; addrIndex > 0; addrIndex--) 
+    {
+        if(serverInfo->addressTable[addrIndex - 1].errorFlags == 0) break;
+
+        // Swap in case entry is preceeded by an erroneous entry
+        swapServerAddress(serverInfo, addrIndex - 1, addrIndex);
+    }
+
+    // Report newly reachable address
+    IDNSL_ADDRESS_PFN pfnCallback = scanCtx->callbacks.onAddressReachable;
+    if(pfnCallback && (errorFlags & (IDNSL_ADDR_ERRORFLAG_UNREACHABLE | IDNSL_ADDR_ERRORFLAG_UNVERIFIED)))
+    {
+        pfnCallback(scanCtx->callbacks.callbackArg, serverInfo, &serverInfo->addressTable[addrIndex]);
+    }
+
+    return addrIndex;
+}
+
+
+static int putAmbiguousAddress(SCAN_CONTEXT *scanCtx, IDNSL_SERVER_INFO *serverInfo, const IDNSL_NET_ADDRESS *addr)
+{
+    int addrIndex = getServerAddressIndex(scanCtx, serverInfo, addr);
+    if(addrIndex < 0) return addrIndex;
+
+    // Set error flag
+    serverInfo->addressTable[addrIndex].errorFlags |= IDNSL_ADDR_ERRORFLAG_AMBIGUOUS;
+
+    // Maintain address info list order (reachable first, erroneous last)
+    int addrLimit = (int)(serverInfo->addressCount) - 1;
+    for(; addrIndex < addrLimit; addrIndex++) 
+    {
+        if(serverInfo->addressTable[addrIndex + 1].errorFlags != 0) break;
+
+        // Swap in case entry is followed by a reachable entry
+        swapServerAddress(serverInfo, addrIndex + 1, addrIndex);
+    }
+
+    return addrIndex;
+}
+
+
+static void reportServerEvents(SCAN_CONTEXT *scanCtx, IDNSL_SERVER_INFO *serverInfo)
+{
+    SERVER_NODE *serverNode = (SERVER_NODE *)serverInfo;
+
+    // New servers are reported once (with the first address), known servers in case of changes
+    if(serverNode->foundFlag == 0)
+    {
+        serverNode->foundFlag = 1;
+        serverNode->changedFlag = 0;
+        notifyServer(scanCtx, scanCtx->callbacks.onServerFound, serverInfo);
+    }
+    else if(serverNode->changedFlag)
+    {
+        serverNode->changedFlag = 0;
+        notifyServer(scanCtx, scanCtx->callbacks.onServerChanged, serverInfo);
+    }
+}
+
+
+static int handleScanResponse(SCAN_CONTEXT *scanCtx, INTERFACE_NODE *ifNode, PLT_RECV_SLOT *recvSlot)
+{
+    IDNSL_NET_ADDRESS remoteAddr;
+    uint16_t remotePort = getSockAddress(&remoteAddr, &recvSlot->remoteAddr);
+    unsigned nBytes = recvSlot->dataLength;
+
+    // Check sender port
+    if(remotePort != IDNVAL_HELLO_UDP_PORT)
+    {
+        rejectPacket(scanCtx, IDNSL_REJECT_PORT, "ScanRsp", &remoteAddr, "Invalid sender port %u", remotePort);
+        return 0;
+    }
+
+    // Get info record for address from which the datagram was received
+    RESPONSE_INFO *responseInfo = getResponseInfo(scanCtx, &remoteAddr);
+    if(responseInfo == (RESPONSE_INFO *)0) return -1;
+
+
+    // -------------------------------------------------------------------------
+    //  Check IDN-Hello packet header
+    // -------------------------------------------------------------------------
+
+    if(recvSlot->recvFlags & PLT_RECVFLG_TRUNCATED)
+    {
+        rejectPacket(scanCtx, IDNSL_REJECT_TRUNCATED, "ScanRsp", &remoteAddr, "Truncated packet (exceeds %u)", recvSlot->bufferSize);
+        return 0;
+    }
+
+    if((size_t)nBytes < sizeof(IDNHDR_PACKET))
+    {
+        rejectPacket(scanCtx, IDNSL_REJECT_LENGTH, "ScanRsp", &remoteAddr, "Invalid packet size %u", nBytes);
+        return 0;
+    }
+
+    // Calculate pointers
+    IDNHDR_PACKET *recvPacketHdr = (IDNHDR_PACKET *)recvSlot->bufferPtr;
+    void *payloadPtr = &recvPacketHdr[1];
+    size_t payloadLen = (size_t)nBytes - sizeof(IDNHDR_PACKET);
+
+    // Check packet command
+    if(recvPacketHdr->command != IDNCMD_SCAN_RESPONSE) 
+    {
+        rejectPacket(scanCtx, IDNSL_REJECT_COMMAND, "ScanRsp", &remoteAddr, "Invalid command 0x%02X", recvPacketHdr->command);
+        return 0;
+    }
+
+    // Check sequence number (distinguish broadcast discovery and unicast check). Responses to a
+    // subnet-directed broadcast are received on the check socket (but are scan responses).
+    uint16_t recvSequenceNum = ntohs(recvPacketHdr->sequence);
+    SCAN_TARGET *bcastTarget = (SCAN_TARGET *)0;
+    if(!ifNode && (recvSequenceNum != responseInfo->checkSequenceNum)) bcastTarget = findBroadcastTarget(scanCtx, recvSequenceNum);
+
+    // Multi-group scan: The broadcast sequence numbers of an interface are consecutive (by group)
+    uint8_t clientGroup = scanCtx->clientGroup;
+    uint16_t sequenceNum = ifNode ? ifNode->scanSequenceNum : responseInfo->checkSequenceNum;
+    if(bcastTarget) sequenceNum = bcastTarget->scanSequenceNum;
+    if(ifNode && ((uint16_t)(recvSequenceNum - sequenceNum) < scanCtx->groupCount))
+    {
+        clientGroup = scanCtx->groupTable[(uint16_t)(recvSequenceNum - sequenceNum)];
+        sequenceNum = recvSequenceNum;
+    }
+    if(recvSequenceNum != sequenceNum)
+    {
+        rejectPacket(scanCtx, IDNSL_REJECT_SEQUENCE, "ScanRsp", &remoteAddr, "Invalid sequence %04X %04X", recvSequenceNum, sequenceNum);
+        return 0;
+    }
+
+    // Track the response time to the broadcast (for the adaptive quiet period and the statistics)
+    IDNSL_SCAN_STATS *scanStats = &scanCtx->scanStats;
+    uint32_t usScanTime = scanCtx->usLastActivity - scanCtx->usScanStart;
+    int scanFlag = (ifNode || bcastTarget);
+    if(scanFlag)
+    {
+        // Note: Sampled once per address (follow-up broadcasts are answered again)
+        uint32_t usScanSent = ifNode ? ifNode->usScanSent : bcastTarget->usScanSent;
+        if(!responseInfo->scanSentFlag)
+        {
+            uint32_t usRTT = scanCtx->usLastActivity - usScanSent;
+            if(usRTT > scanCtx->usMaxRTT) scanCtx->usMaxRTT = usRTT;
+            addLatencySample(&scanStats->scanLatency, usRTT);
+
+            responseInfo->usScanSent = usScanSent;
+            responseInfo->scanSentFlag = 1;
+        }
+
+        if(!scanStats->usFirstResponse) scanStats->usFirstResponse = usScanTime;
+        scanStats->usLastResponse = usScanTime;
+    }
+    else
+    {
+        // Latency of the first response to the check (broadcast -> check)
+        if(responseInfo->checkPendingFlag)
+        {
+            scanStats->usLastCheck = usScanTime;
+            if(responseInfo->scanSentFlag) addLatencySample(&scanStats->checkLatency, scanCtx->usLastActivity - responseInfo->usScanSent);
+            responseInfo->checkPendingFlag = 0;
+        }
+
+        // Check response received - no retransmission
+        completeRequest(scanCtx, responseInfo->checkJob);
+    }
+
+
+    // -------------------------------------------------------------------------
+    //  Check scan response header
+    // -------------------------------------------------------------------------
+
+    if(payloadLen < sizeof(IDNHDR_SCAN_RESPONSE))
+    {
+        rejectPacket(scanCtx, IDNSL_REJECT_LENGTH, "ScanRsp", &remoteAddr, "Invalid response length %u", (unsigned)payloadLen);
+        return 0;
+    }
+
+    IDNHDR_SCAN_RESPONSE *scanRspHdr = (IDNHDR_SCAN_RESPONSE *)payloadPtr;
+    if(scanRspHdr->structSize < sizeof(IDNHDR_SCAN_RESPONSE))
+    {
+        rejectPacket(scanCtx, IDNSL_REJECT_STRUCTSIZE, "ScanRsp", &remoteAddr, "Invalid header size %u", scanRspHdr->structSize);
+        return 0;
+    }
+
+    if(payloadLen < scanRspHdr->structSize)
+    {
+        rejectPacket(scanCtx, IDNSL_REJECT_LENGTH, "ScanRsp", &remoteAddr, "Invalid payload length %u %u", (unsigned)payloadLen, scanRspHdr->structSize);
+        return 0;
+    }
+
+    uint8_t unitIDLen = scanRspHdr->unitID[0];
+    if((unitIDLen >= sizeof(scanRspHdr->unitID)) || (unitIDLen >= sizeof(((IDNSL_SERVER_INFO *)0)->unitID)))
+    {
+        rejectPacket(scanCtx, IDNSL_REJECT_CONTENT, "ScanRsp", &remoteAddr, "Invalid unitID length %u", unitIDLen);
+        return 0;
+    }
+
+
+    // -------------------------------------------------------------------------
+    //  Update server info
+    // -------------------------------------------------------------------------
+
+    IDNSL_SERVER_INFO *serverInfo = getServerInfo(scanCtx, scanRspHdr, clientGroup);
+    if(serverInfo == (IDNSL_SERVER_INFO *)0) return -1;
+
+    // Client groups the server responded to (and excludes) in this scan
+    serverInfo->groupMask |= (uint16_t)(1 << clientGroup);
+    if(scanRspHdr->status & IDNFLG_SCAN_STATUS_EXCLUDED) serverInfo->excludedMask |= (uint16_t)(1 << clientGroup);
+
+    // Check for server/responseInfo match
+    int addrIndex;
+    if((responseInfo->serverInfo != (IDNSL_SERVER_INFO *)0) && (responseInfo->serverInfo != serverInfo))
+    {
+        // Pointer mismatch / Different servers on same address - ignore both
+        int addrIndex1 = putAmbiguousAddress(scanCtx, serverInfo, &remoteAddr);
+        if(addrIndex1 < 0) return -1;
+
+        int addrIndex2 = putAmbiguousAddress(scanCtx, responseInfo->serverInfo, &remoteAddr);
+        if(addrIndex2 < 0) return -1;
+        reportServerEvents(scanCtx, serverInfo);
+
+        // Set error for response info record, abort in case there is no (error-free) default address
+        // Note: There is at least one address in the address table!
+        responseInfo->ambiguousErrorFlag = 1;
+        if(serverInfo->addressTable[0].errorFlags != 0) return 0;
+
+        // Find the info record for the default address
+        // Note: Address order may have shifted because erroneous addresses are moved to the end
+        responseInfo = getResponseInfo(scanCtx, &(serverInfo->addressTable[0].netAddr));
+        if(responseInfo == (RESPONSE_INFO *)0) return -1;
+
+        // Check for info retrieval on default address
+        addrIndex = 0;
+    }
+    else
+    {
+        // Check for new server
+        if(responseInfo->serverInfo == (IDNSL_SERVER_INFO *)0)
+        {
+            // Link response address info record with server to find misconfigured servers
+            responseInfo->serverInfo = serverInfo;
+
+            // Requests to the address are paced for the interface the server was found on
+            if(ifNode) responseInfo->requestPacer = &ifNode->requestPacer;
+            else if(bcastTarget) responseInfo->requestPacer = &scanCtx->targetPacer;
+
+            // Schedule reachability check. Note: Since broadcasts are sent on 255.255.255.255 
+            // ('this network'), any device (configured correctly or wrong) can send a response.
+            // Depending on IP-Stack and firewall setup this might be received or not. However,
+            // reception does not mean that the device is reachable (there may be no route).
+            // Addresses checked in a previous scan of the session are not checked again (cached
+            // addresses are). Note: Unicast responses without broadcast are checks (verify scan),
+            // scan target hosts are checked by the target request.
+            int knownIndex = findServerAddress(serverInfo, &remoteAddr);
+            unsigned checkFlags = IDNSL_ADDR_ERRORFLAG_UNREACHABLE | IDNSL_ADDR_ERRORFLAG_UNVERIFIED;
+            int checkFlag = (knownIndex < 0) || (serverInfo->addressTable[knownIndex].errorFlags & checkFlags);
+            if(scanFlag && checkFlag && !responseInfo->targetRequestFlag)
+            {
+                if(scheduleCheckRequest(scanCtx, responseInfo)) return -1;
+            }
+        }
+
+        // Add/Modify address for broadcast(scan/uncertain) or unicast(checked/reachable) reply
+        if(scanFlag) addrIndex = putScannedAddress(scanCtx, serverInfo, &remoteAddr);
+        else addrIndex = putCheckedAddress(scanCtx, serverInfo, &remoteAddr);  
+        if(addrIndex < 0) return -1;
+        reportServerEvents(scanCtx, serverInfo);
+
+        // Measure the latency of reachable addresses (checked now or in a previous scan)
+        int pingFlag = (serverInfo->addressTable[addrIndex].errorFlags == 0) && !responseInfo->pingRequestFlag;
+        if(pingFlag && scanCtx->scanOptions.pingCount)
+        {
+            if(schedulePingRequest(scanCtx, responseInfo)) return -1;
+        }
+    }
+
+    // In case the server got a default address, schedule info requests (if not done yet)
+    // Note: There is at least one address in the address table! Known servers are only
+    // requested in case the server changed (or the service map/parameters were not received yet).
+    SERVER_NODE *serverNode = (SERVER_NODE *)serverInfo;
+    if(serverNode->serviceMapFlag && (serverNode->paramFlag || !scanCtx->scanOptions.paramRequests)) return 0;
+    if((addrIndex == 0) && (serverInfo->addressTable[0].errorFlags == 0) && (responseInfo->infoRequestFlag == 0))
+    {
+        if(scheduleInfoRequests(scanCtx, responseInfo)) return -1;
+        responseInfo->infoRequestFlag = 1;
+    }
+
+    return 0;
+}
+
+
+static int handlePingResponse(SCAN_CONTEXT *scanCtx, PLT_RECV_SLOT *recvSlot)
+{
+    IDNSL_NET_ADDRESS remoteAddr;
+    uint16_t remotePort = getSockAddress(&remoteAddr, &recvSlot->remoteAddr);
+    unsigned nBytes = recvSlot->dataLength;
+
+    // Check sender port
+    if(remotePort != IDNVAL_HELLO_UDP_PORT)
+    {
+        rejectPacket(scanCtx, IDNSL_REJECT_PORT, "PingRsp", &remoteAddr, "Invalid sender port %u", remotePort);
+        return 0;
+    }
+
+    // Check packet size (header and the echoed request payload)
+    if((size_t)nBytes < sizeof(IDNHDR_PACKET) + PING_PAYLOAD_SIZE)
+    {
+        rejectPacket(scanCtx, IDNSL_REJECT_LENGTH, "PingRsp", &remoteAddr, "Invalid packet size %u", nBytes);
+        return 0;
+    }
+
+    // Only the current ping of the address is expected (late duplicates are ignored)
+    IDNHDR_PACKET *recvPacketHdr = (IDNHDR_PACKET *)recvSlot->bufferPtr;
+    RESPONSE_INFO *responseInfo = getResponseInfo(scanCtx, &remoteAddr);
+    if(responseInfo == (RESPONSE_INFO *)0) return -1;
+    if(!responseInfo->pingPendingFlag || (ntohs(recvPacketHdr->sequence) != responseInfo->pingSequenceNum))
+    {
+        rejectPacket(scanCtx, IDNSL_REJECT_SEQUENCE, "PingRsp", &remoteAddr, "Invalid sequence %04X %04X", ntohs(recvPacketHdr->sequence), responseInfo->pingSequenceNum);
+        return 0;
+    }
+    responseInfo->pingPendingFlag = 0;
+    completeRequest(scanCtx, responseInfo->pingJob);
+
+    // Round trip time from the echoed send time
+    uint32_t usSent;
+    memcpy(&usSent, &recvPacketHdr[1], sizeof(usSent));
+    uint32_t usRTT = scanCtx->usLastActivity - ntohl(usSent);
+    if((int32_t)usRTT < 0) usRTT = 0;
+
+    if(responseInfo->rttSampleCount)
+    {
+        uint32_t usDiff = (usRTT > responseInfo->usRTTLast) ? (usRTT - responseInfo->usRTTLast) : (responseInfo->usRTTLast - usRTT);
+        responseInfo->usJitterSum += usDiff;
+    }
+    responseInfo->rttSampleCount++;
+    responseInfo->usRTTSum += usRTT;
+    responseInfo->usRTTLast = usRTT;
+
+    // Update the address statistics (replaced by the measurement of this scan), keep the order
+    IDNSL_SERVER_INFO *serverInfo = responseInfo->serverInfo;
+    int addrIndex = serverInfo ? findServerAddress(serverInfo, &remoteAddr) : -1;
+    if(addrIndex >= 0)
+    {
+        IDNSL_SERVER_ADDRESS *serverAddr = &serverInfo->addressTable[addrIndex];
+        unsigned sampleCount = responseInfo->rttSampleCount;
+        if((sampleCount == 1) || (usRTT < serverAddr->usRTTMin)) serverAddr->usRTTMin = usRTT;
+        serverAddr->rttSampleCount = sampleCount;
+        serverAddr->usRTTAvg = responseInfo->usRTTSum / sampleCount;
+        serverAddr->usRTTJitter = (sampleCount > 1) ? responseInfo->usJitterSum / (sampleCount - 1) : 0;
+
+        rankServerAddress(serverInfo, addrIndex);
+    }
+
+    // Next ping
+    if(responseInfo->rttSampleCount < scanCtx->scanOptions.pingCount)
+    {
+        if(schedulePingRequest(scanCtx, responseInfo)) return -1;
+    }
+
+    return 0;
+}
+
+
+static int matchInterfaceAddress(const void *entryPtr, const void *keyPtr)
+{
+    return matchNetAddress(&((const INTERFACE_NODE *)entryPtr)->ifAddr, (const IDNSL_NET_ADDRESS *)keyPtr);
+}
+
+
+static INTERFACE_NODE *findSharedInterface(SCAN_CONTEXT *scanCtx, PLT_RECV_SLOT *recvSlot)
+{
+    // Shared socket: The interface the response was sent to (its address is the destination)
+    IDNSL_NET_ADDRESS localAddr;
+    setIP4Address(&localAddr, (uint32_t)recvSlot->localAddr.s_addr);
+
+    INTERFACE_NODE *ifNode = (INTERFACE_NODE *)findHashEntry(&scanCtx->ifAddrIndex, hashAddress(&localAddr), matchInterfaceAddress, &localAddr);
+    if(ifNode == (INTERFACE_NODE *)0)
+    {
+        IDNSL_NET_ADDRESS remoteAddr;
+        getSockAddress(&remoteAddr, &recvSlot->remoteAddr);
+
+        char strLocalAddr[NET_ADDR_STRLEN];
+        if(formatNetAddress(&localAddr, strLocalAddr, sizeof(strLocalAddr))) strcpy(strLocalAddr, "?");
+        rejectPacket(scanCtx, IDNSL_REJECT_INTERFACE, "ScanRsp", &remoteAddr, "No interface %s", strLocalAddr);
+    }
+
+    return ifNode;
+}
+
+
+static int recvScanResponse(SCAN_CONTEXT *scanCtx, EVENT_SOURCE *eventSource)
+{
+    // Interface socket, shared broadcast socket or reachability check socket
+    PACKET_RING *packetRing = &scanCtx->scanRing;
+    INTERFACE_NODE *ifNode = (INTERFACE_NODE *)0;
+    int fdSocket = scanCtx->checkRequestQueue.fdSocket;
+    if(eventSource->sourceType == EVSRC_INTERFACE)
+    {
+        ifNode = (INTERFACE_NODE *)eventSource->sourceRecord;
+        fdSocket = ifNode->fdSocket;
+    }
+    else if(eventSource->sourceType == EVSRC_SHARED_SOCKET)
+    {
+        fdSocket = scanCtx->fdShared;
+    }
+
+    // Drain the socket in batches, then process all datagrams of the batch
+    for(unsigned batchCount = 0; batchCount < RECV_BATCH_LIMIT; batchCount++)
+    {
+        int slotCount = recvDatagrams(scanCtx, eventSource, fdSocket, packetRing);
+        if(slotCount < 0)
+        {
+            logError("recvBatch() failed (error: %d)", plt_sockGetLastError());
+            return -1;
+        }
+
+        if(slotCount > 0) scanCtx->usLastActivity = plt_getMonoTimeUS();
+        if(eventSource->sourceType == EVSRC_SHARED_SOCKET)
+        {
+            // Shared socket: The drops can't be assigned, all interfaces of the socket follow up
+            if(countDrops(scanCtx, &scanCtx->sharedDropCounter, packetRing->slotTable, slotCount))
+            {
+                unsigned burstCount = scanCtx->scanStats.packetsDropped + (unsigned)slotCount;
+                for(INTERFACE_NODE *sharedNode = scanCtx->firstIfNode; sharedNode; sharedNode = sharedNode->next)
+                {
+                    if(sharedNode->fdSocket < 0) burstCount += sharedNode->ifStats.packetsReceived;
+                }
+                if(sizeRecvBuffers(scanCtx, burstCount)) return -1;
+
+                for(INTERFACE_NODE *sharedNode = scanCtx->firstIfNode; sharedNode; sharedNode = sharedNode->next)
+                {
+                    if(sharedNode->fdSocket < 0) scheduleFollowUp(scanCtx, sharedNode, scanCtx->usLastActivity);
+                }
+            }
+        }
+        else if(ifNode)
+        {
+            ifNode->ifStats.packetsReceived += (unsigned)slotCount;
+            uint32_t dropCount = countDrops(scanCtx, &ifNode->dropCounter, packetRing->slotTable, slotCount);
+            ifNode->ifStats.packetsDropped += dropCount;
+            if(dropCount)
+            {
+                // Grow the buffers for the burst seen (the follow-up is answered by all servers again)
+                if(sizeRecvBuffers(scanCtx, ifNode->ifStats.packetsReceived + ifNode->ifStats.packetsDropped)) return -1;
+                scheduleFollowUp(scanCtx, ifNode, scanCtx->usLastActivity);
+            }
+        }
+        else
+        {
+            REQUEST_QUEUE *checkQueue = &scanCtx->checkRequestQueue;
+            checkQueue->queueStats->packetsReceived += (unsigned)slotCount;
+            checkQueue->queueStats->packetsDropped += countDrops(scanCtx, &checkQueue->dropCounter, packetRing->slotTable, slotCount);
+        }
+        for(int i = 0; i < slotCount; i++)
+        {
+            // Shared socket: Responses are counted by the interface they were sent to
+            PLT_RECV_SLOT *recvSlot = &packetRing->slotTable[i];
+            INTERFACE_NODE *respIfNode = ifNode;
+            if(eventSource->sourceType == EVSRC_SHARED_SOCKET)
+            {
+                respIfNode = findSharedInterface(scanCtx, recvSlot);
+                if(respIfNode == (INTERFACE_NODE *)0) continue;
+
+                respIfNode->ifStats.packetsReceived++;
+            }
+
+            // Ping responses are received on the check socket
+            IDNHDR_PACKET *recvPacketHdr = (IDNHDR_PACKET *)recvSlot->bufferPtr;
+            int pingFlag = !respIfNode && (recvSlot->dataLength >= sizeof(IDNHDR_PACKET)) && (recvPacketHdr->command == IDNCMD_PING_RESPONSE);
+
+            int rcHandle = pingFlag ? handlePingResponse(scanCtx, recvSlot) : handleScanResponse(scanCtx, respIfNode, recvSlot);
+            if(rcHandle) return -1;
+        }
+
+        // Socket drained in case the batch was not filled
+        if((unsigned)slotCount < packetRing->slotCount) break;
+    }
+
+    return 0;
+}
+
+
+// -------------------------------------------------------------------------------------------------
+//  Server table (kept across the scans of a session)
+// -------------------------------------------------------------------------------------------------
+
+static void sortServerAddresses(IDNSL_SERVER_INFO *serverInfo)
+{
+    // Restore address order (reachable first, erroneous last) - keep the order within both groups
+    for(unsigned i = 1; i < serverInfo->addressCount; i++)
+    {
+        if(serverInfo->addressTable[i].errorFlags != 0) continue;
+
+        for(unsigned addrIndex = i; addrIndex > 0; addrIndex--)
+        {
+            if(serverInfo->addressTable[addrIndex - 1].errorFlags == 0) break;
+            swapServerAddress(serverInfo, addrIndex - 1, addrIndex);
+        }
+    }
+}
+
+
+static void deleteServerNode(SERVER_NODE *serverNode)
+{
+    free(serverNode->serverInfo.addressTable);
+    free(serverNode->serverInfo.serviceTable);
+    free(serverNode->serverInfo.relayTable);
+    free((void *)serverNode->serverInfo.serviceMap);
+    freeParamTable(&serverNode->serverInfo);
+    free(serverNode->addressScanTable);
+    free(serverNode);
+}
+
+
+static void freeServerTable(SCAN_CONTEXT *scanCtx)
+{
+    while(scanCtx->firstServerInfo)
+    {
+        SERVER_NODE *serverNode = (SERVER_NODE *)scanCtx->firstServerInfo;
+        scanCtx->firstServerInfo = serverNode->serverInfo.next;
+        deleteServerNode(serverNode);
+    }
+
+    scanCtx->lastServerInfo = (IDNSL_SERVER_INFO *)0;
+    freeHashIndex(&scanCtx->serverIndex);
+}
+
+
+static void beginScan(SCAN_CONTEXT *scanCtx)
+{
+    // Release the scratch memory of the previous scan (response info records, request jobs)
+    arenaReset(&scanCtx->scanArena);
+    scanCtx->firstResponseInfo = scanCtx->lastResponseInfo = (RESPONSE_INFO *)0;
+    initHashIndex(&scanCtx->responseIndex, &scanCtx->scanArena);
+    scanCtx->checkRequestQueue.firstRequest = scanCtx->checkRequestQueue.lastRequest = (REQUEST_JOB *)0;
+    scanCtx->infoRequestQueue.firstRequest = scanCtx->infoRequestQueue.lastRequest = (REQUEST_JOB *)0;
+    scanCtx->checkRequestQueue.queuedCount = scanCtx->infoRequestQueue.queuedCount = 0;
+    initTimerWheel(&scanCtx->retryWheel, plt_getMonoTimeNS() / 1000);
+
+    // Statistics of this scan (the statistics of the last scan are kept until it is complete)
+    memset(&scanCtx->scanStats, 0, sizeof(scanCtx->scanStats));
+    for(INTERFACE_NODE *ifNode = scanCtx->firstIfNode; ifNode; ifNode = ifNode->next)
+    {
+        memset(&ifNode->ifStats, 0, sizeof(ifNode->ifStats));
+        ifNode->groupSentCount = 0;
+        ifNode->bcastDueFlag = 0;
+        ifNode->followUpFlag = 0;
+        ifNode->followUpCount = 0;
+    }
+
+    // Next scan number (addresses and servers are marked with the scan they responded in)
+    scanCtx->scanCount++;
+
+    // The quiet period and the retransmission timeout follow the response times of this scan
+    // (an outlier does not stretch the later scans of a session)
+    scanCtx->usMaxRTT = 0;
+
+    // Ambiguous addresses are detected within a scan (all servers on the address respond again),
+    // as are the client groups of a server
+    for(IDNSL_SERVER_INFO *serverInfo = scanCtx->firstServerInfo; serverInfo; serverInfo = serverInfo->next)
+    {
+        serverInfo->groupMask = serverInfo->excludedMask = 0;
+        for(unsigned i = 0; i < serverInfo->addressCount; i++)
+        {
+            serverInfo->addressTable[i].errorFlags &= ~IDNSL_ADDR_ERRORFLAG_AMBIGUOUS;
+        }
+        sortServerAddresses(serverInfo);
+    }
+
+    // Recording: The state a replay of the scan starts with
+    if(scanCtx->traceRecordFlag) traceScanBegin(scanCtx);
+}
+
+
+static void closeScanStats(SCAN_CONTEXT *scanCtx)
+{
+    // Scan complete: Add duration and interface counters, keep as the statistics of the last scan
+    IDNSL_SCAN_STATS *scanStats = &scanCtx->scanStats;
+    closeInfoRequests(scanCtx);
+    scanStats->usDuration = plt_getMonoTimeUS() - scanCtx->usScanStart;
+    if(scanCtx->traceRecordFlag) traceScanEnd(scanCtx);
+
+    scanStats->ifCount = 0;
+    for(INTERFACE_NODE *ifNode = scanCtx->firstIfNode; ifNode; ifNode = ifNode->next, scanStats->ifCount++)
+    {
+        ifNode->lastYield = ifNode->ifStats.packetsReceived;
+        if(scanStats->ifCount >= IDNSL_STATS_IF_LIMIT) continue;
+
+        IDNSL_IF_STATS *ifStats = &scanStats->ifStats[scanStats->ifCount];
+        *ifStats = ifNode->ifStats;
+        snprintf(ifStats->ifName, sizeof(ifStats->ifName), "%s", ifNode->ifName);
+        ifStats->ifAddr = ifNode->ifAddr;
+    }
+
+    if(scanStats->logSuppressCount) logError("%u rejected datagrams not logged (rate limit)", scanStats->logSuppressCount);
+    scanCtx->lastScanStats = *scanStats;
+}
+
+
+static void updateServerTable(SCAN_CONTEXT *scanCtx)
+{
+    unsigned missedScanLimit = scanCtx->scanOptions.missedScanLimit;
+    if(missedScanLimit == 0) missedScanLimit = 1;
+    uint64_t scanTime = (uint64_t)time((time_t *)0);
+
+    IDNSL_SERVER_INFO **nextLink = &scanCtx->firstServerInfo;
+    scanCtx->lastServerInfo = (IDNSL_SERVER_INFO *)0;
+    while(*nextLink)
+    {
+        SERVER_NODE *serverNode = (SERVER_NODE *)*nextLink;
+        IDNSL_SERVER_INFO *serverInfo = &serverNode->serverInfo;
+
+        if(serverNode->seenScanCount == scanCtx->scanCount)
+        {
+            // Server responded: Remove addresses without response in this scan (keep order)
+            unsigned keepCount = 0;
+            for(unsigned i = 0; i < serverInfo->addressCount; i++)
+            {
+                if(serverNode->addressScanTable[i] != scanCtx->scanCount) continue;
+
+                serverInfo->addressTable[keepCount] = serverInfo->addressTable[i];
+                serverNode->addressScanTable[keepCount] = serverNode->addressScanTable[i];
+                keepCount++;
+            }
+            serverInfo->addressCount = keepCount;
+            serverNode->missedScanCount = 0;
+            serverNode->lastSeenTime = scanTime;
+        }
+        else if(++serverNode->missedScanCount >= missedScanLimit)
+        {
+            // Server lost: Report and remove from table
+            *nextLink = serverInfo->next;
+            if(serverNode->foundFlag) notifyServer(scanCtx, scanCtx->callbacks.onServerLost, serverInfo);
+            removeHashEntry(&scanCtx->serverIndex, hashUnitID(serverInfo->unitID), serverNode);
+            deleteServerNode(serverNode);
+            continue;
+        }
+
+        scanCtx->lastServerInfo = serverInfo;
+        nextLink = &serverInfo->next;
+    }
+}
+
+
+// -------------------------------------------------------------------------------------------------
+//  Result list
+// -------------------------------------------------------------------------------------------------
+
+static IDNSL_SERVER_INFO *packServerList(IDNSL_SERVER_INFO *firstServerInfo)
+{
+    // Determine the total size. The server records are stored as an array at the start of the
+    // block (the list head is the block address), followed by the tables of all servers.
+    unsigned serverCount = 0;
+    size_t tableSize = 0;
+    for(IDNSL_SERVER_INFO *serverInfo = firstServerInfo; serverInfo; serverInfo = serverInfo->next)
+    {
+        serverCount++;
+        tableSize += ALIGN_SIZE(serverInfo->addressCount * sizeof(IDNSL_SERVER_ADDRESS), ARENA_ALIGN);
+        if(serverInfo->serviceTable) tableSize += ALIGN_SIZE(serverInfo->serviceCount * sizeof(IDNSL_SERVICE_INFO), ARENA_ALIGN);
+        if(serverInfo->relayTable) tableSize += ALIGN_SIZE(serverInfo->relayCount * sizeof(IDNSL_RELAY_INFO), ARENA_ALIGN);
+        if(serverInfo->serviceMap) tableSize += ALIGN_SIZE(serverInfo->serviceMap->mapSize, ARENA_ALIGN);
+        tableSize += ALIGN_SIZE(serverInfo->paramCount * sizeof(IDNSL_PARAMETER_INFO), ARENA_ALIGN);
+        for(unsigned i = 0; i < serverInfo->paramCount; i++) tableSize += ALIGN_SIZE(serverInfo->paramTable[i].dataLength, ARENA_ALIGN);
+    }
+    if(serverCount == 0) return (IDNSL_SERVER_INFO *)0;
+
+    size_t serverSize = ALIGN_SIZE(serverCount * sizeof(IDNSL_SERVER_INFO), ARENA_ALIGN);
+    uint8_t *blockPtr = (uint8_t *)malloc(serverSize + tableSize);
+    if(blockPtr == (uint8_t *)0)
+    {
+        logError("malloc(IDNSL_SERVER_INFO) failed");
+        return (IDNSL_SERVER_INFO *)0;
+    }
+
+    // Copy records and tables, relocate all pointers into the block
+    IDNSL_SERVER_INFO *serverTable = (IDNSL_SERVER_INFO *)blockPtr;
+    uint8_t *tablePtr = &blockPtr[serverSize];
+    unsigned serverIndex = 0;
+    for(IDNSL_SERVER_INFO *srcInfo = firstServerInfo; srcInfo; srcInfo = srcInfo->next, serverIndex++)
+    {
+        IDNSL_SERVER_INFO *dstInfo = &serverTable[serverIndex];
+        *dstInfo = *srcInfo;
+        dstInfo->next = (serverIndex + 1 < serverCount) ? &serverTable[serverIndex + 1] : (IDNSL_SERVER_INFO *)0;
+
+        // Address table
+        size_t addrSize = srcInfo->addressCount * sizeof(IDNSL_SERVER_ADDRESS);
+        dstInfo->addressTable = srcInfo->addressCount ? (IDNSL_SERVER_ADDRESS *)tablePtr : (IDNSL_SERVER_ADDRESS *)0;
+        if(addrSize) memcpy(tablePtr, srcInfo->addressTable, addrSize);
+        tablePtr += ALIGN_SIZE(addrSize, ARENA_ALIGN);
+
+        // Relay table (before services, services refer to relays). Note: No tables for lazy service maps
+        size_t relaySize = srcInfo->relayTable ? srcInfo->relayCount * sizeof(IDNSL_RELAY_INFO) : 0;
+        dstInfo->relayTable = relaySize ? (IDNSL_RELAY_INFO *)tablePtr : (IDNSL_RELAY_INFO *)0;
+        if(relaySize) memcpy(tablePtr, srcInfo->relayTable, relaySize);
+        tablePtr += ALIGN_SIZE(relaySize, ARENA_ALIGN);
+
+        // Service table
+        size_t serviceSize = srcInfo->serviceTable ? srcInfo->serviceCount * sizeof(IDNSL_SERVICE_INFO) : 0;
+        dstInfo->serviceTable = serviceSize ? (IDNSL_SERVICE_INFO *)tablePtr : (IDNSL_SERVICE_INFO *)0;
+        if(serviceSize) memcpy(tablePtr, srcInfo->serviceTable, serviceSize);
+        tablePtr += ALIGN_SIZE(serviceSize, ARENA_ALIGN);
+
+        // Raw service map (position-independent)
+        if(srcInfo->serviceMap)
+        {
+            dstInfo->serviceMap = (IDNSL_SERVICE_MAP *)tablePtr;
+            memcpy(tablePtr, srcInfo->serviceMap, srcInfo->serviceMap->mapSize);
+            tablePtr += ALIGN_SIZE(srcInfo->serviceMap->mapSize, ARENA_ALIGN);
+        }
+
+        // Parameter table, followed by the response payloads
+        size_t paramSize = srcInfo->paramCount * sizeof(IDNSL_PARAMETER_INFO);
+        dstInfo->paramTable = paramSize ? (IDNSL_PARAMETER_INFO *)tablePtr : (IDNSL_PARAMETER_INFO *)0;
+        if(paramSize) memcpy(tablePtr, srcInfo->paramTable, paramSize);
+        tablePtr += ALIGN_SIZE(paramSize, ARENA_ALIGN);
+
+        for(unsigned i = 0; i < dstInfo->paramCount; i++)
+        {
+            IDNSL_PARAMETER_INFO *paramEntry = &dstInfo->paramTable[i];
+            if(paramEntry->dataPtr == (const uint8_t *)0) continue;
+
+            memcpy(tablePtr, paramEntry->dataPtr, paramEntry->dataLength);
+            paramEntry->dataPtr = tablePtr;
+            tablePtr += ALIGN_SIZE(paramEntry->dataLength, ARENA_ALIGN);
+        }
+
+        // Relocate relay/service references (same index in the copied tables)
+        for(unsigned i = 0; dstInfo->relayTable && (i < dstInfo->relayCount); i++)
+        {
+            IDNSL_RELAY_INFO *relayEntry = &dstInfo->relayTable[i];
+            if(relayEntry->firstRelayService == (IDNSL_SERVICE_INFO *)0) continue;
+            relayEntry->firstRelayService = &dstInfo->serviceTable[relayEntry->firstRelayService - srcInfo->serviceTable];
+        }
+
+        for(unsigned i = 0; dstInfo->serviceTable && (i < dstInfo->serviceCount); i++)
+        {
+            IDNSL_SERVICE_INFO *serviceEntry = &dstInfo->serviceTable[i];
+            if(serviceEntry->parentRelay)
+            {
+                serviceEntry->parentRelay = &dstInfo->relayTable[serviceEntry->parentRelay - srcInfo->relayTable];
+            }
+            if(serviceEntry->nextRelayService)
+            {
+                serviceEntry->nextRelayService = &dstInfo->serviceTable[serviceEntry->nextRelayService - srcInfo->serviceTable];
+            }
+        }
+    }
+
+    return serverTable;
+}
+
+
+static int setEventInterest(SCAN_CONTEXT *scanCtx, EVENT_SOURCE *eventSource, int fdSocket, unsigned evFlags)
+{
+    // Avoid system calls in case the interest did not change. Replay: Virtual sockets (not registered)
+    if(eventSource->evFlags == evFlags) return 0;
+    if(scanCtx->traceReplayFlag) { eventSource->evFlags = evFlags; return 0; }
+
+    if(plt_eventLoopModify(&scanCtx->eventLoop, fdSocket, evFlags, eventSource) < 0)
+    {
+        logError("eventLoopModify() failed (error: %d)", plt_sockGetLastError());
+        return -1;
+    }
+
+    eventSource->evFlags = evFlags;
+    return 0;
+}
+
+
+static int addEventSource(SCAN_CONTEXT *scanCtx, EVENT_SOURCE *eventSource, int fdSocket, unsigned sourceType, void *sourceRecord, unsigned evFlags)
+{
+    eventSource->sourceType = sourceType;
+    eventSource->sourceRecord = sourceRecord;
+    eventSource->evFlags = evFlags;
+
+    if(plt_eventLoopAdd(&scanCtx->eventLoop, fdSocket, evFlags, eventSource) < 0)
+    {
+        logError("eventLoopAdd() failed (error: %d)", plt_sockGetLastError());
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int updateQueueInterest(SCAN_CONTEXT *scanCtx, REQUEST_QUEUE *requestQueue, uint32_t *usWait)
+{
+    uint64_t nsNow = plt_getMonoTimeNS();
+
+    // Write interest only in case of pending requests that may be sent now. Otherwise
+    // shorten the wait time to the next token of a pending request.
+    unsigned evFlags = PLT_EVFLG_READ, inspectCount = 0;
+    REQUEST_JOB *reqJob = requestQueue->firstRequest;
+    for(; reqJob && (inspectCount < PACING_LOOKAHEAD); reqJob = reqJob->next, inspectCount++)
+    {
+        refillTokenBucket(reqJob->requestPacer, nsNow);
+        uint32_t usDelay = getTokenDelay(reqJob->requestPacer);
+        if(usDelay == 0) { evFlags |= PLT_EVFLG_WRITE; break; }
+        if(usDelay < *usWait) *usWait = usDelay;
+    }
+
+    return setEventInterest(scanCtx, &requestQueue->eventSource, requestQueue->fdSocket, evFlags);
+}
+
+
+static int interfaceEvent(SCAN_CONTEXT *scanCtx, INTERFACE_NODE *ifNode, unsigned evFlags)
+{
+    // Writable broadcast/discovery socket: Send the scan request (once)
+    if(evFlags & PLT_EVFLG_WRITE)
+    {
+        int rcSend = sendBroadcastRequest(scanCtx, ifNode);
+        if(rcSend < 0) return -1;
+        if(rcSend == 0 && setEventInterest(scanCtx, &ifNode->eventSource, ifNode->fdSocket, PLT_EVFLG_READ)) return -1;
+    }
+
+    // Readable broadcast/discovery socket: Receive scan responses
+    if(evFlags & PLT_EVFLG_READ)
+    {
+        if(recvScanResponse(scanCtx, &ifNode->eventSource)) return -1;
+    }
+
+    return 0;
+}
+
+
+static int sharedSocketEvent(SCAN_CONTEXT *scanCtx, unsigned evFlags)
+{
+    // Writable shared socket: Send the scan requests of all interfaces (once)
+    if(evFlags & PLT_EVFLG_WRITE)
+    {
+        int rcSend = 0;
+        for(INTERFACE_NODE *ifNode = scanCtx->firstIfNode; ifNode && (rcSend == 0); ifNode = ifNode->next)
+        {
+            if(!ifNode->sendPendingFlag) continue;
+
+            rcSend = sendBroadcastRequest(scanCtx, ifNode);
+            if(rcSend < 0) return -1;
+            if(rcSend == 0) ifNode->sendPendingFlag = 0;
+        }
+
+        if(rcSend == 0 && setEventInterest(scanCtx, &scanCtx->sharedSource, scanCtx->fdShared, PLT_EVFLG_READ)) return -1;
+    }
+
+    // Readable shared socket: Receive the scan responses of all interfaces
+    if(evFlags & PLT_EVFLG_READ)
+    {
+        if(recvScanResponse(scanCtx, &scanCtx->sharedSource)) return -1;
+    }
+
+    return 0;
+}
+
+
+static int requestQueueEvent(SCAN_CONTEXT *scanCtx, REQUEST_QUEUE *requestQueue, unsigned evFlags)
+{
+    // Writable unicast socket: Send pending requests
+    if(evFlags & PLT_EVFLG_WRITE)
+    {
+        if(sendRequests(scanCtx, requestQueue)) return -1;
+        scanCtx->usLastActivity = plt_getMonoTimeUS();
+    }
+
+    // Readable unicast socket: Receive check responses or info responses
+    if(evFlags & PLT_EVFLG_READ)
+    {
+        if(requestQueue == &scanCtx->checkRequestQueue)
+        {
+            if(recvScanResponse(scanCtx, &requestQueue->eventSource)) return -1;
+        }
+        else
+        {
+            if(recvInfoResponse(scanCtx)) return -1;
+        }
+    }
+
+    return 0;
+}
+
+
+static uint32_t getQuietTime(SCAN_CONTEXT *scanCtx, uint32_t usNow)
+{
+    // Adaptive completion: Time (in microseconds) until the scan is complete, 0 in case of
+    // completion, UINT32_MAX in case of pending requests (or disabled).
+    IDNSL_SCAN_OPTIONS *scanOptions = &scanCtx->scanOptions;
+    if(scanOptions->quietRTTFactor == 0) return UINT32_MAX;
+
+    // All broadcasts and all queued requests must be sent.
+    if(scanCtx->checkRequestQueue.firstRequest || scanCtx->infoRequestQueue.firstRequest) return UINT32_MAX;
+    if(scanCtx->retryWheel.jobCount) return UINT32_MAX;
+    if(!scanCtx->verifyScanFlag && isSweepPending(scanCtx)) return UINT32_MAX;
+    for(INTERFACE_NODE *ifNode = scanCtx->firstIfNode; ifNode; ifNode = ifNode->next)
+    {
+        if((ifNode->eventSource.evFlags & PLT_EVFLG_WRITE) || ifNode->sendPendingFlag || ifNode->bcastDueFlag) return UINT32_MAX;
+    }
+
+    // Then wait for a quiet period (no datagram sent or received). Note: Check requests without
+    // retransmission are considered failed in case there is no response within the quiet period,
+    // otherwise (and info requests) once the retransmissions are exhausted.
+    uint64_t usQuiet = (uint64_t)scanCtx->usMaxRTT * scanOptions->quietRTTFactor;
+    if(usQuiet < (uint64_t)scanOptions->msQuietMin * 1000) usQuiet = (uint64_t)scanOptions->msQuietMin * 1000;
+    if(usQuiet > QUIET_PERIOD_MAX) usQuiet = QUIET_PERIOD_MAX;
+
+    uint32_t usIdle = usNow - scanCtx->usLastActivity;
+    return (usIdle >= (uint32_t)usQuiet) ? 0 : ((uint32_t)usQuiet - usIdle);
+}
+
+
+static int scheduleBroadcasts(SCAN_CONTEXT *scanCtx, uint32_t usNow)
+{
+    // Staggered broadcasts: The interfaces are ordered by the responses of the last scan (most
+    // first) and get a slot of the window each, jittered within the slot. Check and service map
+    // requests to early responders are sent while later broadcasts are pending.
+    unsigned ifCount = 0;
+    for(INTERFACE_NODE *ifNode = scanCtx->firstIfNode; ifNode; ifNode = ifNode->next) ifCount++;
+    if(ifCount == 0) return 0;
+
+    INTERFACE_NODE **orderTable = (INTERFACE_NODE **)arenaAlloc(&scanCtx->scanArena, ifCount * sizeof(INTERFACE_NODE *));
+    if(orderTable == (INTERFACE_NODE **)0) return -1;
+
+    // Insertion sort (few interfaces, list order kept for equal yields)
+    unsigned orderCount = 0;
+    for(INTERFACE_NODE *ifNode = scanCtx->firstIfNode; ifNode; ifNode = ifNode->next)
+    {
+        unsigned i = orderCount++;
+        for(; (i > 0) && (orderTable[i - 1]->lastYield < ifNode->lastYield); i--) orderTable[i] = orderTable[i - 1];
+        orderTable[i] = ifNode;
+    }
+
+    uint32_t usSlot = (scanCtx->scanOptions.msBroadcastWindow * 1000) / ifCount;
+    for(unsigned i = 0; i < orderCount; i++)
+    {
+        INTERFACE_NODE *ifNode = orderTable[i];
+        ifNode->usBcastDue = usNow + (i * usSlot) + getJitter(scanCtx, usSlot);
+        ifNode->bcastDueFlag = 1;
+    }
+
+    return 0;
+}
+
+
+static int startScan(SCAN_CONTEXT *scanCtx, unsigned msTimeout)
+{
+    // Receive buffers for the expected burst of responses (as found so far in case not given)
+    unsigned serverCount = scanCtx->scanOptions.expectedServers;
+    if(serverCount == 0)
+    {
+        for(IDNSL_SERVER_INFO *serverInfo = scanCtx->firstServerInfo; serverInfo; serverInfo = serverInfo->next) serverCount++;
+    }
+
+    // Multi-group scan: Each server responds once per group
+    if(sizeRecvBuffers(scanCtx, serverCount * scanCtx->groupCount)) return -1;
+    scanCtx->scanStats.recvBufferSize = scanCtx->recvBufferSize;
+
+    // Scan targets: Queue the unicast/directed requests (not in case of a verify scan - the
+    // check requests are queued already)
+    if(!scanCtx->verifyScanFlag && scheduleTargetRequests(scanCtx, msTimeout)) return -1;
+
+    // Interface broadcast sockets writable: Send the scan request (once per scan, not in case of
+    // a verify scan or in case of scan targets only). Staggered: Sent once due (see stepScan)
+    int broadcastFlag = !scanCtx->verifyScanFlag && !scanCtx->scanOptions.noBroadcast;
+    if(broadcastFlag && scanCtx->scanOptions.msBroadcastWindow)
+    {
+        if(scheduleBroadcasts(scanCtx, plt_getMonoTimeUS())) return -1;
+        broadcastFlag = 0;
+    }
+
+    for(INTERFACE_NODE *ifNode = scanCtx->firstIfNode; ifNode && broadcastFlag; ifNode = ifNode->next)
+    {
+        unsigned evFlags = PLT_EVFLG_READ | PLT_EVFLG_WRITE;
+        if(ifNode->fdSocket < 0) ifNode->sendPendingFlag = 1;
+        else if(setEventInterest(scanCtx, &ifNode->eventSource, ifNode->fdSocket, evFlags)) return -1;
+    }
+
+    // Shared socket writable: Send the scan requests of the interfaces without socket
+    if(broadcastFlag && (scanCtx->fdShared >= 0))
+    {
+        unsigned evFlags = PLT_EVFLG_READ | PLT_EVFLG_WRITE;
+        if(setEventInterest(scanCtx, &scanCtx->sharedSource, scanCtx->fdShared, evFlags)) return -1;
+    }
+
+    // Reachability check socket and device info socket: Write interest once requests are pending
+
+    // Remember start time
+    scanCtx->usScanStart = plt_getMonoTimeUS();
+    scanCtx->usScanTimeout = msTimeout * 1000;
+    scanCtx->usLastActivity = scanCtx->usScanStart;
+
+    return 0;
+}
+
+
+static int updateBroadcasts(SCAN_CONTEXT *scanCtx, uint32_t usNow, uint32_t *usWait)
+{
+    // Write interest for scheduled broadcasts (staggered, follow-ups) that are due, shorten the
+    // wait time to the others
+    int sharedFlag = 0;
+    for(INTERFACE_NODE *ifNode = scanCtx->firstIfNode; ifNode; ifNode = ifNode->next)
+    {
+        if(!ifNode->bcastDueFlag) continue;
+
+        int32_t usDue = (int32_t)(ifNode->usBcastDue - usNow);
+        if(usDue > 0)
+        {
+            if((uint32_t)usDue < *usWait) *usWait = (uint32_t)usDue;
+        }
+        else if(ifNode->fdSocket < 0)
+        {
+            ifNode->sendPendingFlag = 1;
+            sharedFlag = 1;
+        }
+        else if(setEventInterest(scanCtx, &ifNode->eventSource, ifNode->fdSocket, PLT_EVFLG_READ | PLT_EVFLG_WRITE))
+        {
+            return -1;
+        }
+    }
+
+    if(sharedFlag) return setEventInterest(scanCtx, &scanCtx->sharedSource, scanCtx->fdShared, PLT_EVFLG_READ | PLT_EVFLG_WRITE);
+    return 0;
+}
+
+
+static int stepScan(SCAN_CONTEXT *scanCtx, uint32_t *usWait)
+{
+    // Note: Returns 1 in case the scan is complete. Otherwise 0 and the time (in microseconds)
+    // until the next timer (timeout, retransmission, pacing, quiet period).
+    REQUEST_QUEUE *checkQueue = &scanCtx->checkRequestQueue, *infoQueue = &scanCtx->infoRequestQueue;
+
+    // Calculate time left
+    uint32_t usNow = plt_getMonoTimeUS();
+    uint32_t usElapsed = usNow - scanCtx->usScanStart;
+    uint32_t usLeft = scanCtx->usScanTimeout - usElapsed;
+    if((int32_t)usLeft <= 0) return 1;
+
+    // Retransmit requests without response (back to the request queue). Note: The timer wheel
+    // runs on the 64-bit time
+    uint64_t usWheelNow = plt_getMonoTimeNS() / 1000;
+    if(expireRequests(scanCtx, usWheelNow)) return -1;
+    *usWait = usLeft;
+    uint32_t usRetry = getTimerDelay(&scanCtx->retryWheel, usWheelNow);
+    if(usRetry < *usWait) *usWait = usRetry;
+
+    // Scheduled broadcasts (staggered, follow-ups on kernel drops) that are due
+    if(updateBroadcasts(scanCtx, usNow, usWait)) return -1;
+
+    // Next addresses of the sweeps (paced)
+    if(feedTargetSweeps(scanCtx, usWait)) return -1;
+
+    // Set socket write interest in case of pending requests, reset if none (or paced)
+    if(updateQueueInterest(scanCtx, checkQueue, usWait)) return -1;
+    if(updateQueueInterest(scanCtx, infoQueue, usWait)) return -1;
+
+    // Verify scan: Done once all checks (and service map requests) are answered or exhausted
+    if(scanCtx->verifyScanFlag && scanCtx->scanOptions.retryLimit && !checkQueue->firstRequest &&
+       !infoQueue->firstRequest && !scanCtx->retryWheel.jobCount) return 1;
+
+    // Adaptive completion: Done in case nothing happened for the quiet period
+    uint32_t usQuiet = getQuietTime(scanCtx, usNow);
+    if(usQuiet == 0) return 1;
+    if(usQuiet < *usWait) *usWait = usQuiet;
+
+    return 0;
+}
+
+
+static int dispatchEvent(SCAN_CONTEXT *scanCtx, EVENT_SOURCE *eventSource, unsigned evFlags)
+{
+    // Dispatch ready sockets directly to their owner
+    if(eventSource->sourceType == EVSRC_INTERFACE)
+    {
+        return interfaceEvent(scanCtx, (INTERFACE_NODE *)eventSource->sourceRecord, evFlags);
+    }
+
+    if(eventSource->sourceType == EVSRC_SHARED_SOCKET)
+    {
+        return sharedSocketEvent(scanCtx, evFlags);
+    }
+
+    return requestQueueEvent(scanCtx, (REQUEST_QUEUE *)eventSource->sourceRecord, evFlags);
+}
+
+
+static EVENT_SOURCE *getReplaySource(SCAN_CONTEXT *scanCtx, const TRACE_RECORD *traceRec)
+{
+    // The socket owner a recorded datagram was received by
+    if(traceRec->traceRole == TRACEROLE_INTERFACE)
+    {
+        const IDNSL_NET_ADDRESS *ifAddr = &traceRec->localAddr;
+        INTERFACE_NODE *ifNode = (INTERFACE_NODE *)findHashEntry(&scanCtx->ifAddrIndex, hashAddress(ifAddr), matchInterfaceAddress, ifAddr);
+        if(ifNode && (ifNode->eventSource.sourceType == EVSRC_INTERFACE)) return &ifNode->eventSource;
+        return (EVENT_SOURCE *)0;
+    }
+
+    if(traceRec->traceRole == TRACEROLE_SHARED) return &scanCtx->sharedSource;
+    if(traceRec->traceRole == TRACEROLE_CHECK) return &scanCtx->checkRequestQueue.eventSource;
+    if(traceRec->traceRole == TRACEROLE_INFO) return &scanCtx->infoRequestQueue.eventSource;
+
+    return (EVENT_SOURCE *)0;
+}
+
+
+static int replaySends(SCAN_CONTEXT *scanCtx)
+{
+    // Virtual sockets are writable at once: Send pending broadcasts and requests
+    for(INTERFACE_NODE *ifNode = scanCtx->firstIfNode; ifNode; ifNode = ifNode->next)
+    {
+        if(!ifNode->sendPendingFlag) continue;
+
+        if(sendBroadcastRequest(scanCtx, ifNode) < 0) return -1;
+        ifNode->sendPendingFlag = 0;
+    }
+
+    REQUEST_QUEUE *checkQueue = &scanCtx->checkRequestQueue, *infoQueue = &scanCtx->infoRequestQueue;
+    if((checkQueue->eventSource.evFlags & PLT_EVFLG_WRITE) && requestQueueEvent(scanCtx, checkQueue, PLT_EVFLG_WRITE)) return -1;
+    if((infoQueue->eventSource.evFlags & PLT_EVFLG_WRITE) && requestQueueEvent(scanCtx, infoQueue, PLT_EVFLG_WRITE)) return -1;
+
+    return 0;
+}
+
+
+static int replayEvents(SCAN_CONTEXT *scanCtx)
+{
+    // Replay of the scan records instead of the event loop: Requests are sent to virtual sockets,
+    // the received datagrams dispatched to their socket owner in the recorded order. Real time:
+    // Each datagram once due (relative to the scan start), the timers of the scan in between.
+    scanCtx->usReplayStart = scanCtx->usScanStart;
+    while(1)
+    {
+        // Advance timers, done in case of timeout or completion
+        uint32_t usWait = 0;
+        int rcStep = stepScan(scanCtx, &usWait);
+        if(rcStep < 0) return -1;
+        if(rcStep > 0) break;
+
+        if(replaySends(scanCtx)) return -1;
+
+        // Done at the end of the scan records (the trace may be cut)
+        const TRACE_RECORD *traceRec = peekTraceRecord(scanCtx);
+        if((traceRec == (const TRACE_RECORD *)0) || (traceRec->recordType == TRACEREC_SCAN)) break;
+
+        uint32_t usNow = plt_getMonoTimeUS();
+        if(!isTraceRecordDue(scanCtx, traceRec, usNow))
+        {
+            uint32_t usDue = (scanCtx->usReplayStart + (traceRec->usTime - scanCtx->usTraceScan)) - usNow;
+            if(usDue < usWait) usWait = usDue;
+            plt_sleepMS((usWait + 999) / 1000);
+            continue;
+        }
+
+        if(traceRec->recordType == TRACEREC_SCAN_END)
+        {
+            skipTraceRecord(scanCtx, traceRec);
+            break;
+        }
+
+        if(traceRec->recordType == TRACEREC_SENT)
+        {
+            // Recorded broadcast: A scheduled broadcast (staggered, follow-up) of the interface is
+            // due now - sequence numbers are taken in the recorded order
+            const IDNSL_NET_ADDRESS *ifAddr = &traceRec->localAddr;
+            if((traceRec->traceRole == TRACEROLE_INTERFACE) || (traceRec->traceRole == TRACEROLE_SHARED))
+            {
+                INTERFACE_NODE *ifNode = (INTERFACE_NODE *)findHashEntry(&scanCtx->ifAddrIndex, hashAddress(ifAddr), matchInterfaceAddress, ifAddr);
+                if(ifNode && ifNode->bcastDueFlag) ifNode->usBcastDue = usNow;
+            }
+
+            skipTraceRecord(scanCtx, traceRec);
+            continue;
+        }
+
+        // Received datagram (and the ones following on the same socket, see recvDatagrams).
+        // Records not taken by the socket owner are skipped (unknown interface, role mismatch)
+        uint32_t traceOffset = scanCtx->traceOffset;
+        EVENT_SOURCE *eventSource = getReplaySource(scanCtx, traceRec);
+        if(eventSource && dispatchEvent(scanCtx, eventSource, PLT_EVFLG_READ)) return -1;
+        if(scanCtx->traceOffset == traceOffset) skipTraceRecord(scanCtx, traceRec);
+    }
+
+    return 0;
+}
+
+
+static int runScan(SCAN_CONTEXT *scanCtx, unsigned msTimeout)
+{
+    if(startScan(scanCtx, msTimeout)) return -1;
+
+    // Replay: The trace instead of the sockets
+    if(scanCtx->traceReplayFlag) return replayEvents(scanCtx);
+
+    // Send requests, receive replies
+    while(1)
+    {
+        // Advance timers, done in case of timeout or completion
+        uint32_t usWait = 0;
+        int rcStep = stepScan(scanCtx, &usWait);
+        if(rcStep < 0) return -1;
+        if(rcStep > 0) break;
+
+        // Wait for writability and readability on sockets. On timeout, loop and check time left
+        PLT_EVENT eventTable[EVENT_TABLE_SIZE];
+        int numReady = plt_eventLoopWait(&scanCtx->eventLoop, eventTable, EVENT_TABLE_SIZE, usWait);
+        if(numReady < 0)
+        {
+            logError("eventLoopWait() failed (error: %d)", plt_sockGetLastError());
+            return -1;
+        }
+
+        for(int i = 0; i < numReady; i++)
+        {
+            EVENT_SOURCE *eventSource = (EVENT_SOURCE *)eventTable[i].userData;
+            unsigned evFlags = eventTable[i].evFlags & eventSource->evFlags;
+
+            // Note: Errors (ICMP unreachable, ...) are reported with the next receive
+            if(eventTable[i].evFlags & PLT_EVFLG_ERROR) evFlags |= PLT_EVFLG_READ;
+
+            if(dispatchEvent(scanCtx, eventSource, evFlags)) return -1;
+        }
+    }
+
+    return 0;
+}
+
+
+// -------------------------------------------------------------------------------------------------
+//  Async scan (external event loop)
+// -------------------------------------------------------------------------------------------------
+
+static EVENT_SOURCE *findEventSource(SCAN_CONTEXT *scanCtx, int fdSocket)
+{
+    for(INTERFACE_NODE *ifNode = scanCtx->firstIfNode; ifNode; ifNode = ifNode->next)
+    {
+        if((ifNode->fdSocket >= 0) && (ifNode->fdSocket == fdSocket)) return &ifNode->eventSource;
+    }
+
+    if(scanCtx->checkRequestQueue.fdSocket == fdSocket) return &scanCtx->checkRequestQueue.eventSource;
+    if(scanCtx->infoRequestQueue.fdSocket == fdSocket) return &scanCtx->infoRequestQueue.eventSource;
+    if((scanCtx->fdShared >= 0) && (scanCtx->fdShared == fdSocket)) return &scanCtx->sharedSource;
+
+    return (EVENT_SOURCE *)0;
+}
+
+
+static void putPollFD(IDNSL_POLL_FD *fdTable, unsigned fdLimit, unsigned *fdCount, int fdSocket, unsigned evFlags)
+{
+    // Note: All sockets are counted, the table takes the first fdLimit sockets
+    if(*fdCount < fdLimit)
+    {
+        IDNSL_POLL_FD *pollFD = &fdTable[*fdCount];
+        pollFD->fdSocket = fdSocket;
+        pollFD->evFlags = 0;
+        if(evFlags & PLT_EVFLG_READ) pollFD->evFlags |= IDNSL_POLL_READ;
+        if(evFlags & PLT_EVFLG_WRITE) pollFD->evFlags |= IDNSL_POLL_WRITE;
+    }
+
+    (*fdCount)++;
+}
+
+
+static int handleAsyncEvent(SCAN_CONTEXT *scanCtx, int fdSocket, unsigned evFlags)
+{
+    // Late events (scan complete, result not polled yet) are ignored
+    if(scanCtx->scanState == SCANSTATE_DONE) return 0;
+    if(scanCtx->scanState != SCANSTATE_ASYNC) return -1;
+
+    EVENT_SOURCE *eventSource = findEventSource(scanCtx, fdSocket);
+    if(eventSource == (EVENT_SOURCE *)0) return -1;
+
+    // Spurious write events (interest reset in the meantime) are ignored
+    evFlags &= eventSource->evFlags;
+    if(evFlags == 0) return 0;
+
+    // In case of an error: The scan is aborted
+    if(dispatchEvent(scanCtx, eventSource, evFlags))
+    {
+        scanCtx->scanState = SCANSTATE_IDLE;
+        return -1;
+    }
+
+    return 0;
+}
+
+
+// -------------------------------------------------------------------------------------------------
+//  Scan contexts and parallel scan workers
+// -------------------------------------------------------------------------------------------------
+
+static SCAN_CONTEXT *createScanContext(const IDNSL_SCAN_OPTIONS *scanOptions, const IDNSL_SESSION_CALLBACKS *callbacks)
+{
+    // Allocate a context to keep variables for the session. Note: Contains receive packet buffers.
+    // Scratch memory of a scan is taken from the scan arena.
+    SCAN_CONTEXT *scanCtx = (SCAN_CONTEXT *)calloc(1, sizeof(SCAN_CONTEXT));
+    if(scanCtx == (SCAN_CONTEXT *)0)
+    {
+        logError("calloc(SCAN_CONTEXT) failed");
+        return (SCAN_CONTEXT *)0;
+    }
+
+    // Populate context
+    scanCtx->scanOptions = *scanOptions;
+    if(callbacks) scanCtx->callbacks = *callbacks;
+    scanCtx->clientGroup = scanOptions->clientGroup;
+    scanCtx->groupTable[scanCtx->groupCount++] = scanOptions->clientGroup;
+    for(uint8_t group = 0; group < 16; group++)
+    {
+        if((scanOptions->groupMask & (1 << group)) && (group != scanOptions->clientGroup)) scanCtx->groupTable[scanCtx->groupCount++] = group;
+    }
+    initTokenBucket(&scanCtx->defaultPacer, scanOptions->requestRate, scanOptions->requestBurst, plt_getMonoTimeNS());
+    initTokenBucket(&scanCtx->targetPacer, scanOptions->targetRate, scanOptions->requestBurst, plt_getMonoTimeNS());
+    initTokenBucket(&scanCtx->logPacer, IDNSL_PACKET_LOG_RATE, IDNSL_PACKET_LOG_RATE, plt_getMonoTimeNS());
+    scanCtx->checkRequestQueue.fdSocket = -1;
+    scanCtx->checkRequestQueue.queueStats = &scanCtx->scanStats.checkQueue;
+    scanCtx->infoRequestQueue.fdSocket = -1;
+    scanCtx->infoRequestQueue.queueStats = &scanCtx->scanStats.infoQueue;
+    scanCtx->fdShared = -1;
+    initPacketRing(&scanCtx->scanRing, &scanCtx->scanSlotBuffer[0][0], SCAN_SLOT_SIZE, SCAN_SLOT_COUNT);
+    initPacketRing(&scanCtx->infoRing, &scanCtx->infoSlotBuffer[0][0], INFO_SLOT_SIZE, INFO_SLOT_COUNT);
+    initHashIndex(&scanCtx->responseIndex, &scanCtx->scanArena);
+    initHashIndex(&scanCtx->serverIndex, (MEM_ARENA *)0);
+    initHashIndex(&scanCtx->ifAddrIndex, (MEM_ARENA *)0);
+    initTimerWheel(&scanCtx->retryWheel, plt_getMonoTimeNS() / 1000);
+    scanCtx->randomState = plt_getMonoTimeUS() | 1;
+
+    // Get a start sequence number. Note: The target list is parsed once the sockets are open
+    scanCtx->sequenceNum = (uint16_t)clock();
+    scanCtx->scanOptions.scanTargets = (const char *)0;
+
+    // Trace files are opened with the sockets (the names are not kept)
+    scanCtx->scanOptions.traceRecord = scanCtx->scanOptions.traceReplay = (const char *)0;
+
+    // IPv6 scan group (the option string is not kept)
+    const char *ip6Group = scanOptions->ip6Group ? scanOptions->ip6Group : IP6_SCAN_GROUP;
+    scanCtx->scanOptions.ip6Group = (const char *)0;
+    if((inet_pton(AF_INET6, ip6Group, &scanCtx->ip6Group) != 1) || !IN6_IS_ADDR_MULTICAST(&scanCtx->ip6Group))
+    {
+        logError("Invalid IPv6 scan group '%s'", ip6Group);
+        free(scanCtx);
+        return (SCAN_CONTEXT *)0;
+    }
+
+    // Interface filters are kept for interface list updates
+    scanCtx->scanOptions.ifInclude = copyOptionString(scanOptions->ifInclude);
+    scanCtx->scanOptions.ifExclude = copyOptionString(scanOptions->ifExclude);
+    scanCtx->scanOptions.ifSubnets = copyOptionString(scanOptions->ifSubnets);
+    if((scanOptions->ifInclude && !scanCtx->scanOptions.ifInclude) ||
+       (scanOptions->ifExclude && !scanCtx->scanOptions.ifExclude) ||
+       (scanOptions->ifSubnets && !scanCtx->scanOptions.ifSubnets))
+    {
+        free((void *)scanCtx->scanOptions.ifInclude);
+        free((void *)scanCtx->scanOptions.ifExclude);
+        free((void *)scanCtx->scanOptions.ifSubnets);
+        free(scanCtx);
+        return (SCAN_CONTEXT *)0;
+    }
+
+    // Create the event loop (before any socket is registered)
+    if(plt_eventLoopOpen(&scanCtx->eventLoop) < 0)
+    {
+        logError("eventLoopOpen() failed (error: %d)", plt_sockGetLastError());
+        free((void *)scanCtx->scanOptions.ifInclude);
+        free((void *)scanCtx->scanOptions.ifExclude);
+        free((void *)scanCtx->scanOptions.ifSubnets);
+        free(scanCtx);
+        return (SCAN_CONTEXT *)0;
+    }
+
+    return scanCtx;
+}
+
+
+static int openRequestSocket(SCAN_CONTEXT *scanCtx, REQUEST_QUEUE *requestQueue)
+{
+    // IPv6 scan: Dual-stack socket (IPv4 servers as mapped addresses)
+    requestQueue->addrFamily = scanCtx->scanOptions.ip6Scan ? AF_INET6 : AF_INET;
+
+    requestQueue->fdSocket = plt_sockOpen(requestQueue->addrFamily, SOCK_DGRAM, 0);
+    if(requestQueue->fdSocket < 0)
+    {
+        logError("socket() failed (error: %d)", plt_sockGetLastError());
+        return -1;
+    }
+
+    if((requestQueue->addrFamily == AF_INET6) && (plt_sockSetDualStack(requestQueue->fdSocket) < 0))
+    {
+        logError("setsockopt(dual-stack) failed (error: %d)", plt_sockGetLastError());
+        return -1;
+    }
+
+    if(plt_sockSetNonBlocking(requestQueue->fdSocket) < 0)
+    {
+        logError("setNonBlocking() failed (error: %d)", plt_sockGetLastError());
+        return -1;
+    }
+
+    if(plt_sockSetDropCounter(requestQueue->fdSocket) < 0)
+    {
+        logError("setsockopt(drop counter) failed (error: %d)", plt_sockGetLastError());
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int openSharedSocket(SCAN_CONTEXT *scanCtx)
+{
+    // Note: Not bound - the source address is set per broadcast, the destination address of the
+    // responses is reported with the datagram (packet info)
+    scanCtx->fdShared = plt_sockOpen(AF_INET, SOCK_DGRAM, 0);
+    if(scanCtx->fdShared < 0)
+    {
+        logError("socket() failed (error: %d)", plt_sockGetLastError());
+        return -1;
+    }
+
+    if(plt_sockSetBroadcast(scanCtx->fdShared) < 0)
+    {
+        logError("setsockopt(broadcast) failed (error: %d)", plt_sockGetLastError());
+        return -1;
+    }
+
+    if(plt_sockSetPacketInfo(scanCtx->fdShared) < 0)
+    {
+        logError("setsockopt(packet info) failed (error: %d)", plt_sockGetLastError());
+        return -1;
+    }
+
+    if(plt_sockSetDropCounter(scanCtx->fdShared) < 0)
+    {
+        logError("setsockopt(drop counter) failed (error: %d)", plt_sockGetLastError());
+        return -1;
+    }
+
+    if(plt_sockSetNonBlocking(scanCtx->fdShared) < 0)
+    {
+        logError("setNonBlocking() failed (error: %d)", plt_sockGetLastError());
+        return -1;
+    }
+
+    return addEventSource(scanCtx, &scanCtx->sharedSource, scanCtx->fdShared, EVSRC_SHARED_SOCKET, scanCtx, PLT_EVFLG_READ);
+}
+
+
+static int registerInterface(SCAN_CONTEXT *scanCtx, INTERFACE_NODE *ifNode)
+{
+    // Shared socket: Responses are mapped to the interface by the destination address (the event
+    // source marks the node as registered only)
+    if(ifNode->fdSocket < 0)
+    {
+        ifNode->eventSource.sourceType = EVSRC_SHARED_SOCKET;
+        ifNode->eventSource.sourceRecord = ifNode;
+        return insertHashEntry(&scanCtx->ifAddrIndex, hashAddress(&ifNode->ifAddr), ifNode);
+    }
+
+    // New interfaces (interface list update) get the receive buffer of the others
+    if(setRecvBuffer(scanCtx, ifNode->fdSocket)) return -1;
+
+    return addEventSource(scanCtx, &ifNode->eventSource, ifNode->fdSocket, EVSRC_INTERFACE, ifNode, PLT_EVFLG_READ);
+}
+
+
+static void unregisterInterface(SCAN_CONTEXT *scanCtx, INTERFACE_NODE *ifNode)
+{
+    if(ifNode->fdSocket < 0)
+    {
+        removeHashEntry(&scanCtx->ifAddrIndex, hashAddress(&ifNode->ifAddr), ifNode);
+    }
+    else if(plt_eventLoopRemove(&scanCtx->eventLoop, ifNode->fdSocket))
+    {
+        logError("eventLoopRemove() failed (error: %d)", plt_sockGetLastError());
+    }
+}
+
+
+static int openRequestSockets(SCAN_CONTEXT *scanCtx)
+{
+    // Create unicast sockets (for reachability check requests and for device info requests)
+    if(openRequestSocket(scanCtx, &scanCtx->checkRequestQueue)) return -1;
+    if(openRequestSocket(scanCtx, &scanCtx->infoRequestQueue)) return -1;
+
+    // Shared socket: Opened in any case (IPv4 interfaces may show up with an interface list update)
+    if(scanCtx->scanOptions.sharedSocket && openSharedSocket(scanCtx)) return -1;
+
+    // Register all sockets with the event loop (write interest is set during a scan)
+    for(INTERFACE_NODE *ifNode = scanCtx->firstIfNode; ifNode; ifNode = ifNode->next)
+    {
+        if(registerInterface(scanCtx, ifNode)) return -1;
+    }
+
+    REQUEST_QUEUE *checkQueue = &scanCtx->checkRequestQueue, *infoQueue = &scanCtx->infoRequestQueue;
+    if(addEventSource(scanCtx, &checkQueue->eventSource, checkQueue->fdSocket, EVSRC_REQUEST_QUEUE, checkQueue, PLT_EVFLG_READ)) return -1;
+    if(addEventSource(scanCtx, &infoQueue->eventSource, infoQueue->fdSocket, EVSRC_REQUEST_QUEUE, infoQueue, PLT_EVFLG_READ)) return -1;
+
+    return 0;
+}
+
+
+static int refreshInterfaces(SCAN_CONTEXT *scanCtx)
+{
+    // Note: Not for parallel scans (the interfaces are owned by the workers)
+    unsigned msIfRefresh = scanCtx->scanOptions.msIfRefresh;
+    if((msIfRefresh == 0) || scanCtx->workerCount) return 0;
+
+    uint64_t nsNow = plt_getMonoTimeNS();
+    if((nsNow - scanCtx->nsIfRefresh) < (uint64_t)msIfRefresh * 1000000) return 0;
+    scanCtx->nsIfRefresh = nsNow;
+
+    // Visit the current interface list. Known interfaces (name and address) keep their socket,
+    // sockets are opened for new interfaces only.
+    for(INTERFACE_NODE *ifNode = scanCtx->firstIfNode; ifNode; ifNode = ifNode->next) ifNode->visitFlag = 0;
+    if(plt_ifAddrListVisitor(createInterfaceNode, scanCtx)) return -1;
+    if(scanCtx->scanOptions.ip6Scan && plt_ifAddr6ListVisitor(createInterfaceNode6, scanCtx)) return -1;
+
+    INTERFACE_NODE *ifNode = scanCtx->firstIfNode;
+    while(ifNode)
+    {
+        INTERFACE_NODE *nextNode = ifNode->next;
+
+        if(!ifNode->visitFlag)
+        {
+            // Interface (address) gone: Close the socket
+            unregisterInterface(scanCtx, ifNode);
+            LINKOUT_NODE(scanCtx->firstIfNode, scanCtx->lastIfNode, ifNode);
+            deleteInterfaceNode(ifNode);
+        }
+        else if(ifNode->eventSource.sourceType == 0)
+        {
+            // New interface: Register with the event loop
+            if(registerInterface(scanCtx, ifNode)) return -1;
+        }
+
+        ifNode = nextNode;
+    }
+
+    return 0;
+}
+
+
+static int addReplayInterface(SCAN_CONTEXT *scanCtx, const char *ifName, const IDNSL_NET_ADDRESS *ifAddr, uint8_t traceRole)
+{
+    // Known interfaces are kept (statistics, responses of the last scan)
+    for(INTERFACE_NODE *ifNode = scanCtx->firstIfNode; ifNode; ifNode = ifNode->next)
+    {
+        if(!matchNetAddress(&ifNode->ifAddr, ifAddr) || strncmp(ifNode->ifName, ifName, sizeof(ifNode->ifName) - 1)) continue;
+
+        ifNode->visitFlag = 1;
+        return 0;
+    }
+
+    INTERFACE_NODE *ifNode = (INTERFACE_NODE *)calloc(1, sizeof(INTERFACE_NODE));
+    if(ifNode == (INTERFACE_NODE *)0)
+    {
+        logError("calloc(INTERFACE_NODE) failed");
+        return -1;
+    }
+
+    snprintf(ifNode->ifName, sizeof(ifNode->ifName), "%s", ifName);
+    ifNode->ifAddr = *ifAddr;
+    ifNode->visitFlag = 1;
+    ifNode->fdSocket = -1;
+    initTokenBucket(&ifNode->requestPacer, scanCtx->scanOptions.requestRate, scanCtx->scanOptions.requestBurst, plt_getMonoTimeNS());
+
+    // Virtual socket: The role as recorded, indexed by address (recorded datagrams are mapped)
+    ifNode->eventSource.sourceType = (traceRole == TRACEROLE_SHARED) ? EVSRC_SHARED_SOCKET : EVSRC_INTERFACE;
+    ifNode->eventSource.sourceRecord = ifNode;
+    ifNode->eventSource.evFlags = PLT_EVFLG_READ;
+    if(insertHashEntry(&scanCtx->ifAddrIndex, hashAddress(&ifNode->ifAddr), ifNode))
+    {
+        free(ifNode);
+        return -1;
+    }
+
+    APPEND_NODE(scanCtx->firstIfNode, scanCtx->lastIfNode, ifNode);
+    return 0;
+}
+
+
+static int loadTraceScan(SCAN_CONTEXT *scanCtx)
+{
+    // Replay: The next scan of the trace (records left by a scan that ended early are skipped)
+    const TRACE_RECORD *traceRec = peekTraceRecord(scanCtx);
+    for(; traceRec && (traceRec->recordType != TRACEREC_SCAN); traceRec = peekTraceRecord(scanCtx)) skipTraceRecord(scanCtx, traceRec);
+    if(traceRec == (const TRACE_RECORD *)0)
+    {
+        logError("End of trace");
+        return -1;
+    }
+
+    // Sequence and jitter state as recorded (requests are issued in the recorded order)
+    TRACE_SCAN traceScan;
+    memset(&traceScan, 0, sizeof(traceScan));
+    memcpy(&traceScan, &traceRec[1], (traceRec->dataLength < sizeof(traceScan)) ? traceRec->dataLength : sizeof(traceScan));
+    scanCtx->sequenceNum = traceScan.sequenceNum;
+    scanCtx->randomState = traceScan.randomState;
+    scanCtx->usTraceScan = traceRec->usTime;
+    skipTraceRecord(scanCtx, traceRec);
+
+    // Interfaces of the scan (like an interface list update)
+    for(INTERFACE_NODE *ifNode = scanCtx->firstIfNode; ifNode; ifNode = ifNode->next) ifNode->visitFlag = 0;
+    for(traceRec = peekTraceRecord(scanCtx); traceRec && (traceRec->recordType == TRACEREC_INTERFACE); traceRec = peekTraceRecord(scanCtx))
+    {
+        char ifName[sizeof(((INTERFACE_NODE *)0)->ifName)];
+        unsigned nameLength = (traceRec->dataLength < sizeof(ifName)) ? traceRec->dataLength : (unsigned)(sizeof(ifName) - 1);
+        memcpy(ifName, &traceRec[1], nameLength);
+        ifName[nameLength] = '\0';
+
+        if(addReplayInterface(scanCtx, ifName, &traceRec->localAddr, traceRec->traceRole)) return -1;
+        skipTraceRecord(scanCtx, traceRec);
+    }
+
+    INTERFACE_NODE *ifNode = scanCtx->firstIfNode;
+    while(ifNode)
+    {
+        INTERFACE_NODE *nextNode = ifNode->next;
+        if(!ifNode->visitFlag)
+        {
+            unregisterInterface(scanCtx, ifNode);
+            LINKOUT_NODE(scanCtx->firstIfNode, scanCtx->lastIfNode, ifNode);
+            deleteInterfaceNode(ifNode);
+        }
+
+        ifNode = nextNode;
+    }
+
+    return 0;
+}
+
+
+static void deleteScanContext(SCAN_CONTEXT *scanCtx)
+{
+    // Workers first (own interfaces and sockets)
+    for(unsigned i = 0; i < scanCtx->workerCount; i++) deleteScanContext(scanCtx->workerTable[i]);
+    free(scanCtx->workerTable);
+
+    // Close interface sockets
+    while(scanCtx->firstIfNode)
+    {
+        INTERFACE_NODE *ifNode = scanCtx->firstIfNode;
+        LINKOUT_NODE(scanCtx->firstIfNode, scanCtx->lastIfNode, ifNode);
+        deleteInterfaceNode(ifNode);
+    }
+
+    // Close unicast reachability check socket
+    if(scanCtx->checkRequestQueue.fdSocket >= 0)
+    {
+        int fdSocket = scanCtx->checkRequestQueue.fdSocket;
+        if(plt_sockClose(fdSocket)) logError("close() failed (error: %d)", plt_sockGetLastError());
+    }
+
+    // Close unicast device info socket
+    if(scanCtx->infoRequestQueue.fdSocket >= 0)
+    {
+        int fdSocket = scanCtx->infoRequestQueue.fdSocket;
+        if(plt_sockClose(fdSocket)) logError("close() failed (error: %d)", plt_sockGetLastError());
+    }
+
+    // Close shared broadcast socket
+    if(scanCtx->fdShared >= 0)
+    {
+        if(plt_sockClose(scanCtx->fdShared)) logError("close() failed (error: %d)", plt_sockGetLastError());
+    }
+    freeHashIndex(&scanCtx->ifAddrIndex);
+
+    // Close the trace file (recording: truncated to the records)
+    closeTrace(scanCtx);
+
+    // Close the event loop (sockets are closed already)
+    if(plt_eventLoopClose(&scanCtx->eventLoop)) logError("eventLoopClose() failed (error: %d)", plt_sockGetLastError());
+
+    // Release the server table and all scratch memory at once (response info, request jobs)
+    freeServerTable(scanCtx);
+    arenaFree(&scanCtx->scanArena);
+    free(scanCtx->targetTable);
+    free((void *)scanCtx->scanOptions.ifInclude);
+    free((void *)scanCtx->scanOptions.ifExclude);
+    free((void *)scanCtx->scanOptions.ifSubnets);
+
+    // Free context struct memory
+    free(scanCtx);
+}
+
+
+static int createWorkers(SCAN_CONTEXT *scanCtx)
+{
+    // One worker per interface group (no workers in case of a single group)
+    unsigned ifCount = 0;
+    for(INTERFACE_NODE *ifNode = scanCtx->firstIfNode; ifNode; ifNode = ifNode->next) ifCount++;
+
+    unsigned workerCount = scanCtx->scanOptions.workerCount;
+    if(workerCount > ifCount) workerCount = ifCount;
+    if(workerCount < 2) return 0;
+
+    scanCtx->workerTable = (SCAN_CONTEXT **)calloc(workerCount, sizeof(SCAN_CONTEXT *));
+    if(scanCtx->workerTable == (SCAN_CONTEXT **)0)
+    {
+        logError("calloc(workerTable) failed");
+        return -1;
+    }
+
+    for(unsigned i = 0; i < workerCount; i++)
+    {
+        SCAN_CONTEXT *workerCtx = createScanContext(&scanCtx->scanOptions, &scanCtx->callbacks);
+        if(workerCtx == (SCAN_CONTEXT *)0) return -1;
+
+        workerCtx->parentCtx = scanCtx;
+        workerCtx->ip6Group = scanCtx->ip6Group;
+        scanCtx->workerTable[scanCtx->workerCount++] = workerCtx;
+    }
+
+    // Distribute the interfaces (round robin). Each worker owns the sockets of its interfaces.
+    for(unsigned i = 0; scanCtx->firstIfNode; i++)
+    {
+        INTERFACE_NODE *ifNode = scanCtx->firstIfNode;
+        LINKOUT_NODE(scanCtx->firstIfNode, scanCtx->lastIfNode, ifNode);
+
+        SCAN_CONTEXT *workerCtx = scanCtx->workerTable[i % workerCount];
+        APPEND_NODE(workerCtx->firstIfNode, workerCtx->lastIfNode, ifNode);
+    }
+
+    // Unicast sockets per worker, register with the event loop of the worker
+    for(unsigned i = 0; i < workerCount; i++)
+    {
+        if(openRequestSockets(scanCtx->workerTable[i])) return -1;
+    }
+
+    return 0;
+}
+
+
+static void mergeServerNode(MERGE_INDEX *mergeIndex, SERVER_NODE *serverNode)
+{
+    // Note: Called concurrently by all workers. Records are only linked (never unlinked) - a list
+    // once read stays valid. The merge links of the record are reset before it is published.
+    uint32_t hashValue = hashUnitID(serverNode->serverInfo.unitID);
+    void *volatile *bucketRef = (void *volatile *)&mergeIndex->bucketTable[hashValue & mergeIndex->bucketMask];
+
+    while(1)
+    {
+        // In case the server was inserted by another worker: Add to the records of the server
+        SERVER_NODE *firstNode = (SERVER_NODE *)plt_atomicLoadPtr(bucketRef);
+        for(SERVER_NODE *cursor = firstNode; cursor; cursor = cursor->mergeNext)
+        {
+            if(!matchServerUnitID(cursor, serverNode->serverInfo.unitID)) continue;
+
+            void *volatile *dupRef = (void *volatile *)&cursor->mergeDup;
+            serverNode->mergePrimary = 0;
+            do { serverNode->mergeDup = (SERVER_NODE *)plt_atomicLoadPtr(dupRef); }
+            while(!plt_atomicCasPtr(dupRef, serverNode->mergeDup, serverNode));
+            return;
+        }
+
+        // New server: Insert as first record of the bucket (check again on a concurrent insert)
+        serverNode->mergeNext = firstNode;
+        serverNode->mergePrimary = 1;
+        if(plt_atomicCasPtr(bucketRef, firstNode, serverNode)) return;
+    }
+}
+
+
+static void workerScan(void *threadArg)
+{
+    SCAN_CONTEXT *workerCtx = (SCAN_CONTEXT *)threadArg;
+
+    // Scan the interfaces of the worker (own sockets, own server table)
+    beginScan(workerCtx);
+    workerCtx->workerResult = runScan(workerCtx, workerCtx->scanOptions.msTimeout);
+    if(workerCtx->workerResult != 0) return;
+    closeScanStats(workerCtx);
+    updateServerTable(workerCtx);
+
+    // Merge into the session index (all workers in parallel, lock-free)
+    for(IDNSL_SERVER_INFO *serverInfo = workerCtx->firstServerInfo; serverInfo; serverInfo = serverInfo->next)
+    {
+        SERVER_NODE *serverNode = (SERVER_NODE *)serverInfo;
+        serverNode->mergeNext = serverNode->mergeDup = (SERVER_NODE *)0;
+        mergeServerNode(&workerCtx->parentCtx->mergeIndex, serverNode);
+    }
+}
+
+
+static int buildMergedList(SCAN_CONTEXT *scanCtx)
+{
+    // Note: All workers are joined. One list entry per server (worker order), from all records
+    IDNSL_SERVER_INFO *lastServerInfo = (IDNSL_SERVER_INFO *)0;
+    for(unsigned w = 0; w < scanCtx->workerCount; w++)
+    {
+        IDNSL_SERVER_INFO *serverInfo = scanCtx->workerTable[w]->firstServerInfo;
+        for(; serverInfo; serverInfo = serverInfo->next)
+        {
+            SERVER_NODE *serverNode = (SERVER_NODE *)serverInfo;
+            if(!serverNode->mergePrimary) continue;
+
+            // Allocate server info and address table (from scan arena, the result list is a copy)
+            unsigned addrCount = 0;
+            for(SERVER_NODE *cursor = serverNode; cursor; cursor = cursor->mergeDup) addrCount += cursor->serverInfo.addressCount;
+
+            IDNSL_SERVER_INFO *mergedInfo = (IDNSL_SERVER_INFO *)arenaAlloc(&scanCtx->scanArena, sizeof(IDNSL_SERVER_INFO));
+            if(mergedInfo == (IDNSL_SERVER_INFO *)0) return -1;
+
+            *mergedInfo = *serverInfo;
+            mergedInfo->next = (IDNSL_SERVER_INFO *)0;
+            mergedInfo->addressCount = 0;
+            mergedInfo->addressTable = (IDNSL_SERVER_ADDRESS *)arenaAlloc(&scanCtx->scanArena, (addrCount + 1) * sizeof(IDNSL_SERVER_ADDRESS));
+            if(mergedInfo->addressTable == (IDNSL_SERVER_ADDRESS *)0) return -1;
+
+            // Addresses of all records (reachable first, erroneous last, once per address)
+            for(int errorPass = 0; errorPass < 2; errorPass++)
+            {
+                for(SERVER_NODE *cursor = serverNode; cursor; cursor = cursor->mergeDup)
+                {
+                    for(unsigned i = 0; i < cursor->serverInfo.addressCount; i++)
+                    {
+                        IDNSL_SERVER_ADDRESS *serverAddr = &cursor->serverInfo.addressTable[i];
+                        if((serverAddr->errorFlags != 0) != (errorPass != 0)) continue;
+                        if(findServerAddress(mergedInfo, &serverAddr->netAddr) >= 0) continue;
+                        mergedInfo->addressTable[mergedInfo->addressCount++] = *serverAddr;
+
+                        // Reachable addresses of different workers ordered by latency
+                        for(unsigned j = mergedInfo->addressCount - 1; (j > 0) && !errorPass; j--)
+                        {
+                            IDNSL_SERVER_ADDRESS *addressTable = mergedInfo->addressTable;
+                            if(!isLowerLatency(&addressTable[j], &addressTable[j - 1])) break;
+
+                            IDNSL_SERVER_ADDRESS mergedAddr = addressTable[j];
+                            addressTable[j] = addressTable[j - 1];
+                            addressTable[j - 1] = mergedAddr;
+                        }
+                    }
+                }
+            }
+
+            // Client groups of all records
+            for(SERVER_NODE *cursor = serverNode->mergeDup; cursor; cursor = cursor->mergeDup)
+            {
+                mergedInfo->groupMask |= cursor->serverInfo.groupMask;
+                mergedInfo->excludedMask |= cursor->serverInfo.excludedMask;
+            }
+
+            // Service map of the first record that has a (current) service map
+            for(SERVER_NODE *cursor = serverNode; cursor; cursor = cursor->mergeDup)
+            {
+                if(!cursor->serviceMapFlag) continue;
+
+                mergedInfo->serviceCount = cursor->serverInfo.serviceCount;
+                mergedInfo->serviceTable = cursor->serverInfo.serviceTable;
+                mergedInfo->relayCount = cursor->serverInfo.relayCount;
+                mergedInfo->relayTable = cursor->serverInfo.relayTable;
+                mergedInfo->serviceMap = cursor->serverInfo.serviceMap;
+                break;
+            }
+
+            // Parameters of the first record that has complete parameters
+            for(SERVER_NODE *cursor = serverNode; cursor; cursor = cursor->mergeDup)
+            {
+                if(!cursor->paramFlag) continue;
+
+                mergedInfo->paramCount = cursor->serverInfo.paramCount;
+                mergedInfo->paramTable = cursor->serverInfo.paramTable;
+                break;
+            }
+
+            // Append to list
+            if(lastServerInfo) lastServerInfo->next = mergedInfo;
+            else scanCtx->mergedServerInfo = mergedInfo;
+            lastServerInfo = mergedInfo;
+        }
+    }
+
+    return 0;
+}
+
+
+static int rescanWorkers(SCAN_CONTEXT *scanCtx)
+{
+    // Release the merged list of the previous scan
+    arenaReset(&scanCtx->scanArena);
+    scanCtx->mergedServerInfo = (IDNSL_SERVER_INFO *)0;
+
+    // Merge index - sized for the servers of the previous scan (buckets are lists, no limit)
+    unsigned serverCount = 0;
+    for(unsigned w = 0; w < scanCtx->workerCount; w++)
+    {
+        IDNSL_SERVER_INFO *serverInfo = scanCtx->workerTable[w]->firstServerInfo;
+        for(; serverInfo; serverInfo = serverInfo->next) serverCount++;
+    }
+
+    unsigned bucketCount = HASH_INDEX_MIN_SIZE;
+    while(bucketCount < serverCount * 2) bucketCount *= 2;
+
+    MERGE_INDEX *mergeIndex = &scanCtx->mergeIndex;
+    mergeIndex->bucketTable = (SERVER_NODE **)arenaAlloc(&scanCtx->scanArena, bucketCount * sizeof(SERVER_NODE *));
+    if(mergeIndex->bucketTable == (SERVER_NODE **)0) return -1;
+    mergeIndex->bucketMask = bucketCount - 1;
+
+    // Run all workers in parallel, wait for completion
+    unsigned startCount = 0;
+    for(; startCount < scanCtx->workerCount; startCount++)
+    {
+        SCAN_CONTEXT *workerCtx = scanCtx->workerTable[startCount];
+        workerCtx->workerResult = -1;
+        if(plt_threadStart(&workerCtx->workerThread, workerScan, workerCtx))
+        {
+            logError("threadStart() failed (error: %d)", plt_sockGetLastError());
+            break;
+        }
+    }
+
+    int result = (startCount == scanCtx->workerCount) ? 0 : -1;
+    for(unsigned i = 0; i < startCount; i++)
+    {
+        SCAN_CONTEXT *workerCtx = scanCtx->workerTable[i];
+        if(plt_threadJoin(&workerCtx->workerThread))
+        {
+            logError("threadJoin() failed (error: %d)", plt_sockGetLastError());
+            result = -1;
+        }
+        else if(workerCtx->workerResult != 0) result = -1;
+    }
+    if(result != 0) return result;
+
+    // Statistics of all workers
+    memset(&scanCtx->lastScanStats, 0, sizeof(scanCtx->lastScanStats));
+    for(unsigned i = 0; i < scanCtx->workerCount; i++) mergeScanStats(&scanCtx->lastScanStats, &scanCtx->workerTable[i]->lastScanStats);
+
+    return buildMergedList(scanCtx);
+}
+
+
+// -------------------------------------------------------------------------------------------------
+//  Snapshot export
+// -------------------------------------------------------------------------------------------------
+
+static uint32_t putSnapshotArray(size_t *snapshotSize, size_t arraySize)
+{
+    // Arrays are aligned (8 bytes), the offset of the array is returned
+    uint32_t arrayOffset = (uint32_t)*snapshotSize;
+    *snapshotSize += ALIGN_SIZE(arraySize, 8);
+
+    return arrayOffset;
+}
+
+
+static void getServiceEntry(const IDNSL_SERVER_INFO *serverInfo, unsigned serviceIndex, IDNSL_SERVICE_INFO *serviceInfo, unsigned *relayIndex)
+{
+    // Service tables or lazy service map. Relay index: relayCount for root services
+    if(serverInfo->serviceTable)
+    {
+        *serviceInfo = serverInfo->serviceTable[serviceIndex];
+        *relayIndex = serviceInfo->parentRelay ? (unsigned)(serviceInfo->parentRelay - serverInfo->relayTable) : serverInfo->relayCount;
+    }
+    else
+    {
+        decodeServiceEntry(serverInfo->serviceMap, serviceIndex, serviceInfo);
+        *relayIndex = getServiceRelayTable(serverInfo->serviceMap)[serviceIndex];
+    }
+}
+
+
+static void getRelayEntry(const IDNSL_SERVER_INFO *serverInfo, unsigned relayIndex, IDNSL_RELAY_INFO *relayInfo)
+{
+    if(serverInfo->relayTable) *relayInfo = serverInfo->relayTable[relayIndex];
+    else decodeRelayEntry(serverInfo->serviceMap, relayIndex, relayInfo);
+}
+
+
+static size_t layoutSnapshot(IDNSL_SNAPSHOT *snapshot)
+{
+    // Note: Counts set, all array offsets are calculated. Returns the total size.
+    size_t snapshotSize = ALIGN_SIZE(sizeof(IDNSL_SNAPSHOT), 8);
+    unsigned serverCount = snapshot->serverCount, addressCount = snapshot->addressCount;
+    unsigned serviceCount = snapshot->serviceCount, relayCount = snapshot->relayCount;
+
+    snapshot->unitIDOffset = putSnapshotArray(&snapshotSize, (size_t)serverCount * IDNSL_UNITID_LENGTH);
+    snapshot->hostNameOffset = putSnapshotArray(&snapshotSize, (size_t)serverCount * IDNSL_HOST_NAME_LENGTH);
+    snapshot->addressStartOffset = putSnapshotArray(&snapshotSize, (size_t)(serverCount + 1) * sizeof(uint32_t));
+    snapshot->serviceStartOffset = putSnapshotArray(&snapshotSize, (size_t)(serverCount + 1) * sizeof(uint32_t));
+    snapshot->relayStartOffset = putSnapshotArray(&snapshotSize, (size_t)(serverCount + 1) * sizeof(uint32_t));
+
+    snapshot->addressOffset = putSnapshotArray(&snapshotSize, (size_t)addressCount * sizeof(IDNSL_NET_ADDRESS));
+    snapshot->addressFlagsOffset = putSnapshotArray(&snapshotSize, addressCount);
+
+    snapshot->serviceIDOffset = putSnapshotArray(&snapshotSize, serviceCount);
+    snapshot->serviceTypeOffset = putSnapshotArray(&snapshotSize, serviceCount);
+    snapshot->serviceFlagsOffset = putSnapshotArray(&snapshotSize, serviceCount);
+    snapshot->serviceRelayOffset = putSnapshotArray(&snapshotSize, (size_t)serviceCount * sizeof(uint32_t));
+    snapshot->serviceNameOffset = putSnapshotArray(&snapshotSize, (size_t)serviceCount * IDNSL_SERVICE_NAME_LENGTH);
+
+    snapshot->relayNumberOffset = putSnapshotArray(&snapshotSize, relayCount);
+    snapshot->relayFlagsOffset = putSnapshotArray(&snapshotSize, relayCount);
+    snapshot->relayNameOffset = putSnapshotArray(&snapshotSize, (size_t)relayCount * IDNSL_RELAY_NAME_LENGTH);
+
+    return snapshotSize;
+}
+
+
+// -------------------------------------------------------------------------------------------------
+//  Query index (sorted tables, binary search)
+// -------------------------------------------------------------------------------------------------
+
+static int compareUnitID(const uint8_t *unitID1, const uint8_t *unitID2)
+{
+    // Length first, then the ID bytes
+    if(unitID1[0] != unitID2[0]) return (unitID1[0] < unitID2[0]) ? -1 : 1;
+    return memcmp(&unitID1[1], &unitID2[1], unitID1[0]);
+}
+
+
+static int compareNamePrefix(const char *name, const char *key, int prefixFlag)
+{
+    // Order of strcmp(). Prefix: A name that starts with the key compares equal
+    if(!prefixFlag) return strcmp(name, key);
+
+    size_t keyLength = strlen(key);
+    return strncmp(name, key, keyLength);
+}
+
+
+static int orderByUnitID(const void *ptr1, const void *ptr2)
+{
+    const QUERY_SERVER *server1 = *(const QUERY_SERVER * const *)ptr1, *server2 = *(const QUERY_SERVER * const *)ptr2;
+    return compareUnitID(server1->serverInfo->unitID, server2->serverInfo->unitID);
+}
+
+
+static int orderByHostName(const void *ptr1, const void *ptr2)
+{
+    const QUERY_SERVER *server1 = *(const QUERY_SERVER * const *)ptr1, *server2 = *(const QUERY_SERVER * const *)ptr2;
+    int rc = strcmp(server1->serverInfo->hostName, server2->serverInfo->hostName);
+    if(rc == 0) rc = (server1 < server2) ? -1 : (server1 > server2);
+
+    return rc;
+}
+
+
+static int orderByServiceType(const void *ptr1, const void *ptr2)
+{
+    const QUERY_ENTRY *entry1 = *(const QUERY_ENTRY * const *)ptr1, *entry2 = *(const QUERY_ENTRY * const *)ptr2;
+    if(entry1->serviceInfo.serviceType != entry2->serviceInfo.serviceType) return (entry1->serviceInfo.serviceType < entry2->serviceInfo.serviceType) ? -1 : 1;
+
+    return (entry1 < entry2) ? -1 : (entry1 > entry2);
+}
+
+
+static int orderByServiceName(const void *ptr1, const void *ptr2)
+{
+    const QUERY_ENTRY *entry1 = *(const QUERY_ENTRY * const *)ptr1, *entry2 = *(const QUERY_ENTRY * const *)ptr2;
+    int rc = strcmp(entry1->serviceInfo.serviceName, entry2->serviceInfo.serviceName);
+    if(rc == 0) rc = (entry1 < entry2) ? -1 : (entry1 > entry2);
+
+    return rc;
+}
+
+
+// Range of a sorted pointer table: First element not below the key (lower) / above the key (upper)
+#define FIND_RANGE(table, count, compareExpr, rangeStart, rangeEnd)                         \
+    do {                                                                                    \
+        unsigned lo = 0, hi = (count);                                                      \
+        while(lo < hi) { unsigned mid = (lo + hi) / 2; const void *elem = (table)[mid];     \
+                         if((compareExpr) < 0) lo = mid + 1; else hi = mid; }               \
+        (rangeStart) = lo; hi = (count);                                                    \
+        while(lo < hi) { unsigned mid = (lo + hi) / 2; const void *elem = (table)[mid];     \
+                         if((compareExpr) <= 0) lo = mid + 1; else hi = mid; }              \
+        (rangeEnd) = lo;                                                                    \
+    } while(0)
+
+
+static int matchQueryEntry(const QUERY_ENTRY *queryEntry, const IDNSL_QUERY *query)
+{
+    // All criteria of the query (the driving index is checked again - cheap)
+    const IDNSL_SERVER_INFO *serverInfo = queryEntry->serverInfo;
+    int prefixFlag = (query->queryFlags & IDNSL_QUERY_PREFIX) != 0;
+
+    if((query->queryFlags & IDNSL_QUERY_SERVICE_TYPE) && (queryEntry->serviceInfo.serviceType != query->serviceType)) return 0;
+    if((query->queryFlags & IDNSL_QUERY_SERVICE_NAME) && compareNamePrefix(queryEntry->serviceInfo.serviceName, query->serviceName, prefixFlag)) return 0;
+    if((query->queryFlags & IDNSL_QUERY_HOST_NAME) && compareNamePrefix(serverInfo->hostName, query->hostName, prefixFlag)) return 0;
+    if((query->queryFlags & IDNSL_QUERY_UNITID) && compareUnitID(serverInfo->unitID, query->unitID)) return 0;
+    if((query->queryFlags & IDNSL_QUERY_REACHABLE) && ((serverInfo->addressCount == 0) || serverInfo->addressTable[0].errorFlags)) return 0;
+
+    return 1;
+}
+
+
+static int putQueryResult(const QUERY_ENTRY *queryEntry, const IDNSL_QUERY *query, IDNSL_QUERY_RESULT *resultTable, unsigned resultLimit, unsigned *resultCount)
+{
+    // Returns 1 in case the result table is full
+    if(!matchQueryEntry(queryEntry, query)) return 0;
+
+    // Best address: The first one (reachable first, then by latency), in case reachable
+    const IDNSL_SERVER_INFO *serverInfo = queryEntry->serverInfo;
+    IDNSL_QUERY_RESULT *queryResult = &resultTable[(*resultCount)++];
+    queryResult->serverInfo = serverInfo;
+    queryResult->serviceInfo = &queryEntry->serviceInfo;
+    queryResult->serverAddr = (const IDNSL_SERVER_ADDRESS *)0;
+    if(serverInfo->addressCount && (serverInfo->addressTable[0].errorFlags == 0)) queryResult->serverAddr = &serverInfo->addressTable[0];
+
+    return *resultCount >= resultLimit;
+}
+
+
+// -------------------------------------------------------------------------------------------------
+//  Discovery cache
+// -------------------------------------------------------------------------------------------------
+
+static int loadCachedServiceMap(SCAN_CONTEXT *scanCtx, SERVER_NODE *serverNode, const IDNSL_SNAPSHOT *snapshot, uint32_t serverIndex)
+{
+    // Rebuild the service map response (relay entries, then service entries) from the snapshot
+    uint32_t firstService = IDNSL_SNAPSHOT_ARRAY(snapshot, uint32_t, serviceStartOffset)[serverIndex];
+    uint32_t firstRelay = IDNSL_SNAPSHOT_ARRAY(snapshot, uint32_t, relayStartOffset)[serverIndex];
+    uint32_t serviceCount = IDNSL_SNAPSHOT_ARRAY(snapshot, uint32_t, serviceStartOffset)[serverIndex + 1] - firstService;
+    uint32_t relayCount = IDNSL_SNAPSHOT_ARRAY(snapshot, uint32_t, relayStartOffset)[serverIndex + 1] - firstRelay;
+    if(serviceCount > 255 || relayCount > 255) return 0;
+
+    size_t rspSize = sizeof(IDNHDR_SERVICEMAP_RESPONSE) + (relayCount + serviceCount) * sizeof(IDNHDR_SERVICEMAP_ENTRY);
+    IDNHDR_SERVICEMAP_RESPONSE *serviceMapHdr = (IDNHDR_SERVICEMAP_RESPONSE *)arenaAlloc(&scanCtx->scanArena, rspSize);
+    if(serviceMapHdr == (IDNHDR_SERVICEMAP_RESPONSE *)0) return -1;
+
+    serviceMapHdr->structSize = sizeof(IDNHDR_SERVICEMAP_RESPONSE);
+    serviceMapHdr->entrySize = sizeof(IDNHDR_SERVICEMAP_ENTRY);
+    serviceMapHdr->relayEntryCount = (uint8_t)relayCount;
+    serviceMapHdr->serviceEntryCount = (uint8_t)serviceCount;
+
+    IDNHDR_SERVICEMAP_ENTRY *entryTable = (IDNHDR_SERVICEMAP_ENTRY *)&serviceMapHdr[1];
+    const uint8_t *relayNumberArray = IDNSL_SNAPSHOT_ARRAY(snapshot, uint8_t, relayNumberOffset);
+    const char *relayNameArray = IDNSL_SNAPSHOT_ARRAY(snapshot, char, relayNameOffset);
+    for(uint32_t i = 0; i < relayCount; i++)
+    {
+        IDNHDR_SERVICEMAP_ENTRY *serviceMapEntry = &entryTable[i];
+        serviceMapEntry->relayNumber = relayNumberArray[firstRelay + i];
+        serviceMapEntry->flags = IDNSL_SNAPSHOT_ARRAY(snapshot, uint8_t, relayFlagsOffset)[firstRelay + i];
+        strncpy((char *)serviceMapEntry->name, &relayNameArray[(firstRelay + i) * IDNSL_RELAY_NAME_LENGTH], sizeof(serviceMapEntry->name));
+    }
+
+    const uint32_t *serviceRelayArray = IDNSL_SNAPSHOT_ARRAY(snapshot, uint32_t, serviceRelayOffset);
+    const char *serviceNameArray = IDNSL_SNAPSHOT_ARRAY(snapshot, char, serviceNameOffset);
+    for(uint32_t i = 0; i < serviceCount; i++)
+    {
+        // Note: Relay references of other servers are invalid (and rejected)
+        uint32_t relayIndex = serviceRelayArray[firstService + i];
+        if(relayIndex != IDNSL_SNAPSHOT_NO_RELAY && (relayIndex < firstRelay || relayIndex >= firstRelay + relayCount)) return 0;
+
+        IDNHDR_SERVICEMAP_ENTRY *serviceMapEntry = &entryTable[relayCount + i];
+        serviceMapEntry->serviceID = IDNSL_SNAPSHOT_ARRAY(snapshot, uint8_t, serviceIDOffset)[firstService + i];
+        serviceMapEntry->serviceType = IDNSL_SNAPSHOT_ARRAY(snapshot, uint8_t, serviceTypeOffset)[firstService + i];
+        serviceMapEntry->flags = IDNSL_SNAPSHOT_ARRAY(snapshot, uint8_t, serviceFlagsOffset)[firstService + i];
+        serviceMapEntry->relayNumber = (relayIndex == IDNSL_SNAPSHOT_NO_RELAY) ? 0 : relayNumberArray[relayIndex];
+        strncpy((char *)serviceMapEntry->name, &serviceNameArray[(firstService + i) * IDNSL_SERVICE_NAME_LENGTH], sizeof(serviceMapEntry->name));
+    }
+
+    // Validate and decode like a received service map (no sender address, logged as 0.0.0.0)
+    IDNSL_NET_ADDRESS cacheAddr;
+    setIP4Address(&cacheAddr, INADDR_ANY);
+    IDNSL_SERVICE_MAP *serviceMap = createServiceMap(scanCtx, serviceMapHdr, &cacheAddr);
+    if(serviceMap == (IDNSL_SERVICE_MAP *)0) return 0;
+
+    IDNSL_SERVER_INFO *serverInfo = &serverNode->serverInfo;
+    if(!scanCtx->scanOptions.lazyServiceMap && decodeServiceMap(serviceMap, &serverInfo->relayTable, &serverInfo->serviceTable))
+    {
+        free(serviceMap);
+        return -1;
+    }
+
+    serverInfo->relayCount = serviceMap->relayCount;
+    serverInfo->serviceCount = serviceMap->serviceCount;
+    serverInfo->serviceMap = serviceMap;
+    serverNode->serviceMapFlag = 1;
+
+    return 0;
+}
+
+
+static int loadCachedServers(SCAN_CONTEXT *scanCtx, const CACHE_HEADER *cacheHdr, const IDNSL_SNAPSHOT *snapshot, unsigned secMaxAge)
+{
+    const CACHE_SERVER *cacheServerTable = (const CACHE_SERVER *)&cacheHdr[1];
+    const uint8_t *unitIDArray = IDNSL_SNAPSHOT_ARRAY(snapshot, uint8_t, unitIDOffset);
+    const char *hostNameArray = IDNSL_SNAPSHOT_ARRAY(snapshot, char, hostNameOffset);
+    const uint32_t *addressStartArray = IDNSL_SNAPSHOT_ARRAY(snapshot, uint32_t, addressStartOffset);
+    const IDNSL_NET_ADDRESS *addressArray = IDNSL_SNAPSHOT_ARRAY(snapshot, IDNSL_NET_ADDRESS, addressOffset);
+
+    // Note: Servers missing in the next scan are dropped (one missed scan)
+    unsigned missedScanLimit = scanCtx->scanOptions.missedScanLimit;
+    uint64_t loadTime = (uint64_t)time((time_t *)0);
+
+    // Scratch memory for the service map responses
+    arenaReset(&scanCtx->scanArena);
+    scanCtx->firstResponseInfo = scanCtx->lastResponseInfo = (RESPONSE_INFO *)0;
+    initHashIndex(&scanCtx->responseIndex, &scanCtx->scanArena);
+
+    for(uint32_t serverIndex = 0; serverIndex < snapshot->serverCount; serverIndex++)
+    {
+        const CACHE_SERVER *cacheServer = &cacheServerTable[serverIndex];
+        if(secMaxAge && (loadTime - cacheServer->lastSeenTime > secMaxAge)) continue;
+
+        // Skip invalid and known servers (a scan is more recent)
+        const uint8_t *unitID = &unitIDArray[serverIndex * IDNSL_UNITID_LENGTH];
+        if(unitID[0] == 0 || unitID[0] >= IDNSL_UNITID_LENGTH) continue;
+
+        uint32_t hashValue = hashUnitID(unitID);
+        if(findHashEntry(&scanCtx->serverIndex, hashValue, matchServerUnitID, unitID)) continue;
+
+        SERVER_NODE *serverNode = addServerNode(scanCtx, unitID, hashValue);
+        if(serverNode == (SERVER_NODE *)0) return -1;
+
+        IDNSL_SERVER_INFO *serverInfo = &serverNode->serverInfo;
+        memcpy(serverInfo->hostName, &hostNameArray[serverIndex * IDNSL_HOST_NAME_LENGTH], IDNSL_HOST_NAME_LENGTH);
+        serverInfo->hostName[IDNSL_HOST_NAME_LENGTH - 1] = '\0';
+        serverNode->scanStatus = cacheServer->scanStatus;
+        serverNode->lastSeenTime = cacheServer->lastSeenTime;
+        serverNode->missedScanCount = missedScanLimit ? missedScanLimit - 1 : 0;
+
+        // All addresses unverified (until checked)
+        for(uint32_t i = addressStartArray[serverIndex]; i < addressStartArray[serverIndex + 1]; i++)
+        {
+            // Note: The address family is checked by validateIDNSnapshot()
+            IDNSL_NET_ADDRESS addr = addressArray[i];
+            addr.reserved = 0;
+            int addrIndex = getServerAddressIndex(scanCtx, serverInfo, &addr);
+            if(addrIndex < 0) return -1;
+            serverInfo->addressTable[addrIndex].errorFlags = IDNSL_ADDR_ERRORFLAG_UNVERIFIED;
+        }
+
+        // Service map as saved (requested again in case the server changed)
+        if(cacheServer->serviceMapFlag && loadCachedServiceMap(scanCtx, serverNode, snapshot, serverIndex)) return -1;
+
+        serverNode->foundFlag = 1;
+        notifyServer(scanCtx, scanCtx->callbacks.onServerFound, serverInfo);
+    }
+
+    return 0;
+}
+
+
+// -------------------------------------------------------------------------------------------------
+//  Shared memory publishing (single writer, seqlock)
+// -------------------------------------------------------------------------------------------------
+
+static void writeSharedSnapshot(SHM_HEADER *shmHdr, const IDNSL_SNAPSHOT *snapshot)
+{
+    // Odd sequence number while writing - readers retry (or fail after SHM_READ_RETRIES)
+    uint32_t sequenceNum = shmHdr->sequenceNum;
+    plt_atomicStore32(&shmHdr->sequenceNum, sequenceNum + 1);
+    plt_atomicFence();
+
+    memcpy((uint8_t *)shmHdr + SHM_HEADER_SIZE, snapshot, snapshot->snapshotSize);
+    shmHdr->snapshotSize = snapshot->snapshotSize;
+    shmHdr->publishCount = shmHdr->publishCount + 1;
+
+    plt_atomicStore32(&shmHdr->sequenceNum, sequenceNum + 2);
+}
+
+
+static int readSharedSnapshot(const SHM_HEADER *shmHdr, void *bufferPtr, size_t bufferSize)
+{
+    // Note: Returns the snapshot size (> bufferSize: buffer too small), 0 in case there is none.
+    // The segment is copied optimistically, then the sequence number is checked for changes.
+    size_t areaSize = shmHdr->segmentSize - SHM_HEADER_SIZE;
+    for(unsigned retryCount = 0; retryCount < SHM_READ_RETRIES; retryCount++)
+    {
+        uint32_t sequenceNum = plt_atomicLoad32((volatile uint32_t *)&shmHdr->sequenceNum);
+        if(sequenceNum & 1) continue;
+
+        uint32_t snapshotSize = shmHdr->snapshotSize;
+        if(snapshotSize <= bufferSize && snapshotSize <= areaSize)
+        {
+            memcpy(bufferPtr, (const uint8_t *)shmHdr + SHM_HEADER_SIZE, snapshotSize);
+        }
+
+        plt_atomicFence();
+        if(plt_atomicLoad32((volatile uint32_t *)&shmHdr->sequenceNum) != sequenceNum) continue;
+
+        // Consistent - still invalid in case of a size beyond the segment
+        if(snapshotSize > areaSize) return -1;
+        return (int)snapshotSize;
+    }
+
+    logError("readSharedSnapshot(): Retries exceeded");
+    return -1;
+}
+
+
+// -------------------------------------------------------------------------------------------------
+//  API functions
+// -------------------------------------------------------------------------------------------------
+
+void initIDNScanOptions(IDNSL_SCAN_OPTIONS *scanOptions)
+{
+    memset(scanOptions, 0, sizeof(IDNSL_SCAN_OPTIONS));
+
+    scanOptions->clientGroup = 0;
+    scanOptions->groupMask = 0;
+    scanOptions->msTimeout = 500;
+
+    scanOptions->requestRate = 0;
+    scanOptions->requestBurst = 16;
+
+    scanOptions->missedScanLimit = 2;
+
+    scanOptions->quietRTTFactor = 0;
+    scanOptions->msQuietMin = 10;
+
+    scanOptions->retryLimit = 2;
+    scanOptions->msRetryTimeout = 20;
+
+    scanOptions->expectedServers = 0;
+    scanOptions->followUpLimit = 2;
+    scanOptions->msBroadcastWindow = 0;
+
+    scanOptions->workerCount = 0;
+
+    scanOptions->pingCount = 3;
+
+    scanOptions->lazyServiceMap = 0;
+
+    scanOptions->paramRequests = 0;
+    scanOptions->paramWindow = 4;
+
+    scanOptions->scanTargets = (const char *)0;
+    scanOptions->targetRate = 1000;
+    scanOptions->noBroadcast = 0;
+
+    scanOptions->ifInclude = (const char *)0;
+    scanOptions->ifExclude = (const char *)0;
+    scanOptions->ifSubnets = (const char *)0;
+    scanOptions->ifFlagsRequired = 0;
+    scanOptions->ifFlagsExcluded = 0;
+    scanOptions->msIfRefresh = 5000;
+    scanOptions->sharedSocket = 0;
+
+    scanOptions->ip6Scan = 0;
+    scanOptions->ip6Group = (const char *)0;
+
+    scanOptions->traceRecord = (const char *)0;
+    scanOptions->traceLimit = 0x4000000;
+    scanOptions->traceReplay = (const char *)0;
+    scanOptions->traceRealTime = 0;
+}
+
+
+int getIDNServerList(IDNSL_SERVER_INFO **ppFirstServerInfo, uint8_t clientGroup, unsigned msTimeout)
+{
+    IDNSL_SCAN_OPTIONS scanOptions;
+    initIDNScanOptions(&scanOptions);
+    scanOptions.clientGroup = clientGroup;
+    scanOptions.msTimeout = msTimeout;
+
+    return getIDNServerListEx(ppFirstServerInfo, &scanOptions);
+}
+
+
+int getIDNServerListGroups(IDNSL_SERVER_INFO **ppFirstServerInfo, uint16_t groupMask, unsigned msTimeout)
+{
+    // Validate/Initialize result argument, at least one group is scanned
+    if(ppFirstServerInfo == (IDNSL_SERVER_INFO **)NULL) return -1;
+    *ppFirstServerInfo = (IDNSL_SERVER_INFO *)NULL;
+    if(groupMask == 0) return -1;
+
+    // Checks and service maps on the lowest group of the mask
+    IDNSL_SCAN_OPTIONS scanOptions;
+    initIDNScanOptions(&scanOptions);
+    while((scanOptions.clientGroup < 15) && !(groupMask & (1 << scanOptions.clientGroup))) scanOptions.clientGroup++;
+    scanOptions.groupMask = groupMask;
+    scanOptions.msTimeout = msTimeout;
+
+    return getIDNServerListEx(ppFirstServerInfo, &scanOptions);
+}
+
+
+int getIDNServerListEx(IDNSL_SERVER_INFO **ppFirstServerInfo, const IDNSL_SCAN_OPTIONS *scanOptions)
+{
+    // Validate/Initialize result argument
+    if(ppFirstServerInfo == (IDNSL_SERVER_INFO **)NULL) return -1;
+    *ppFirstServerInfo = (IDNSL_SERVER_INFO *)NULL;
+
+    // Single scan of a temporary session
+    IDNSL_SESSION *session;
+    if(openIDNSession(&session, scanOptions, (const IDNSL_SESSION_CALLBACKS *)NULL)) return -1;
+
+    int result = rescanIDNSession(session);
+    if(result == 0) result = getIDNSessionServerList(session, ppFirstServerInfo);
+
+    closeIDNSession(session);
+    return result;
+}
+
+
+int openIDNSession(IDNSL_SESSION **ppSession, const IDNSL_SCAN_OPTIONS *scanOptions, const IDNSL_SESSION_CALLBACKS *callbacks)
+{
+    // Validate/Initialize result argument
+    if(ppSession == (IDNSL_SESSION **)NULL) return -1;
+    *ppSession = (IDNSL_SESSION *)NULL;
+
+    // Validate options argument (client group, trace record/replay on a single thread)
+    if(scanOptions == (const IDNSL_SCAN_OPTIONS *)NULL) return -1;
+    if(scanOptions->clientGroup > 15) return -1;
+    if(scanOptions->traceRecord && scanOptions->traceReplay) return -1;
+    if((scanOptions->traceRecord || scanOptions->traceReplay) && (scanOptions->workerCount > 1))
+    {
+        logError("Trace record/replay not available for parallel scans");
+        return -1;
+    }
+
+    // Validate monotonic time reference
+    if(plt_validateMonoTime() != 0)
+    {
+        logError("Monotonic time init failed");
+        return -1;
+    }
+
+    // Create the session context
+    SCAN_CONTEXT *scanCtx = createScanContext(scanOptions, callbacks);
+    if(scanCtx == (SCAN_CONTEXT *)0) return -1;
+
+    int result = -1;
+    do
+    {
+        // Replay: Virtual sockets, the interfaces are taken from the trace with each scan
+        if(scanOptions->traceReplay)
+        {
+            if(openTraceReplay(scanCtx, scanOptions->traceReplay)) break;
+        }
+        else
+        {
+            // Walk all interfaces - creating interface structs containing broadcast sockets and state
+            if(plt_ifAddrListVisitor(createInterfaceNode, scanCtx)) break;
+            if(scanOptions->ip6Scan && plt_ifAddr6ListVisitor(createInterfaceNode6, scanCtx)) break;
+            scanCtx->nsIfRefresh = plt_getMonoTimeNS();
+
+            // Parallel scan: Hand the interfaces over to the workers. Single thread: Session sockets
+            if(createWorkers(scanCtx)) break;
+            if((scanCtx->workerCount == 0) && openRequestSockets(scanCtx)) break;
+        }
+
+        // Recording: All datagrams of the session from now on
+        if(scanOptions->traceRecord && openTraceRecord(scanCtx, scanOptions->traceRecord, scanOptions->traceLimit)) break;
+
+        // Scan targets are swept by the session (or by the first worker)
+        SCAN_CONTEXT *targetCtx = scanCtx->workerCount ? scanCtx->workerTable[0] : scanCtx;
+        if(scanOptions->scanTargets && addScanTargets(targetCtx, scanOptions->scanTargets)) break;
+
+        result = 0;
+    }
+    while(0);
+
+    // In case of an error: Release everything created so far
+    if(result != 0)
+    {
+        deleteScanContext(scanCtx);
+        return result;
+    }
+
+    *ppSession = scanCtx;
+    return 0;
+}
+
+
+int rescanIDNSession(IDNSL_SESSION *session)
+{
+    if(session == (IDNSL_SESSION *)NULL) return -1;
+    SCAN_CONTEXT *scanCtx = session;
+    if(scanCtx->scanState != SCANSTATE_IDLE) return -1;
+
+    // Parallel scan: Workers scan their interfaces, results are merged
+    if(scanCtx->workerCount) return rescanWorkers(scanCtx);
+
+    // Find the devices. Known servers are updated in place, lost servers removed afterwards.
+    // Replay: Interfaces and sequence state of the next scan of the trace
+    if(scanCtx->traceReplayFlag ? loadTraceScan(scanCtx) : refreshInterfaces(scanCtx)) return -1;
+    beginScan(scanCtx);
+    if(runScan(scanCtx, scanCtx->scanOptions.msTimeout)) return -1;
+    closeScanStats(scanCtx);
+    updateServerTable(scanCtx);
+
+    return 0;
+}
+
+
+int getIDNSessionServerList(IDNSL_SESSION *session, IDNSL_SERVER_INFO **ppFirstServerInfo)
+{
+    // Validate/Initialize result argument
+    if(ppFirstServerInfo == (IDNSL_SERVER_INFO **)NULL) return -1;
+    *ppFirstServerInfo = (IDNSL_SERVER_INFO *)NULL;
+    if(session == (IDNSL_SESSION *)NULL) return -1;
+
+    // Copy the server table (or the merged worker tables) into a single memory block
+    IDNSL_SERVER_INFO *firstServerInfo = session->workerCount ? session->mergedServerInfo : session->firstServerInfo;
+    if(firstServerInfo == (IDNSL_SERVER_INFO *)0) return 0;
+
+    *ppFirstServerInfo = packServerList(firstServerInfo);
+    if(*ppFirstServerInfo == (IDNSL_SERVER_INFO *)0) return -1;
+
+    return 0;
+}
+
+
+int beginIDNSessionScan(IDNSL_SESSION *session)
+{
+    if(session == (IDNSL_SESSION *)NULL) return -1;
+    SCAN_CONTEXT *scanCtx = session;
+
+    // Note: Not available for parallel scans (workers scan on their own threads) and for a trace
+    // replay (no sockets to watch)
+    if(scanCtx->workerCount || scanCtx->traceReplayFlag) return -1;
+    if(scanCtx->scanState != SCANSTATE_IDLE) return -1;
+
+    // Known servers are updated in place (like rescanIDNSession), requests sent on events.
+    // Note: The socket set may change with an interface list update (get the poll FDs again)
+    if(refreshInterfaces(scanCtx)) return -1;
+    beginScan(scanCtx);
+    if(startScan(scanCtx, scanCtx->scanOptions.msTimeout)) return -1;
+
+    scanCtx->scanState = SCANSTATE_ASYNC;
+    return 0;
+}
+
+
+int getIDNSessionPollFDs(IDNSL_SESSION *session, IDNSL_POLL_FD *fdTable, unsigned fdLimit, uint32_t *usTimeout)
+{
+    // Validate/Initialize result argument
+    if(usTimeout == (uint32_t *)NULL) return -1;
+    *usTimeout = 0;
+    if(session == (IDNSL_SESSION *)NULL) return -1;
+    SCAN_CONTEXT *scanCtx = session;
+
+    // Advance timers (retransmissions, pacing). No sockets in case the scan is complete
+    if(scanCtx->scanState != SCANSTATE_ASYNC) return 0;
+
+    int rcStep = stepScan(scanCtx, usTimeout);
+    if(rcStep < 0)
+    {
+        scanCtx->scanState = SCANSTATE_IDLE;
+        return -1;
+    }
+    if(rcStep > 0)
     {
-        logError("scanRsp(%s): Invalid sequence %04X %04X", strRemoteAddr, recvPacketHdr->sequence, sequenceNum);
+        scanCtx->scanState = SCANSTATE_DONE;
         return 0;
     }
 
+    // All sockets of the session with the current interest
+    unsigned fdCount = 0;
+    for(INTERFACE_NODE *ifNode = scanCtx->firstIfNode; ifNode; ifNode = ifNode->next)
+    {
+        if(ifNode->fdSocket >= 0) putPollFD(fdTable, fdLimit, &fdCount, ifNode->fdSocket, ifNode->eventSource.evFlags);
+    }
 
-    // -------------------------------------------------------------------------
-    //  Check scan response header
-    // -------------------------------------------------------------------------
+    REQUEST_QUEUE *checkQueue = &scanCtx->checkRequestQueue, *infoQueue = &scanCtx->infoRequestQueue;
+    putPollFD(fdTable, fdLimit, &fdCount, checkQueue->fdSocket, checkQueue->eventSource.evFlags);
+    putPollFD(fdTable, fdLimit, &fdCount, infoQueue->fdSocket, infoQueue->eventSource.evFlags);
+    if(scanCtx->fdShared >= 0) putPollFD(fdTable, fdLimit, &fdCount, scanCtx->fdShared, scanCtx->sharedSource.evFlags);
 
-    if(payloadLen < sizeof(IDNHDR_SCAN_RESPONSE))
+    return (int)fdCount;
+}
+
+
+int handleIDNSessionReadable(IDNSL_SESSION *session, int fdSocket)
+{
+    if(session == (IDNSL_SESSION *)NULL) return -1;
+
+    // Note: Errors (ICMP unreachable, ...) are reported with the next receive
+    return handleAsyncEvent(session, fdSocket, PLT_EVFLG_READ);
+}
+
+
+int handleIDNSessionWritable(IDNSL_SESSION *session, int fdSocket)
+{
+    if(session == (IDNSL_SESSION *)NULL) return -1;
+
+    return handleAsyncEvent(session, fdSocket, PLT_EVFLG_WRITE);
+}
+
+
+int pollIDNSessionResult(IDNSL_SESSION *session, IDNSL_SERVER_INFO **ppFirstServerInfo)
+{
+    // Validate/Initialize result argument
+    if(ppFirstServerInfo == (IDNSL_SERVER_INFO **)NULL) return -1;
+    *ppFirstServerInfo = (IDNSL_SERVER_INFO *)NULL;
+    if(session == (IDNSL_SESSION *)NULL) return -1;
+    SCAN_CONTEXT *scanCtx = session;
+
+    // Check for timeout/completion (in case the timer of the application fired)
+    if(scanCtx->scanState == SCANSTATE_ASYNC)
+    {
+        uint32_t usWait = 0;
+        int rcStep = stepScan(scanCtx, &usWait);
+        if(rcStep < 0)
+        {
+            scanCtx->scanState = SCANSTATE_IDLE;
+            return -1;
+        }
+        if(rcStep == 0) return 1;
+
+        scanCtx->scanState = SCANSTATE_DONE;
+    }
+    if(scanCtx->scanState != SCANSTATE_DONE) return -1;
+
+    // Scan complete: Remove lost servers, then return a copy of the server table
+    scanCtx->scanState = SCANSTATE_IDLE;
+    closeScanStats(scanCtx);
+    updateServerTable(scanCtx);
+
+    return getIDNSessionServerList(session, ppFirstServerInfo);
+}
+
+
+void closeIDNSession(IDNSL_SESSION *session)
+{
+    if(session == (IDNSL_SESSION *)NULL) return;
+
+    deleteScanContext(session);
+}
+
+
+int getIDNSessionStats(IDNSL_SESSION *session, IDNSL_SCAN_STATS *scanStats)
+{
+    // Validate/Initialize result argument
+    if(scanStats == (IDNSL_SCAN_STATS *)NULL) return -1;
+    memset(scanStats, 0, sizeof(IDNSL_SCAN_STATS));
+    if(session == (IDNSL_SESSION *)NULL) return -1;
+
+    // Statistics of the last completed scan (all zero before the first scan)
+    *scanStats = session->lastScanStats;
+    return 0;
+}
+
+
+int getIDNRelayInfo(const IDNSL_SERVER_INFO *serverInfo, unsigned relayIndex, IDNSL_RELAY_INFO *relayInfo)
+{
+    if(serverInfo == (const IDNSL_SERVER_INFO *)NULL || relayInfo == (IDNSL_RELAY_INFO *)NULL) return -1;
+
+    const IDNSL_SERVICE_MAP *serviceMap = serverInfo->serviceMap;
+    if(serviceMap == (const IDNSL_SERVICE_MAP *)0 || relayIndex >= serviceMap->relayCount) return -1;
+
+    decodeRelayEntry(serviceMap, relayIndex, relayInfo);
+    return 0;
+}
+
+
+int getIDNServiceInfo(const IDNSL_SERVER_INFO *serverInfo, unsigned serviceIndex, IDNSL_SERVICE_INFO *serviceInfo)
+{
+    if(serverInfo == (const IDNSL_SERVER_INFO *)NULL || serviceInfo == (IDNSL_SERVICE_INFO *)NULL) return -1;
+
+    const IDNSL_SERVICE_MAP *serviceMap = serverInfo->serviceMap;
+    if(serviceMap == (const IDNSL_SERVICE_MAP *)0 || serviceIndex >= serviceMap->serviceCount) return -1;
+
+    decodeServiceEntry(serviceMap, serviceIndex, serviceInfo);
+    return 0;
+}
+
+
+int getIDNServiceRelayIndex(const IDNSL_SERVER_INFO *serverInfo, unsigned serviceIndex)
+{
+    if(serverInfo == (const IDNSL_SERVER_INFO *)NULL) return -1;
+
+    const IDNSL_SERVICE_MAP *serviceMap = serverInfo->serviceMap;
+    if(serviceMap == (const IDNSL_SERVICE_MAP *)0 || serviceIndex >= serviceMap->serviceCount) return -1;
+
+    return getServiceRelayTable(serviceMap)[serviceIndex];
+}
+
+
+int getIDNRelayServices(const IDNSL_SERVER_INFO *serverInfo, unsigned relayIndex, const uint8_t **ppServiceIndexTable)
+{
+    // Validate/Initialize result argument
+    if(ppServiceIndexTable == (const uint8_t **)NULL) return -1;
+    *ppServiceIndexTable = (const uint8_t *)NULL;
+    if(serverInfo == (const IDNSL_SERVER_INFO *)NULL) return -1;
+
+    const IDNSL_SERVICE_MAP *serviceMap = serverInfo->serviceMap;
+    if(serviceMap == (const IDNSL_SERVICE_MAP *)0 || relayIndex > serviceMap->relayCount) return -1;
+
+    // The services of a relay are a range of the grouped service index table
+    const uint8_t *relayStartTable = getRelayStartTable(serviceMap);
+    *ppServiceIndexTable = &getRelayServiceTable(serviceMap)[relayStartTable[relayIndex]];
+
+    return relayStartTable[relayIndex + 1] - relayStartTable[relayIndex];
+}
+
+
+int createIDNSnapshot(const IDNSL_SERVER_INFO *firstServerInfo, IDNSL_SNAPSHOT **ppSnapshot)
+{
+    // Validate/Initialize result argument
+    if(ppSnapshot == (IDNSL_SNAPSHOT **)NULL) return -1;
+    *ppSnapshot = (IDNSL_SNAPSHOT *)NULL;
+
+    // Count all items, calculate the layout
+    IDNSL_SNAPSHOT snapshotHdr;
+    memset(&snapshotHdr, 0, sizeof(snapshotHdr));
+    for(const IDNSL_SERVER_INFO *serverInfo = firstServerInfo; serverInfo; serverInfo = serverInfo->next)
     {
-        logError("scanRsp(%s): Invalid response length %u", strRemoteAddr, payloadLen);
-        return 0;
+        // Note: Services/relays without table or service map are skipped
+        int mapFlag = (serverInfo->serviceTable != (IDNSL_SERVICE_INFO *)0) || (serverInfo->serviceMap != (const IDNSL_SERVICE_MAP *)0);
+
+        snapshotHdr.serverCount++;
+        snapshotHdr.addressCount += serverInfo->addressCount;
+        if(mapFlag) snapshotHdr.serviceCount += serverInfo->serviceCount;
+        if(mapFlag) snapshotHdr.relayCount += serverInfo->relayCount;
     }
 
-    IDNHDR_SCAN_RESPONSE *scanRspHdr = (IDNHDR_SCAN_RESPONSE *)payloadPtr;
-    if(scanRspHdr->structSize < sizeof(IDNHDR_SCAN_RESPONSE))
+    snapshotHdr.magic = IDNSL_SNAPSHOT_MAGIC;
+    snapshotHdr.version = IDNSL_SNAPSHOT_VERSION;
+    snapshotHdr.headerSize = (uint16_t)sizeof(IDNSL_SNAPSHOT);
+    size_t snapshotSize = layoutSnapshot(&snapshotHdr);
+    if(snapshotSize > UINT32_MAX) return -1;
+    snapshotHdr.snapshotSize = (uint32_t)snapshotSize;
+
+    // Allocate memory (zeroed, names are padded)
+    uint8_t *snapshotPtr = (uint8_t *)calloc(1, snapshotSize);
+    if(snapshotPtr == (uint8_t *)0)
     {
-        logError("scanRsp(%s): Invalid header size %u", strRemoteAddr, scanRspHdr->structSize);
-        return 0;
+        logError("calloc(IDNSL_SNAPSHOT) failed");
+        return -1;
     }
 
-    if(payloadLen < scanRspHdr->structSize)
+    IDNSL_SNAPSHOT *snapshot = (IDNSL_SNAPSHOT *)snapshotPtr;
+    *snapshot = snapshotHdr;
+
+    uint8_t *unitIDArray = &snapshotPtr[snapshot->unitIDOffset];
+    char *hostNameArray = (char *)&snapshotPtr[snapshot->hostNameOffset];
+    uint32_t *addressStartArray = (uint32_t *)&snapshotPtr[snapshot->addressStartOffset];
+    uint32_t *serviceStartArray = (uint32_t *)&snapshotPtr[snapshot->serviceStartOffset];
+    uint32_t *relayStartArray = (uint32_t *)&snapshotPtr[snapshot->relayStartOffset];
+    IDNSL_NET_ADDRESS *addressArray = (IDNSL_NET_ADDRESS *)&snapshotPtr[snapshot->addressOffset];
+    uint8_t *addressFlagsArray = &snapshotPtr[snapshot->addressFlagsOffset];
+    uint8_t *serviceIDArray = &snapshotPtr[snapshot->serviceIDOffset];
+    uint8_t *serviceTypeArray = &snapshotPtr[snapshot->serviceTypeOffset];
+    uint8_t *serviceFlagsArray = &snapshotPtr[snapshot->serviceFlagsOffset];
+    uint32_t *serviceRelayArray = (uint32_t *)&snapshotPtr[snapshot->serviceRelayOffset];
+    char *serviceNameArray = (char *)&snapshotPtr[snapshot->serviceNameOffset];
+    uint8_t *relayNumberArray = &snapshotPtr[snapshot->relayNumberOffset];
+    uint8_t *relayFlagsArray = &snapshotPtr[snapshot->relayFlagsOffset];
+    char *relayNameArray = (char *)&snapshotPtr[snapshot->relayNameOffset];
+
+    // Fill the arrays (list order)
+    uint32_t serverIndex = 0, addressIndex = 0, serviceIndex = 0, relayIndex = 0;
+    for(const IDNSL_SERVER_INFO *serverInfo = firstServerInfo; serverInfo; serverInfo = serverInfo->next, serverIndex++)
     {
-        logError("scanRsp(%s): Invalid payload length %u %u", strRemoteAddr, payloadLen, scanRspHdr->structSize);
-        return 0;
-    }
+        memcpy(&unitIDArray[serverIndex * IDNSL_UNITID_LENGTH], serverInfo->unitID, IDNSL_UNITID_LENGTH);
+        memcpy(&hostNameArray[serverIndex * IDNSL_HOST_NAME_LENGTH], serverInfo->hostName, IDNSL_HOST_NAME_LENGTH);
 
+        addressStartArray[serverIndex] = addressIndex;
+        serviceStartArray[serverIndex] = serviceIndex;
+        relayStartArray[serverIndex] = relayIndex;
 
-    // -------------------------------------------------------------------------
-    //  Update server info
-    // -------------------------------------------------------------------------
+        for(unsigned i = 0; i < serverInfo->addressCount; i++, addressIndex++)
+        {
+            addressArray[addressIndex] = serverInfo->addressTable[i].netAddr;
+            addressFlagsArray[addressIndex] = (uint8_t)serverInfo->addressTable[i].errorFlags;
+        }
 
-    IDNSL_SERVER_INFO *serverInfo = getServerInfo(scanCtx, scanRspHdr);
-    if(serverInfo == (IDNSL_SERVER_INFO *)0) return -1;
+        if((serverInfo->serviceTable == (IDNSL_SERVICE_INFO *)0) && (serverInfo->serviceMap == (const IDNSL_SERVICE_MAP *)0)) continue;
 
-    // Check for server/responseInfo match
-    int addrIndex;
-    if((responseInfo->serverInfo != (IDNSL_SERVER_INFO *)0) && (responseInfo->serverInfo != serverInfo))
-    {
-        // Pointer mismatch / Different servers on same address - ignore both
-        int addrIndex1 = putAmbiguousAddress(serverInfo, &(recvSockAddr.sin_addr));
-        if(addrIndex1 < 0) return -1;
+        uint32_t firstRelayIndex = relayIndex;
+        for(unsigned i = 0; i < serverInfo->relayCount; i++, relayIndex++)
+        {
+            IDNSL_RELAY_INFO relayInfo;
+            getRelayEntry(serverInfo, i, &relayInfo);
 
-        int addrIndex2 = putAmbiguousAddress(responseInfo->serverInfo, &(recvSockAddr.sin_addr));
-        if(addrIndex2 < 0) return -1;
+            relayNumberArray[relayIndex] = relayInfo.relayNumber;
+            relayFlagsArray[relayIndex] = relayInfo.flags;
+            memcpy(&relayNameArray[relayIndex * IDNSL_RELAY_NAME_LENGTH], relayInfo.relayName, IDNSL_RELAY_NAME_LENGTH);
+        }
 
-        // Set error for response info record, abort in case there is no (error-free) default address
-        // Note: There is at least one address in the address table!
-        responseInfo->ambiguousErrorFlag = 1;
-        if(serverInfo->addressTable[0].errorFlags != 0) return 0;
+        for(unsigned i = 0; i < serverInfo->serviceCount; i++, serviceIndex++)
+        {
+            IDNSL_SERVICE_INFO serviceInfo;
+            unsigned serverRelayIndex;
+            getServiceEntry(serverInfo, i, &serviceInfo, &serverRelayIndex);
+
+            serviceIDArray[serviceIndex] = serviceInfo.serviceID;
+            serviceTypeArray[serviceIndex] = serviceInfo.serviceType;
+            serviceFlagsArray[serviceIndex] = serviceInfo.flags;
+            serviceRelayArray[serviceIndex] = (serverRelayIndex < serverInfo->relayCount) ? firstRelayIndex + serverRelayIndex : IDNSL_SNAPSHOT_NO_RELAY;
+            memcpy(&serviceNameArray[serviceIndex * IDNSL_SERVICE_NAME_LENGTH], serviceInfo.serviceName, IDNSL_SERVICE_NAME_LENGTH);
+        }
+    }
 
-        // Find the info record for the default address
-        // Note: Address order may have shifted because erroneous addresses are moved to the end
-        responseInfo = getResponseInfo(scanCtx, &(serverInfo->addressTable[0].addr));
-        if(responseInfo == (RESPONSE_INFO *)0) return -1;
+    addressStartArray[serverIndex] = addressIndex;
+    serviceStartArray[serverIndex] = serviceIndex;
+    relayStartArray[serverIndex] = relayIndex;
 
-        // Check for info retrieval on default address
-        addrIndex = 0;
-    }
-    else
+    *ppSnapshot = snapshot;
+    return 0;
+}
+
+
+int validateIDNSnapshot(const void *snapshotPtr, size_t snapshotSize)
+{
+    // Check the header
+    if(snapshotPtr == (const void *)NULL || snapshotSize < sizeof(IDNSL_SNAPSHOT)) return -1;
+
+    const IDNSL_SNAPSHOT *snapshot = (const IDNSL_SNAPSHOT *)snapshotPtr;
+    if(snapshot->magic != IDNSL_SNAPSHOT_MAGIC || snapshot->version != IDNSL_SNAPSHOT_VERSION) return -1;
+    if(snapshot->headerSize != sizeof(IDNSL_SNAPSHOT) || snapshot->snapshotSize > snapshotSize) return -1;
+
+    // The layout is implied by the counts (all offsets must match)
+    IDNSL_SNAPSHOT layoutHdr = *snapshot;
+    if((uint64_t)snapshot->serverCount + snapshot->addressCount + snapshot->serviceCount + snapshot->relayCount > snapshotSize) return -1;
+    if(layoutSnapshot(&layoutHdr) != snapshot->snapshotSize) return -1;
+    if(memcmp(&layoutHdr, snapshot, sizeof(IDNSL_SNAPSHOT)) != 0) return -1;
+
+    // Check the ranges (ascending, within the arrays). Relay references within the relay array.
+    const uint32_t *startTable[3] =
     {
-        // Check for new server
-        if(responseInfo->serverInfo == (IDNSL_SERVER_INFO *)0)
+        IDNSL_SNAPSHOT_ARRAY(snapshot, uint32_t, addressStartOffset),
+        IDNSL_SNAPSHOT_ARRAY(snapshot, uint32_t, serviceStartOffset),
+        IDNSL_SNAPSHOT_ARRAY(snapshot, uint32_t, relayStartOffset)
+    };
+    uint32_t itemCount[3] = { snapshot->addressCount, snapshot->serviceCount, snapshot->relayCount };
+    for(unsigned t = 0; t < 3; t++)
+    {
+        if(startTable[t][0] != 0 || startTable[t][snapshot->serverCount] != itemCount[t]) return -1;
+        for(unsigned i = 0; i < snapshot->serverCount; i++)
         {
-            // Link response address info record with server to find misconfigured servers
-            responseInfo->serverInfo = serverInfo;
-
-            // Schedule reachability check. Note: Since broadcasts are sent on 255.255.255.255 
-            // ('this network'), any device (configured correctly or wrong) can send a response.
-            // Depending on IP-Stack and firewall setup this might be received or not. However,
-            // reception does not mean that the device is reachable (there may be no route).
-            if(scheduleCheckRequest(scanCtx, responseInfo)) return -1;
+            if(startTable[t][i] > startTable[t][i + 1]) return -1;
         }
+    }
 
-        // Add/Modify address for broadcast(scan/uncertain) or unicast(checked/reachable) reply
-        if(ifNode) addrIndex = putScannedAddress(serverInfo, &recvSockAddr.sin_addr);
-        else addrIndex = putCheckedAddress(serverInfo, &recvSockAddr.sin_addr);  
-        if(addrIndex < 0) return -1;
+    const uint32_t *serviceRelayArray = IDNSL_SNAPSHOT_ARRAY(snapshot, uint32_t, serviceRelayOffset);
+    for(unsigned i = 0; i < snapshot->serviceCount; i++)
+    {
+        if(serviceRelayArray[i] != IDNSL_SNAPSHOT_NO_RELAY && serviceRelayArray[i] >= snapshot->relayCount) return -1;
     }
 
-    // In case the server got a default address, schedule info requests (if not done yet)
-    // Note: There is at least one address in the address table!
-    if((addrIndex == 0) && (serverInfo->addressTable[0].errorFlags == 0) && (responseInfo->infoRequestFlag == 0))
+    // Addresses are IPv4 or IPv6
+    const IDNSL_NET_ADDRESS *addressArray = IDNSL_SNAPSHOT_ARRAY(snapshot, IDNSL_NET_ADDRESS, addressOffset);
+    for(unsigned i = 0; i < snapshot->addressCount; i++)
     {
-        if(scheduleInfoRequests(scanCtx, responseInfo)) return -1;
-        responseInfo->infoRequestFlag = 1;
+        if(addressArray[i].family != AF_INET && addressArray[i].family != AF_INET6) return -1;
     }
 
     return 0;
 }
 
 
-// -------------------------------------------------------------------------------------------------
-// -------------------------------------------------------------------------------------------------
-
-
-static int runScan(SCAN_CONTEXT *scanCtx, unsigned msTimeout)
+int createIDNQueryIndex(const IDNSL_SERVER_INFO *firstServerInfo, IDNSL_QUERY_INDEX **ppQueryIndex)
 {
-    // File descriptor sets
-    fd_set rfdsPrm, wfdsPrm;
-    FD_ZERO(&rfdsPrm);
-    FD_ZERO(&wfdsPrm);
-    int maxSocket = 0;
+    // Validate/Initialize result argument
+    if(ppQueryIndex == (IDNSL_QUERY_INDEX **)NULL) return -1;
+    *ppQueryIndex = (IDNSL_QUERY_INDEX *)NULL;
 
-    // Add interface broadcast socket descriptors
-    for(INTERFACE_NODE *ifNode = scanCtx->firstIfNode; ifNode; ifNode = ifNode->next) 
+    // Count servers and services (services without table or service map are skipped)
+    unsigned serverCount = 0, entryCount = 0;
+    for(const IDNSL_SERVER_INFO *serverInfo = firstServerInfo; serverInfo; serverInfo = serverInfo->next)
     {
-        FD_SET(ifNode->fdSocket, &wfdsPrm);
-        FD_SET(ifNode->fdSocket, &rfdsPrm);
-        if(ifNode->fdSocket > maxSocket) maxSocket = ifNode->fdSocket;
+        serverCount++;
+        if(serverInfo->serviceTable || serverInfo->serviceMap) entryCount += serverInfo->serviceCount;
     }
 
-    // Add reachability check socket descriptor
-    FD_SET(scanCtx->checkRequestQueue.fdSocket, &wfdsPrm);
-    FD_SET(scanCtx->checkRequestQueue.fdSocket, &rfdsPrm);
-    if(scanCtx->checkRequestQueue.fdSocket > maxSocket) maxSocket = scanCtx->checkRequestQueue.fdSocket;
-
-    // Add device info socket descriptor
-    FD_SET(scanCtx->infoRequestQueue.fdSocket, &wfdsPrm);
-    FD_SET(scanCtx->infoRequestQueue.fdSocket, &rfdsPrm);
-    if(scanCtx->infoRequestQueue.fdSocket > maxSocket) maxSocket = scanCtx->infoRequestQueue.fdSocket;
-
-    // Remember start time
-    uint32_t usStart = plt_getMonoTimeUS();
-
-    // Send requests, receive replies
-    while(1)
+    // Allocate all tables as a single block
+    size_t indexSize = ALIGN_SIZE(sizeof(IDNSL_QUERY_INDEX), ARENA_ALIGN);
+    size_t serverOffset = indexSize;
+    indexSize += ALIGN_SIZE(serverCount * sizeof(QUERY_SERVER), ARENA_ALIGN);
+    size_t entryOffset = indexSize;
+    indexSize += ALIGN_SIZE(entryCount * sizeof(QUERY_ENTRY), ARENA_ALIGN);
+    size_t unitIDOffset = indexSize;
+    indexSize += 2 * serverCount * sizeof(QUERY_SERVER *);
+    size_t typeOffset = indexSize;
+    indexSize += 2 * entryCount * sizeof(QUERY_ENTRY *);
+
+    uint8_t *indexPtr = (uint8_t *)calloc(1, indexSize);
+    if(indexPtr == (uint8_t *)0)
     {
-        // Calculate time left
-        uint32_t usNow = plt_getMonoTimeUS();
-        uint32_t usElapsed = usNow - usStart;
-        uint32_t usLeft = (msTimeout * 1000) - usElapsed;
-        if((int32_t)usLeft <= 0) break;
-
-        // Populate select timeout
-        struct timeval tv;
-        tv.tv_sec = usLeft / 1000000;
-        tv.tv_usec = usLeft % 1000000;
-
-        // Get writability and readability on sockets. On timeout just terminate the loop
-        fd_set rfdsResult = rfdsPrm, wfdsResult = wfdsPrm;
-        int numReady = select(maxSocket + 1, &rfdsResult, &wfdsResult, 0, &tv);
-        if(numReady < 0)
-        {
-            logError("select() failed (error: %d)", plt_sockGetLastError());
-            return -1;
-        }
-        else if(numReady == 0)
-        {
-            // Timeout - no packets received, no more packets to send
-            break;
-        }
+        logError("calloc(IDNSL_QUERY_INDEX) failed");
+        return -1;
+    }
 
-        // -------------------------------------------------------------------------
+    IDNSL_QUERY_INDEX *queryIndex = (IDNSL_QUERY_INDEX *)indexPtr;
+    queryIndex->serverCount = serverCount;
+    queryIndex->entryCount = entryCount;
+    queryIndex->serverTable = (QUERY_SERVER *)&indexPtr[serverOffset];
+    queryIndex->entryTable = (QUERY_ENTRY *)&indexPtr[entryOffset];
+    queryIndex->unitIDTable = (QUERY_SERVER **)&indexPtr[unitIDOffset];
+    queryIndex->hostTable = &queryIndex->unitIDTable[serverCount];
+    queryIndex->typeTable = (QUERY_ENTRY **)&indexPtr[typeOffset];
+    queryIndex->nameTable = &queryIndex->typeTable[entryCount];
+
+    // Fill the tables (list order), then sort the index tables
+    unsigned serverIndex = 0, entryIndex = 0;
+    for(const IDNSL_SERVER_INFO *serverInfo = firstServerInfo; serverInfo; serverInfo = serverInfo->next, serverIndex++)
+    {
+        QUERY_SERVER *queryServer = &queryIndex->serverTable[serverIndex];
+        queryServer->serverInfo = serverInfo;
+        queryServer->entryStart = entryIndex;
+        queryIndex->unitIDTable[serverIndex] = queryIndex->hostTable[serverIndex] = queryServer;
 
-        // Check broadcast/discovery sockets
-        for(INTERFACE_NODE *ifNode = scanCtx->firstIfNode; ifNode; ifNode = ifNode->next) 
+        if(!serverInfo->serviceTable && !serverInfo->serviceMap) continue;
+        for(unsigned i = 0; i < serverInfo->serviceCount; i++, entryIndex++)
         {
-            if(FD_ISSET(ifNode->fdSocket, &wfdsResult))
-            {
-                FD_CLR(ifNode->fdSocket, &wfdsPrm);
-                if(sendBroadcastRequest(scanCtx, ifNode)) return -1;
-            }
+            QUERY_ENTRY *queryEntry = &queryIndex->entryTable[entryIndex];
+            unsigned relayIndex;
+            queryEntry->serverInfo = serverInfo;
+            getServiceEntry(serverInfo, i, &queryEntry->serviceInfo, &relayIndex);
+            queryIndex->typeTable[entryIndex] = queryIndex->nameTable[entryIndex] = queryEntry;
+        }
+        queryServer->entryCount = entryIndex - queryServer->entryStart;
+    }
 
-            if(FD_ISSET(ifNode->fdSocket, &rfdsResult))
-            {
-                if(recvScanResponse(scanCtx, ifNode)) return -1;
+    qsort(queryIndex->unitIDTable, serverCount, sizeof(QUERY_SERVER *), orderByUnitID);
+    qsort(queryIndex->hostTable, serverCount, sizeof(QUERY_SERVER *), orderByHostName);
+    qsort(queryIndex->typeTable, entryCount, sizeof(QUERY_ENTRY *), orderByServiceType);
+    qsort(queryIndex->nameTable, entryCount, sizeof(QUERY_ENTRY *), orderByServiceName);
 
-                // In case of pending check requests: Set socket write interest
-                if(scanCtx->checkRequestQueue.firstRequest != (REQUEST_JOB *)0)
-                {
-                    FD_SET(scanCtx->checkRequestQueue.fdSocket, &wfdsPrm);
-                }
+    *ppQueryIndex = queryIndex;
+    return 0;
+}
 
-                // In case of pending info requests: Set socket write interest
-                if(scanCtx->infoRequestQueue.firstRequest != (REQUEST_JOB *)0)
-                {
-                    FD_SET(scanCtx->infoRequestQueue.fdSocket, &wfdsPrm);
-                }
-            }
-        }
 
-        // -------------------------------------------------------------------------
+int queryIDNServices(const IDNSL_QUERY_INDEX *queryIndex, const IDNSL_QUERY *query, IDNSL_QUERY_RESULT *resultTable, unsigned resultLimit)
+{
+    if(queryIndex == (const IDNSL_QUERY_INDEX *)NULL || query == (const IDNSL_QUERY *)NULL) return -1;
+    if(resultTable == (IDNSL_QUERY_RESULT *)NULL && resultLimit) return -1;
+    if((query->queryFlags & IDNSL_QUERY_SERVICE_NAME) && (query->serviceName == (const char *)NULL)) return -1;
+    if((query->queryFlags & IDNSL_QUERY_HOST_NAME) && (query->hostName == (const char *)NULL)) return -1;
+    if((query->queryFlags & IDNSL_QUERY_UNITID) && (query->unitID == (const uint8_t *)NULL)) return -1;
+    if(resultLimit == 0) return 0;
+
+    // Range of each indexed criterion, the smallest one is walked (the others are filtered)
+    int prefixFlag = (query->queryFlags & IDNSL_QUERY_PREFIX) != 0;
+    unsigned serverStart = 0, serverEnd = queryIndex->serverCount;
+    QUERY_SERVER *const *serverTable = (QUERY_SERVER *const *)0;
+    if(query->queryFlags & IDNSL_QUERY_UNITID)
+    {
+        serverTable = queryIndex->unitIDTable;
+        FIND_RANGE(serverTable, queryIndex->serverCount, compareUnitID(((const QUERY_SERVER *)elem)->serverInfo->unitID, query->unitID), serverStart, serverEnd);
+    }
+    else if(query->queryFlags & IDNSL_QUERY_HOST_NAME)
+    {
+        serverTable = queryIndex->hostTable;
+        FIND_RANGE(serverTable, queryIndex->serverCount, compareNamePrefix(((const QUERY_SERVER *)elem)->serverInfo->hostName, query->hostName, prefixFlag), serverStart, serverEnd);
+    }
 
-        // Check for reachability check socket to be writable (send check requests)
-        if(FD_ISSET(scanCtx->checkRequestQueue.fdSocket, &wfdsResult))
+    unsigned entryStart = 0, entryEnd = queryIndex->entryCount, nameStart = 0, nameEnd = 0, typeStart = 0, typeEnd = 0;
+    QUERY_ENTRY *const *entryTable = (QUERY_ENTRY *const *)0;
+    if(query->queryFlags & IDNSL_QUERY_SERVICE_NAME)
+    {
+        FIND_RANGE(queryIndex->nameTable, queryIndex->entryCount, compareNamePrefix(((const QUERY_ENTRY *)elem)->serviceInfo.serviceName, query->serviceName, prefixFlag), nameStart, nameEnd);
+        entryTable = queryIndex->nameTable;
+        entryStart = nameStart;
+        entryEnd = nameEnd;
+    }
+    if(query->queryFlags & IDNSL_QUERY_SERVICE_TYPE)
+    {
+        FIND_RANGE(queryIndex->typeTable, queryIndex->entryCount, (int)((const QUERY_ENTRY *)elem)->serviceInfo.serviceType - (int)query->serviceType, typeStart, typeEnd);
+        if(!entryTable || ((typeEnd - typeStart) < (entryEnd - entryStart)))
         {
-            if(sendNextRequest(&(scanCtx->checkRequestQueue))) return -1;
-
-            // In case no more check requests are pending: Reset socket write interest
-            if(scanCtx->checkRequestQueue.firstRequest == (REQUEST_JOB *)0)
-            {
-                FD_CLR(scanCtx->checkRequestQueue.fdSocket, &wfdsPrm);
-            }
+            entryTable = queryIndex->typeTable;
+            entryStart = typeStart;
+            entryEnd = typeEnd;
         }
+    }
 
-        // Check for reachability check socket to be readable (receive check responses)
-        if(FD_ISSET(scanCtx->checkRequestQueue.fdSocket, &rfdsResult))
+    // Walk the services of the server range (in case fewer candidates) or the service range
+    unsigned resultCount = 0;
+    if(serverTable)
+    {
+        unsigned candidateCount = 0;
+        for(unsigned i = serverStart; i < serverEnd; i++) candidateCount += serverTable[i]->entryCount;
+        if(!entryTable || (candidateCount < (entryEnd - entryStart)))
         {
-            if(recvScanResponse(scanCtx, (INTERFACE_NODE *)0)) return -1;
-
-            // In case of pending info requests: Set socket write interest
-            if(scanCtx->infoRequestQueue.firstRequest != (REQUEST_JOB *)0)
+            for(unsigned i = serverStart; i < serverEnd; i++)
             {
-                FD_SET(scanCtx->infoRequestQueue.fdSocket, &wfdsPrm);
+                const QUERY_SERVER *queryServer = serverTable[i];
+                for(unsigned j = 0; j < queryServer->entryCount; j++)
+                {
+                    const QUERY_ENTRY *queryEntry = &queryIndex->entryTable[queryServer->entryStart + j];
+                    if(putQueryResult(queryEntry, query, resultTable, resultLimit, &resultCount)) return (int)resultCount;
+                }
             }
+            return (int)resultCount;
         }
+    }
 
-        // -------------------------------------------------------------------------
+    for(unsigned i = entryStart; i < entryEnd; i++)
+    {
+        const QUERY_ENTRY *queryEntry = entryTable ? entryTable[i] : &queryIndex->entryTable[i];
+        if(putQueryResult(queryEntry, query, resultTable, resultLimit, &resultCount)) break;
+    }
 
-        // Check for device info socket to be writable (send info requests)
-        if(FD_ISSET(scanCtx->infoRequestQueue.fdSocket, &wfdsResult))
-        {
-            if(sendNextRequest(&(scanCtx->infoRequestQueue))) return -1;
+    return (int)resultCount;
+}
 
-            // In case no more info requests are pending: Reset socket write interest
-            if(scanCtx->infoRequestQueue.firstRequest == (REQUEST_JOB *)0)
-            {
-                FD_CLR(scanCtx->infoRequestQueue.fdSocket, &wfdsPrm);
-            }
-        }
 
-        // Check for device info socket to be readable (receive info responses)
-        if(FD_ISSET(scanCtx->infoRequestQueue.fdSocket, &rfdsResult))
-        {
-            if(recvInfoResponse(scanCtx)) return -1;
-        }
-    }
+const IDNSL_SERVER_INFO *findIDNServer(const IDNSL_QUERY_INDEX *queryIndex, const uint8_t *unitID)
+{
+    if(queryIndex == (const IDNSL_QUERY_INDEX *)NULL || unitID == (const uint8_t *)NULL) return (const IDNSL_SERVER_INFO *)NULL;
 
-    return 0;
-}
+    unsigned rangeStart, rangeEnd;
+    FIND_RANGE(queryIndex->unitIDTable, queryIndex->serverCount, compareUnitID(((const QUERY_SERVER *)elem)->serverInfo->unitID, unitID), rangeStart, rangeEnd);
+    if(rangeStart == rangeEnd) return (const IDNSL_SERVER_INFO *)NULL;
 
+    return queryIndex->unitIDTable[rangeStart]->serverInfo;
+}
 
-// -------------------------------------------------------------------------------------------------
-//  API functions
-// -------------------------------------------------------------------------------------------------
 
-int getIDNServerList(IDNSL_SERVER_INFO **ppFirstServerInfo, uint8_t clientGroup, unsigned msTimeout)
+void freeIDNQueryIndex(IDNSL_QUERY_INDEX *queryIndex)
 {
-    // Validate/Initialize result argument
-    if(ppFirstServerInfo == (IDNSL_SERVER_INFO **)NULL) return -1;
-    *ppFirstServerInfo = (IDNSL_SERVER_INFO *)NULL;
+    // Note: The index is a single memory block
+    free(queryIndex);
+}
 
-    // Validate client group argument
-    if(clientGroup > 15) return -1;
 
-    // Validate monotonic time reference
-    if(plt_validateMonoTime() != 0)
+int saveIDNSessionCache(IDNSL_SESSION *session, const char *fileName)
+{
+    if(session == (IDNSL_SESSION *)NULL || fileName == (const char *)NULL) return -1;
+    SCAN_CONTEXT *scanCtx = session;
+
+    // Note: Not available for parallel scans (no server table of the session)
+    if(scanCtx->workerCount) return -1;
+
+    IDNSL_SNAPSHOT *snapshot;
+    if(createIDNSnapshot(scanCtx->firstServerInfo, &snapshot)) return -1;
+
+    // Header and server records (order of the snapshot = list order)
+    CACHE_HEADER cacheHdr;
+    memset(&cacheHdr, 0, sizeof(cacheHdr));
+    cacheHdr.magic = CACHE_MAGIC;
+    cacheHdr.version = CACHE_VERSION;
+    cacheHdr.headerSize = (uint16_t)sizeof(CACHE_HEADER);
+    cacheHdr.serverCount = snapshot->serverCount;
+    cacheHdr.snapshotOffset = (uint32_t)ALIGN_SIZE(sizeof(CACHE_HEADER) + snapshot->serverCount * sizeof(CACHE_SERVER), 16);
+
+    // Write to a temporary file, then replace the cache file (readers see old or new)
+    char tmpName[1024];
+    int nameLen = snprintf(tmpName, sizeof(tmpName), "%s.tmp", fileName);
+    if(nameLen < 0 || (size_t)nameLen >= sizeof(tmpName))
     {
-        logError("Monotonic time init failed");
+        free(snapshot);
         return -1;
     }
 
-    // Allocate a context to keep variables for this scan. Note: Contains receive packet buffer
-    SCAN_CONTEXT *scanCtx = (SCAN_CONTEXT *)calloc(1, sizeof(SCAN_CONTEXT));
-    if(scanCtx == (SCAN_CONTEXT *)0)
+    FILE *cacheFile = fopen(tmpName, "wb");
+    if(cacheFile == (FILE *)NULL)
     {
-        logError("calloc(SCAN_CONTEXT) failed");
+        logError("fopen(%s) failed", tmpName);
+        free(snapshot);
         return -1;
     }
 
-    // Populate context
-    scanCtx->clientGroup = clientGroup;
+    int writeError = (fwrite(&cacheHdr, sizeof(cacheHdr), 1, cacheFile) != 1);
+    for(IDNSL_SERVER_INFO *serverInfo = scanCtx->firstServerInfo; serverInfo && !writeError; serverInfo = serverInfo->next)
+    {
+        SERVER_NODE *serverNode = (SERVER_NODE *)serverInfo;
+
+        CACHE_SERVER cacheServer;
+        memset(&cacheServer, 0, sizeof(cacheServer));
+        cacheServer.lastSeenTime = serverNode->lastSeenTime;
+        cacheServer.scanStatus = serverNode->scanStatus;
+        cacheServer.serviceMapFlag = (serverInfo->serviceMap != (const IDNSL_SERVICE_MAP *)0);
+        writeError = (fwrite(&cacheServer, sizeof(cacheServer), 1, cacheFile) != 1);
+    }
 
+    static const uint8_t padding[16] = { 0 };
+    size_t padSize = cacheHdr.snapshotOffset - (sizeof(CACHE_HEADER) + snapshot->serverCount * sizeof(CACHE_SERVER));
+    if(!writeError && padSize) writeError = (fwrite(padding, padSize, 1, cacheFile) != 1);
+    if(!writeError) writeError = (fwrite(snapshot, snapshot->snapshotSize, 1, cacheFile) != 1);
+    if(fclose(cacheFile) != 0) writeError = 1;
+    free(snapshot);
 
-    // -------------------------------------------------------------------------
-    //  Run the scan
-    // -------------------------------------------------------------------------
+    if(writeError || plt_fileReplace(tmpName, fileName))
+    {
+        logError("saveIDNSessionCache(%s) failed (error: %d)", fileName, plt_sockGetLastError());
+        remove(tmpName);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+int loadIDNSessionCache(IDNSL_SESSION *session, const char *fileName, unsigned secMaxAge)
+{
+    if(session == (IDNSL_SESSION *)NULL || fileName == (const char *)NULL) return -1;
+    SCAN_CONTEXT *scanCtx = session;
+    if(scanCtx->workerCount || scanCtx->scanState != SCANSTATE_IDLE) return -1;
+
+    // Note: Fails silently in case there is no cache file (yet)
+    PLT_SHARED_MEM fileMap;
+    if(plt_fileMapOpen(&fileMap, fileName)) return -1;
 
     int result = -1;
     do
     {
-        // Get a start sequence number
-        scanCtx->sequenceNum = (uint16_t)clock();
+        // Check the header and the snapshot (the file may be corrupt)
+        const CACHE_HEADER *cacheHdr = (const CACHE_HEADER *)fileMap.mapPtr;
+        if(fileMap.mapSize < sizeof(CACHE_HEADER)) break;
+        if(cacheHdr->magic != CACHE_MAGIC || cacheHdr->version != CACHE_VERSION || cacheHdr->headerSize != sizeof(CACHE_HEADER)) break;
+        if(cacheHdr->snapshotOffset % 16 || cacheHdr->snapshotOffset > fileMap.mapSize) break;
+        if(sizeof(CACHE_HEADER) + (uint64_t)cacheHdr->serverCount * sizeof(CACHE_SERVER) > cacheHdr->snapshotOffset) break;
+
+        const IDNSL_SNAPSHOT *snapshot = (const IDNSL_SNAPSHOT *)((const uint8_t *)fileMap.mapPtr + cacheHdr->snapshotOffset);
+        if(validateIDNSnapshot(snapshot, fileMap.mapSize - cacheHdr->snapshotOffset)) break;
+        if(snapshot->serverCount != cacheHdr->serverCount) break;
+
+        result = loadCachedServers(scanCtx, cacheHdr, snapshot, secMaxAge);
+    }
+    while(0);
 
-        // Walk all interfaces - creating interface structs containing broadcast sockets and state
-        if(plt_ifAddrListVisitor(createInterfaceNode, scanCtx)) break;
+    if(result != 0) logError("loadIDNSessionCache(%s) failed", fileName);
+    plt_sharedMemClose(&fileMap);
+
+    return result;
+}
 
-        // Create unicast socket (for reachability check requests)
-        scanCtx->checkRequestQueue.fdSocket = plt_sockOpen(AF_INET, SOCK_DGRAM, 0);
-        if(scanCtx->checkRequestQueue.fdSocket < 0)
-        {
-            logError("socket() failed (error: %d)", plt_sockGetLastError());
-            break;
-        }
 
-        // Create unicast socket (for device info requests)
-        scanCtx->infoRequestQueue.fdSocket = plt_sockOpen(AF_INET, SOCK_DGRAM, 0);
-        if(scanCtx->infoRequestQueue.fdSocket < 0)
+int verifyIDNSession(IDNSL_SESSION *session)
+{
+    if(session == (IDNSL_SESSION *)NULL) return -1;
+    SCAN_CONTEXT *scanCtx = session;
+    if(scanCtx->workerCount || scanCtx->scanState != SCANSTATE_IDLE) return -1;
+
+    // Unicast check of all known addresses (once per address), no broadcast
+    if(scanCtx->traceReplayFlag && loadTraceScan(scanCtx)) return -1;
+    beginScan(scanCtx);
+    for(IDNSL_SERVER_INFO *serverInfo = scanCtx->firstServerInfo; serverInfo; serverInfo = serverInfo->next)
+    {
+        for(unsigned i = 0; i < serverInfo->addressCount; i++)
         {
-            logError("socket() failed (error: %d)", plt_sockGetLastError());
-            break;
+            RESPONSE_INFO *responseInfo = getResponseInfo(scanCtx, &serverInfo->addressTable[i].netAddr);
+            if(responseInfo == (RESPONSE_INFO *)0) return -1;
+            if(responseInfo->checkPendingFlag) continue;
+
+            if(scheduleCheckRequest(scanCtx, responseInfo)) return -1;
         }
+    }
 
-        // Find the devices
-        if(runScan(scanCtx, msTimeout)) break;
+    scanCtx->verifyScanFlag = 1;
+    int rcScan = runScan(scanCtx, scanCtx->scanOptions.msTimeout);
+    scanCtx->verifyScanFlag = 0;
+    if(rcScan) return -1;
 
-        // Successful - set result
-        *ppFirstServerInfo = scanCtx->firstServerInfo;
-        scanCtx->firstServerInfo = (IDNSL_SERVER_INFO *)0;
-        result = 0;
-    }
-    while(0);
-    
-        
-    // -------------------------------------------------------------------------
-    //  Cleanup
-    // -------------------------------------------------------------------------
+    // Servers without response are dropped (cached servers after a single verify scan)
+    closeScanStats(scanCtx);
+    updateServerTable(scanCtx);
 
-    // Delete interface structs
-    while(scanCtx->firstIfNode)
+    return 0;
+}
+
+
+int openIDNPublisher(IDNSL_PUBLISHER **ppPublisher, const char *memName, size_t memSize)
+{
+    // Validate/Initialize result argument
+    if(ppPublisher == (IDNSL_PUBLISHER **)NULL) return -1;
+    *ppPublisher = (IDNSL_PUBLISHER *)NULL;
+
+    // Validate arguments (name and size)
+    if(memName == (const char *)NULL || strlen(memName) >= sizeof(((IDNSL_PUBLISHER *)0)->memName)) return -1;
+    if(memSize <= SHM_HEADER_SIZE + sizeof(IDNSL_SNAPSHOT) || memSize > INT32_MAX) return -1;
+
+    IDNSL_PUBLISHER *publisher = (IDNSL_PUBLISHER *)calloc(1, sizeof(IDNSL_PUBLISHER));
+    if(publisher == (IDNSL_PUBLISHER *)0)
     {
-        INTERFACE_NODE *ifNode = scanCtx->firstIfNode;
-        LINKOUT_NODE(scanCtx->firstIfNode, scanCtx->lastIfNode, ifNode);
-        deleteInterfaceNode(ifNode);
+        logError("calloc(IDNSL_PUBLISHER) failed");
+        return -1;
     }
+    strcpy(publisher->memName, memName);
 
-    // Delete device response info list
-    while(scanCtx->firstResponseInfo)
+    if(plt_sharedMemCreate(&publisher->sharedMem, memName, memSize))
     {
-        RESPONSE_INFO *responseInfo = scanCtx->firstResponseInfo;
-        LINKOUT_NODE(scanCtx->firstResponseInfo, scanCtx->lastResponseInfo, responseInfo);
-        free(responseInfo);
+        logError("sharedMemCreate(%s) failed (error: %d)", memName, plt_sockGetLastError());
+        free(publisher);
+        return -1;
     }
 
-    // Delete check request list
-    while(scanCtx->checkRequestQueue.firstRequest)
+    // Initialize the segment (magic last, readers check it first)
+    SHM_HEADER *shmHdr = (SHM_HEADER *)publisher->sharedMem.mapPtr;
+    shmHdr->magic = 0;
+    plt_atomicFence();
+    shmHdr->segmentSize = (uint32_t)memSize;
+    shmHdr->snapshotSize = 0;
+    shmHdr->publishCount = 0;
+    plt_atomicStore32(&shmHdr->sequenceNum, 0);
+    plt_atomicStore32(&shmHdr->magic, SHM_MAGIC);
+
+    *ppPublisher = publisher;
+    return 0;
+}
+
+
+int publishIDNServerList(IDNSL_PUBLISHER *publisher, const IDNSL_SERVER_INFO *firstServerInfo)
+{
+    if(publisher == (IDNSL_PUBLISHER *)NULL) return -1;
+
+    IDNSL_SNAPSHOT *snapshot;
+    if(createIDNSnapshot(firstServerInfo, &snapshot)) return -1;
+
+    // The snapshot must fit into the segment (keep the previous snapshot otherwise)
+    SHM_HEADER *shmHdr = (SHM_HEADER *)publisher->sharedMem.mapPtr;
+    if(snapshot->snapshotSize > shmHdr->segmentSize - SHM_HEADER_SIZE)
     {
-        REQUEST_JOB *reqJob = scanCtx->checkRequestQueue.firstRequest;
-        LINKOUT_NODE(scanCtx->checkRequestQueue.firstRequest, scanCtx->checkRequestQueue.lastRequest, reqJob);
-        free(reqJob);
+        logError("publishIDNServerList(): Snapshot size %u exceeds segment", snapshot->snapshotSize);
+        free(snapshot);
+        return -1;
     }
 
-    // Delete info request list
-    while(scanCtx->infoRequestQueue.firstRequest)
+    writeSharedSnapshot(shmHdr, snapshot);
+    free(snapshot);
+
+    return 0;
+}
+
+
+void closeIDNPublisher(IDNSL_PUBLISHER *publisher)
+{
+    if(publisher == (IDNSL_PUBLISHER *)NULL) return;
+
+    if(plt_sharedMemClose(&publisher->sharedMem)) logError("sharedMemClose() failed (error: %d)", plt_sockGetLastError());
+    if(plt_sharedMemRemove(publisher->memName)) logError("sharedMemRemove() failed (error: %d)", plt_sockGetLastError());
+
+    free(publisher);
+}
+
+
+int openIDNReader(IDNSL_READER **ppReader, const char *memName)
+{
+    // Validate/Initialize result argument
+    if(ppReader == (IDNSL_READER **)NULL) return -1;
+    *ppReader = (IDNSL_READER *)NULL;
+    if(memName == (const char *)NULL) return -1;
+
+    IDNSL_READER *reader = (IDNSL_READER *)calloc(1, sizeof(IDNSL_READER));
+    if(reader == (IDNSL_READER *)0)
     {
-        REQUEST_JOB *reqJob = scanCtx->infoRequestQueue.firstRequest;
-        LINKOUT_NODE(scanCtx->infoRequestQueue.firstRequest, scanCtx->infoRequestQueue.lastRequest, reqJob);
-        free(reqJob);
+        logError("calloc(IDNSL_READER) failed");
+        return -1;
     }
 
-    // Close unicast device info socket
-    if(scanCtx->checkRequestQueue.fdSocket >= 0)
+    // Note: Fails silently in case there is no publisher (yet), the caller may retry
+    if(plt_sharedMemOpen(&reader->sharedMem, memName))
     {
-        int fdSocket = scanCtx->checkRequestQueue.fdSocket;
-        if(plt_sockClose(fdSocket)) logError("close() failed (error: %d)", plt_sockGetLastError());
+        free(reader);
+        return -1;
     }
 
-    // Close unicast reachability check socket
-    if(scanCtx->infoRequestQueue.fdSocket >= 0)
+    // Check the segment (initialized, size within the mapping)
+    const SHM_HEADER *shmHdr = (const SHM_HEADER *)reader->sharedMem.mapPtr;
+    if(reader->sharedMem.mapSize < SHM_HEADER_SIZE || plt_atomicLoad32((volatile uint32_t *)&shmHdr->magic) != SHM_MAGIC ||
+       shmHdr->segmentSize < SHM_HEADER_SIZE || shmHdr->segmentSize > reader->sharedMem.mapSize)
     {
-        int fdSocket = scanCtx->infoRequestQueue.fdSocket;
-        if(plt_sockClose(fdSocket)) logError("close() failed (error: %d)", plt_sockGetLastError());
+        logError("openIDNReader(%s): Invalid segment", memName);
+        plt_sharedMemClose(&reader->sharedMem);
+        free(reader);
+        return -1;
     }
 
-    // In case of errors - free device list memory
-    if(scanCtx->firstServerInfo) freeIDNServerList(scanCtx->firstServerInfo);
+    *ppReader = reader;
+    return 0;
+}
 
-    // Free context struct memory
-    free(scanCtx);
 
-    return result;
+uint32_t getIDNPublishCount(IDNSL_READER *reader)
+{
+    if(reader == (IDNSL_READER *)NULL) return 0;
+
+    const SHM_HEADER *shmHdr = (const SHM_HEADER *)reader->sharedMem.mapPtr;
+    return plt_atomicLoad32((volatile uint32_t *)&shmHdr->publishCount);
 }
 
 
-void freeIDNServerList(IDNSL_SERVER_INFO *firstServerInfo)
+int readIDNSnapshot(IDNSL_READER *reader, IDNSL_SNAPSHOT *snapshotBuffer, size_t bufferSize)
 {
-    if(firstServerInfo == (IDNSL_SERVER_INFO *)0) return;
+    if(reader == (IDNSL_READER *)NULL || snapshotBuffer == (IDNSL_SNAPSHOT *)NULL) return -1;
 
-    // Delete server info list
-    while(firstServerInfo)
-    {
-        IDNSL_SERVER_INFO *serverInfo = firstServerInfo;
-        firstServerInfo = firstServerInfo->next;
+    // Consistent copy of the current snapshot
+    int snapshotSize = readSharedSnapshot((const SHM_HEADER *)reader->sharedMem.mapPtr, snapshotBuffer, bufferSize);
+    if(snapshotSize <= 0 || (size_t)snapshotSize > bufferSize) return snapshotSize;
 
-        // Free table memories
-        if(serverInfo->addressTable) free(serverInfo->addressTable);
-        if(serverInfo->serviceTable) free(serverInfo->serviceTable);
-        if(serverInfo->relayTable) free(serverInfo->relayTable);
+    // The copy is private - check once (the layout is trusted afterwards)
+    if(validateIDNSnapshot(snapshotBuffer, (size_t)snapshotSize)) return -1;
 
-        // Free server info struct memory
-        free(serverInfo);
-    }
+    return snapshotSize;
+}
+
+
+void closeIDNReader(IDNSL_READER *reader)
+{
+    if(reader == (IDNSL_READER *)NULL) return;
+
+    if(plt_sharedMemClose(&reader->sharedMem)) logError("sharedMemClose() failed (error: %d)", plt_sockGetLastError());
+    free(reader);
+}
+
+
+void freeIDNServerList(IDNSL_SERVER_INFO *firstServerInfo)
+{
+    if(firstServerInfo == (IDNSL_SERVER_INFO *)0) return;
+
+    // The server info list (including all tables) is a single memory block
+    free(firstServerInfo);
 }
 
@@ -36,16 +36,19 @@
 
 // Standard libraries
 #include <stdint.h>
+#include <stddef.h>
 
 
 // Platform includes
 #if defined(_WIN32) || defined(WIN32)
 
     #include <winsock2.h>
+    #include <ws2tcpip.h>
 
 #else
 
     #include <arpa/inet.h>
+    #include <netinet/in.h>
 
 #endif
 
@@ -61,17 +64,82 @@
 
 #define IDNSL_ADDR_ERRORFLAG_UNREACHABLE    1           // The address has no route
 #define IDNSL_ADDR_ERRORFLAG_AMBIGUOUS      2           // Multiple servers responded on the address
+#define IDNSL_ADDR_ERRORFLAG_UNVERIFIED     4           // The address is from the cache (not checked yet)
+
+#define IDNSL_PARAMREQ_UNIT                 0x01        // Parameter retrieval: Unit parameters
+#define IDNSL_PARAMREQ_LINK                 0x02        // Parameter retrieval: Link parameters
+#define IDNSL_PARAMREQ_SERVICE              0x04        // Parameter retrieval: Parameters of each service
+#define IDNSL_PARAM_WINDOW_MAX              8           // Parameter retrieval: Max. info requests in flight per server
+
+#define IDNSL_IFFLAG_UP                     0x01        // Interface filter: Interface is up
+#define IDNSL_IFFLAG_BROADCAST              0x02        // Interface filter: Interface supports broadcast
+#define IDNSL_IFFLAG_LOOPBACK               0x04        // Interface filter: Loopback interface
+#define IDNSL_IFFLAG_MULTICAST              0x08        // Interface filter: Interface supports multicast (IPv6)
+
+#define IDNSL_REJECT_PORT                   0           // Scan statistics: Sender port is not the IDN-Hello port
+#define IDNSL_REJECT_TRUNCATED              1           // Scan statistics: Datagram exceeds the receive buffer
+#define IDNSL_REJECT_LENGTH                 2           // Scan statistics: Packet/payload length invalid
+#define IDNSL_REJECT_COMMAND                3           // Scan statistics: Unexpected command
+#define IDNSL_REJECT_SEQUENCE               4           // Scan statistics: Sequence number of another (or old) request
+#define IDNSL_REJECT_STRUCTSIZE             5           // Scan statistics: Header/entry struct size mismatch
+#define IDNSL_REJECT_CONTENT                6           // Scan statistics: Invalid field (unitID, service map entries)
+#define IDNSL_REJECT_INTERFACE              7           // Scan statistics: Shared socket, destination is no interface address
+#define IDNSL_REJECT_REASONS                8           // Scan statistics: Number of reject reasons
+
+#define IDNSL_STATS_IF_LIMIT                16          // Scan statistics: Interfaces reported (first n)
+#define IDNSL_STATS_HIST_BUCKETS            16          // Scan statistics: Latency histogram buckets
+#define IDNSL_STATS_HIST_BASE               64          // Scan statistics: Upper bound (us) of the first bucket
+
+#define IDNSL_QUERY_SERVICE_TYPE            0x01        // Query: Services of serviceType
+#define IDNSL_QUERY_SERVICE_NAME            0x02        // Query: Services named serviceName
+#define IDNSL_QUERY_HOST_NAME               0x04        // Query: Services of the hosts named hostName
+#define IDNSL_QUERY_UNITID                  0x08        // Query: Services of the server unitID
+#define IDNSL_QUERY_PREFIX                  0x10        // Query: Names are prefixes (service and host name)
+#define IDNSL_QUERY_REACHABLE               0x20        // Query: Servers with a reachable address only
+
+#define IDNSL_POLL_READ                     0x01        // Async scan: Watch socket for readability
+#define IDNSL_POLL_WRITE                    0x02        // Async scan: Watch socket for writability
+
+#define IDNSL_SNAPSHOT_MAGIC                0x504E5349  // Snapshot: 'ISNP' (host byte order)
+#define IDNSL_SNAPSHOT_VERSION              2           // Snapshot: Layout version
+#define IDNSL_SNAPSHOT_NO_RELAY             0xFFFFFFFF  // Snapshot: Relay index of a root service
+
+// Snapshot: Address of an array (offset from the snapshot start)
+#define IDNSL_SNAPSHOT_ARRAY(snapshot, type, arrayOffset)                                   \
+    ((const type *)((const uint8_t *)(snapshot) + (snapshot)->arrayOffset))
 
 
 // -------------------------------------------------------------------------------------------------
 //  Typedefs
 // -------------------------------------------------------------------------------------------------
 
+typedef struct
+{
+    uint16_t family;                                    // AF_INET or AF_INET6
+    uint16_t reserved;
+    uint32_t scopeID;                                   // IPv6: Interface index of a link-local address (0: none)
+
+    union
+    {
+        struct in_addr ip4;                             // IPv4 address (family AF_INET)
+        struct in6_addr ip6;                            // IPv6 address (family AF_INET6)
+
+    } u;
+
+} IDNSL_NET_ADDRESS;
+
+
 typedef struct
 {
     unsigned errorFlags;
 
-    struct in_addr addr;
+    struct in_addr addr;                                // IPv4 address (0.0.0.0 for IPv6 addresses)
+    IDNSL_NET_ADDRESS netAddr;                          // The address (IPv4 or IPv6)
+
+    unsigned rttSampleCount;                            // Ping responses of the last measurement (0: none)
+    uint32_t usRTTMin;                                  // Min. round trip time (microseconds)
+    uint32_t usRTTAvg;                                  // Average round trip time (microseconds)
+    uint32_t usRTTJitter;                               // Mean difference of consecutive round trip times
 
 } IDNSL_SERVER_ADDRESS;
 
@@ -100,6 +168,26 @@ typedef struct _IDNSL_RELAY_INFO
 } IDNSL_RELAY_INFO;
 
 
+typedef struct
+{
+    uint8_t paramType;                                  // IDNSL_PARAMREQ_UNIT, _LINK or _SERVICE
+    uint8_t serviceID;                                  // Service parameters: The service (0: unit/link)
+    uint8_t validFlag;                                  // Set in case the response was received
+    uint8_t reserved;
+    uint32_t dataLength;                                // Length of the response payload
+    const uint8_t *dataPtr;                             // Response payload as received, null = none
+
+} IDNSL_PARAMETER_INFO;
+
+
+// Shared memory publisher (single writer) and reader of server list snapshots
+typedef struct _IDNSL_PUBLISHER IDNSL_PUBLISHER;
+typedef struct _IDNSL_READER IDNSL_READER;
+
+// Raw service map (validated entries as received, decoded on demand)
+typedef struct _IDNSL_SERVICE_MAP IDNSL_SERVICE_MAP;
+
+
 typedef struct _IDN_SERVER_INFO
 {
     struct _IDN_SERVER_INFO *next;                      // Next server in list
@@ -108,7 +196,7 @@ typedef struct _IDN_SERVER_INFO
     char hostName[IDNSL_HOST_NAME_LENGTH];              // The name of the host (0-terminated)
 
     unsigned addressCount;
-    IDNSL_SERVER_ADDRESS *addressTable;                 // The server addresses (ordered by reachability)
+    IDNSL_SERVER_ADDRESS *addressTable;                 // The server addresses (ordered by reachability, then latency)
 
     unsigned serviceCount;
     IDNSL_SERVICE_INFO *serviceTable;                   // The services, the server provides
@@ -116,16 +204,375 @@ typedef struct _IDN_SERVER_INFO
     unsigned relayCount;
     IDNSL_RELAY_INFO *relayTable;                       // Hidden servers, the server provides a relay for
 
+    const IDNSL_SERVICE_MAP *serviceMap;                // Raw service/relay entries (see accessors), null = none
+
+    unsigned paramCount;
+    IDNSL_PARAMETER_INFO *paramTable;                   // Parameter responses (see paramRequests), null = none
+
+    uint16_t groupMask;                                 // Client groups the server responded to (last scan, bit n: group n)
+    uint16_t excludedMask;                              // Client groups excluded from streaming (IDNFLG_SCAN_STATUS_EXCLUDED)
+
 } IDNSL_SERVER_INFO;
 
 
+typedef struct
+{
+    uint8_t clientGroup;                                // The client group to run on (0..15)
+    uint16_t groupMask;                                 // Multi-group scan: Further client groups broadcast (bit n: group n)
+    unsigned msTimeout;                                 // Scan duration (hard limit)
+
+    unsigned requestRate;                               // Unicast requests per second and interface (0: unlimited)
+    unsigned requestBurst;                              // Requests that may be sent at once (token bucket depth)
+
+    unsigned missedScanLimit;                           // Session rescans without response until a server is dropped
+
+    unsigned quietRTTFactor;                            // Adaptive completion: Quiet period in multiples of the max. RTT (0: off)
+    unsigned msQuietMin;                                // Adaptive completion: Min. quiet period
+
+    unsigned retryLimit;                                // Retransmissions of check/service map requests (0: off)
+    unsigned msRetryTimeout;                            // Initial retransmission timeout (doubled per retry)
+
+    unsigned expectedServers;                           // Receive buffer sizing: Servers per scan (0: as found in the last scan)
+    unsigned followUpLimit;                             // Follow-up broadcasts per interface and scan on kernel drops (0: off)
+    unsigned msBroadcastWindow;                         // Staggered broadcasts: Window the interface broadcasts spread across (0: off)
+
+    unsigned workerCount;                               // Parallel scan: Worker threads, interfaces split (0, 1: off)
+
+    unsigned pingCount;                                 // Ping requests per reachable address and scan (0: off)
+
+    uint8_t lazyServiceMap;                             // Keep raw service maps only (null service/relay tables)
+
+    unsigned paramRequests;                             // Parameters retrieved per server (IDNSL_PARAMREQ_*, 0: off)
+    unsigned paramWindow;                               // Info requests in flight per server (1..IDNSL_PARAM_WINDOW_MAX)
+
+    const char *scanTargets;                            // Unicast/directed scan targets (see below), null = none
+    unsigned targetRate;                                // Scan target requests per second (0: unlimited)
+    uint8_t noBroadcast;                                // Scan targets only (no interface broadcasts)
+
+    const char *ifInclude;                              // Interface names to scan (comma separated globs), null = all
+    const char *ifExclude;                              // Interface names to skip (comma separated globs), null = none
+    const char *ifSubnets;                              // Interface addresses to scan (comma separated a.b.c.d/n), null = all
+    unsigned ifFlagsRequired;                           // Interface flags required (IDNSL_IFFLAG_*)
+    unsigned ifFlagsExcluded;                           // Interface flags rejected (IDNSL_IFFLAG_*)
+    unsigned msIfRefresh;                               // Session: Min. time between interface list updates (0: never)
+    uint8_t sharedSocket;                               // IPv4 interfaces share one broadcast socket (see below)
+
+    uint8_t ip6Scan;                                    // Scan IPv6 interfaces as well (link-local multicast)
+    const char *ip6Group;                               // IPv6 multicast group of the scan request, null = ff02::1
+
+    const char *traceRecord;                            // Record all datagrams into this trace file (see below), null = off
+    unsigned traceLimit;                                // Max. size of the trace file (bytes, mapped at once)
+    const char *traceReplay;                            // Replay this trace file instead of sockets, null = off
+    uint8_t traceRealTime;                              // Replay with the recorded timing (0: as fast as possible)
+
+} IDNSL_SCAN_OPTIONS;
+
+// Multi-group scan: The scan request is broadcast once per group of clientGroup and groupMask
+// (consecutive sequence numbers, the groups of an interface back to back), the responses share
+// the sockets and the server table. Checks, pings and service maps run on clientGroup only (once
+// per server), as do scan targets. The groups each server responded to and excludes are reported
+// with the server info (groupMask/excludedMask, also without groupMask: clientGroup only).
+//
+// Scan targets: Comma separated list of "a.b.c.d" (host), "a.b.c.d/n" (all hosts of the subnet,
+// n >= 16) and "bcast:a.b.c.d/n" (subnet-directed broadcast, crosses routers that forward them).
+// Host responses are reachability checks, broadcast responses are checked like interface scan
+// responses. The list is parsed when the session is opened. Subnets are swept at targetRate, a
+// sweep not covered by msTimeout (number of addresses / targetRate) is continued by the next scan
+// of the session (noted on the first sweep).
+//
+// IPv6: The scan request is sent once per interface (link-local address) to the multicast group,
+// the unicast sockets are dual-stack. The address subnet filter and the scan targets are IPv4
+// only; snapshots (and the cache/shared memory) contain all addresses, family tagged.
+//
+// Latency: Reachable addresses are pinged (pingCount requests per scan, one at a time) and the
+// reachable addresses of a server are ordered by the average round trip time (measured first).
+// The statistics are kept until the address is measured again.
+//
+// Parameters: The unit/link parameters and the parameters of each service (service map order) are
+// requested along with the service map, paramWindow requests in flight per server (retransmitted
+// like the service map request). IDN-Hello parameter payloads are kept as received (the service
+// request carries the service ID). Known servers are requested again once changed or incomplete.
+// Without retransmissions (retryLimit 0), a request without response is given up on its timeout.
+// Requests left at the end of the scan fail (parameter not valid, onParametersReady). Snapshots
+// and the cache do not contain parameters.
+//
+// Receive buffers: Broadcast responses arrive at once. The sockets are sized for expectedServers
+// responses (or the number of servers found so far), grown only. Datagrams dropped by the kernel
+// (receive buffer overflow, SO_RXQ_OVFL) are counted as they are reported by the next datagram of
+// the socket. Drops on a broadcast socket trigger a follow-up broadcast (same sequence number)
+// once the burst had the time to drain, up to followUpLimit per interface and scan. Lost check and
+// info responses are retransmitted anyway.
+//
+// Staggered broadcasts: With msBroadcastWindow, the interface broadcasts are spread across the
+// window instead of sent at once, one jittered slot per interface, ordered by the responses of the
+// previous scan (most first). Responders of early broadcasts are checked and their service maps
+// requested while later broadcasts are still pending. The window counts against the scan timeout.
+//
+// Interface filters are applied before a socket is opened. Sessions keep the interface sockets
+// across scans; an interface list update (see msIfRefresh, at the start of a scan) opens sockets
+// for new interfaces and closes the sockets of vanished ones only.
+//
+// Shared socket: A single unbound IPv4 socket (per worker) sends the broadcast of each interface
+// with the interface address as source (IP_PKTINFO/IP_SENDSRCADDR) and maps the responses to the
+// interface by their destination address. One descriptor and one wakeup for any number of IPv4
+// interfaces. IPv6 interfaces keep their sockets. Note: Without IP_PKTINFO (BSD) the broadcast
+// interface is selected by the source address.
+//
+// Trace record/replay: With traceRecord, every datagram sent or received by the session is
+// appended to a memory-mapped trace file (time, socket role - interface, shared, check or info -
+// addresses and payload), along with the interfaces and the sequence state at the start of each
+// scan. The file is truncated to the records on close; recording stops once traceLimit is reached.
+// With traceReplay, no sockets are opened: Each scan of the session replays the next scan of the
+// trace through the regular receive path (interfaces as recorded, requests not sent). Responses
+// match as long as the requests are issued in the recorded order, which needs the options of the
+// recording (groups, parameters, targets); rejected datagrams are counted as usual. A rescan
+// fails at the end of the trace. Not available for parallel scans (workerCount > 1) and async
+// scans (replay).
+
+
+// Discovery session (sockets and server table are kept between scans)
+typedef struct _IDNSL_SESSION IDNSL_SESSION;
+
+
+// Session event callbacks. Note: Called from within the scan (as soon as the data is received).
+// The info is valid for the duration of the call only, session functions must not be called.
+// Parallel scan: Called by the worker threads (concurrently), per worker found/lost/changed.
+typedef void (* IDNSL_SERVER_PFN)(void *callbackArg, const IDNSL_SERVER_INFO *serverInfo);
+typedef void (* IDNSL_ADDRESS_PFN)(void *callbackArg, const IDNSL_SERVER_INFO *serverInfo, const IDNSL_SERVER_ADDRESS *serverAddr);
+
+typedef struct
+{
+    void *callbackArg;                                  // Passed to all callbacks
+
+    IDNSL_SERVER_PFN onServerFound;                     // First response of a server (session lifetime)
+    IDNSL_ADDRESS_PFN onAddressReachable;               // Reachability of a server address was checked
+    IDNSL_SERVER_PFN onServiceMapReady;                 // The services/relays of a server were received
+    IDNSL_SERVER_PFN onParametersReady;                 // The parameter requests of a server are done (see paramTable)
+    IDNSL_SERVER_PFN onServerChanged;                   // Host name or status of a known server changed
+    IDNSL_SERVER_PFN onServerLost;                      // Server dropped (see missedScanLimit)
+
+} IDNSL_SESSION_CALLBACKS;
+
+
+// Scan statistics (of the last completed scan, see getIDNSessionStats). Latency histograms: Bucket
+// n counts the samples below (IDNSL_STATS_HIST_BASE << n) microseconds that are not counted by a
+// lower bucket, the last bucket counts all others. Latencies are measured from the broadcast the
+// address responded to (addresses found by a unicast scan target are not sampled). Phase times are
+// relative to the scan start (0: no such event).
+typedef struct
+{
+    uint32_t sampleCount;                               // Number of samples
+    uint32_t usMax;                                     // Max. latency
+    uint64_t usSum;                                     // Sum of all samples (average: usSum / sampleCount)
+    uint32_t bucketCount[IDNSL_STATS_HIST_BUCKETS];     // Samples per bucket (not cumulative)
+
+} IDNSL_LATENCY_HISTOGRAM;
+
+
+typedef struct
+{
+    char ifName[40];                                    // Interface name (0-terminated)
+    IDNSL_NET_ADDRESS ifAddr;                           // Interface address
+    uint32_t packetsSent;                               // Broadcast/multicast scan requests
+    uint32_t packetsReceived;                           // Datagrams received on the interface socket
+    uint32_t packetsDropped;                            // Datagrams dropped by the kernel (interface socket)
+    uint32_t followUpCount;                             // Follow-up broadcasts (kernel drops seen)
+
+} IDNSL_IF_STATS;
+
+
+typedef struct
+{
+    uint32_t packetsSent;                               // Requests sent (including retransmissions)
+    uint32_t packetsReceived;                           // Datagrams received on the queue socket
+    uint32_t packetsDropped;                            // Datagrams dropped by the kernel (queue socket)
+    uint32_t retryCount;                                // Retransmissions
+    uint32_t timeoutCount;                              // Requests without response (retransmissions exhausted)
+    uint32_t queueHighWater;                            // Max. number of requests waiting to be sent
+
+} IDNSL_QUEUE_STATS;
+
+
+typedef struct
+{
+    uint32_t usDuration;                                // Scan duration
+    uint32_t usFirstResponse;                           // First broadcast response
+    uint32_t usLastResponse;                            // Last broadcast response
+    uint32_t usLastCheck;                               // Last check response
+    uint32_t usLastServiceMap;                          // Last service map response
+
+    unsigned ifCount;                                   // Number of interfaces scanned (ifStats: up to IDNSL_STATS_IF_LIMIT)
+    IDNSL_IF_STATS ifStats[IDNSL_STATS_IF_LIMIT];       // Per interface counters
+
+    IDNSL_QUEUE_STATS checkQueue;                       // Check/ping/scan target requests (check socket)
+    IDNSL_QUEUE_STATS infoQueue;                        // Service map requests (info socket)
+    uint32_t inflightHighWater;                         // Max. number of requests waiting for a response
+
+    uint32_t recvBufferSize;                            // Receive buffer size requested per socket (bytes)
+    uint32_t packetsDropped;                            // Datagrams dropped by the kernel (all sockets, Linux only)
+
+    uint32_t rejectCount[IDNSL_REJECT_REASONS];         // Datagrams rejected by reason (IDNSL_REJECT_*)
+    uint32_t logSuppressCount;                          // Reject messages not logged (rate limit)
+
+    IDNSL_LATENCY_HISTOGRAM scanLatency;                // Broadcast -> scan response (per address)
+    IDNSL_LATENCY_HISTOGRAM checkLatency;               // Broadcast -> check response (per address)
+    IDNSL_LATENCY_HISTOGRAM serviceMapLatency;          // Broadcast -> service map response (per server)
+
+} IDNSL_SCAN_STATS;
+
+
+// Snapshot of a server list: A single position-independent buffer of parallel arrays (structure
+// of arrays, indexed by server, address, service or relay number). The items of server i are
+// the ranges [start[i], start[i + 1]) of the address/service/relay arrays. Relay indices are
+// global (into the relay arrays). Note: All values in host byte order, addresses (IPv4 and IPv6)
+// as IDNSL_NET_ADDRESS (family tagged, address bytes in network byte order).
+typedef struct
+{
+    uint32_t magic;                                     // IDNSL_SNAPSHOT_MAGIC
+    uint16_t version;                                   // IDNSL_SNAPSHOT_VERSION
+    uint16_t headerSize;                                // sizeof(IDNSL_SNAPSHOT)
+    uint32_t snapshotSize;                              // Size of the snapshot including all arrays
+
+    uint32_t serverCount;                               // Number of servers
+    uint32_t addressCount;                              // Number of addresses (all servers)
+    uint32_t serviceCount;                              // Number of services (all servers)
+    uint32_t relayCount;                                // Number of relays (all servers)
+
+    uint32_t unitIDOffset;                              // uint8_t[serverCount][IDNSL_UNITID_LENGTH]
+    uint32_t hostNameOffset;                            // char[serverCount][IDNSL_HOST_NAME_LENGTH]
+    uint32_t addressStartOffset;                        // uint32_t[serverCount + 1]
+    uint32_t serviceStartOffset;                        // uint32_t[serverCount + 1]
+    uint32_t relayStartOffset;                          // uint32_t[serverCount + 1]
+
+    uint32_t addressOffset;                             // IDNSL_NET_ADDRESS[addressCount]
+    uint32_t addressFlagsOffset;                        // uint8_t[addressCount] (IDNSL_ADDR_ERRORFLAG_*)
+
+    uint32_t serviceIDOffset;                           // uint8_t[serviceCount]
+    uint32_t serviceTypeOffset;                         // uint8_t[serviceCount]
+    uint32_t serviceFlagsOffset;                        // uint8_t[serviceCount]
+    uint32_t serviceRelayOffset;                        // uint32_t[serviceCount] (IDNSL_SNAPSHOT_NO_RELAY: root)
+    uint32_t serviceNameOffset;                         // char[serviceCount][IDNSL_SERVICE_NAME_LENGTH]
+
+    uint32_t relayNumberOffset;                         // uint8_t[relayCount]
+    uint32_t relayFlagsOffset;                          // uint8_t[relayCount]
+    uint32_t relayNameOffset;                           // char[relayCount][IDNSL_RELAY_NAME_LENGTH]
+
+} IDNSL_SNAPSHOT;
+
+
+// Query index over a server list (see createIDNQueryIndex)
+typedef struct _IDNSL_QUERY_INDEX IDNSL_QUERY_INDEX;
+
+typedef struct
+{
+    unsigned queryFlags;                                // Criteria (IDNSL_QUERY_*, all must match, 0: all services)
+    uint8_t serviceType;                                // IDNSL_QUERY_SERVICE_TYPE: The type (IDNVAL_STYPE_*)
+    const char *serviceName;                            // IDNSL_QUERY_SERVICE_NAME: The name (or prefix)
+    const char *hostName;                               // IDNSL_QUERY_HOST_NAME: The name (or prefix)
+    const uint8_t *unitID;                              // IDNSL_QUERY_UNITID: The unitID ([0]: length)
+
+} IDNSL_QUERY;
+
+
+typedef struct
+{
+    const IDNSL_SERVER_INFO *serverInfo;                // The server (of the indexed list)
+    const IDNSL_SERVICE_INFO *serviceInfo;              // The service (copy held by the index)
+    const IDNSL_SERVER_ADDRESS *serverAddr;             // Best address (reachable, lowest latency), null = none
+
+} IDNSL_QUERY_RESULT;
+
+
+typedef struct
+{
+    int fdSocket;                                       // Socket to be watched by the application
+    unsigned evFlags;                                   // Interest (IDNSL_POLL_*)
+
+} IDNSL_POLL_FD;
+
+
 // -------------------------------------------------------------------------------------------------
 //  Prototypes
 // -------------------------------------------------------------------------------------------------
 
+void initIDNScanOptions(IDNSL_SCAN_OPTIONS *scanOptions);
+
 int getIDNServerList(IDNSL_SERVER_INFO **ppFirstServerInfo, uint8_t clientGroup, unsigned msTimeout);
+int getIDNServerListEx(IDNSL_SERVER_INFO **ppFirstServerInfo, const IDNSL_SCAN_OPTIONS *scanOptions);
+
+// Multi-group scan of all groups in groupMask (checks and service maps on the lowest group),
+// an empty groupMask fails (-1)
+int getIDNServerListGroups(IDNSL_SERVER_INFO **ppFirstServerInfo, uint16_t groupMask, unsigned msTimeout);
+
+// Note: The server list is a single memory block - only the list head can be freed
 void freeIDNServerList(IDNSL_SERVER_INFO *firstServerInfo);
 
+// Service map accessors: Entries are decoded from the raw service map on demand (also available
+// without lazyServiceMap). Decoded entries have null relay/service pointers - relations by index.
+// The services of a relay are returned as a table of service indices (relayIndex == relayCount:
+// the root services). The relay index of a root service is relayCount.
+int getIDNRelayInfo(const IDNSL_SERVER_INFO *serverInfo, unsigned relayIndex, IDNSL_RELAY_INFO *relayInfo);
+int getIDNServiceInfo(const IDNSL_SERVER_INFO *serverInfo, unsigned serviceIndex, IDNSL_SERVICE_INFO *serviceInfo);
+int getIDNServiceRelayIndex(const IDNSL_SERVER_INFO *serverInfo, unsigned serviceIndex);
+int getIDNRelayServices(const IDNSL_SERVER_INFO *serverInfo, unsigned relayIndex, const uint8_t **ppServiceIndexTable);
+
+// Snapshot export: The snapshot is a single memory block (free()), to be copied or mapped as is.
+// A snapshot from an untrusted source (file, shared memory) is checked by validateIDNSnapshot().
+int createIDNSnapshot(const IDNSL_SERVER_INFO *firstServerInfo, IDNSL_SNAPSHOT **ppSnapshot);
+int validateIDNSnapshot(const void *snapshotPtr, size_t snapshotSize);
+
+// Query index: Sorted tables over a server list (unitID, host name, service type, service name),
+// a single memory block (freeIDNQueryIndex()) referring to the list - free the list after the
+// index. A query walks the smallest range of the indexed criteria (binary search) and filters
+// the others; the results are ordered by that index (type: list order). Returns the number of
+// results, at most resultLimit. Names are compared case-sensitive (strcmp). Lazy service maps are
+// decoded into the index (service info without relay pointer).
+int createIDNQueryIndex(const IDNSL_SERVER_INFO *firstServerInfo, IDNSL_QUERY_INDEX **ppQueryIndex);
+int queryIDNServices(const IDNSL_QUERY_INDEX *queryIndex, const IDNSL_QUERY *query, IDNSL_QUERY_RESULT *resultTable, unsigned resultLimit);
+const IDNSL_SERVER_INFO *findIDNServer(const IDNSL_QUERY_INDEX *queryIndex, const uint8_t *unitID);
+void freeIDNQueryIndex(IDNSL_QUERY_INDEX *queryIndex);
+
+// Shared memory: The publisher writes snapshots into a named segment (seqlock protected), readers
+// copy the current snapshot without any sockets. readIDNSnapshot() returns the snapshot size,
+// 0 in case nothing was published yet. In case the size exceeds bufferSize, nothing is copied.
+// getIDNPublishCount() changes with each snapshot (no need to copy an unchanged snapshot).
+// Discovery cache: saveIDNSessionCache() saves the server table into a file. Loading adds the
+// servers to the session (unverified addresses, service maps as saved, found events), skipping
+// entries older than secMaxAge seconds (0: any). verifyIDNSession() sends unicast checks to all
+// known addresses (no broadcast) - servers without response, like cached servers, are dropped.
+// Note: Not available with parallel scan workers.
+int saveIDNSessionCache(IDNSL_SESSION *session, const char *fileName);
+int loadIDNSessionCache(IDNSL_SESSION *session, const char *fileName, unsigned secMaxAge);
+int verifyIDNSession(IDNSL_SESSION *session);
+
+int openIDNPublisher(IDNSL_PUBLISHER **ppPublisher, const char *memName, size_t memSize);
+int publishIDNServerList(IDNSL_PUBLISHER *publisher, const IDNSL_SERVER_INFO *firstServerInfo);
+void closeIDNPublisher(IDNSL_PUBLISHER *publisher);
+
+int openIDNReader(IDNSL_READER **ppReader, const char *memName);
+uint32_t getIDNPublishCount(IDNSL_READER *reader);
+int readIDNSnapshot(IDNSL_READER *reader, IDNSL_SNAPSHOT *snapshotBuffer, size_t bufferSize);
+void closeIDNReader(IDNSL_READER *reader);
+
+// Session: Each rescan updates the server table in place (service maps are requested for
+// new and changed servers only). The server list is a copy, to be freed by freeIDNServerList().
+int openIDNSession(IDNSL_SESSION **ppSession, const IDNSL_SCAN_OPTIONS *scanOptions, const IDNSL_SESSION_CALLBACKS *callbacks);
+int rescanIDNSession(IDNSL_SESSION *session);
+int getIDNSessionServerList(IDNSL_SESSION *session, IDNSL_SERVER_INFO **ppFirstServerInfo);
+void closeIDNSession(IDNSL_SESSION *session);
+int getIDNSessionStats(IDNSL_SESSION *session, IDNSL_SCAN_STATS *scanStats);
+
+// Async scan (external event loop, no blocking calls): The application watches the sockets returned
+// by getIDNSessionPollFDs() and passes ready sockets to handleIDNSessionReadable()/Writable(). The
+// interest changes with events - get the sockets (and the time to wait) again after each event.
+// pollIDNSessionResult() returns 1 while the scan is running, 0 and the server list once done.
+// Note: Not available with parallel scan workers.
+int beginIDNSessionScan(IDNSL_SESSION *session);
+int getIDNSessionPollFDs(IDNSL_SESSION *session, IDNSL_POLL_FD *fdTable, unsigned fdLimit, uint32_t *usTimeout);
+int handleIDNSessionReadable(IDNSL_SESSION *session, int fdSocket);
+int handleIDNSessionWritable(IDNSL_SESSION *session, int fdSocket);
+int pollIDNSessionResult(IDNSL_SESSION *session, IDNSL_SERVER_INFO **ppFirstServerInfo);
+
 
 #endif
 
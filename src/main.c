@@ -34,11 +34,14 @@
 #include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
+#include <signal.h>
 
 
 // Platform includes
 #if defined(_WIN32) || defined(WIN32)
 
+    #include <io.h>
+    #include <fcntl.h>
     #include "plt-windows.h"
 
 #else
@@ -53,6 +56,56 @@
 #include "idnServerList.h"
 
 
+// -------------------------------------------------------------------------------------------------
+//  Defines
+// -------------------------------------------------------------------------------------------------
+
+#define DAEMON_SEGMENT_SIZE                 (4 * 1024 * 1024)   // Shared memory for snapshots
+#define DAEMON_CACHE_MAXAGE                 (24 * 60 * 60)      // Max. age of cached servers (seconds)
+
+#define WATCH_FORMAT_JSON                   0                   // Watch mode: Newline delimited JSON
+#define WATCH_FORMAT_BINARY                 1                   // Watch mode: Length-prefixed frames
+#define WATCH_BUFFER_SIZE                   0x10000             // Watch mode: Output buffer
+#define WATCH_FRAME_MAX                     0x4000              // Watch mode: Max. binary frame size
+
+#define WATCH_EVENT_ADDED                   1                   // Watch event: New server (first address)
+#define WATCH_EVENT_CHANGED                 2                   // Watch event: Host name or status changed
+#define WATCH_EVENT_SERVICES                3                   // Watch event: Service map received (new/changed)
+#define WATCH_EVENT_LOST                    4                   // Watch event: Server dropped
+#define WATCH_EVENT_SCAN                    5                   // Watch event: Scan complete
+
+
+// -------------------------------------------------------------------------------------------------
+//  Typedefs
+// -------------------------------------------------------------------------------------------------
+
+// Watch mode output: Events are appended to the buffer, written once per scan (or when full).
+// Binary frames (network byte order): Event type (1), reserved (1), payload length (2), payload.
+// Server events: scan number (4), unitID (IDNSL_UNITID_LENGTH, [0]: length), host name (length
+// byte, characters), address count (1) and per address: family (4/6), error flags (1), average
+// RTT in us (4, 0: not measured), address (4/16); service count (1, services event only) and per
+// service: ID, type, flags, relay number (1 each, 0: root), name (length byte, characters).
+// Scan event: scan number, server count, scan duration in us (4 each).
+typedef struct
+{
+    unsigned format;                                    // WATCH_FORMAT_*
+    uint32_t scanCount;                                 // Number of the current scan
+    unsigned serverCount;                               // Servers in the session table (added - lost)
+    int errorFlag;                                      // Set in case the output failed (closed pipe)
+
+    size_t length;                                      // Bytes in the buffer
+    uint8_t buffer[WATCH_BUFFER_SIZE];
+
+} WATCH_WRITER;
+
+
+// -------------------------------------------------------------------------------------------------
+//  Variables
+// -------------------------------------------------------------------------------------------------
+
+static volatile sig_atomic_t stopFlag = 0;      // Daemon: Set on SIGINT/SIGTERM
+
+
 // -------------------------------------------------------------------------------------------------
 //  Tools
 // -------------------------------------------------------------------------------------------------
@@ -160,23 +213,41 @@ static void logServer(IDNSL_SERVER_INFO *serverInfo)
         if(i == 0) logPtr = bufPrintf(logPtr, logLimit, " at ");
         else logPtr = bufPrintf(logPtr, logLimit, ", ");
 
-        // Convert IP address to string
-        char ifAddrString[20];
-        if(inet_ntop(AF_INET, &addrInfo->addr, ifAddrString, sizeof(ifAddrString)) == (char *)0)
+        // Convert IP address to string (link-local IPv6 addresses with scope)
+        char ifAddrString[64];
+        const IDNSL_NET_ADDRESS *netAddr = &addrInfo->netAddr;
+        if(inet_ntop(netAddr->family, &netAddr->u, ifAddrString, sizeof(ifAddrString)) == (char *)0)
         {
             logError("inet_ntop() failed (error: %d)", plt_sockGetLastError());
             snprintf(ifAddrString, sizeof(ifAddrString), "<error>");
         }
+        else if(netAddr->scopeID)
+        {
+            size_t addrLength = strlen(ifAddrString);
+            snprintf(&ifAddrString[addrLength], sizeof(ifAddrString) - addrLength, "%%%u", (unsigned)netAddr->scopeID);
+        }
 
         // Append address and reachability information
         const char *comment = "";
         if(addrInfo->errorFlags & IDNSL_ADDR_ERRORFLAG_AMBIGUOUS) comment = " (ambiguous)";
         else if(addrInfo->errorFlags & IDNSL_ADDR_ERRORFLAG_UNREACHABLE) comment = " (unreachable)";
         logPtr = bufPrintf(logPtr, logLimit, "%s%s", ifAddrString, comment);
+
+        // Append round trip time (in case measured)
+        if(addrInfo->rttSampleCount && !addrInfo->errorFlags)
+        {
+            logPtr = bufPrintf(logPtr, logLimit, " (rtt %u.%03u ms)", addrInfo->usRTTAvg / 1000, addrInfo->usRTTAvg % 1000);
+        }
     }
 
     // ... and write the server information log line
-    logInfo(logString);
+    logInfo("%s", logString);
+
+    // Multi-group scan (or excluded): The client groups the server responded to and excludes
+    if((serverInfo->groupMask & (serverInfo->groupMask - 1)) || serverInfo->excludedMask)
+    {
+        logInfo("  client groups 0x%04X, excluded 0x%04X", serverInfo->groupMask, serverInfo->excludedMask);
+    }
 
     // ------------------------------------------------------------------------.
 
@@ -212,8 +283,657 @@ static void logServer(IDNSL_SERVER_INFO *serverInfo)
         else logPtr = bufPrintf(logPtr, logLimit, " (0x%02X)", serviceEntry->serviceType);
 
         // ... and write the service log line
-        logInfo(logString);
+        logInfo("%s", logString);
+    }
+
+    // Log the parameter responses (raw payload, the first bytes in hex)
+    for(unsigned i = 0; i < serverInfo->paramCount; i++)
+    {
+        IDNSL_PARAMETER_INFO *paramEntry = &serverInfo->paramTable[i];
+        logPtr = logString;
+
+        if(paramEntry->paramType == IDNSL_PARAMREQ_UNIT) logPtr = bufPrintf(logPtr, logLimit, "  unit params: ");
+        else if(paramEntry->paramType == IDNSL_PARAMREQ_LINK) logPtr = bufPrintf(logPtr, logLimit, "  link params: ");
+        else logPtr = bufPrintf(logPtr, logLimit, "  %3u params: ", paramEntry->serviceID);
+
+        if(!paramEntry->validFlag)
+        {
+            logPtr = bufPrintf(logPtr, logLimit, "<no response>");
+        }
+        else
+        {
+            logPtr = bufPrintf(logPtr, logLimit, "%u bytes", (unsigned)paramEntry->dataLength);
+            for(unsigned j = 0; (j < paramEntry->dataLength) && (j < 16); j++)
+            {
+                logPtr = bufPrintf(logPtr, logLimit, "%s%02X", j ? " " : " - ", paramEntry->dataPtr[j]);
+            }
+        }
+
+        // ... and write the parameter log line
+        logInfo("%s", logString);
+    }
+}
+
+
+// -------------------------------------------------------------------------------------------------
+//  Scan statistics
+// -------------------------------------------------------------------------------------------------
+
+static void logLatency(const char *name, const IDNSL_LATENCY_HISTOGRAM *histogram)
+{
+    char logString[400], *logPtr = logString, *logLimit = &logString[sizeof(logString)];
+
+    uint32_t usAvg = histogram->sampleCount ? (uint32_t)(histogram->usSum / histogram->sampleCount) : 0;
+    logPtr = bufPrintf(logPtr, logLimit, "  %-18s %5u samples, avg %u.%03u ms, max %u.%03u ms", name, histogram->sampleCount,
+                       usAvg / 1000, usAvg % 1000, histogram->usMax / 1000, histogram->usMax % 1000);
+
+    // Non-empty buckets by upper bound (last bucket: all above)
+    for(unsigned i = 0; i < IDNSL_STATS_HIST_BUCKETS; i++)
+    {
+        if(histogram->bucketCount[i] == 0) continue;
+
+        if(i == IDNSL_STATS_HIST_BUCKETS - 1) logPtr = bufPrintf(logPtr, logLimit, ", more: %u", histogram->bucketCount[i]);
+        else logPtr = bufPrintf(logPtr, logLimit, ", <%uus: %u", (unsigned)IDNSL_STATS_HIST_BASE << i, histogram->bucketCount[i]);
+    }
+
+    logInfo("%s", logString);
+}
+
+
+static void logQueueStats(const char *name, const IDNSL_QUEUE_STATS *queueStats)
+{
+    logInfo("  %-18s sent %u, received %u, dropped %u, retries %u, timeouts %u, high-water %u", name, queueStats->packetsSent,
+            queueStats->packetsReceived, queueStats->packetsDropped, queueStats->retryCount, queueStats->timeoutCount,
+            queueStats->queueHighWater);
+}
+
+
+static void logScanStats(const IDNSL_SCAN_STATS *scanStats)
+{
+    logInfo("Scan statistics");
+    logInfo("  %-18s %u.%03u ms (first response %u.%03u, last response %u.%03u, last check %u.%03u, last service map %u.%03u)",
+            "duration", scanStats->usDuration / 1000, scanStats->usDuration % 1000,
+            scanStats->usFirstResponse / 1000, scanStats->usFirstResponse % 1000,
+            scanStats->usLastResponse / 1000, scanStats->usLastResponse % 1000,
+            scanStats->usLastCheck / 1000, scanStats->usLastCheck % 1000,
+            scanStats->usLastServiceMap / 1000, scanStats->usLastServiceMap % 1000);
+
+    for(unsigned i = 0; (i < scanStats->ifCount) && (i < IDNSL_STATS_IF_LIMIT); i++)
+    {
+        const IDNSL_IF_STATS *ifStats = &scanStats->ifStats[i];
+
+        char ifAddrString[64];
+        if(inet_ntop(ifStats->ifAddr.family, &ifStats->ifAddr.u, ifAddrString, sizeof(ifAddrString)) == (char *)0)
+        {
+            snprintf(ifAddrString, sizeof(ifAddrString), "<error>");
+        }
+        logInfo("  if %-15s sent %u (follow-ups %u), received %u, dropped %u (%s)", ifStats->ifName, ifStats->packetsSent,
+                ifStats->followUpCount, ifStats->packetsReceived, ifStats->packetsDropped, ifAddrString);
+    }
+
+    logQueueStats("check queue", &scanStats->checkQueue);
+    logQueueStats("info queue", &scanStats->infoQueue);
+    logInfo("  %-18s %u", "in flight (max)", scanStats->inflightHighWater);
+    logInfo("  %-18s %u kB per socket, %u datagrams dropped by the kernel", "receive buffer", scanStats->recvBufferSize / 1024,
+            scanStats->packetsDropped);
+
+    const uint32_t *rejectCount = scanStats->rejectCount;
+    logInfo("  %-18s port %u, truncated %u, length %u, command %u, sequence %u, struct size %u, content %u, interface %u", "rejected",
+            rejectCount[IDNSL_REJECT_PORT], rejectCount[IDNSL_REJECT_TRUNCATED], rejectCount[IDNSL_REJECT_LENGTH],
+            rejectCount[IDNSL_REJECT_COMMAND], rejectCount[IDNSL_REJECT_SEQUENCE], rejectCount[IDNSL_REJECT_STRUCTSIZE],
+            rejectCount[IDNSL_REJECT_CONTENT], rejectCount[IDNSL_REJECT_INTERFACE]);
+
+    logLatency("scan latency", &scanStats->scanLatency);
+    logLatency("check latency", &scanStats->checkLatency);
+    logLatency("service map", &scanStats->serviceMapLatency);
+}
+
+
+static int runStats(const IDNSL_SCAN_OPTIONS *scanOptions)
+{
+    // Single scan of a session (to get the statistics)
+    IDNSL_SESSION *session = (IDNSL_SESSION *)0;
+    if(openIDNSession(&session, scanOptions, (const IDNSL_SESSION_CALLBACKS *)0))
+    {
+        logError("openIDNSession() failed");
+        return -1;
+    }
+
+    int result = -1;
+    do
+    {
+        IDNSL_SERVER_INFO *firstServerInfo;
+        if(rescanIDNSession(session) || getIDNSessionServerList(session, &firstServerInfo))
+        {
+            logError("Scan failed");
+            break;
+        }
+
+        for(IDNSL_SERVER_INFO *serverInfo = firstServerInfo; serverInfo; serverInfo = serverInfo->next) 
+        {
+            logServer(serverInfo);
+        }
+        freeIDNServerList(firstServerInfo);
+
+        IDNSL_SCAN_STATS scanStats;
+        if(getIDNSessionStats(session, &scanStats)) break;
+        logScanStats(&scanStats);
+
+        result = 0;
+    }
+    while(0);
+
+    closeIDNSession(session);
+
+    return result;
+}
+
+
+// -------------------------------------------------------------------------------------------------
+//  Daemon mode
+// -------------------------------------------------------------------------------------------------
+
+static void stopHandler(int signalNumber)
+{
+    stopFlag = 1;
+}
+
+
+static int runDaemon(const IDNSL_SCAN_OPTIONS *scanOptions, const char *memName, unsigned msInterval, const char *cacheName)
+{
+    IDNSL_SESSION *session = (IDNSL_SESSION *)0;
+    IDNSL_PUBLISHER *publisher = (IDNSL_PUBLISHER *)0;
+
+    signal(SIGINT, stopHandler);
+    signal(SIGTERM, stopHandler);
+
+    int result = -1;
+    do
+    {
+        // The session is kept, rescans are incremental
+        if(openIDNSession(&session, scanOptions, (const IDNSL_SESSION_CALLBACKS *)0))
+        {
+            logError("openIDNSession() failed");
+            break;
+        }
+
+        if(openIDNPublisher(&publisher, memName, DAEMON_SEGMENT_SIZE))
+        {
+            logError("openIDNPublisher(%s) failed", memName);
+            break;
+        }
+
+        logInfo("Publishing to '%s' every %u ms", memName, msInterval);
+
+        // Warm start: Verify the cached servers, publish before the first (full) scan
+        // Note: The verified servers are published at the head of the loop
+        int verifyFlag = 0;
+        if(cacheName && !loadIDNSessionCache(session, cacheName, DAEMON_CACHE_MAXAGE)) verifyFlag = 1;
+
+        unsigned lastCount = (unsigned)-1;
+        while(!stopFlag)
+        {
+            // Rescan, publish a snapshot of the current server table
+            IDNSL_SERVER_INFO *firstServerInfo;
+            int rcScan = verifyFlag ? verifyIDNSession(session) : rescanIDNSession(session);
+            if(rcScan || getIDNSessionServerList(session, &firstServerInfo))
+            {
+                logError("Rescan failed");
+                break;
+            }
+
+            int rcPublish = publishIDNServerList(publisher, firstServerInfo);
+
+            unsigned serverCount = 0;
+            for(IDNSL_SERVER_INFO *serverInfo = firstServerInfo; serverInfo; serverInfo = serverInfo->next) serverCount++;
+            freeIDNServerList(firstServerInfo);
+
+            if(rcPublish) logError("publishIDNServerList() failed");
+            else if(serverCount != lastCount) logInfo("%u servers", serverCount);
+            lastCount = serverCount;
+
+            if(verifyFlag) verifyFlag = 0;
+            else plt_sleepMS(msInterval);
+        }
+
+        result = stopFlag ? 0 : -1;
+
+        // Save the server table for the next start
+        if(cacheName && saveIDNSessionCache(session, cacheName)) logError("saveIDNSessionCache(%s) failed", cacheName);
+    }
+    while(0);
+
+    closeIDNPublisher(publisher);
+    closeIDNSession(session);
+
+    return result;
+}
+
+
+// -------------------------------------------------------------------------------------------------
+//  Discovery cache
+// -------------------------------------------------------------------------------------------------
+
+static int runCached(const IDNSL_SCAN_OPTIONS *scanOptions, const char *cacheName)
+{
+    IDNSL_SESSION *session = (IDNSL_SESSION *)0;
+
+    int result = -1;
+    do
+    {
+        if(openIDNSession(&session, scanOptions, (const IDNSL_SESSION_CALLBACKS *)0))
+        {
+            logError("openIDNSession() failed");
+            break;
+        }
+
+        // Warm start: Verify the cached servers (unicast only), otherwise scan
+        int rcScan;
+        if(!loadIDNSessionCache(session, cacheName, 0)) rcScan = verifyIDNSession(session);
+        else rcScan = rescanIDNSession(session);
+
+        IDNSL_SERVER_INFO *firstServerInfo;
+        if(rcScan || getIDNSessionServerList(session, &firstServerInfo))
+        {
+            logError("Scan failed");
+            break;
+        }
+
+        for(IDNSL_SERVER_INFO *serverInfo = firstServerInfo; serverInfo; serverInfo = serverInfo->next) 
+        {
+            logServer(serverInfo);
+        }
+        freeIDNServerList(firstServerInfo);
+
+        // Full scan (new servers) before saving the server table for the next run
+        if(rescanIDNSession(session))
+        {
+            logError("Rescan failed");
+            break;
+        }
+
+        if(saveIDNSessionCache(session, cacheName))
+        {
+            logError("saveIDNSessionCache(%s) failed", cacheName);
+            break;
+        }
+
+        result = 0;
+    }
+    while(0);
+
+    closeIDNSession(session);
+
+    return result;
+}
+
+
+// -------------------------------------------------------------------------------------------------
+//  Watch mode
+// -------------------------------------------------------------------------------------------------
+
+static void flushWatchWriter(WATCH_WRITER *writer)
+{
+    // One write per scan (or in case the buffer is full) - the consumer reads whole events
+    if(writer->length && (fwrite(writer->buffer, 1, writer->length, stdout) != writer->length)) writer->errorFlag = 1;
+    if(fflush(stdout)) writer->errorFlag = 1;
+    writer->length = 0;
+}
+
+
+static void putBytes(WATCH_WRITER *writer, const void *dataPtr, size_t dataLength)
+{
+    const uint8_t *srcPtr = (const uint8_t *)dataPtr;
+    while(dataLength)
+    {
+        if(writer->length == sizeof(writer->buffer)) flushWatchWriter(writer);
+
+        size_t chunkLength = sizeof(writer->buffer) - writer->length;
+        if(chunkLength > dataLength) chunkLength = dataLength;
+        memcpy(&writer->buffer[writer->length], srcPtr, chunkLength);
+        writer->length += chunkLength;
+        srcPtr += chunkLength;
+        dataLength -= chunkLength;
+    }
+}
+
+
+static void putText(WATCH_WRITER *writer, const char *text)
+{
+    putBytes(writer, text, strlen(text));
+}
+
+
+static void putDecimal(WATCH_WRITER *writer, uint32_t value)
+{
+    char digitBuffer[10], *digitPtr = &digitBuffer[sizeof(digitBuffer)];
+    do { *--digitPtr = (char)('0' + (value % 10)); value /= 10; } while(value);
+    putBytes(writer, digitPtr, &digitBuffer[sizeof(digitBuffer)] - digitPtr);
+}
+
+
+static void putJSONString(WATCH_WRITER *writer, const char *text)
+{
+    // Quoted, with escapes for quotes, backslashes and control characters
+    static const char hexDigits[] = "0123456789abcdef";
+    putBytes(writer, "\"", 1);
+    for(const unsigned char *srcPtr = (const unsigned char *)text; *srcPtr; srcPtr++)
+    {
+        if((*srcPtr == '"') || (*srcPtr == '\\'))
+        {
+            char escape[2] = { '\\', (char)*srcPtr };
+            putBytes(writer, escape, 2);
+        }
+        else if(*srcPtr < 0x20)
+        {
+            char escape[6] = { '\\', 'u', '0', '0', hexDigits[*srcPtr >> 4], hexDigits[*srcPtr & 0x0F] };
+            putBytes(writer, escape, 6);
+        }
+        else putBytes(writer, srcPtr, 1);
+    }
+    putBytes(writer, "\"", 1);
+}
+
+
+static void getUnitIDString(char *unitIDString, const IDNSL_SERVER_INFO *serverInfo)
+{
+    // Category, '-', then the ID (as printed by logServer)
+    static const char hexDigits[] = "0123456789ABCDEF";
+    unsigned unitIDLen = serverInfo->unitID[0];
+    for(unsigned i = 0; i < unitIDLen; i++)
+    {
+        uint8_t idByte = serverInfo->unitID[1 + i];
+        *unitIDString++ = hexDigits[idByte >> 4];
+        *unitIDString++ = hexDigits[idByte & 0x0F];
+        if(i == 0) *unitIDString++ = '-';
     }
+    *unitIDString = '\0';
+}
+
+
+static int getWatchService(const IDNSL_SERVER_INFO *serverInfo, unsigned serviceIndex, IDNSL_SERVICE_INFO *serviceInfo, IDNSL_RELAY_INFO *relayInfo)
+{
+    // Decoded by the accessors (the service table is null with lazyServiceMap). Returns 1 in
+    // case the service refers to a relay, 0 for a root service, -1 on failure.
+    if(getIDNServiceInfo(serverInfo, serviceIndex, serviceInfo)) return -1;
+
+    int relayIndex = getIDNServiceRelayIndex(serverInfo, serviceIndex);
+    if(relayIndex < 0) return -1;
+    return getIDNRelayInfo(serverInfo, (unsigned)relayIndex, relayInfo) ? 0 : 1;
+}
+
+
+static void putJSONEvent(WATCH_WRITER *writer, unsigned eventType, const IDNSL_SERVER_INFO *serverInfo)
+{
+    static const char *eventName[] = { "", "added", "changed", "services", "lost" };
+
+    char unitIDString[2 * IDNSL_UNITID_LENGTH + 2];
+    getUnitIDString(unitIDString, serverInfo);
+
+    putText(writer, "{\"event\":\"");
+    putText(writer, eventName[eventType]);
+    putText(writer, "\",\"scan\":");
+    putDecimal(writer, writer->scanCount);
+    putText(writer, ",\"unitID\":\"");
+    putText(writer, unitIDString);
+    putText(writer, "\",\"host\":");
+    putJSONString(writer, serverInfo->hostName);
+
+    // A lost server has no current addresses/services
+    if(eventType != WATCH_EVENT_LOST)
+    {
+        putText(writer, ",\"addresses\":[");
+        for(unsigned i = 0; i < serverInfo->addressCount; i++)
+        {
+            const IDNSL_SERVER_ADDRESS *serverAddr = &serverInfo->addressTable[i];
+
+            char addrString[64];
+            if(inet_ntop(serverAddr->netAddr.family, &serverAddr->netAddr.u, addrString, sizeof(addrString)) == (char *)0) addrString[0] = '\0';
+
+            putText(writer, i ? ",{\"addr\":\"" : "{\"addr\":\"");
+            putText(writer, addrString);
+            putText(writer, "\",\"errorFlags\":");
+            putDecimal(writer, serverAddr->errorFlags);
+            if(serverAddr->rttSampleCount)
+            {
+                putText(writer, ",\"usRTT\":");
+                putDecimal(writer, serverAddr->usRTTAvg);
+            }
+            putText(writer, "}");
+        }
+        putText(writer, "]");
+    }
+
+    if(eventType == WATCH_EVENT_SERVICES)
+    {
+        putText(writer, ",\"services\":[");
+        for(unsigned i = 0; i < serverInfo->serviceCount; i++)
+        {
+            IDNSL_SERVICE_INFO serviceInfo;
+            IDNSL_RELAY_INFO relayInfo;
+            int relayFlag = getWatchService(serverInfo, i, &serviceInfo, &relayInfo);
+            if(relayFlag < 0) break;
+
+            putText(writer, i ? ",{\"id\":" : "{\"id\":");
+            putDecimal(writer, serviceInfo.serviceID);
+            putText(writer, ",\"type\":");
+            putDecimal(writer, serviceInfo.serviceType);
+            putText(writer, ",\"flags\":");
+            putDecimal(writer, serviceInfo.flags);
+            putText(writer, ",\"name\":");
+            putJSONString(writer, serviceInfo.serviceName);
+            if(relayFlag)
+            {
+                putText(writer, ",\"relay\":");
+                putJSONString(writer, relayInfo.relayName);
+            }
+            putText(writer, "}");
+        }
+        putText(writer, "]");
+    }
+
+    putText(writer, "}\n");
+}
+
+
+static uint8_t *putFrameString(uint8_t *framePtr, const char *text)
+{
+    size_t textLength = strlen(text);
+    if(textLength > 255) textLength = 255;
+
+    *framePtr++ = (uint8_t)textLength;
+    memcpy(framePtr, text, textLength);
+    return framePtr + textLength;
+}
+
+
+static uint8_t *putFrameUInt32(uint8_t *framePtr, uint32_t value)
+{
+    framePtr[0] = (uint8_t)(value >> 24);
+    framePtr[1] = (uint8_t)(value >> 16);
+    framePtr[2] = (uint8_t)(value >> 8);
+    framePtr[3] = (uint8_t)value;
+    return framePtr + 4;
+}
+
+
+static void putBinaryEvent(WATCH_WRITER *writer, unsigned eventType, const IDNSL_SERVER_INFO *serverInfo)
+{
+    // Frame: Event type, reserved, payload length (16 bit), payload. Counts are limited to 255
+    // (the frame fits WATCH_FRAME_MAX)
+    uint8_t frameBuffer[WATCH_FRAME_MAX], *framePtr = &frameBuffer[4];
+    framePtr = putFrameUInt32(framePtr, writer->scanCount);
+    memcpy(framePtr, serverInfo->unitID, IDNSL_UNITID_LENGTH);
+    framePtr = putFrameString(framePtr + IDNSL_UNITID_LENGTH, serverInfo->hostName);
+
+    unsigned addrCount = (eventType == WATCH_EVENT_LOST) ? 0 : serverInfo->addressCount;
+    if(addrCount > 255) addrCount = 255;
+    *framePtr++ = (uint8_t)addrCount;
+    for(unsigned i = 0; i < addrCount; i++)
+    {
+        const IDNSL_SERVER_ADDRESS *serverAddr = &serverInfo->addressTable[i];
+        *framePtr++ = (serverAddr->netAddr.family == AF_INET6) ? 6 : 4;
+        *framePtr++ = (uint8_t)serverAddr->errorFlags;
+        framePtr = putFrameUInt32(framePtr, serverAddr->rttSampleCount ? serverAddr->usRTTAvg : 0);
+
+        size_t addrLength = (serverAddr->netAddr.family == AF_INET6) ? sizeof(struct in6_addr) : sizeof(struct in_addr);
+        memcpy(framePtr, &serverAddr->netAddr.u, addrLength);
+        framePtr += addrLength;
+    }
+
+    unsigned serviceCount = (eventType == WATCH_EVENT_SERVICES) ? serverInfo->serviceCount : 0;
+    if(serviceCount > 255) serviceCount = 255;
+    uint8_t *countPtr = framePtr++;
+    for(unsigned i = 0; i < serviceCount; i++)
+    {
+        IDNSL_SERVICE_INFO serviceInfo;
+        IDNSL_RELAY_INFO relayInfo;
+        int relayFlag = getWatchService(serverInfo, i, &serviceInfo, &relayInfo);
+        if(relayFlag < 0) { serviceCount = i; break; }
+
+        *framePtr++ = serviceInfo.serviceID;
+        *framePtr++ = serviceInfo.serviceType;
+        *framePtr++ = serviceInfo.flags;
+        *framePtr++ = relayFlag ? relayInfo.relayNumber : 0;
+        framePtr = putFrameString(framePtr, serviceInfo.serviceName);
+    }
+    *countPtr = (uint8_t)serviceCount;
+
+    size_t payloadLength = framePtr - &frameBuffer[4];
+    frameBuffer[0] = (uint8_t)eventType;
+    frameBuffer[1] = 0;
+    frameBuffer[2] = (uint8_t)(payloadLength >> 8);
+    frameBuffer[3] = (uint8_t)payloadLength;
+    putBytes(writer, frameBuffer, framePtr - frameBuffer);
+}
+
+
+static void putWatchEvent(WATCH_WRITER *writer, unsigned eventType, const IDNSL_SERVER_INFO *serverInfo)
+{
+    // Servers in the table (the server list is not copied per scan)
+    if(eventType == WATCH_EVENT_ADDED) writer->serverCount++;
+    else if(eventType == WATCH_EVENT_LOST) writer->serverCount--;
+
+    if(writer->format == WATCH_FORMAT_BINARY) putBinaryEvent(writer, eventType, serverInfo);
+    else putJSONEvent(writer, eventType, serverInfo);
+}
+
+
+static void putScanEvent(WATCH_WRITER *writer, unsigned serverCount, uint32_t usDuration)
+{
+    // End of a scan: Number of servers in the table, scan duration
+    if(writer->format == WATCH_FORMAT_BINARY)
+    {
+        uint8_t frameBuffer[16];
+        frameBuffer[0] = WATCH_EVENT_SCAN;
+        frameBuffer[1] = frameBuffer[2] = 0;
+        frameBuffer[3] = 12;
+        putFrameUInt32(putFrameUInt32(putFrameUInt32(&frameBuffer[4], writer->scanCount), serverCount), usDuration);
+        putBytes(writer, frameBuffer, sizeof(frameBuffer));
+    }
+    else
+    {
+        putText(writer, "{\"event\":\"scan\",\"scan\":");
+        putDecimal(writer, writer->scanCount);
+        putText(writer, ",\"servers\":");
+        putDecimal(writer, serverCount);
+        putText(writer, ",\"usDuration\":");
+        putDecimal(writer, usDuration);
+        putText(writer, "}\n");
+    }
+}
+
+
+static void onWatchAdded(void *callbackArg, const IDNSL_SERVER_INFO *serverInfo)
+{
+    putWatchEvent((WATCH_WRITER *)callbackArg, WATCH_EVENT_ADDED, serverInfo);
+}
+
+
+static void onWatchChanged(void *callbackArg, const IDNSL_SERVER_INFO *serverInfo)
+{
+    putWatchEvent((WATCH_WRITER *)callbackArg, WATCH_EVENT_CHANGED, serverInfo);
+}
+
+
+static void onWatchServices(void *callbackArg, const IDNSL_SERVER_INFO *serverInfo)
+{
+    putWatchEvent((WATCH_WRITER *)callbackArg, WATCH_EVENT_SERVICES, serverInfo);
+}
+
+
+static void onWatchLost(void *callbackArg, const IDNSL_SERVER_INFO *serverInfo)
+{
+    putWatchEvent((WATCH_WRITER *)callbackArg, WATCH_EVENT_LOST, serverInfo);
+}
+
+
+static int runWatch(const IDNSL_SCAN_OPTIONS *scanOptions, unsigned msInterval, unsigned format)
+{
+    // Events are written by the session callbacks (single thread, see main), flushed once per scan
+    WATCH_WRITER *writer = (WATCH_WRITER *)calloc(1, sizeof(WATCH_WRITER));
+    if(writer == (WATCH_WRITER *)0)
+    {
+        logError("calloc(WATCH_WRITER) failed");
+        return -1;
+    }
+    writer->format = format;
+
+    // A closed pipe ends the watch (write error instead of SIGPIPE)
+#if defined(_WIN32) || defined(WIN32)
+    if(format == WATCH_FORMAT_BINARY) _setmode(_fileno(stdout), _O_BINARY);
+#else
+    signal(SIGPIPE, SIG_IGN);
+#endif
+
+    IDNSL_SESSION_CALLBACKS callbacks;
+    memset(&callbacks, 0, sizeof(callbacks));
+    callbacks.callbackArg = writer;
+    callbacks.onServerFound = onWatchAdded;
+    callbacks.onServerChanged = onWatchChanged;
+    callbacks.onServiceMapReady = onWatchServices;
+    callbacks.onServerLost = onWatchLost;
+
+    signal(SIGINT, stopHandler);
+    signal(SIGTERM, stopHandler);
+
+    IDNSL_SESSION *session = (IDNSL_SESSION *)0;
+    int result = -1;
+    do
+    {
+        if(openIDNSession(&session, scanOptions, &callbacks))
+        {
+            logError("openIDNSession() failed");
+            break;
+        }
+
+        while(!stopFlag && !writer->errorFlag)
+        {
+            writer->scanCount++;
+            if(rescanIDNSession(session))
+            {
+                logError("Rescan failed");
+                break;
+            }
+
+            // Scan marker (the events of the scan are complete)
+            IDNSL_SCAN_STATS scanStats;
+            if(getIDNSessionStats(session, &scanStats)) memset(&scanStats, 0, sizeof(scanStats));
+            putScanEvent(writer, writer->serverCount, scanStats.usDuration);
+            flushWatchWriter(writer);
+
+            plt_sleepMS(msInterval);
+        }
+
+        // Output closed (consumer gone) or stopped
+        result = (stopFlag || writer->errorFlag) ? 0 : -1;
+    }
+    while(0);
+
+    closeIDNSession(session);
+    free(writer);
+
+    return result;
 }
 
 
@@ -223,8 +943,14 @@ static void logServer(IDNSL_SERVER_INFO *serverInfo)
 
 int main(int argc, char **argv)
 {
-    int usageFlag = 0;
-    uint8_t clientGroup = 0;
+    int usageFlag = 0, statsFlag = 0, watchFlag = 0;
+    unsigned msWatchInterval = 0, watchFormat = WATCH_FORMAT_JSON;
+    const char *daemonName = (const char *)0;
+    const char *cacheName = (const char *)0;
+    unsigned msInterval = 1000;
+    unsigned msTimeout = 500;
+    IDNSL_SCAN_OPTIONS scanOptions;
+    initIDNScanOptions(&scanOptions);
 
     for(int i = 1; i < argc; i++)
     {
@@ -233,7 +959,165 @@ int main(int argc, char **argv)
             if(++i >= argc) { usageFlag = 1; break; }
             int param = atoi(argv[i]);
             if((param < 0) || (param >= 16)) { usageFlag = 1; break; }
-            else clientGroup = (uint8_t)param;
+            else scanOptions.clientGroup = (uint8_t)param;
+        }
+        else if(!strcmp(argv[i], "-groups"))
+        {
+            if(++i >= argc) { usageFlag = 1; break; }
+            unsigned long param = strtoul(argv[i], (char **)0, 0);
+            if(param > 0xFFFF) { usageFlag = 1; break; }
+            else scanOptions.groupMask = (uint16_t)param;
+        }
+        else if(!strcmp(argv[i], "-rate"))
+        {
+            if(++i >= argc) { usageFlag = 1; break; }
+            int param = atoi(argv[i]);
+            if(param < 0) { usageFlag = 1; break; }
+            else scanOptions.requestRate = (unsigned)param;
+        }
+        else if(!strcmp(argv[i], "-ping"))
+        {
+            if(++i >= argc) { usageFlag = 1; break; }
+            int param = atoi(argv[i]);
+            if(param < 0) { usageFlag = 1; break; }
+            else scanOptions.pingCount = (unsigned)param;
+        }
+        else if(!strcmp(argv[i], "-quiet"))
+        {
+            if(++i >= argc) { usageFlag = 1; break; }
+            int param = atoi(argv[i]);
+            if(param < 0) { usageFlag = 1; break; }
+            else scanOptions.quietRTTFactor = (unsigned)param;
+        }
+        else if(!strcmp(argv[i], "-workers"))
+        {
+            if(++i >= argc) { usageFlag = 1; break; }
+            int param = atoi(argv[i]);
+            if(param < 0) { usageFlag = 1; break; }
+            else scanOptions.workerCount = (unsigned)param;
+        }
+        else if(!strcmp(argv[i], "-daemon"))
+        {
+            if(++i >= argc) { usageFlag = 1; break; }
+            daemonName = argv[i];
+        }
+        else if(!strcmp(argv[i], "-target"))
+        {
+            if(++i >= argc) { usageFlag = 1; break; }
+            scanOptions.scanTargets = argv[i];
+        }
+        else if(!strcmp(argv[i], "-nobcast"))
+        {
+            scanOptions.noBroadcast = 1;
+        }
+        else if(!strcmp(argv[i], "-if"))
+        {
+            if(++i >= argc) { usageFlag = 1; break; }
+            scanOptions.ifInclude = argv[i];
+        }
+        else if(!strcmp(argv[i], "-xif"))
+        {
+            if(++i >= argc) { usageFlag = 1; break; }
+            scanOptions.ifExclude = argv[i];
+        }
+        else if(!strcmp(argv[i], "-ifnet"))
+        {
+            if(++i >= argc) { usageFlag = 1; break; }
+            scanOptions.ifSubnets = argv[i];
+        }
+        else if(!strcmp(argv[i], "-noloop"))
+        {
+            scanOptions.ifFlagsExcluded |= IDNSL_IFFLAG_LOOPBACK;
+        }
+        else if(!strcmp(argv[i], "-shared"))
+        {
+            scanOptions.sharedSocket = 1;
+        }
+        else if(!strcmp(argv[i], "-expect"))
+        {
+            if(++i >= argc) { usageFlag = 1; break; }
+            int param = atoi(argv[i]);
+            if(param < 0) { usageFlag = 1; break; }
+            else scanOptions.expectedServers = (unsigned)param;
+        }
+        else if(!strcmp(argv[i], "-stagger"))
+        {
+            if(++i >= argc) { usageFlag = 1; break; }
+            int param = atoi(argv[i]);
+            if(param < 0) { usageFlag = 1; break; }
+            else scanOptions.msBroadcastWindow = (unsigned)param;
+        }
+        else if(!strcmp(argv[i], "-params"))
+        {
+            scanOptions.paramRequests = IDNSL_PARAMREQ_UNIT | IDNSL_PARAMREQ_LINK | IDNSL_PARAMREQ_SERVICE;
+        }
+        else if(!strcmp(argv[i], "-window"))
+        {
+            if(++i >= argc) { usageFlag = 1; break; }
+            int param = atoi(argv[i]);
+            if((param < 1) || (param > IDNSL_PARAM_WINDOW_MAX)) { usageFlag = 1; break; }
+            else scanOptions.paramWindow = (unsigned)param;
+        }
+        else if(!strcmp(argv[i], "-stats"))
+        {
+            statsFlag = 1;
+        }
+        else if(!strcmp(argv[i], "-ip6"))
+        {
+            scanOptions.ip6Scan = 1;
+        }
+        else if(!strcmp(argv[i], "-ip6group"))
+        {
+            if(++i >= argc) { usageFlag = 1; break; }
+            scanOptions.ip6Scan = 1;
+            scanOptions.ip6Group = argv[i];
+        }
+        else if(!strcmp(argv[i], "-timeout"))
+        {
+            if(++i >= argc) { usageFlag = 1; break; }
+            int param = atoi(argv[i]);
+            if(param <= 0) { usageFlag = 1; break; }
+            else msTimeout = (unsigned)param;
+        }
+        else if(!strcmp(argv[i], "-cache"))
+        {
+            if(++i >= argc) { usageFlag = 1; break; }
+            cacheName = argv[i];
+        }
+        else if(!strcmp(argv[i], "-watch"))
+        {
+            if(++i >= argc) { usageFlag = 1; break; }
+            int param = atoi(argv[i]);
+            if(param < 0) { usageFlag = 1; break; }
+            else { msWatchInterval = (unsigned)param; watchFlag = 1; }
+        }
+        else if(!strcmp(argv[i], "-format"))
+        {
+            if(++i >= argc) { usageFlag = 1; break; }
+            if(!strcmp(argv[i], "json")) watchFormat = WATCH_FORMAT_JSON;
+            else if(!strcmp(argv[i], "binary")) watchFormat = WATCH_FORMAT_BINARY;
+            else { usageFlag = 1; break; }
+        }
+        else if(!strcmp(argv[i], "-interval"))
+        {
+            if(++i >= argc) { usageFlag = 1; break; }
+            int param = atoi(argv[i]);
+            if(param < 0) { usageFlag = 1; break; }
+            else msInterval = (unsigned)param;
+        }
+        else if(!strcmp(argv[i], "-record"))
+        {
+            if(++i >= argc) { usageFlag = 1; break; }
+            scanOptions.traceRecord = argv[i];
+        }
+        else if(!strcmp(argv[i], "-replay"))
+        {
+            if(++i >= argc) { usageFlag = 1; break; }
+            scanOptions.traceReplay = argv[i];
+        }
+        else if(!strcmp(argv[i], "-realtime"))
+        {
+            scanOptions.traceRealTime = 1;
         }
         else
         {
@@ -242,20 +1126,59 @@ int main(int argc, char **argv)
         }
     }
 
+    // Watch mode: The callbacks write the events (parallel scan workers would call concurrently)
+    if(watchFlag && scanOptions.workerCount > 1) usageFlag = 1;
+
+    // Trace: Record or replay, a single scan thread
+    if(scanOptions.traceRecord && scanOptions.traceReplay) usageFlag = 1;
+    if((scanOptions.traceRecord || scanOptions.traceReplay) && scanOptions.workerCount > 1) usageFlag = 1;
+
     if(usageFlag)
     {
         printf("\n");
         printf("USAGE: serverList { Options } \n\n");
         printf("Options:\n");
         printf("  -cg      clientGroup The client group (0..15, default = 0).\n");
+        printf("  -groups  groupMask   Also broadcast to the client groups in groupMask (e.g. 0xFFFF, one scan).\n");
+        printf("  -rate    requestRate Unicast requests per second and interface (default = 0, unlimited).\n");
+        printf("  -ping    pingCount   Ping requests per reachable address (default = 3, 0 = off).\n");
+        printf("  -quiet   rttFactor   Complete after a quiet period of rttFactor * max. RTT (default = 0, off).\n");
+        printf("  -workers workerCount Parallel scan threads, interfaces split (default = 0, off).\n");
+        printf("  -daemon  memName     Rescan continuously, publish to shared memory segment memName.\n");
+        printf("  -interval msInterval Daemon: Time between rescans (default = 1000).\n");
+        printf("  -cache   fileName    Start with the servers of the last run, save the servers on exit.\n");
+        printf("  -watch   msInterval  Rescan continuously, print added/changed/lost servers (no workers).\n");
+        printf("  -format  json|binary Watch: Newline delimited JSON (default) or length-prefixed frames.\n");
+        printf("  -target  targetList  Scan hosts/subnets (a.b.c.d[/n]) and directed broadcasts (bcast:a.b.c.d/n).\n");
+        printf("  -nobcast             Scan the targets only (no interface broadcasts).\n");
+        printf("  -timeout msTimeout   Scan duration (default = 500).\n");
+        printf("  -if      ifGlobs     Scan the named interfaces only (comma separated, '*' and '?' wildcards).\n");
+        printf("  -xif     ifGlobs     Skip the named interfaces (e.g. veth*,docker*).\n");
+        printf("  -ifnet   subnetList  Scan interfaces with an address in the subnets only (a.b.c.d/n).\n");
+        printf("  -noloop              Skip loopback interfaces.\n");
+        printf("  -shared              Broadcast on all IPv4 interfaces through a single socket.\n");
+        printf("  -expect  serverCount Size the receive buffers for serverCount responses (default = as found).\n");
+        printf("  -stagger msWindow    Spread the interface broadcasts across msWindow (default = 0, at once).\n");
+        printf("  -ip6                 Also scan IPv6 (link-local multicast, default group ff02::1).\n");
+        printf("  -ip6group groupAddr  IPv6 scan using the multicast group groupAddr.\n");
+        printf("  -params              Also retrieve the unit, link and service parameters of each server.\n");
+        printf("  -window  windowSize  Parameter requests in flight per server (1..%u, default = 4).\n", IDNSL_PARAM_WINDOW_MAX);
+        printf("  -stats               Print the scan statistics (counters, rejects, latency histograms).\n");
+        printf("  -record  fileName    Record the datagrams of all scans into the trace file fileName (no workers).\n");
+        printf("  -replay  fileName    Scan by replaying the trace file fileName instead of the network.\n");
+        printf("  -realtime            Replay: With the recorded timing (default = as fast as possible).\n");
         printf("\n");
 
         return 0;
     }
 
 
-    logInfo("IDN server list");
-    logInfo("------------------------------------------------------------");
+    // Watch mode: Only events are written to stdout
+    if(!watchFlag)
+    {
+        logInfo("IDN server list");
+        logInfo("------------------------------------------------------------");
+    }
 
     do
     {
@@ -267,13 +1190,41 @@ int main(int argc, char **argv)
             break;
         }
 
+        // Daemon mode: Publish the server table until stopped
+        scanOptions.msTimeout = msTimeout;
+        if(daemonName)
+        {
+            if(runDaemon(&scanOptions, daemonName, msInterval, cacheName)) logError("Daemon failed");
+            break;
+        }
+
+        // Watch mode: Stream the server events until stopped
+        if(watchFlag)
+        {
+            if(runWatch(&scanOptions, msWatchInterval, watchFormat)) logError("Watch failed");
+            break;
+        }
+
+        // Discovery cache: Warm start with the servers of the last run
+        if(cacheName)
+        {
+            if(runCached(&scanOptions, cacheName)) logError("Cached scan failed");
+            break;
+        }
+
+        // Scan statistics: Single scan of a session
+        if(statsFlag)
+        {
+            if(runStats(&scanOptions)) logError("Scan failed");
+            break;
+        }
+
         // Find all IDN servers
-        unsigned msTimeout = 500;
         IDNSL_SERVER_INFO *firstServerInfo;
-        int rcGetList = getIDNServerList(&firstServerInfo, clientGroup, msTimeout);
+        int rcGetList = getIDNServerListEx(&firstServerInfo, &scanOptions);
         if(rcGetList != 0)
         {
-            logError("getIDNServerList() failed (error: %d)", rcGetList);
+            logError("getIDNServerListEx() failed (error: %d)", rcGetList);
             break;
         }
 
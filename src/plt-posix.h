@@ -33,20 +33,175 @@
 
 
 // Standard libraries
+#include <stdio.h>
 #include <unistd.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <string.h>
 #include <time.h>
+#include <pthread.h>
 
 // Platform headers
 #include <ifaddrs.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+
+
+// Batched datagram receive/send (recvmmsg/sendmmsg are GNU extensions)
+#if defined(__linux__) && defined(_GNU_SOURCE)
+
+    #define PLT_HAVE_MMSG
+
+#endif
+
+
+// IPv4 packet info: Destination of received datagrams, source/interface of sent datagrams
+#if defined(IP_PKTINFO)
+
+    #define PLT_PKTINFO_SIZE                sizeof(struct in_pktinfo)
+
+#else
+
+    #define PLT_PKTINFO_SIZE                sizeof(struct in_addr)
+
+#endif
+
+// Receive control data: Packet info and drop counter (SO_RXQ_OVFL)
+#define PLT_RECV_CONTROL_SIZE               (CMSG_SPACE(PLT_PKTINFO_SIZE) + CMSG_SPACE(sizeof(uint32_t)))
+
+
+// Event loop backend
+#if defined(__linux__)
+
+    #define PLT_EVENTLOOP_EPOLL
+    #include <sys/epoll.h>
+    #include <sys/timerfd.h>
+
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__) || defined(__DragonFly__)
+
+    #define PLT_EVENTLOOP_KQUEUE
+    #include <sys/types.h>
+    #include <sys/event.h>
+
+#else
+
+    #define PLT_EVENTLOOP_POLL
+    #include <stdlib.h>
+
+#endif
+
+
+// -------------------------------------------------------------------------------------------------
+//  Defines
+// -------------------------------------------------------------------------------------------------
+
+#define PLT_EVFLG_READ                      0x01        // Socket readable / read interest
+#define PLT_EVFLG_WRITE                     0x02        // Socket writable / write interest
+#define PLT_EVFLG_ERROR                     0x04        // Error condition (reported only)
+
+#define PLT_RECVFLG_TRUNCATED               0x01        // Datagram exceeded the slot buffer
+
+#define PLT_IFFLG_UP                        0x01        // Interface is up
+#define PLT_IFFLG_BROADCAST                 0x02        // Interface supports broadcast
+#define PLT_IFFLG_LOOPBACK                  0x04        // Loopback interface
+#define PLT_IFFLG_MULTICAST                 0x08        // Interface supports multicast
+
+#define PLT_RECV_BATCH_MAX                  64          // Max. number of datagrams per batch call
+#define PLT_SEND_BATCH_MAX                  64          // Max. number of datagrams per batch call
 
 
 // -------------------------------------------------------------------------------------------------
 //  Typedefs
 // -------------------------------------------------------------------------------------------------
 
-typedef void (* IFADDR_CALLBACK_PFN)(void *callbackArg, const char *ifName, uint32_t ifIP4Addr);
+typedef void (* IFADDR_CALLBACK_PFN)(void *callbackArg, const char *ifName, uint32_t ifIP4Addr, uint32_t ifIP4Mask, unsigned ifFlags);
+typedef void (* IFADDR6_CALLBACK_PFN)(void *callbackArg, const char *ifName, const struct in6_addr *ifIP6Addr, uint32_t scopeID, unsigned ifFlags);
+typedef void (* PLT_THREAD_PFN)(void *threadArg);
+
+
+typedef struct
+{
+    pthread_t threadHandle;                     // The thread (once started)
+    PLT_THREAD_PFN pfnThread;                   // The thread function
+    void *threadArg;                            // The argument passed to the thread function
+
+} PLT_THREAD;
+
+
+typedef struct
+{
+    void *mapPtr;                               // The mapped memory (null: not mapped)
+    size_t mapSize;                             // Size of the mapping
+
+} PLT_SHARED_MEM;
+
+
+typedef struct
+{
+    int fdTimer;                                // Deadline timer (timerfd on Linux), -1: not available
+
+} PLT_TIMER;
+
+
+typedef struct
+{
+    unsigned evFlags;                           // The ready conditions (PLT_EVFLG_*)
+    void *userData;                             // The pointer passed when the socket was added
+
+} PLT_EVENT;
+
+
+typedef struct
+{
+#if defined(PLT_EVENTLOOP_POLL)
+    struct pollfd *pollTable;                   // Poll descriptors (one per socket)
+    void **userDataTable;                       // User data (same index as poll descriptor)
+    unsigned entryCount;                        // Number of sockets in the tables
+    unsigned entryLimit;                        // Allocated table size
+#else
+    int fdQueue;                                // The epoll/kqueue file descriptor
+#endif
+#if defined(PLT_EVENTLOOP_EPOLL)
+    PLT_TIMER waitTimer;                        // Sub-millisecond timeouts (epoll_wait() has ms resolution)
+#endif
+
+} PLT_EVENTLOOP;
+
+
+typedef union
+{
+    struct sockaddr sa;                         // Address family (either IPv4 or IPv6)
+    struct sockaddr_in sin;                     // IPv4 socket address
+    struct sockaddr_in6 sin6;                   // IPv6 socket address
+
+} PLT_SOCKADDR;
+
+
+typedef struct
+{
+    uint8_t *bufferPtr;                         // Datagram buffer
+    unsigned bufferSize;                        // Size of the datagram buffer
+    unsigned dataLength;                        // Length of the received datagram
+    unsigned recvFlags;                         // Receive condition flags (PLT_RECVFLG_*)
+    PLT_SOCKADDR remoteAddr;                    // The address the datagram was received from
+    struct in_addr localAddr;                   // IPv4 destination address (see plt_sockSetPacketInfo), 0: unknown
+    uint32_t dropCounter;                       // Kernel drops of the socket so far (see plt_sockSetDropCounter), 0: none/unknown
+
+} PLT_RECV_SLOT;
+
+
+typedef struct
+{
+    const uint8_t *dataPtr;                     // Datagram data
+    unsigned dataLength;                        // Length of the datagram
+    PLT_SOCKADDR remoteAddr;                    // The address the datagram shall be sent to
+
+} PLT_SEND_SLOT;
 
 
 // -------------------------------------------------------------------------------------------------
@@ -56,16 +211,13 @@ typedef void (* IFADDR_CALLBACK_PFN)(void *callbackArg, const char *ifName, uint
 inline static int plt_validateMonoTime()
 {
     extern int plt_monoValid;
-    extern struct timespec plt_monoRef;
-    extern uint32_t plt_monoTimeUS;
 
     if(!plt_monoValid)
     {
-        // Initialize time reference
-        if(clock_gettime(CLOCK_MONOTONIC, &plt_monoRef) < 0) return -1;
+        // Check the clock
+        struct timespec tsNow;
+        if(clock_gettime(CLOCK_MONOTONIC, &tsNow) < 0) return -1;
 
-        // Initialize internal time randomly
-        plt_monoTimeUS = (uint32_t)((plt_monoRef.tv_sec * 1000000ul) + (plt_monoRef.tv_nsec / 1000));
         plt_monoValid = 1;
     }
 
@@ -73,32 +225,90 @@ inline static int plt_validateMonoTime()
 }
 
 
+inline static uint64_t plt_getMonoTimeNS()
+{
+    // Note: Derived from the clock on each call (no shared state - may be called by any thread).
+    // 64 bit nanoseconds do not wrap around (for centuries).
+    struct timespec tsNow;
+    clock_gettime(CLOCK_MONOTONIC, &tsNow);
+
+    return ((uint64_t)tsNow.tv_sec * 1000000000) + (uint64_t)tsNow.tv_nsec;
+}
+
+
 inline static uint32_t plt_getMonoTimeUS()
 {
-    extern struct timespec plt_monoRef;
-    extern uint32_t plt_monoTimeUS;
+    // Note: Same time base as plt_getMonoTimeNS(). The time wraps around (after ~71 minutes),
+    // only differences of short intervals are meaningful.
+    return (uint32_t)(plt_getMonoTimeNS() / 1000);
+}
 
-    // Get current time
-    struct timespec tsNow, tsDiff;
-    clock_gettime(CLOCK_MONOTONIC, &tsNow);
 
-    // Determine difference to reference time
-    if(tsNow.tv_nsec < plt_monoRef.tv_nsec) 
-    {
-        tsDiff.tv_sec = (tsNow.tv_sec - plt_monoRef.tv_sec) - 1;
-        tsDiff.tv_nsec = (1000000000 + tsNow.tv_nsec) - plt_monoRef.tv_nsec;
-    } 
-    else 
+inline static int plt_timerOpen(PLT_TIMER *timer)
+{
+    // Note: Linux only (timerfd, readable at the deadline - may be added to an event loop)
+#if defined(PLT_EVENTLOOP_EPOLL)
+    timer->fdTimer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    return (timer->fdTimer < 0) ? -1 : 0;
+#else
+    timer->fdTimer = -1;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+
+inline static int plt_timerClose(PLT_TIMER *timer)
+{
+    if(timer->fdTimer < 0) return 0;
+
+    int rc = close(timer->fdTimer);
+    timer->fdTimer = -1;
+    return rc;
+}
+
+
+inline static int plt_timerSetDeadline(PLT_TIMER *timer, uint64_t nsDeadline)
+{
+    // Note: Absolute time (plt_getMonoTimeNS() base), one-shot. 0 disarms the timer.
+#if defined(PLT_EVENTLOOP_EPOLL)
+    struct itimerspec timerSpec;
+    memset(&timerSpec, 0, sizeof(timerSpec));
+    timerSpec.it_value.tv_sec = (time_t)(nsDeadline / 1000000000);
+    timerSpec.it_value.tv_nsec = (long)(nsDeadline % 1000000000);
+
+    return timerfd_settime(timer->fdTimer, nsDeadline ? TFD_TIMER_ABSTIME : 0, &timerSpec, (struct itimerspec *)0);
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+
+inline static int plt_timerAck(PLT_TIMER *timer)
+{
+    // Consume the expiration (the timer stays readable otherwise). Returns 1 in case it expired.
+    uint64_t expireCount = 0;
+    if(read(timer->fdTimer, &expireCount, sizeof(expireCount)) < 0) return (errno == EAGAIN) ? 0 : -1;
+
+    return (expireCount > 0) ? 1 : 0;
+}
+
+
+inline static int plt_timerWait(PLT_TIMER *timer)
+{
+    // Block until the deadline (the timer must be armed)
+    struct pollfd pollFD;
+    pollFD.fd = timer->fdTimer;
+    pollFD.events = POLLIN;
+    pollFD.revents = 0;
+
+    while(poll(&pollFD, 1, -1) < 0)
     {
-        tsDiff.tv_sec = tsNow.tv_sec - plt_monoRef.tv_sec;
-        tsDiff.tv_nsec = tsNow.tv_nsec - plt_monoRef.tv_nsec;
+        if(errno != EINTR) return -1;
     }
 
-    // Update internal time and system time reference
-    plt_monoTimeUS += (uint32_t)((tsDiff.tv_sec * 1000000) + (tsDiff.tv_nsec / 1000));
-    plt_monoRef = tsNow;
-
-    return plt_monoTimeUS;
+    return (plt_timerAck(timer) < 0) ? -1 : 0;
 }
 
 
@@ -114,9 +324,50 @@ inline static int plt_ifAddrListVisitor(IFADDR_CALLBACK_PFN pfnCallback, void *c
         if(ifa->ifa_addr == NULL) continue;
         if(ifa->ifa_addr->sa_family != AF_INET) continue;
 
+        // Interface flags and netmask (for filtering)
+        unsigned ifFlags = 0;
+        if(ifa->ifa_flags & IFF_UP) ifFlags |= PLT_IFFLG_UP;
+        if(ifa->ifa_flags & IFF_BROADCAST) ifFlags |= PLT_IFFLG_BROADCAST;
+        if(ifa->ifa_flags & IFF_LOOPBACK) ifFlags |= PLT_IFFLG_LOOPBACK;
+
+        uint32_t ifIP4Mask = 0;
+        if(ifa->ifa_netmask && ifa->ifa_netmask->sa_family == AF_INET)
+        {
+            ifIP4Mask = (uint32_t)(((struct sockaddr_in *)ifa->ifa_netmask)->sin_addr.s_addr);
+        }
+
         // Invoke callback on interface
         struct sockaddr_in *ifSockAddr = (struct sockaddr_in *)ifa->ifa_addr;
-        pfnCallback(callbackArg, ifa->ifa_name, (uint32_t)(ifSockAddr->sin_addr.s_addr));
+        pfnCallback(callbackArg, ifa->ifa_name, (uint32_t)(ifSockAddr->sin_addr.s_addr), ifIP4Mask, ifFlags);
+    }
+
+    // Interface list is dynamically allocated and must be freed
+    freeifaddrs(ifaddr);
+
+    return 0;
+}
+
+
+inline static int plt_ifAddr6ListVisitor(IFADDR6_CALLBACK_PFN pfnCallback, void *callbackArg)
+{
+    // Find all interfaces
+    struct ifaddrs *ifaddr;
+    if(getifaddrs(&ifaddr) == -1) return errno;
+
+    // Walk through all interfaces (IPv6 addresses)
+    for(struct ifaddrs *ifa = ifaddr; ifa != NULL; ifa = ifa->ifa_next) 
+    {
+        if(ifa->ifa_addr == NULL) continue;
+        if(ifa->ifa_addr->sa_family != AF_INET6) continue;
+
+        unsigned ifFlags = 0;
+        if(ifa->ifa_flags & IFF_UP) ifFlags |= PLT_IFFLG_UP;
+        if(ifa->ifa_flags & IFF_MULTICAST) ifFlags |= PLT_IFFLG_MULTICAST;
+        if(ifa->ifa_flags & IFF_LOOPBACK) ifFlags |= PLT_IFFLG_LOOPBACK;
+
+        // Invoke callback on interface
+        struct sockaddr_in6 *ifSockAddr = (struct sockaddr_in6 *)ifa->ifa_addr;
+        pfnCallback(callbackArg, ifa->ifa_name, &ifSockAddr->sin6_addr, (uint32_t)ifSockAddr->sin6_scope_id, ifFlags);
     }
 
     // Interface list is dynamically allocated and must be freed
@@ -126,6 +377,19 @@ inline static int plt_ifAddrListVisitor(IFADDR_CALLBACK_PFN pfnCallback, void *c
 }
 
 
+inline static unsigned plt_ifNameToIndex(const char *ifName)
+{
+    // Note: Alias names (eth0:1) map to the index of the interface
+    char nameBuffer[IF_NAMESIZE];
+    size_t nameLen = strcspn(ifName, ":");
+    if(nameLen >= sizeof(nameBuffer)) return 0;
+
+    memcpy(nameBuffer, ifName, nameLen);
+    nameBuffer[nameLen] = '\0';
+    return if_nametoindex(nameBuffer);
+}
+
+
 inline static int plt_sockStartup()
 {
     return 0;
@@ -163,5 +427,812 @@ inline static int plt_sockSetBroadcast(int fdSocket)
 }
 
 
+inline static int plt_sockSetMulticast6(int fdSocket, uint32_t scopeID)
+{
+    // Send multicasts on the interface (link-local scope, not routed)
+    unsigned int ifIndex = (unsigned int)scopeID;
+    if(setsockopt(fdSocket, IPPROTO_IPV6, IPV6_MULTICAST_IF, &ifIndex, sizeof(ifIndex)) < 0) return -1;
+
+    int hopsOpt = 1;
+    return setsockopt(fdSocket, IPPROTO_IPV6, IPV6_MULTICAST_HOPS, &hopsOpt, sizeof(hopsOpt));
+}
+
+
+inline static int plt_sockSetDualStack(int fdSocket)
+{
+    // IPv4 as mapped addresses (::ffff:a.b.c.d)
+    int v6OnlyOpt = 0;
+    return setsockopt(fdSocket, IPPROTO_IPV6, IPV6_V6ONLY, &v6OnlyOpt, sizeof(v6OnlyOpt));
+}
+
+
+inline static int plt_sockSetNonBlocking(int fdSocket)
+{
+    int flags = fcntl(fdSocket, F_GETFL, 0);
+    if(flags < 0) return -1;
+
+    return fcntl(fdSocket, F_SETFL, flags | O_NONBLOCK);
+}
+
+
+inline static int plt_sockSetPacketInfo(int fdSocket)
+{
+    // Report the destination address of received IPv4 datagrams (see PLT_RECV_SLOT)
+    int pktInfoOpt = 1;
+#if defined(IP_PKTINFO)
+    return setsockopt(fdSocket, IPPROTO_IP, IP_PKTINFO, &pktInfoOpt, sizeof(pktInfoOpt));
+#else
+    return setsockopt(fdSocket, IPPROTO_IP, IP_RECVDSTADDR, &pktInfoOpt, sizeof(pktInfoOpt));
+#endif
+}
+
+
+inline static int plt_sockSetRecvBuffer(int fdSocket, unsigned bufferSize)
+{
+    // Note: Linux limits the size to net.core.rmem_max (unless privileged, SO_RCVBUFFORCE)
+    int bufferOpt = (int)bufferSize;
+#if defined(SO_RCVBUFFORCE)
+    if(setsockopt(fdSocket, SOL_SOCKET, SO_RCVBUFFORCE, &bufferOpt, sizeof(bufferOpt)) == 0) return 0;
+#endif
+    return setsockopt(fdSocket, SOL_SOCKET, SO_RCVBUF, &bufferOpt, sizeof(bufferOpt));
+}
+
+
+inline static int plt_sockSetDropCounter(int fdSocket)
+{
+    // Report the number of datagrams dropped by the kernel (receive buffer overflow) with the
+    // received datagrams (see PLT_RECV_SLOT). Not supported: Drops are not reported.
+#if defined(SO_RXQ_OVFL)
+    int dropCounterOpt = 1;
+    return setsockopt(fdSocket, SOL_SOCKET, SO_RXQ_OVFL, &dropCounterOpt, sizeof(dropCounterOpt));
+#else
+    return 0;
+#endif
+}
+
+
+inline static void plt_sockParseControl(struct msghdr *msgHdr, PLT_RECV_SLOT *slot)
+{
+    slot->localAddr.s_addr = INADDR_ANY;
+    slot->dropCounter = 0;
+    if(msgHdr->msg_controllen == 0) return;
+
+    for(struct cmsghdr *cmsg = CMSG_FIRSTHDR(msgHdr); cmsg; cmsg = CMSG_NXTHDR(msgHdr, cmsg))
+    {
+#if defined(SO_RXQ_OVFL)
+        // Note: Attached in case datagrams were dropped only
+        if((cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SO_RXQ_OVFL))
+        {
+            memcpy(&slot->dropCounter, CMSG_DATA(cmsg), sizeof(uint32_t));
+            continue;
+        }
+#endif
+
+        if(cmsg->cmsg_level != IPPROTO_IP) continue;
+#if defined(IP_PKTINFO)
+        if(cmsg->cmsg_type != IP_PKTINFO) continue;
+
+        struct in_pktinfo pktInfo;
+        memcpy(&pktInfo, CMSG_DATA(cmsg), sizeof(pktInfo));
+        slot->localAddr = pktInfo.ipi_addr;
+#else
+        if(cmsg->cmsg_type != IP_RECVDSTADDR) continue;
+
+        memcpy(&slot->localAddr, CMSG_DATA(cmsg), sizeof(struct in_addr));
+#endif
+    }
+}
+
+
+inline static int plt_sockIsWouldBlock(int errorCode)
+{
+    return (errorCode == EAGAIN) || (errorCode == EWOULDBLOCK);
+}
+
+
+inline static socklen_t plt_sockAddrSize(const PLT_SOCKADDR *sockAddr)
+{
+    return (sockAddr->sa.sa_family == AF_INET6) ? sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
+}
+
+
+inline static int plt_sockRecvBatch(int fdSocket, PLT_RECV_SLOT *slotTable, unsigned slotCount)
+{
+    // Note: Returns the number of datagrams received (0 in case no datagram is pending)
+    if(slotCount > PLT_RECV_BATCH_MAX) slotCount = PLT_RECV_BATCH_MAX;
+
+#if defined(PLT_HAVE_MMSG)
+
+    struct mmsghdr msgTable[PLT_RECV_BATCH_MAX];
+    struct iovec iovTable[PLT_RECV_BATCH_MAX];
+    union { struct cmsghdr align; uint8_t buffer[PLT_RECV_CONTROL_SIZE]; } controlTable[PLT_RECV_BATCH_MAX];
+    memset(msgTable, 0, slotCount * sizeof(struct mmsghdr));
+
+    for(unsigned i = 0; i < slotCount; i++)
+    {
+        iovTable[i].iov_base = slotTable[i].bufferPtr;
+        iovTable[i].iov_len = slotTable[i].bufferSize;
+        msgTable[i].msg_hdr.msg_iov = &iovTable[i];
+        msgTable[i].msg_hdr.msg_iovlen = 1;
+        msgTable[i].msg_hdr.msg_name = &slotTable[i].remoteAddr;
+        msgTable[i].msg_hdr.msg_namelen = sizeof(slotTable[i].remoteAddr);
+        msgTable[i].msg_hdr.msg_control = controlTable[i].buffer;
+        msgTable[i].msg_hdr.msg_controllen = sizeof(controlTable[i].buffer);
+    }
+
+    // Receive all pending datagrams (up to the number of slots) with a single system call
+    int msgCount = recvmmsg(fdSocket, msgTable, slotCount, MSG_DONTWAIT, (struct timespec *)0);
+    if(msgCount < 0) return plt_sockIsWouldBlock(errno) ? 0 : -1;
+
+    for(int i = 0; i < msgCount; i++)
+    {
+        slotTable[i].dataLength = msgTable[i].msg_len;
+        slotTable[i].recvFlags = (msgTable[i].msg_hdr.msg_flags & MSG_TRUNC) ? PLT_RECVFLG_TRUNCATED : 0;
+        plt_sockParseControl(&msgTable[i].msg_hdr, &slotTable[i]);
+    }
+
+    return msgCount;
+
+#else
+
+    // Receive pending datagrams one by one (until the socket would block)
+    unsigned msgCount = 0;
+    for(; msgCount < slotCount; msgCount++)
+    {
+        PLT_RECV_SLOT *slot = &slotTable[msgCount];
+
+        struct iovec iov;
+        iov.iov_base = slot->bufferPtr;
+        iov.iov_len = slot->bufferSize;
+
+        union { struct cmsghdr align; uint8_t buffer[PLT_RECV_CONTROL_SIZE]; } control;
+
+        struct msghdr msgHdr;
+        memset(&msgHdr, 0, sizeof(msgHdr));
+        msgHdr.msg_iov = &iov;
+        msgHdr.msg_iovlen = 1;
+        msgHdr.msg_name = &slot->remoteAddr;
+        msgHdr.msg_namelen = sizeof(slot->remoteAddr);
+        msgHdr.msg_control = control.buffer;
+        msgHdr.msg_controllen = sizeof(control.buffer);
+
+        ssize_t nBytes = recvmsg(fdSocket, &msgHdr, MSG_DONTWAIT);
+        if(nBytes < 0)
+        {
+            if(plt_sockIsWouldBlock(errno)) break;
+            return (msgCount > 0) ? (int)msgCount : -1;
+        }
+
+        slot->dataLength = (unsigned)nBytes;
+        slot->recvFlags = (msgHdr.msg_flags & MSG_TRUNC) ? PLT_RECVFLG_TRUNCATED : 0;
+        plt_sockParseControl(&msgHdr, slot);
+    }
+
+    return (int)msgCount;
+
+#endif
+}
+
+
+inline static int plt_sockSendBatch(int fdSocket, const PLT_SEND_SLOT *slotTable, unsigned slotCount)
+{
+    // Note: Returns the number of datagrams sent (0 in case the socket would block)
+    if(slotCount > PLT_SEND_BATCH_MAX) slotCount = PLT_SEND_BATCH_MAX;
+
+#if defined(PLT_HAVE_MMSG)
+
+    struct mmsghdr msgTable[PLT_SEND_BATCH_MAX];
+    struct iovec iovTable[PLT_SEND_BATCH_MAX];
+    memset(msgTable, 0, slotCount * sizeof(struct mmsghdr));
+
+    for(unsigned i = 0; i < slotCount; i++)
+    {
+        iovTable[i].iov_base = (void *)slotTable[i].dataPtr;
+        iovTable[i].iov_len = slotTable[i].dataLength;
+        msgTable[i].msg_hdr.msg_iov = &iovTable[i];
+        msgTable[i].msg_hdr.msg_iovlen = 1;
+        msgTable[i].msg_hdr.msg_name = (void *)&slotTable[i].remoteAddr;
+        msgTable[i].msg_hdr.msg_namelen = plt_sockAddrSize(&slotTable[i].remoteAddr);
+    }
+
+    // Send all datagrams with a single system call
+    int msgCount = sendmmsg(fdSocket, msgTable, slotCount, MSG_DONTWAIT);
+    if(msgCount < 0) return plt_sockIsWouldBlock(errno) ? 0 : -1;
+
+    return msgCount;
+
+#else
+
+    // Send datagrams one by one (until the socket would block)
+    unsigned msgCount = 0;
+    for(; msgCount < slotCount; msgCount++)
+    {
+        const PLT_SEND_SLOT *slot = &slotTable[msgCount];
+
+        struct sockaddr *remoteAddr = (struct sockaddr *)&slot->remoteAddr;
+        if(sendto(fdSocket, slot->dataPtr, slot->dataLength, MSG_DONTWAIT, remoteAddr, plt_sockAddrSize(&slot->remoteAddr)) < 0)
+        {
+            if(plt_sockIsWouldBlock(errno)) break;
+            return (msgCount > 0) ? (int)msgCount : -1;
+        }
+    }
+
+    return (int)msgCount;
+
+#endif
+}
+
+
+inline static int plt_sockSendFrom(int fdSocket, const uint8_t *dataPtr, unsigned dataLength, const PLT_SOCKADDR *remoteAddr, struct in_addr srcAddr, unsigned ifIndex)
+{
+    // IPv4 datagram with the given source address, sent on the given interface (0: routed by the
+    // source address). Note: The interface can't be selected without IP_PKTINFO (BSD).
+    struct iovec iov;
+    iov.iov_base = (void *)dataPtr;
+    iov.iov_len = dataLength;
+
+    union { struct cmsghdr align; uint8_t buffer[CMSG_SPACE(PLT_PKTINFO_SIZE)]; } control;
+    memset(&control, 0, sizeof(control));
+
+    struct msghdr msgHdr;
+    memset(&msgHdr, 0, sizeof(msgHdr));
+    msgHdr.msg_name = (void *)remoteAddr;
+    msgHdr.msg_namelen = plt_sockAddrSize(remoteAddr);
+    msgHdr.msg_iov = &iov;
+    msgHdr.msg_iovlen = 1;
+    msgHdr.msg_control = control.buffer;
+    msgHdr.msg_controllen = sizeof(control.buffer);
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msgHdr);
+    cmsg->cmsg_level = IPPROTO_IP;
+    cmsg->cmsg_len = CMSG_LEN(PLT_PKTINFO_SIZE);
+#if defined(IP_PKTINFO)
+    struct in_pktinfo pktInfo;
+    memset(&pktInfo, 0, sizeof(pktInfo));
+    pktInfo.ipi_ifindex = (int)ifIndex;
+    pktInfo.ipi_spec_dst = srcAddr;
+    cmsg->cmsg_type = IP_PKTINFO;
+    memcpy(CMSG_DATA(cmsg), &pktInfo, sizeof(pktInfo));
+#else
+    cmsg->cmsg_type = IP_SENDSRCADDR;
+    memcpy(CMSG_DATA(cmsg), &srcAddr, sizeof(srcAddr));
+#endif
+
+    return (sendmsg(fdSocket, &msgHdr, MSG_DONTWAIT) < 0) ? -1 : 0;
+}
+
+
+// -------------------------------------------------------------------------------------------------
+//  Threads and atomics
+// -------------------------------------------------------------------------------------------------
+
+inline static void *plt_threadEntry(void *threadArg)
+{
+    PLT_THREAD *thread = (PLT_THREAD *)threadArg;
+    thread->pfnThread(thread->threadArg);
+
+    return (void *)0;
+}
+
+
+inline static int plt_threadStart(PLT_THREAD *thread, PLT_THREAD_PFN pfnThread, void *threadArg)
+{
+    thread->pfnThread = pfnThread;
+    thread->threadArg = threadArg;
+
+    // Note: Error code is passed by errno (plt_sockGetLastError())
+    int rc = pthread_create(&thread->threadHandle, (pthread_attr_t *)0, plt_threadEntry, thread);
+    if(rc != 0) { errno = rc; return -1; }
+
+    return 0;
+}
+
+
+inline static int plt_threadJoin(PLT_THREAD *thread)
+{
+    int rc = pthread_join(thread->threadHandle, (void **)0);
+    if(rc != 0) { errno = rc; return -1; }
+
+    return 0;
+}
+
+
+inline static void *plt_atomicLoadPtr(void *volatile *ptrRef)
+{
+    return __atomic_load_n(ptrRef, __ATOMIC_ACQUIRE);
+}
+
+
+inline static int plt_atomicCasPtr(void *volatile *ptrRef, void *expectedPtr, void *desiredPtr)
+{
+    // Returns nonzero in case the pointer was replaced
+    return __atomic_compare_exchange_n(ptrRef, &expectedPtr, desiredPtr, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+
+inline static uint32_t plt_atomicLoad32(volatile uint32_t *valueRef)
+{
+    return __atomic_load_n(valueRef, __ATOMIC_ACQUIRE);
+}
+
+
+inline static void plt_atomicStore32(volatile uint32_t *valueRef, uint32_t value)
+{
+    __atomic_store_n(valueRef, value, __ATOMIC_RELEASE);
+}
+
+
+inline static void plt_atomicFence()
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+
+inline static void plt_sleepMS(unsigned msSleep)
+{
+    // Note: Returns early in case of a signal
+    struct timespec tsSleep;
+    tsSleep.tv_sec = msSleep / 1000;
+    tsSleep.tv_nsec = (long)(msSleep % 1000) * 1000000;
+    nanosleep(&tsSleep, (struct timespec *)0);
+}
+
+
+// -------------------------------------------------------------------------------------------------
+//  Shared memory (POSIX shared memory objects, name without leading '/') and mapped files
+// -------------------------------------------------------------------------------------------------
+
+inline static int plt_sharedMemName(char *nameBuffer, size_t bufferSize, const char *memName)
+{
+    int nameLen = snprintf(nameBuffer, bufferSize, "/%s", memName);
+    if(nameLen < 0 || (size_t)nameLen >= bufferSize) { errno = ENAMETOOLONG; return -1; }
+
+    return 0;
+}
+
+
+inline static int plt_sharedMemCreate(PLT_SHARED_MEM *sharedMem, const char *memName, size_t memSize)
+{
+    sharedMem->mapPtr = (void *)0;
+    sharedMem->mapSize = 0;
+
+    char nameBuffer[256];
+    if(plt_sharedMemName(nameBuffer, sizeof(nameBuffer), memName)) return -1;
+
+    // Note: An existing segment is reused (resized). Error code is passed by errno.
+    int fdMem = shm_open(nameBuffer, O_RDWR | O_CREAT, 0644);
+    if(fdMem < 0) return -1;
+
+    void *mapPtr = MAP_FAILED;
+    if(ftruncate(fdMem, (off_t)memSize) == 0)
+    {
+        mapPtr = mmap((void *)0, memSize, PROT_READ | PROT_WRITE, MAP_SHARED, fdMem, 0);
+    }
+
+    int errorCode = errno;
+    close(fdMem);
+    if(mapPtr == MAP_FAILED) { errno = errorCode; return -1; }
+
+    sharedMem->mapPtr = mapPtr;
+    sharedMem->mapSize = memSize;
+    return 0;
+}
+
+
+inline static int plt_sharedMemOpen(PLT_SHARED_MEM *sharedMem, const char *memName)
+{
+    sharedMem->mapPtr = (void *)0;
+    sharedMem->mapSize = 0;
+
+    char nameBuffer[256];
+    if(plt_sharedMemName(nameBuffer, sizeof(nameBuffer), memName)) return -1;
+
+    // Read-only mapping of the whole segment
+    int fdMem = shm_open(nameBuffer, O_RDONLY, 0);
+    if(fdMem < 0) return -1;
+
+    void *mapPtr = MAP_FAILED;
+    struct stat memStat;
+    if(fstat(fdMem, &memStat) == 0)
+    {
+        if(memStat.st_size > 0) mapPtr = mmap((void *)0, (size_t)memStat.st_size, PROT_READ, MAP_SHARED, fdMem, 0);
+        else errno = ENODATA;
+    }
+
+    int errorCode = errno;
+    close(fdMem);
+    if(mapPtr == MAP_FAILED) { errno = errorCode; return -1; }
+
+    sharedMem->mapPtr = mapPtr;
+    sharedMem->mapSize = (size_t)memStat.st_size;
+    return 0;
+}
+
+
+inline static int plt_sharedMemClose(PLT_SHARED_MEM *sharedMem)
+{
+    if(sharedMem->mapPtr == (void *)0) return 0;
+
+    int rc = munmap(sharedMem->mapPtr, sharedMem->mapSize);
+    sharedMem->mapPtr = (void *)0;
+    sharedMem->mapSize = 0;
+
+    return rc;
+}
+
+
+inline static int plt_fileMapOpen(PLT_SHARED_MEM *sharedMem, const char *fileName)
+{
+    sharedMem->mapPtr = (void *)0;
+    sharedMem->mapSize = 0;
+
+    // Read-only mapping of the whole file
+    int fdFile = open(fileName, O_RDONLY);
+    if(fdFile < 0) return -1;
+
+    void *mapPtr = MAP_FAILED;
+    struct stat fileStat;
+    if(fstat(fdFile, &fileStat) == 0)
+    {
+        if(fileStat.st_size > 0) mapPtr = mmap((void *)0, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fdFile, 0);
+        else errno = ENODATA;
+    }
+
+    int errorCode = errno;
+    close(fdFile);
+    if(mapPtr == MAP_FAILED) { errno = errorCode; return -1; }
+
+    sharedMem->mapPtr = mapPtr;
+    sharedMem->mapSize = (size_t)fileStat.st_size;
+    return 0;
+}
+
+
+inline static int plt_fileMapCreate(PLT_SHARED_MEM *sharedMem, const char *fileName, size_t mapSize)
+{
+    sharedMem->mapPtr = (void *)0;
+    sharedMem->mapSize = 0;
+
+    // Read/write mapping of a new file (an existing file is replaced), sized at once
+    int fdFile = open(fileName, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(fdFile < 0) return -1;
+
+    void *mapPtr = MAP_FAILED;
+    if(ftruncate(fdFile, (off_t)mapSize) == 0)
+    {
+        mapPtr = mmap((void *)0, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fdFile, 0);
+    }
+
+    int errorCode = errno;
+    close(fdFile);
+    if(mapPtr == MAP_FAILED) { errno = errorCode; return -1; }
+
+    sharedMem->mapPtr = mapPtr;
+    sharedMem->mapSize = mapSize;
+    return 0;
+}
+
+
+inline static int plt_fileTruncate(const char *fileName, size_t fileSize)
+{
+    // Note: In case the file is mapped, unmap first
+    return truncate(fileName, (off_t)fileSize);
+}
+
+
+inline static int plt_fileReplace(const char *srcName, const char *dstName)
+{
+    // Note: Atomic, the destination is replaced
+    return rename(srcName, dstName);
+}
+
+
+inline static int plt_sharedMemRemove(const char *memName)
+{
+    // Note: Mapped segments stay valid until unmapped
+    char nameBuffer[256];
+    if(plt_sharedMemName(nameBuffer, sizeof(nameBuffer), memName)) return -1;
+
+    return shm_unlink(nameBuffer);
+}
+
+
+// -------------------------------------------------------------------------------------------------
+//  Event loop (epoll on Linux, kqueue on BSD/macOS, poll() otherwise)
+// -------------------------------------------------------------------------------------------------
+
+#if defined(PLT_EVENTLOOP_EPOLL)
+
+inline static int plt_eventLoopOpen(PLT_EVENTLOOP *eventLoop)
+{
+    eventLoop->waitTimer.fdTimer = -1;
+    eventLoop->fdQueue = epoll_create1(EPOLL_CLOEXEC);
+    if(eventLoop->fdQueue < 0) return -1;
+
+    // Precise timeouts (the timer wakes the wait up). Note: Optional, millisecond timeouts otherwise
+    if(plt_timerOpen(&eventLoop->waitTimer) == 0)
+    {
+        struct epoll_event epEvent;
+        memset(&epEvent, 0, sizeof(epEvent));
+        epEvent.events = EPOLLIN;
+        epEvent.data.ptr = &eventLoop->waitTimer;
+        if(epoll_ctl(eventLoop->fdQueue, EPOLL_CTL_ADD, eventLoop->waitTimer.fdTimer, &epEvent) < 0) plt_timerClose(&eventLoop->waitTimer);
+    }
+
+    return 0;
+}
+
+
+inline static int plt_eventLoopClose(PLT_EVENTLOOP *eventLoop)
+{
+    if(eventLoop->fdQueue < 0) return 0;
+
+    plt_timerClose(&eventLoop->waitTimer);
+    int rc = close(eventLoop->fdQueue);
+    eventLoop->fdQueue = -1;
+    return rc;
+}
+
+
+inline static int plt_eventLoopCtl(PLT_EVENTLOOP *eventLoop, int op, int fdSocket, unsigned evFlags, void *userData)
+{
+    struct epoll_event epEvent;
+    memset(&epEvent, 0, sizeof(epEvent));
+    if(evFlags & PLT_EVFLG_READ) epEvent.events |= EPOLLIN;
+    if(evFlags & PLT_EVFLG_WRITE) epEvent.events |= EPOLLOUT;
+    epEvent.data.ptr = userData;
+
+    return epoll_ctl(eventLoop->fdQueue, op, fdSocket, &epEvent);
+}
+
+
+inline static int plt_eventLoopAdd(PLT_EVENTLOOP *eventLoop, int fdSocket, unsigned evFlags, void *userData)
+{
+    return plt_eventLoopCtl(eventLoop, EPOLL_CTL_ADD, fdSocket, evFlags, userData);
+}
+
+
+inline static int plt_eventLoopModify(PLT_EVENTLOOP *eventLoop, int fdSocket, unsigned evFlags, void *userData)
+{
+    return plt_eventLoopCtl(eventLoop, EPOLL_CTL_MOD, fdSocket, evFlags, userData);
+}
+
+
+inline static int plt_eventLoopRemove(PLT_EVENTLOOP *eventLoop, int fdSocket)
+{
+    return plt_eventLoopCtl(eventLoop, EPOLL_CTL_DEL, fdSocket, 0, (void *)0);
+}
+
+
+inline static int plt_eventLoopWait(PLT_EVENTLOOP *eventLoop, PLT_EVENT *eventTable, unsigned eventLimit, uint32_t usTimeout)
+{
+    struct epoll_event epEventTable[64];
+    if(eventLimit > sizeof(epEventTable) / sizeof(epEventTable[0])) eventLimit = sizeof(epEventTable) / sizeof(epEventTable[0]);
+
+    // Note: Round up to full milliseconds, whole timeout shall have elapsed on return. The timer
+    // (if available) wakes up at the exact deadline, the timeout is the fallback.
+    int msTimeout = (int)((usTimeout + 999) / 1000);
+    if(eventLoop->waitTimer.fdTimer >= 0)
+    {
+        uint64_t nsDeadline = usTimeout ? plt_getMonoTimeNS() + ((uint64_t)usTimeout * 1000) : 0;
+        if(plt_timerSetDeadline(&eventLoop->waitTimer, nsDeadline) < 0) return -1;
+    }
+
+    int numReady = epoll_wait(eventLoop->fdQueue, epEventTable, (int)eventLimit, msTimeout);
+    if(numReady < 0) return (errno == EINTR) ? 0 : -1;
+
+    unsigned eventCount = 0;
+    for(int i = 0; i < numReady; i++)
+    {
+        // The timer is not reported (timeout)
+        if(epEventTable[i].data.ptr == (void *)&eventLoop->waitTimer)
+        {
+            if(plt_timerAck(&eventLoop->waitTimer) < 0) return -1;
+            continue;
+        }
+
+        unsigned evFlags = 0;
+        if(epEventTable[i].events & (EPOLLIN | EPOLLHUP)) evFlags |= PLT_EVFLG_READ;
+        if(epEventTable[i].events & EPOLLOUT) evFlags |= PLT_EVFLG_WRITE;
+        if(epEventTable[i].events & EPOLLERR) evFlags |= PLT_EVFLG_ERROR;
+
+        eventTable[eventCount].evFlags = evFlags;
+        eventTable[eventCount].userData = epEventTable[i].data.ptr;
+        eventCount++;
+    }
+
+    return (int)eventCount;
+}
+
+#elif defined(PLT_EVENTLOOP_KQUEUE)
+
+inline static int plt_eventLoopOpen(PLT_EVENTLOOP *eventLoop)
+{
+    eventLoop->fdQueue = kqueue();
+    return (eventLoop->fdQueue < 0) ? -1 : 0;
+}
+
+
+inline static int plt_eventLoopClose(PLT_EVENTLOOP *eventLoop)
+{
+    if(eventLoop->fdQueue < 0) return 0;
+
+    int rc = close(eventLoop->fdQueue);
+    eventLoop->fdQueue = -1;
+    return rc;
+}
+
+
+inline static int plt_eventLoopModify(PLT_EVENTLOOP *eventLoop, int fdSocket, unsigned evFlags, void *userData)
+{
+    // Note: Read and write are separate filters, both are registered and enabled/disabled
+    struct kevent kevTable[2];
+    unsigned short rdAction = EV_ADD | ((evFlags & PLT_EVFLG_READ) ? EV_ENABLE : EV_DISABLE);
+    unsigned short wrAction = EV_ADD | ((evFlags & PLT_EVFLG_WRITE) ? EV_ENABLE : EV_DISABLE);
+    EV_SET(&kevTable[0], fdSocket, EVFILT_READ, rdAction, 0, 0, userData);
+    EV_SET(&kevTable[1], fdSocket, EVFILT_WRITE, wrAction, 0, 0, userData);
+
+    return kevent(eventLoop->fdQueue, kevTable, 2, (struct kevent *)0, 0, (struct timespec *)0);
+}
+
+
+inline static int plt_eventLoopAdd(PLT_EVENTLOOP *eventLoop, int fdSocket, unsigned evFlags, void *userData)
+{
+    return plt_eventLoopModify(eventLoop, fdSocket, evFlags, userData);
+}
+
+
+inline static int plt_eventLoopRemove(PLT_EVENTLOOP *eventLoop, int fdSocket)
+{
+    struct kevent kevTable[2];
+    EV_SET(&kevTable[0], fdSocket, EVFILT_READ, EV_DELETE, 0, 0, (void *)0);
+    EV_SET(&kevTable[1], fdSocket, EVFILT_WRITE, EV_DELETE, 0, 0, (void *)0);
+
+    return kevent(eventLoop->fdQueue, kevTable, 2, (struct kevent *)0, 0, (struct timespec *)0);
+}
+
+
+inline static int plt_eventLoopWait(PLT_EVENTLOOP *eventLoop, PLT_EVENT *eventTable, unsigned eventLimit, uint32_t usTimeout)
+{
+    struct kevent kevTable[64];
+    if(eventLimit > sizeof(kevTable) / sizeof(kevTable[0])) eventLimit = sizeof(kevTable) / sizeof(kevTable[0]);
+
+    struct timespec tsTimeout;
+    tsTimeout.tv_sec = usTimeout / 1000000;
+    tsTimeout.tv_nsec = (usTimeout % 1000000) * 1000;
+
+    int numReady = kevent(eventLoop->fdQueue, (struct kevent *)0, 0, kevTable, (int)eventLimit, &tsTimeout);
+    if(numReady < 0) return (errno == EINTR) ? 0 : -1;
+
+    for(int i = 0; i < numReady; i++)
+    {
+        unsigned evFlags = (kevTable[i].filter == EVFILT_WRITE) ? PLT_EVFLG_WRITE : PLT_EVFLG_READ;
+        if(kevTable[i].flags & EV_ERROR) evFlags |= PLT_EVFLG_ERROR;
+
+        eventTable[i].evFlags = evFlags;
+        eventTable[i].userData = kevTable[i].udata;
+    }
+
+    return numReady;
+}
+
+#else
+
+inline static int plt_eventLoopOpen(PLT_EVENTLOOP *eventLoop)
+{
+    eventLoop->pollTable = (struct pollfd *)0;
+    eventLoop->userDataTable = (void **)0;
+    eventLoop->entryCount = 0;
+    eventLoop->entryLimit = 0;
+
+    return 0;
+}
+
+
+inline static int plt_eventLoopClose(PLT_EVENTLOOP *eventLoop)
+{
+    free(eventLoop->pollTable);
+    free(eventLoop->userDataTable);
+
+    return plt_eventLoopOpen(eventLoop);
+}
+
+
+inline static int plt_eventLoopFind(PLT_EVENTLOOP *eventLoop, int fdSocket)
+{
+    for(unsigned i = 0; i < eventLoop->entryCount; i++)
+    {
+        if(eventLoop->pollTable[i].fd == fdSocket) return (int)i;
+    }
+
+    return -1;
+}
+
+
+inline static int plt_eventLoopModify(PLT_EVENTLOOP *eventLoop, int fdSocket, unsigned evFlags, void *userData)
+{
+    int index = plt_eventLoopFind(eventLoop, fdSocket);
+    if(index < 0) { errno = ENOENT; return -1; }
+
+    eventLoop->pollTable[index].events = 0;
+    if(evFlags & PLT_EVFLG_READ) eventLoop->pollTable[index].events |= POLLIN;
+    if(evFlags & PLT_EVFLG_WRITE) eventLoop->pollTable[index].events |= POLLOUT;
+    eventLoop->userDataTable[index] = userData;
+
+    return 0;
+}
+
+
+inline static int plt_eventLoopAdd(PLT_EVENTLOOP *eventLoop, int fdSocket, unsigned evFlags, void *userData)
+{
+    if(plt_eventLoopFind(eventLoop, fdSocket) >= 0) { errno = EEXIST; return -1; }
+
+    // Grow tables in case of insufficient size
+    if(eventLoop->entryCount >= eventLoop->entryLimit)
+    {
+        unsigned newLimit = eventLoop->entryLimit ? (eventLoop->entryLimit * 2) : 16;
+
+        struct pollfd *pollTable = (struct pollfd *)realloc(eventLoop->pollTable, newLimit * sizeof(struct pollfd));
+        if(pollTable == (struct pollfd *)0) return -1;
+        eventLoop->pollTable = pollTable;
+
+        void **userDataTable = (void **)realloc(eventLoop->userDataTable, newLimit * sizeof(void *));
+        if(userDataTable == (void **)0) return -1;
+        eventLoop->userDataTable = userDataTable;
+
+        eventLoop->entryLimit = newLimit;
+    }
+
+    eventLoop->pollTable[eventLoop->entryCount].fd = fdSocket;
+    eventLoop->pollTable[eventLoop->entryCount].revents = 0;
+    eventLoop->entryCount++;
+
+    return plt_eventLoopModify(eventLoop, fdSocket, evFlags, userData);
+}
+
+
+inline static int plt_eventLoopRemove(PLT_EVENTLOOP *eventLoop, int fdSocket)
+{
+    int index = plt_eventLoopFind(eventLoop, fdSocket);
+    if(index < 0) { errno = ENOENT; return -1; }
+
+    // Move last entry into the gap
+    unsigned lastIndex = --eventLoop->entryCount;
+    eventLoop->pollTable[index] = eventLoop->pollTable[lastIndex];
+    eventLoop->userDataTable[index] = eventLoop->userDataTable[lastIndex];
+
+    return 0;
+}
+
+
+inline static int plt_eventLoopWait(PLT_EVENTLOOP *eventLoop, PLT_EVENT *eventTable, unsigned eventLimit, uint32_t usTimeout)
+{
+    int msTimeout = (int)((usTimeout + 999) / 1000);
+    int numReady = poll(eventLoop->pollTable, (nfds_t)eventLoop->entryCount, msTimeout);
+    if(numReady < 0) return (errno == EINTR) ? 0 : -1;
+
+    // Collect ready sockets
+    unsigned eventCount = 0;
+    for(unsigned i = 0; (i < eventLoop->entryCount) && (eventCount < eventLimit); i++)
+    {
+        short revents = eventLoop->pollTable[i].revents;
+        if(revents == 0) continue;
+
+        unsigned evFlags = 0;
+        if(revents & (POLLIN | POLLHUP)) evFlags |= PLT_EVFLG_READ;
+        if(revents & POLLOUT) evFlags |= PLT_EVFLG_WRITE;
+        if(revents & (POLLERR | POLLNVAL)) evFlags |= PLT_EVFLG_ERROR;
+
+        eventTable[eventCount].evFlags = evFlags;
+        eventTable[eventCount].userData = eventLoop->userDataTable[i];
+        eventCount++;
+    }
+
+    return (int)eventCount;
+}
+
+#endif
+
+
 #endif
 
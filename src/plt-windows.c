@@ -40,6 +40,4 @@
 
 int plt_monoValid = 0;
 LARGE_INTEGER plt_monoCtrFreq;
-LARGE_INTEGER plt_monoCtrRef;
-uint32_t plt_monoTimeUS = 0;
 
@@ -34,10 +34,35 @@
 
 // Standard libraries
 #include <stdint.h>
+#include <stdlib.h>
 
 // Platform headers
 #include <winsock2.h>
 #include <ws2tcpip.h>
+#include <mswsock.h>
+
+
+// -------------------------------------------------------------------------------------------------
+//  Defines
+// -------------------------------------------------------------------------------------------------
+
+#define PLT_EVFLG_READ                      0x01        // Socket readable / read interest
+#define PLT_EVFLG_WRITE                     0x02        // Socket writable / write interest
+#define PLT_EVFLG_ERROR                     0x04        // Error condition (reported only)
+
+#define PLT_RECVFLG_TRUNCATED               0x01        // Datagram exceeded the slot buffer
+
+#define PLT_IFFLG_UP                        0x01        // Interface is up
+#define PLT_IFFLG_BROADCAST                 0x02        // Interface supports broadcast
+#define PLT_IFFLG_LOOPBACK                  0x04        // Loopback interface
+#define PLT_IFFLG_MULTICAST                 0x08        // Interface supports multicast
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002  // Windows 10 1803 and later
+#endif
+
+#define PLT_RECV_BATCH_MAX                  64          // Max. number of datagrams per batch call
+#define PLT_SEND_BATCH_MAX                  64          // Max. number of datagrams per batch call
 
 
 // -------------------------------------------------------------------------------------------------
@@ -46,7 +71,84 @@
 
 typedef unsigned long in_addr_t;
 
-typedef void(*IFADDR_CALLBACK_PFN)(void *callbackArg, const char *ifName, uint32_t ifIP4Addr);
+typedef void(*IFADDR_CALLBACK_PFN)(void *callbackArg, const char *ifName, uint32_t ifIP4Addr, uint32_t ifIP4Mask, unsigned ifFlags);
+typedef void(*IFADDR6_CALLBACK_PFN)(void *callbackArg, const char *ifName, const struct in6_addr *ifIP6Addr, uint32_t scopeID, unsigned ifFlags);
+typedef void(*PLT_THREAD_PFN)(void *threadArg);
+
+
+typedef struct
+{
+    HANDLE threadHandle;                        // The thread (once started)
+    PLT_THREAD_PFN pfnThread;                   // The thread function
+    void *threadArg;                            // The argument passed to the thread function
+
+} PLT_THREAD;
+
+
+typedef struct
+{
+    void *mapPtr;                               // The mapped memory (null: not mapped)
+    size_t mapSize;                             // Size of the mapping
+    HANDLE mapHandle;                           // The file mapping object
+
+} PLT_SHARED_MEM;
+
+
+typedef struct
+{
+    unsigned evFlags;                           // The ready conditions (PLT_EVFLG_*)
+    void *userData;                             // The pointer passed when the socket was added
+
+} PLT_EVENT;
+
+
+typedef struct
+{
+    HANDLE timerHandle;                         // Deadline timer (waitable timer), null: not available
+
+} PLT_TIMER;
+
+
+typedef struct
+{
+    WSAPOLLFD *pollTable;                       // Poll descriptors (one per socket)
+    void **userDataTable;                       // User data (same index as poll descriptor)
+    unsigned entryCount;                        // Number of sockets in the tables
+    unsigned entryLimit;                        // Allocated table size
+    PLT_TIMER waitTimer;                        // Sub-millisecond timeouts (WSAPoll() has ms resolution)
+
+} PLT_EVENTLOOP;
+
+
+typedef union
+{
+    struct sockaddr sa;                         // Address family (either IPv4 or IPv6)
+    struct sockaddr_in sin;                     // IPv4 socket address
+    struct sockaddr_in6 sin6;                   // IPv6 socket address
+
+} PLT_SOCKADDR;
+
+
+typedef struct
+{
+    uint8_t *bufferPtr;                         // Datagram buffer
+    unsigned bufferSize;                        // Size of the datagram buffer
+    unsigned dataLength;                        // Length of the received datagram
+    unsigned recvFlags;                         // Receive condition flags (PLT_RECVFLG_*)
+    PLT_SOCKADDR remoteAddr;                    // The address the datagram was received from
+    struct in_addr localAddr;                   // IPv4 destination address (see plt_sockSetPacketInfo), 0: unknown
+    uint32_t dropCounter;                       // Kernel drops of the socket so far (not reported: 0)
+
+} PLT_RECV_SLOT;
+
+
+typedef struct
+{
+    const uint8_t *dataPtr;                     // Datagram data
+    unsigned dataLength;                        // Length of the datagram
+    PLT_SOCKADDR remoteAddr;                    // The address the datagram shall be sent to
+
+} PLT_SEND_SLOT;
 
 
 // -------------------------------------------------------------------------------------------------
@@ -57,8 +159,6 @@ inline static int plt_validateMonoTime()
 {
     extern int plt_monoValid;
     extern LARGE_INTEGER plt_monoCtrFreq;
-    extern LARGE_INTEGER plt_monoCtrRef;
-    extern uint32_t plt_monoTimeUS;
 
     extern void logError(const char *fmt, ...);
 
@@ -71,36 +171,96 @@ inline static int plt_validateMonoTime()
             return -1;
         }
 
-        // Initialize performance counter reference
-        if(QueryPerformanceCounter(&plt_monoCtrRef) == 0)
+        // Check the performance counter
+        LARGE_INTEGER pctNow;
+        if(QueryPerformanceCounter(&pctNow) == 0)
         {
             logError("QueryPerformanceCounter() error = %d", (int)GetLastError());
             return -1;
         }
 
-        // Initialize internal time randomly
-        plt_monoTimeUS = (uint32_t)((plt_monoCtrRef.QuadPart * 1000000) / plt_monoCtrFreq.QuadPart);
+        plt_monoValid = 1;
     }
 
     return 0;
 }
 
 
-inline static uint32_t plt_getMonoTimeUS(void)
+inline static uint64_t plt_getMonoTimeNS(void)
 {
     extern LARGE_INTEGER plt_monoCtrFreq;
-    extern LARGE_INTEGER plt_monoCtrRef;
-    extern uint32_t plt_monoTimeUS;
 
-    // Get current time
+    // Note: Derived from the counter on each call (no shared state - may be called by any thread).
+    // 64 bit nanoseconds do not wrap around (for centuries).
     LARGE_INTEGER pctNow;
     QueryPerformanceCounter(&pctNow);
 
-    // Update internal time and system time reference
-    plt_monoTimeUS += (uint32_t)(((pctNow.QuadPart - plt_monoCtrRef.QuadPart) * 1000000) / plt_monoCtrFreq.QuadPart);
-    plt_monoCtrRef = pctNow;
+    // Seconds and remainder (avoid overflow of the multiplication)
+    uint64_t ctrSec = (uint64_t)pctNow.QuadPart / (uint64_t)plt_monoCtrFreq.QuadPart;
+    uint64_t ctrRem = (uint64_t)pctNow.QuadPart % (uint64_t)plt_monoCtrFreq.QuadPart;
+
+    return (ctrSec * 1000000000) + ((ctrRem * 1000000000) / (uint64_t)plt_monoCtrFreq.QuadPart);
+}
+
+
+inline static uint32_t plt_getMonoTimeUS(void)
+{
+    // Note: Same time base as plt_getMonoTimeNS(). The time wraps around (after ~71 minutes),
+    // only differences of short intervals are meaningful.
+    return (uint32_t)(plt_getMonoTimeNS() / 1000);
+}
+
 
-    return plt_monoTimeUS;
+inline static int plt_timerOpen(PLT_TIMER *timer)
+{
+    // High resolution timer (older versions: default resolution)
+    timer->timerHandle = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if(timer->timerHandle == NULL) timer->timerHandle = CreateWaitableTimerExW(NULL, NULL, 0, TIMER_ALL_ACCESS);
+
+    return (timer->timerHandle == NULL) ? -1 : 0;
+}
+
+
+inline static int plt_timerClose(PLT_TIMER *timer)
+{
+    if(timer->timerHandle == NULL) return 0;
+
+    BOOL rc = CloseHandle(timer->timerHandle);
+    timer->timerHandle = NULL;
+    return rc ? 0 : -1;
+}
+
+
+inline static int plt_timerSetDeadline(PLT_TIMER *timer, uint64_t nsDeadline)
+{
+    // Note: Absolute time (plt_getMonoTimeNS() base), one-shot. 0 disarms the timer.
+    if(nsDeadline == 0) return CancelWaitableTimer(timer->timerHandle) ? 0 : -1;
+
+    // Due time relative to now (negative, in 100ns units)
+    uint64_t nsNow = plt_getMonoTimeNS();
+    uint64_t nsDue = (nsDeadline > nsNow) ? (nsDeadline - nsNow) : 0;
+    LARGE_INTEGER dueTime;
+    dueTime.QuadPart = -(LONGLONG)((nsDue + 99) / 100);
+    if(dueTime.QuadPart == 0) dueTime.QuadPart = -1;
+
+    return SetWaitableTimer(timer->timerHandle, &dueTime, 0, NULL, NULL, FALSE) ? 0 : -1;
+}
+
+
+inline static int plt_timerAck(PLT_TIMER *timer)
+{
+    // Consume the expiration (auto-reset timer). Returns 1 in case it expired.
+    DWORD rcWait = WaitForSingleObject(timer->timerHandle, 0);
+    if(rcWait == WAIT_FAILED) return -1;
+
+    return (rcWait == WAIT_OBJECT_0) ? 1 : 0;
+}
+
+
+inline static int plt_timerWait(PLT_TIMER *timer)
+{
+    // Block until the deadline (the timer must be armed)
+    return (WaitForSingleObject(timer->timerHandle, INFINITE) == WAIT_OBJECT_0) ? 0 : -1;
 }
 
 
@@ -123,9 +283,47 @@ inline static int plt_ifAddrListVisitor(IFADDR_CALLBACK_PFN pfnCallback, void *c
         if(ifa->ai_addr == NULL) continue;
         if(ifa->ai_addr->sa_family != AF_INET) continue;
 
-        // Invoke callback on interface
+        // Note: The host addresses carry neither netmask nor flags (mask 0: host address only,
+        // all addresses up and broadcast-capable, loopback derived from the address)
         struct sockaddr_in *ifSockAddr = (struct sockaddr_in *)ifa->ai_addr;
-        pfnCallback(callbackArg, ifa->ai_canonname, (uint32_t)(ifSockAddr->sin_addr.s_addr));
+        unsigned ifFlags = PLT_IFFLG_UP | PLT_IFFLG_BROADCAST;
+        if((ntohl(ifSockAddr->sin_addr.s_addr) >> 24) == 127) ifFlags = PLT_IFFLG_UP | PLT_IFFLG_LOOPBACK;
+
+        // Invoke callback on interface
+        pfnCallback(callbackArg, ifa->ai_canonname, (uint32_t)(ifSockAddr->sin_addr.s_addr), 0, ifFlags);
+    }
+
+    // Interface list is dynamically allocated and must be freed
+    freeaddrinfo(servinfo);
+
+    return 0;
+}
+
+
+inline static int plt_ifAddr6ListVisitor(IFADDR6_CALLBACK_PFN pfnCallback, void *callbackArg)
+{
+    struct addrinfo *servinfo;              // Will point to the results
+    struct addrinfo hints;                  // Hints about the caller-supported socket types
+    memset(&hints, 0, sizeof hints);        // Make sure the struct is empty
+    hints.ai_flags = AI_PASSIVE;            // Intention to use address with the bind function
+    hints.ai_family = AF_INET6;             // IPv6
+
+    int rcAddrInfo = getaddrinfo("", "", &hints, &servinfo);
+    if(rcAddrInfo != 0) return rcAddrInfo;
+
+    // Walk through all interfaces (servinfo points to a linked list of struct addrinfos)
+    for(struct addrinfo *ifa = servinfo; ifa != NULL; ifa = ifa->ai_next)
+    {
+        if(ifa->ai_addr == NULL) continue;
+        if(ifa->ai_addr->sa_family != AF_INET6) continue;
+
+        // Note: No flags (see IPv4), the scope of link-local addresses is the interface index
+        struct sockaddr_in6 *ifSockAddr = (struct sockaddr_in6 *)ifa->ai_addr;
+        unsigned ifFlags = PLT_IFFLG_UP | PLT_IFFLG_MULTICAST;
+        if(IN6_IS_ADDR_LOOPBACK(&ifSockAddr->sin6_addr)) ifFlags = PLT_IFFLG_UP | PLT_IFFLG_LOOPBACK;
+
+        // Invoke callback on interface
+        pfnCallback(callbackArg, ifa->ai_canonname, &ifSockAddr->sin6_addr, (uint32_t)ifSockAddr->sin6_scope_id, ifFlags);
     }
 
     // Interface list is dynamically allocated and must be freed
@@ -135,6 +333,14 @@ inline static int plt_ifAddrListVisitor(IFADDR_CALLBACK_PFN pfnCallback, void *c
 }
 
 
+inline static unsigned plt_ifNameToIndex(const char *ifName)
+{
+    // Note: The interface list carries host names (see plt_ifAddrListVisitor), the stack
+    // selects the interface by the source address.
+    return 0;
+}
+
+
 inline static int plt_sockStartup()
 {
     // Initialize Winsock
@@ -174,5 +380,591 @@ inline static int plt_sockSetBroadcast(int fdSocket)
 }
 
 
+inline static int plt_sockSetMulticast6(int fdSocket, uint32_t scopeID)
+{
+    // Send multicasts on the interface (link-local scope, not routed)
+    DWORD ifIndex = (DWORD)scopeID;
+    if(setsockopt(fdSocket, IPPROTO_IPV6, IPV6_MULTICAST_IF, (const char *)&ifIndex, sizeof(ifIndex)) == SOCKET_ERROR) return -1;
+
+    DWORD hopsOpt = 1;
+    return setsockopt(fdSocket, IPPROTO_IPV6, IPV6_MULTICAST_HOPS, (const char *)&hopsOpt, sizeof(hopsOpt));
+}
+
+
+inline static int plt_sockSetDualStack(int fdSocket)
+{
+    // IPv4 as mapped addresses (::ffff:a.b.c.d)
+    DWORD v6OnlyOpt = 0;
+    return setsockopt(fdSocket, IPPROTO_IPV6, IPV6_V6ONLY, (const char *)&v6OnlyOpt, sizeof(v6OnlyOpt));
+}
+
+
+inline static int plt_sockSetNonBlocking(int fdSocket)
+{
+    u_long nonBlocking = 1;
+    return ioctlsocket(fdSocket, FIONBIO, &nonBlocking);
+}
+
+
+inline static int plt_sockSetPacketInfo(int fdSocket)
+{
+    // Report the destination address of received IPv4 datagrams (see PLT_RECV_SLOT)
+    DWORD pktInfoOpt = 1;
+    return setsockopt(fdSocket, IPPROTO_IP, IP_PKTINFO, (const char *)&pktInfoOpt, sizeof(pktInfoOpt));
+}
+
+
+inline static int plt_sockSetRecvBuffer(int fdSocket, unsigned bufferSize)
+{
+    int bufferOpt = (int)bufferSize;
+    return setsockopt(fdSocket, SOL_SOCKET, SO_RCVBUF, (const char *)&bufferOpt, sizeof(bufferOpt));
+}
+
+
+inline static int plt_sockSetDropCounter(int fdSocket)
+{
+    // Note: Drops (receive buffer overflow) are not reported by Winsock
+    return 0;
+}
+
+
+inline static LPFN_WSARECVMSG plt_sockGetRecvMsg(int fdSocket)
+{
+    // WSARecvMsg is an extension function, the pointer has to be queried from the provider
+    static LPFN_WSARECVMSG pfnRecvMsg = NULL;
+    if(pfnRecvMsg != NULL) return pfnRecvMsg;
+
+    GUID recvMsgGUID = WSAID_WSARECVMSG;
+    LPFN_WSARECVMSG pfnQueried = NULL;
+    DWORD nBytes = 0;
+    if(WSAIoctl((SOCKET)fdSocket, SIO_GET_EXTENSION_FUNCTION_POINTER, &recvMsgGUID, sizeof(recvMsgGUID),
+                &pfnQueried, sizeof(pfnQueried), &nBytes, NULL, NULL) == SOCKET_ERROR) return NULL;
+
+    pfnRecvMsg = pfnQueried;
+    return pfnRecvMsg;
+}
+
+
+inline static int plt_sockIsWouldBlock(int errorCode)
+{
+    return (errorCode == WSAEWOULDBLOCK);
+}
+
+
+inline static int plt_sockAddrSize(const PLT_SOCKADDR *sockAddr)
+{
+    return (sockAddr->sa.sa_family == AF_INET6) ? (int)sizeof(struct sockaddr_in6) : (int)sizeof(struct sockaddr_in);
+}
+
+
+inline static int plt_sockRecvBatch(int fdSocket, PLT_RECV_SLOT *slotTable, unsigned slotCount)
+{
+    // Note: Returns the number of datagrams received (0 in case no datagram is pending).
+    // Requires a non-blocking socket.
+    if(slotCount > PLT_RECV_BATCH_MAX) slotCount = PLT_RECV_BATCH_MAX;
+
+    // Note: WSARecvMsg reports the destination address (if enabled), fall back to recvfrom
+    LPFN_WSARECVMSG pfnRecvMsg = plt_sockGetRecvMsg(fdSocket);
+
+    // Receive pending datagrams one by one (until the socket would block)
+    unsigned msgCount = 0;
+    while(msgCount < slotCount)
+    {
+        PLT_RECV_SLOT *slot = &slotTable[msgCount];
+        slot->recvFlags = 0;
+        slot->localAddr.s_addr = INADDR_ANY;
+        slot->dropCounter = 0;
+
+        int nBytes = SOCKET_ERROR;
+        if(pfnRecvMsg != NULL)
+        {
+            char controlBuffer[WSA_CMSG_SPACE(sizeof(IN_PKTINFO))];
+
+            WSABUF dataBuffer;
+            dataBuffer.buf = (char *)slot->bufferPtr;
+            dataBuffer.len = (ULONG)slot->bufferSize;
+
+            WSAMSG wsaMsg;
+            memset(&wsaMsg, 0, sizeof(wsaMsg));
+            wsaMsg.name = (struct sockaddr *)&slot->remoteAddr;
+            wsaMsg.namelen = sizeof(slot->remoteAddr);
+            wsaMsg.lpBuffers = &dataBuffer;
+            wsaMsg.dwBufferCount = 1;
+            wsaMsg.Control.buf = controlBuffer;
+            wsaMsg.Control.len = sizeof(controlBuffer);
+
+            DWORD recvBytes = 0;
+            if(pfnRecvMsg((SOCKET)fdSocket, &wsaMsg, &recvBytes, NULL, NULL) != SOCKET_ERROR)
+            {
+                nBytes = (int)recvBytes;
+                if(wsaMsg.dwFlags & MSG_TRUNC) slot->recvFlags = PLT_RECVFLG_TRUNCATED;
+
+                for(WSACMSGHDR *cmsg = WSA_CMSG_FIRSTHDR(&wsaMsg); cmsg; cmsg = WSA_CMSG_NXTHDR(&wsaMsg, cmsg))
+                {
+                    if(cmsg->cmsg_level != IPPROTO_IP || cmsg->cmsg_type != IP_PKTINFO) continue;
+
+                    IN_PKTINFO *pktInfo = (IN_PKTINFO *)WSA_CMSG_DATA(cmsg);
+                    slot->localAddr = pktInfo->ipi_addr;
+                }
+            }
+        }
+        else
+        {
+            int addrSize = sizeof(slot->remoteAddr);
+            nBytes = recvfrom(fdSocket, (char *)slot->bufferPtr, (int)slot->bufferSize, 0, (struct sockaddr *)&slot->remoteAddr, &addrSize);
+        }
+
+        if(nBytes == SOCKET_ERROR)
+        {
+            // Note: ICMP port unreachable is reported as WSAECONNRESET for UDP - ignore.
+            int errorCode = WSAGetLastError();
+            if(errorCode == WSAECONNRESET) continue;
+
+            if(errorCode != WSAEMSGSIZE)
+            {
+                if(plt_sockIsWouldBlock(errorCode)) break;
+                return (msgCount > 0) ? (int)msgCount : -1;
+            }
+
+            // Datagram did not fit into the buffer
+            slot->dataLength = slot->bufferSize;
+            slot->recvFlags = PLT_RECVFLG_TRUNCATED;
+        }
+        else
+        {
+            slot->dataLength = (unsigned)nBytes;
+        }
+
+        msgCount++;
+    }
+
+    return (int)msgCount;
+}
+
+
+inline static int plt_sockSendBatch(int fdSocket, const PLT_SEND_SLOT *slotTable, unsigned slotCount)
+{
+    // Note: Returns the number of datagrams sent (0 in case the socket would block)
+    if(slotCount > PLT_SEND_BATCH_MAX) slotCount = PLT_SEND_BATCH_MAX;
+
+    // Send datagrams one by one (until the socket would block)
+    unsigned msgCount = 0;
+    for(; msgCount < slotCount; msgCount++)
+    {
+        const PLT_SEND_SLOT *slot = &slotTable[msgCount];
+
+        struct sockaddr *remoteAddr = (struct sockaddr *)&slot->remoteAddr;
+        if(sendto(fdSocket, (const char *)slot->dataPtr, (int)slot->dataLength, 0, remoteAddr, plt_sockAddrSize(&slot->remoteAddr)) == SOCKET_ERROR)
+        {
+            if(plt_sockIsWouldBlock(WSAGetLastError())) break;
+            return (msgCount > 0) ? (int)msgCount : -1;
+        }
+    }
+
+    return (int)msgCount;
+}
+
+
+inline static int plt_sockSendFrom(int fdSocket, const uint8_t *dataPtr, unsigned dataLength, const PLT_SOCKADDR *remoteAddr, struct in_addr srcAddr, unsigned ifIndex)
+{
+    // IPv4 datagram with the given source address, sent on the given interface (0: routed by the
+    // source address)
+    char controlBuffer[WSA_CMSG_SPACE(sizeof(IN_PKTINFO))];
+    memset(controlBuffer, 0, sizeof(controlBuffer));
+
+    WSABUF dataBuffer;
+    dataBuffer.buf = (char *)dataPtr;
+    dataBuffer.len = (ULONG)dataLength;
+
+    WSAMSG wsaMsg;
+    memset(&wsaMsg, 0, sizeof(wsaMsg));
+    wsaMsg.name = (struct sockaddr *)remoteAddr;
+    wsaMsg.namelen = plt_sockAddrSize(remoteAddr);
+    wsaMsg.lpBuffers = &dataBuffer;
+    wsaMsg.dwBufferCount = 1;
+    wsaMsg.Control.buf = controlBuffer;
+    wsaMsg.Control.len = sizeof(controlBuffer);
+
+    WSACMSGHDR *cmsg = WSA_CMSG_FIRSTHDR(&wsaMsg);
+    cmsg->cmsg_level = IPPROTO_IP;
+    cmsg->cmsg_type = IP_PKTINFO;
+    cmsg->cmsg_len = WSA_CMSG_LEN(sizeof(IN_PKTINFO));
+
+    IN_PKTINFO *pktInfo = (IN_PKTINFO *)WSA_CMSG_DATA(cmsg);
+    pktInfo->ipi_addr = srcAddr;
+    pktInfo->ipi_ifindex = (ULONG)ifIndex;
+
+    DWORD sentBytes = 0;
+    return (WSASendMsg((SOCKET)fdSocket, &wsaMsg, 0, &sentBytes, NULL, NULL) == SOCKET_ERROR) ? -1 : 0;
+}
+
+
+// -------------------------------------------------------------------------------------------------
+//  Threads and atomics
+// -------------------------------------------------------------------------------------------------
+
+inline static DWORD WINAPI plt_threadEntry(LPVOID threadArg)
+{
+    PLT_THREAD *thread = (PLT_THREAD *)threadArg;
+    thread->pfnThread(thread->threadArg);
+
+    return 0;
+}
+
+
+inline static int plt_threadStart(PLT_THREAD *thread, PLT_THREAD_PFN pfnThread, void *threadArg)
+{
+    thread->pfnThread = pfnThread;
+    thread->threadArg = threadArg;
+
+    thread->threadHandle = CreateThread(NULL, 0, plt_threadEntry, thread, 0, NULL);
+    if(thread->threadHandle == NULL) return -1;
+
+    return 0;
+}
+
+
+inline static int plt_threadJoin(PLT_THREAD *thread)
+{
+    if(WaitForSingleObject(thread->threadHandle, INFINITE) != WAIT_OBJECT_0) return -1;
+    CloseHandle(thread->threadHandle);
+
+    return 0;
+}
+
+
+inline static void *plt_atomicLoadPtr(void *volatile *ptrRef)
+{
+    // Note: Compare-exchange with equal values is a full barrier load
+    return InterlockedCompareExchangePointer(ptrRef, NULL, NULL);
+}
+
+
+inline static int plt_atomicCasPtr(void *volatile *ptrRef, void *expectedPtr, void *desiredPtr)
+{
+    // Returns nonzero in case the pointer was replaced
+    return InterlockedCompareExchangePointer(ptrRef, desiredPtr, expectedPtr) == expectedPtr;
+}
+
+
+inline static uint32_t plt_atomicLoad32(volatile uint32_t *valueRef)
+{
+    return (uint32_t)InterlockedCompareExchange((volatile LONG *)valueRef, 0, 0);
+}
+
+
+inline static void plt_atomicStore32(volatile uint32_t *valueRef, uint32_t value)
+{
+    InterlockedExchange((volatile LONG *)valueRef, (LONG)value);
+}
+
+
+inline static void plt_atomicFence()
+{
+    MemoryBarrier();
+}
+
+
+inline static void plt_sleepMS(unsigned msSleep)
+{
+    Sleep(msSleep);
+}
+
+
+// -------------------------------------------------------------------------------------------------
+//  Shared memory (named file mappings, backed by the paging file) and mapped files
+// -------------------------------------------------------------------------------------------------
+
+inline static int plt_sharedMemCreate(PLT_SHARED_MEM *sharedMem, const char *memName, size_t memSize)
+{
+    sharedMem->mapPtr = NULL;
+    sharedMem->mapSize = 0;
+
+    // Note: An existing mapping (of the same name) is reused
+    uint64_t mappingSize = (uint64_t)memSize;
+    sharedMem->mapHandle = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)(mappingSize >> 32), (DWORD)mappingSize, memName);
+    if(sharedMem->mapHandle == NULL) return -1;
+
+    sharedMem->mapPtr = MapViewOfFile(sharedMem->mapHandle, FILE_MAP_WRITE, 0, 0, memSize);
+    if(sharedMem->mapPtr == NULL)
+    {
+        CloseHandle(sharedMem->mapHandle);
+        return -1;
+    }
+
+    sharedMem->mapSize = memSize;
+    return 0;
+}
+
+
+inline static int plt_sharedMemOpen(PLT_SHARED_MEM *sharedMem, const char *memName)
+{
+    sharedMem->mapPtr = NULL;
+    sharedMem->mapSize = 0;
+
+    sharedMem->mapHandle = OpenFileMappingA(FILE_MAP_READ, FALSE, memName);
+    if(sharedMem->mapHandle == NULL) return -1;
+
+    // Read-only view of the whole mapping, the size is the size of the mapped region
+    MEMORY_BASIC_INFORMATION memInfo;
+    sharedMem->mapPtr = MapViewOfFile(sharedMem->mapHandle, FILE_MAP_READ, 0, 0, 0);
+    if(sharedMem->mapPtr == NULL || VirtualQuery(sharedMem->mapPtr, &memInfo, sizeof(memInfo)) == 0)
+    {
+        if(sharedMem->mapPtr) UnmapViewOfFile(sharedMem->mapPtr);
+        sharedMem->mapPtr = NULL;
+        CloseHandle(sharedMem->mapHandle);
+        return -1;
+    }
+
+    sharedMem->mapSize = memInfo.RegionSize;
+    return 0;
+}
+
+
+inline static int plt_sharedMemClose(PLT_SHARED_MEM *sharedMem)
+{
+    if(sharedMem->mapPtr == NULL) return 0;
+
+    int rc = 0;
+    if(!UnmapViewOfFile(sharedMem->mapPtr)) rc = -1;
+    if(!CloseHandle(sharedMem->mapHandle)) rc = -1;
+    sharedMem->mapPtr = NULL;
+    sharedMem->mapSize = 0;
+
+    return rc;
+}
+
+
+inline static int plt_fileMapOpen(PLT_SHARED_MEM *sharedMem, const char *fileName)
+{
+    sharedMem->mapPtr = NULL;
+    sharedMem->mapSize = 0;
+
+    // Read-only view of the whole file (the mapping keeps the file open)
+    HANDLE fileHandle = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(fileHandle == INVALID_HANDLE_VALUE) return -1;
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0 || (uint64_t)fileSize.QuadPart > (SIZE_MAX / 2))
+    {
+        CloseHandle(fileHandle);
+        return -1;
+    }
+
+    sharedMem->mapHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(fileHandle);
+    if(sharedMem->mapHandle == NULL) return -1;
+
+    sharedMem->mapPtr = MapViewOfFile(sharedMem->mapHandle, FILE_MAP_READ, 0, 0, 0);
+    if(sharedMem->mapPtr == NULL)
+    {
+        CloseHandle(sharedMem->mapHandle);
+        return -1;
+    }
+
+    sharedMem->mapSize = (size_t)fileSize.QuadPart;
+    return 0;
+}
+
+
+inline static int plt_fileMapCreate(PLT_SHARED_MEM *sharedMem, const char *fileName, size_t mapSize)
+{
+    sharedMem->mapPtr = NULL;
+    sharedMem->mapSize = 0;
+
+    // Read/write view of a new file (an existing file is replaced), sized by the mapping
+    HANDLE fileHandle = CreateFileA(fileName, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(fileHandle == INVALID_HANDLE_VALUE) return -1;
+
+    uint64_t mapSize64 = (uint64_t)mapSize;
+    sharedMem->mapHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READWRITE, (DWORD)(mapSize64 >> 32), (DWORD)mapSize64, NULL);
+    CloseHandle(fileHandle);
+    if(sharedMem->mapHandle == NULL) return -1;
+
+    sharedMem->mapPtr = MapViewOfFile(sharedMem->mapHandle, FILE_MAP_WRITE, 0, 0, mapSize);
+    if(sharedMem->mapPtr == NULL)
+    {
+        CloseHandle(sharedMem->mapHandle);
+        return -1;
+    }
+
+    sharedMem->mapSize = mapSize;
+    return 0;
+}
+
+
+inline static int plt_fileTruncate(const char *fileName, size_t fileSize)
+{
+    // Note: In case the file is mapped, unmap first
+    HANDLE fileHandle = CreateFileA(fileName, GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(fileHandle == INVALID_HANDLE_VALUE) return -1;
+
+    LARGE_INTEGER filePos;
+    filePos.QuadPart = (LONGLONG)fileSize;
+    int rc = (SetFilePointerEx(fileHandle, filePos, NULL, FILE_BEGIN) && SetEndOfFile(fileHandle)) ? 0 : -1;
+    CloseHandle(fileHandle);
+
+    return rc;
+}
+
+
+inline static int plt_fileReplace(const char *srcName, const char *dstName)
+{
+    if(!MoveFileExA(srcName, dstName, MOVEFILE_REPLACE_EXISTING)) return -1;
+
+    return 0;
+}
+
+
+inline static int plt_sharedMemRemove(const char *memName)
+{
+    // Note: The mapping is released with the last handle
+    (void)memName;
+    return 0;
+}
+
+
+// -------------------------------------------------------------------------------------------------
+//  Event loop (WSAPoll - not limited by FD_SETSIZE)
+// -------------------------------------------------------------------------------------------------
+
+inline static int plt_eventLoopOpen(PLT_EVENTLOOP *eventLoop)
+{
+    eventLoop->pollTable = (WSAPOLLFD *)0;
+    eventLoop->userDataTable = (void **)0;
+    eventLoop->entryCount = 0;
+    eventLoop->entryLimit = 0;
+
+    // Precise timeouts. Note: Optional, millisecond timeouts otherwise
+    plt_timerOpen(&eventLoop->waitTimer);
+
+    return 0;
+}
+
+
+inline static int plt_eventLoopClose(PLT_EVENTLOOP *eventLoop)
+{
+    free(eventLoop->pollTable);
+    free(eventLoop->userDataTable);
+    eventLoop->pollTable = (WSAPOLLFD *)0;
+    eventLoop->userDataTable = (void **)0;
+    eventLoop->entryCount = 0;
+    eventLoop->entryLimit = 0;
+
+    return plt_timerClose(&eventLoop->waitTimer);
+}
+
+
+inline static int plt_eventLoopFind(PLT_EVENTLOOP *eventLoop, int fdSocket)
+{
+    for(unsigned i = 0; i < eventLoop->entryCount; i++)
+    {
+        if(eventLoop->pollTable[i].fd == (SOCKET)fdSocket) return (int)i;
+    }
+
+    return -1;
+}
+
+
+inline static int plt_eventLoopModify(PLT_EVENTLOOP *eventLoop, int fdSocket, unsigned evFlags, void *userData)
+{
+    int index = plt_eventLoopFind(eventLoop, fdSocket);
+    if(index < 0) { WSASetLastError(WSAENOTSOCK); return -1; }
+
+    eventLoop->pollTable[index].events = 0;
+    if(evFlags & PLT_EVFLG_READ) eventLoop->pollTable[index].events |= POLLRDNORM;
+    if(evFlags & PLT_EVFLG_WRITE) eventLoop->pollTable[index].events |= POLLWRNORM;
+    eventLoop->userDataTable[index] = userData;
+
+    return 0;
+}
+
+
+inline static int plt_eventLoopAdd(PLT_EVENTLOOP *eventLoop, int fdSocket, unsigned evFlags, void *userData)
+{
+    if(plt_eventLoopFind(eventLoop, fdSocket) >= 0) { WSASetLastError(WSAEINVAL); return -1; }
+
+    // Grow tables in case of insufficient size
+    if(eventLoop->entryCount >= eventLoop->entryLimit)
+    {
+        unsigned newLimit = eventLoop->entryLimit ? (eventLoop->entryLimit * 2) : 16;
+
+        WSAPOLLFD *pollTable = (WSAPOLLFD *)realloc(eventLoop->pollTable, newLimit * sizeof(WSAPOLLFD));
+        if(pollTable == (WSAPOLLFD *)0) return -1;
+        eventLoop->pollTable = pollTable;
+
+        void **userDataTable = (void **)realloc(eventLoop->userDataTable, newLimit * sizeof(void *));
+        if(userDataTable == (void **)0) return -1;
+        eventLoop->userDataTable = userDataTable;
+
+        eventLoop->entryLimit = newLimit;
+    }
+
+    eventLoop->pollTable[eventLoop->entryCount].fd = (SOCKET)fdSocket;
+    eventLoop->pollTable[eventLoop->entryCount].revents = 0;
+    eventLoop->entryCount++;
+
+    return plt_eventLoopModify(eventLoop, fdSocket, evFlags, userData);
+}
+
+
+inline static int plt_eventLoopRemove(PLT_EVENTLOOP *eventLoop, int fdSocket)
+{
+    int index = plt_eventLoopFind(eventLoop, fdSocket);
+    if(index < 0) { WSASetLastError(WSAENOTSOCK); return -1; }
+
+    // Move last entry into the gap
+    unsigned lastIndex = --eventLoop->entryCount;
+    eventLoop->pollTable[index] = eventLoop->pollTable[lastIndex];
+    eventLoop->userDataTable[index] = eventLoop->userDataTable[lastIndex];
+
+    return 0;
+}
+
+
+inline static int plt_eventLoopWait(PLT_EVENTLOOP *eventLoop, PLT_EVENT *eventTable, unsigned eventLimit, uint32_t usTimeout)
+{
+    // Note: WSAPoll() fails on an empty descriptor set
+    INT msTimeout = (INT)((usTimeout + 999) / 1000);
+    if(eventLoop->entryCount == 0) { Sleep((DWORD)msTimeout); return 0; }
+
+    // Sub-millisecond timeout: The sockets are checked before and after the timer wait
+    // (WSAPoll() can not wait for the timer)
+    int timerFlag = (eventLoop->waitTimer.timerHandle != NULL) && (usTimeout > 0) && (usTimeout < 1000);
+    if(timerFlag) msTimeout = 0;
+
+    int numReady = WSAPoll(eventLoop->pollTable, (ULONG)eventLoop->entryCount, msTimeout);
+    if(numReady == SOCKET_ERROR) return -1;
+
+    if(timerFlag && (numReady == 0))
+    {
+        if(plt_timerSetDeadline(&eventLoop->waitTimer, plt_getMonoTimeNS() + ((uint64_t)usTimeout * 1000)) < 0) return -1;
+        if(plt_timerWait(&eventLoop->waitTimer) < 0) return -1;
+
+        numReady = WSAPoll(eventLoop->pollTable, (ULONG)eventLoop->entryCount, 0);
+        if(numReady == SOCKET_ERROR) return -1;
+    }
+
+    // Collect ready sockets
+    unsigned eventCount = 0;
+    for(unsigned i = 0; (i < eventLoop->entryCount) && (eventCount < eventLimit); i++)
+    {
+        SHORT revents = eventLoop->pollTable[i].revents;
+        if(revents == 0) continue;
+
+        unsigned evFlags = 0;
+        if(revents & (POLLRDNORM | POLLHUP)) evFlags |= PLT_EVFLG_READ;
+        if(revents & POLLWRNORM) evFlags |= PLT_EVFLG_WRITE;
+        if(revents & (POLLERR | POLLNVAL)) evFlags |= PLT_EVFLG_ERROR;
+
+        eventTable[eventCount].evFlags = evFlags;
+        eventTable[eventCount].userData = eventLoop->userDataTable[i];
+        eventCount++;
+    }
+
+    return (int)eventCount;
+}
+
+
 #endif
 